@@ -194,6 +194,7 @@ ApplicationManager::ApplicationManager(QObject *parent) :
     m_statisticsManager(new StatisticsManager(this, m_view)),
     m_settingsManager(new SettingsManager(this, m_view)),
     m_importManager(new ImportManager(this, m_view)),
+    m_saveProjectAfterImport(false),
     m_exportManager(new ExportManager(this, m_view)),
     m_synchronizationManager(new SynchronizationManager(this, m_view))
 {
@@ -372,9 +373,10 @@ void ApplicationManager::createNewLocalProject(const QString& _filePath, const Q
             //
             goToEditCurrentProject();
             //
-            // ... и импортируем, если надо
+            // ... и импортируем, если надо, проект сохраним по окончании импорта
             //
             if (!_importFilePath.isEmpty()) {
+                m_saveProjectAfterImport = true;
                 m_importManager->importScenario(m_scenarioManager->scenario(), _importFilePath);
             }
         }
@@ -429,9 +431,10 @@ void ApplicationManager::createNewRemoteProject(const QString& _projectName, con
         //
         goToEditCurrentProject();
         //
-        // ... и импортируем, если надо
+        // ... и импортируем, если надо, проект сохраним по окончании импорта
         //
         if (!_importFilePath.isEmpty()) {
+            m_saveProjectAfterImport = true;
             m_importManager->importScenario(m_scenarioManager->scenario(), _importFilePath);
         }
     }
@@ -1259,8 +1262,22 @@ void ApplicationManager::aboutSyncClosedWithError(int _errorCode, const QString&
 
 void ApplicationManager::aboutImport()
 {
+    m_saveProjectAfterImport = false;
     m_importManager->importScenario(m_scenarioManager->scenario(), m_scenarioManager->cursorPosition());
+}
+
+void ApplicationManager::aboutScenarioImported()
+{
     m_researchManager->loadScenarioData();
+
+    //
+    // Новый проект сохраняем уже с импортированным текстом
+    //
+    if (m_saveProjectAfterImport) {
+        m_saveProjectAfterImport = false;
+        m_view->setWindowModified(true);
+        aboutSave();
+    }
 }
 
 void ApplicationManager::aboutExport()
@@ -1682,6 +1699,12 @@ void ApplicationManager::goToEditCurrentProject()
 void ApplicationManager::closeCurrentProject()
 {
     if (isProjectLoaded()) {
+        //
+        // Результат незавершённого импорта закрываемому проекту уже не нужен
+        //
+        m_importManager->cancelImport();
+        m_saveProjectAfterImport = false;
+
         //
         // Сохраним настройки закрываемого проекта
         //
@@ -1959,6 +1982,8 @@ void ApplicationManager::initConnections()
     connect(m_researchManager, &ResearchManager::locationNameChanged, m_scenarioManager, &ScenarioManager::aboutLocationNameChanged);
     connect(m_researchManager, &ResearchManager::refreshLocations, m_scenarioManager, &ScenarioManager::aboutRefreshLocations);
 
+    connect(m_importManager, &ImportManager::scenarioImported, this, &ApplicationManager::aboutScenarioImported);
+
     connect(m_scenarioManager, &ScenarioManager::showFullscreen, this, &ApplicationManager::aboutShowFullscreen);
     connect(m_scenarioManager, &ScenarioManager::updateScenarioRequest, this, &ApplicationManager::aboutUpdateLastChangeInfo);
     connect(m_scenarioManager, &ScenarioManager::updateScenarioRequest, m_synchronizationManager, &SynchronizationManager::aboutWorkSyncScenario);
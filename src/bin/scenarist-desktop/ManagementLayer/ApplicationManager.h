@@ -169,6 +169,11 @@ namespace ManagementLayer
          */
         void aboutImport();
 
+        /**
+         * @brief Импорт завершён, сохранить новый проект, если он был создан из импортируемого файла
+         */
+        void aboutScenarioImported();
+
         /**
          * @brief Экспортировать документ
          */
@@ -378,6 +383,11 @@ namespace ManagementLayer
          */
         ImportManager* m_importManager;
 
+        /**
+         * @brief Нужно ли сохранить проект после окончания импорта
+         */
+        bool m_saveProjectAfterImport;
+
         /**
          * @brief Управляющий экспортом
          */
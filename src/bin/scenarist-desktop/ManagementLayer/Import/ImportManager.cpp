@@ -23,9 +23,16 @@
 #include <3rd_party/Widgets/QLightBoxWidget/qlightboxprogress.h>
 #include <3rd_party/Widgets/QLightBoxWidget/qlightboxmessage.h>
 
+#include <format_manager.h>
+
 #include <QApplication>
 #include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QScopedPointer>
 #include <QSet>
+#include <QtConcurrentRun>
 
 using ManagementLayer::ImportManager;
 using UserInterface::ImportDialog;
@@ -57,6 +64,38 @@ namespace {
      */
     const QString FOUNTAIN_EXTENSION = ".fountain";
 
+    /**
+     * @brief Интервал обновления прогресса импорта
+     */
+    const int PROGRESS_UPDATE_INTERVAL = 100;
+
+    /**
+     * @brief Создать импортёр заданного типа
+     */
+    template <typename Importer>
+    static BusinessLogic::AbstractImporter* createImporter() {
+        return new Importer;
+    }
+
+    /**
+     * @brief Импортёры специальных форматов по расширению файла, остальные файлы
+     *        разбираются импортёром документов
+     */
+    static BusinessLogic::AbstractImporter* importerFor(const QString& _filePath) {
+        typedef BusinessLogic::AbstractImporter* (*ImporterFactory)();
+        static const QHash<QString, ImporterFactory> s_importers = {
+            { KIT_SCENARIST_EXTENSION, &createImporter<BusinessLogic::KitScenaristImporter> },
+            { FINAL_DRAFT_EXTENSION, &createImporter<BusinessLogic::FdxImporter> },
+            { FINAL_DRAFT_TEMPLATE_EXTENSION, &createImporter<BusinessLogic::FdxImporter> },
+            { TRELBY_EXTENSION, &createImporter<BusinessLogic::TrelbyImporter> },
+            { FOUNTAIN_EXTENSION, &createImporter<BusinessLogic::FountainImporter> }
+        };
+
+        const ImporterFactory factory =
+                s_importers.value("." + QFileInfo(_filePath).suffix().toLower(), &createImporter<BusinessLogic::DocumentImporter>);
+        return factory();
+    }
+
     /**
      * @brief Сохранить импортированный документ разработки со вложенными документами
      */
@@ -136,38 +175,123 @@ namespace {
 
 ImportManager::ImportManager(QObject* _parent, QWidget* _parentWidget) :
     QObject(_parent),
-    m_importDialog(new ImportDialog(_parentWidget))
+    m_importDialog(new ImportDialog(_parentWidget)),
+    m_importProgress(new QLightBoxProgress(_parentWidget)),
+    m_isImporting(false),
+    m_cursorPosition(0)
 {
     initView();
     initConnections();
 }
 
-bool ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, int _cursorPosition,
+ImportManager::~ImportManager()
+{
+    //
+    // Поток импорта пишет в поля управляющего, поэтому дожидаемся его, попросив прерваться
+    //
+    m_importCancelled.store(1);
+    m_importWatcher.waitForFinished();
+}
+
+void ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, int _cursorPosition,
     const BusinessLogic::ImportParameters& _importParameters)
 {
+    //
+    // Пока предыдущий импорт не завершён, новый не начинаем, а отменённый дожидаемся,
+    // его результат всё равно будет отброшен
+    //
+    if (m_isImporting) {
+        if (m_importCancelled.load() == 0) {
+            return;
+        }
+        m_importWatcher.waitForFinished();
+    }
+
+    m_isImporting = true;
+    m_scenario = _scenario;
+    m_cursorPosition = _cursorPosition;
+    m_importParameters = _importParameters;
+    m_importProgressValue.store(0);
+    m_importCancelled.store(0);
+
+    //
+    // Покажем уведомление пользователю
+    //
+    m_importProgress->showProgress(tr("Import"), tr("Please wait. Import can take few minutes."));
+    m_importProgress->setProgressValue(0);
+    m_importProgressTimer.start();
+
     //
     // Получим xml-представление импортируемого сценария
     //
-    QScopedPointer<BusinessLogic::AbstractImporter> importer;
-    if (_importParameters.filePath.toLower().endsWith(KIT_SCENARIST_EXTENSION)) {
-        importer.reset(new BusinessLogic::KitScenaristImporter);
-    } else if (_importParameters.filePath.toLower().endsWith(FINAL_DRAFT_EXTENSION)
-               || _importParameters.filePath.toLower().endsWith(FINAL_DRAFT_TEMPLATE_EXTENSION)) {
-        importer.reset(new BusinessLogic::FdxImporter);
-    } else if (_importParameters.filePath.toLower().endsWith(TRELBY_EXTENSION)) {
-        importer.reset(new BusinessLogic::TrelbyImporter);
-    } else if (_importParameters.filePath.toLower().endsWith(FOUNTAIN_EXTENSION)) {
-        importer.reset(new BusinessLogic::FountainImporter);
-    } else {
-        importer.reset(new BusinessLogic::DocumentImporter);
+    // ... разбор файла выполняется в отдельном потоке, а гуи-поток тем временем продолжает
+    //     работать, импорт завершается в aboutImportFinished()
+    //
+    m_importWatcher.setFuture(QtConcurrent::run(&ImportManager::importFile, m_importParameters,
+        &m_importProgressValue, &m_importCancelled));
+}
+
+void ImportManager::cancelImport()
+{
+    if (m_isImporting) {
+        m_importCancelled.store(1);
+    }
+}
+
+ImportManager::ImportResult ImportManager::importFile(const BusinessLogic::ImportParameters& _importParameters,
+    QAtomicInt* _progress, const QAtomicInt* _cancelled)
+{
+    //
+    // Импортёр создаётся в потоке импорта и живёт только в нём, читатели документов,
+    // созданные им, отчитываются о прогрессе и проверяют отмену
+    //
+    FormatManager::setThreadProgress(_progress, _cancelled);
+    QScopedPointer<BusinessLogic::AbstractImporter> importer(importerFor(_importParameters.filePath));
+
+    ImportResult result;
+    result.scenarioXml = importer->importScript(_importParameters);
+    if (!result.scenarioXml.isEmpty()
+        && _cancelled->load() == 0) {
+        result.research = importer->importResearch(_importParameters);
     }
-    const QString importScenarioXml = importer->importScript(_importParameters);
 
     //
-    // Если нету текста, прерываем выполнение
+    // ... потоки пула переиспользуются, поэтому не оставляем им чужих счётчиков
+    //
+    FormatManager::setThreadProgress(nullptr, nullptr);
+    return result;
+}
+
+void ImportManager::aboutUpdateImportProgress()
+{
+    m_importProgress->setProgressValue(m_importProgressValue.load());
+}
+
+void ImportManager::aboutImportFinished()
+{
+    m_isImporting = false;
+    m_importProgressTimer.stop();
+
+    //
+    // Результат отменённого импорта, или импорта в уже удалённый сценарий, отбрасываем
+    //
+    if (m_importCancelled.load() != 0
+        || m_scenario.isNull()) {
+        m_importProgress->finish();
+        return;
+    }
+
+    const ImportResult importResult = m_importWatcher.result();
+    const QString& importScenarioXml = importResult.scenarioXml;
+
+    //
+    // Если нету текста, уведомим об этом пользователя и прерываем выполнение
     //
     if (importScenarioXml.isEmpty()) {
-        return false;
+        QLightBoxMessage::critical(m_importDialog->parentWidget(), tr("Import aborted"),
+            tr("File to import is empty. Please check that you select correct file and retry import."));
+        m_importProgress->finish();
+        return;
     }
 
     //
@@ -176,38 +300,38 @@ bool ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
     // ... определим позицию вставки
     //
     int insertPosition = 0;
-    switch (_importParameters.insertionMode) {
+    switch (m_importParameters.insertionMode) {
         case BusinessLogic::ImportParameters::ReplaceDocument: {
-            _scenario->clear();
+            m_scenario->clear();
             insertPosition = 0;
             break;
         }
 
         case BusinessLogic::ImportParameters::ToCursorPosition: {
-            insertPosition = _cursorPosition;
+            insertPosition = m_cursorPosition;
             break;
         }
 
         default:
         case BusinessLogic::ImportParameters::ToDocumentEnd: {
-            insertPosition = _scenario->document()->characterCount() - 1;
+            insertPosition = m_scenario->document()->characterCount() - 1;
             break;
         }
     }
     //
     // ... загрузим текст
     //
-    _scenario->document()->insertFromMime(insertPosition, importScenarioXml);
+    m_scenario->document()->insertFromMime(insertPosition, importScenarioXml);
 
     //
     // ... в случае необходимости определяем локации и персонажей
     //
-    if (_importParameters.findCharactersAndLocations) {
+    if (m_importParameters.findCharactersAndLocations) {
         //
         // Персонажи
         //
         {
-            const QSet<QString> characters = QSet<QString>::fromList(_scenario->findCharacters());
+            const QSet<QString> characters = QSet<QString>::fromList(m_scenario->findCharacters());
 
             //
             // Определить персонажи, которых нет в тексте
@@ -246,7 +370,7 @@ bool ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
         // Локации
         //
         {
-            const QSet<QString> locations = QSet<QString>::fromList(_scenario->findLocations());
+            const QSet<QString> locations = QSet<QString>::fromList(m_scenario->findLocations());
 
             //
             // Определить локации, которых нет в тексте
@@ -286,7 +410,7 @@ bool ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
     //
     // Загрузим данные разработки
     //
-    const QVariantMap research = importer->importResearch(_importParameters);
+    const QVariantMap& research = importResult.research;
     if (!research.isEmpty()) {
         //
         // Данные сценария
@@ -337,7 +461,12 @@ bool ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
         }
     }
 
-    return true;
+    //
+    // Закроем уведомление
+    //
+    m_importProgress->finish();
+
+    emit scenarioImported();
 }
 
 void ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, const QString& _importFilePath)
@@ -371,38 +500,20 @@ void ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
             return;
         }
 
-        //
-        // Покажем уведомление пользователю
-        //
-        QLightBoxProgress progress(m_importDialog->parentWidget());
-        progress.showProgress(tr("Import"), tr("Please wait. Import can take few minutes."));
-
         //
         // Импортируем
         //
-        const bool isImportSucceed = importScenario(_scenario, _cursorPosition, importParameters);
-
-        //
-        // Если импорт не удался, уведомим об этом пользователя
-        //
-        if (!isImportSucceed) {
-            QLightBoxMessage::critical(m_importDialog->parentWidget(), tr("Import aborted"),
-                tr("File to import is empty. Please check that you select correct file and retry import."));
-        }
-
-        //
-        // Закроем уведомление
-        //
-        progress.finish();
+        importScenario(_scenario, _cursorPosition, importParameters);
     }
 }
 
 void ImportManager::initView()
 {
-
+    m_importProgressTimer.setInterval(PROGRESS_UPDATE_INTERVAL);
 }
 
 void ImportManager::initConnections()
 {
-
+    connect(&m_importWatcher, &QFutureWatcher<ImportResult>::finished, this, &ImportManager::aboutImportFinished);
+    connect(&m_importProgressTimer, &QTimer::timeout, this, &ImportManager::aboutUpdateImportProgress);
 }
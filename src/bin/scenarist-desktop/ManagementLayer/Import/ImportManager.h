@@ -1,11 +1,19 @@
 #ifndef IMPORTMANAGER_H
 #define IMPORTMANAGER_H
 
+#include <BusinessLayer/Import/AbstractImporter.h>
+
+#include <QAtomicInt>
+#include <QFutureWatcher>
 #include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVariantMap>
+
+class QLightBoxProgress;
 
 namespace BusinessLogic {
     class ScenarioDocument;
-    class ImportParameters;
 }
 
 namespace UserInterface {
@@ -24,17 +32,43 @@ namespace ManagementLayer
 
     public:
         explicit ImportManager(QObject* _parent, QWidget* _parentWidget);
+        ~ImportManager();
 
         /**
          * @brief Импортировать сценарий
+         * @note Файл разбирается в отдельном потоке, по окончании импорта испускается
+         *       сигнал scenarioImported(), новый импорт до этого момента не начинается,
+         *       если текущий не был отменён
          */
         /** @{ */
-        bool importScenario(BusinessLogic::ScenarioDocument* _scenario, int _cursorPosition,
+        void importScenario(BusinessLogic::ScenarioDocument* _scenario, int _cursorPosition,
             const BusinessLogic::ImportParameters& _importParameters);
         void importScenario(BusinessLogic::ScenarioDocument* _scenario, const QString& _importFilePath);
         void importScenario(BusinessLogic::ScenarioDocument* _scenario, int _cursorPosition);
         /** @} */
 
+        /**
+         * @brief Отменить текущий импорт, его результат не будет загружен в сценарий
+         */
+        void cancelImport();
+
+    signals:
+        /**
+         * @brief Импортированный сценарий загружен в документ
+         */
+        void scenarioImported();
+
+    private slots:
+        /**
+         * @brief Разбор файла завершён, загрузить результат в сценарий
+         */
+        void aboutImportFinished();
+
+        /**
+         * @brief Обновить прогресс разбора файла
+         */
+        void aboutUpdateImportProgress();
+
     private:
         /**
          * @brief Настроить представление
@@ -46,11 +80,73 @@ namespace ManagementLayer
          */
         void initConnections();
 
+    private:
+        /**
+         * @brief Результат разбора файла, передаётся из потока импорта целиком
+         */
+        struct ImportResult {
+            /**
+             * @brief Текст сценария в xml-представлении
+             */
+            QString scenarioXml;
+
+            /**
+             * @brief Данные разработки
+             */
+            QVariantMap research;
+        };
+
+        /**
+         * @brief Разобрать файл, выполняется в потоке импорта собственным импортёром
+         */
+        static ImportResult importFile(const BusinessLogic::ImportParameters& _importParameters,
+            QAtomicInt* _progress, const QAtomicInt* _cancelled);
+
     private:
         /**
          * @brief Диалог экспорта
          */
         UserInterface::ImportDialog* m_importDialog;
+
+        /**
+         * @brief Уведомление о ходе импорта
+         */
+        QLightBoxProgress* m_importProgress;
+
+        /**
+         * @brief Разбор импортируемого файла в отдельном потоке
+         */
+        QFutureWatcher<ImportResult> m_importWatcher;
+
+        /**
+         * @brief Идёт ли импорт
+         */
+        bool m_isImporting;
+
+        /**
+         * @brief Процент разобранного файла, заполняется потоком импорта
+         */
+        QAtomicInt m_importProgressValue;
+
+        /**
+         * @brief Флаг отмены импорта, проверяется потоком импорта
+         */
+        QAtomicInt m_importCancelled;
+
+        /**
+         * @brief Таймер обновления прогресса импорта
+         */
+        QTimer m_importProgressTimer;
+
+        /**
+         * @brief Параметры текущего импорта
+         * @note Сценарий может быть удалён, пока файл разбирается
+         */
+        /** @{ */
+        BusinessLogic::ImportParameters m_importParameters;
+        QPointer<BusinessLogic::ScenarioDocument> m_scenario;
+        int m_cursorPosition;
+        /** @} */
     };
 }
 
@@ -18,6 +18,8 @@
 
 #include <NetworkRequestLoader.h>
 
+#include <hunspell/hunspell.hxx>
+
 #include <QApplication>
 #include <QFileDialog>
 #include <QSplitter>
@@ -322,6 +324,7 @@ void SettingsManager::scenarioEditSpellCheckLanguageChanged(int _value)
     const QString languageCode = SpellChecker::languageCode((SpellChecker::Language)_value);
     const QString affFileName = languageCode + ".aff";
     const QString dicFileName = languageCode + ".dic";
+    const QString hdicFileName = languageCode + ".hdic";
     //
     // Получим информацию о файлах словаря
     //
@@ -342,6 +345,7 @@ void SettingsManager::scenarioEditSpellCheckLanguageChanged(int _value)
     //
     // Если не установлен, скачаем
     //
+    bool needCompileDictionary = !QFile::exists(hunspellDictionariesFolderPath + hdicFileName);
     if (!affFileInfo.exists() || !dicFileInfo.exists()) {
         //
         // ... покажем прелоадер
@@ -382,6 +386,11 @@ void SettingsManager::scenarioEditSpellCheckLanguageChanged(int _value)
             dicFile.close();
         }
 
+        //
+        // ... образ прошлой версии словаря больше не подходит
+        //
+        needCompileDictionary = downloadingAffFileSuccess && downloadingDicFileSuccess;
+
         //
         // ... скрываем прогресс
         //
@@ -397,6 +406,15 @@ void SettingsManager::scenarioEditSpellCheckLanguageChanged(int _value)
             m_view->setScenarioEditSpellCheck(false);
         }
     }
+
+    //
+    // Собираем образ словаря, чтобы проверка орфографии не разбирала его файлы при каждой загрузке
+    //
+    if (needCompileDictionary) {
+        Hunspell::compile(
+            QFile::encodeName(hunspellDictionariesFolderPath + affFileName).constData(),
+            QFile::encodeName(hunspellDictionariesFolderPath + dicFileName).constData());
+    }
 }
 
 void SettingsManager::scenarioEditTextColorChanged(const QColor&_value)
@@ -0,0 +1,43 @@
+TARGET   = fileformats-bench
+TEMPLATE = app
+
+#
+# Build configuration
+#
+CONFIG += console c++11 thread warn_on
+CONFIG -= app_bundle
+QT += concurrent gui
+
+#
+# The library sources are built into the benchmark, so nothing is imported
+#
+DEFINES += FILEFORMATS_LIBRARY
+
+QMAKE_MAC_SDK = macosx10.12
+
+#
+# Конфигурируем расположение файлов сборки
+#
+CONFIG(debug, debug|release) {
+    DESTDIR = $$PWD/../../../../build/Debug/libs/fileformats/bench
+} else {
+    DESTDIR = $$PWD/../../../../build/Release/libs/fileformats/bench
+}
+
+OBJECTS_DIR = $$DESTDIR/.obj
+MOC_DIR = $$DESTDIR/.moc
+RCC_DIR = $$DESTDIR/.qrc
+UI_DIR = $$DESTDIR/.ui
+#
+
+mac {
+     LIBS += -lz
+}
+win32 {
+     LIBS += -lpsapi
+}
+
+include(../fileformats.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,332 @@
+/*
+ * fileformats-bench: runs every reader and DocxWriter over generated scripts
+ * and reports throughput, heap allocations and peak resident memory.
+ *
+ *     fileformats-bench [iterations]
+ *
+ * The corpus is generated in memory, so runs are reproducible and do not
+ * depend on the disk. Output is one tab-separated line per format and size,
+ * which keeps it easy to diff between builds.
+ */
+
+#include "docx_reader.h"
+#include "docx_writer.h"
+#include "odt_reader.h"
+#include "rtf_reader.h"
+#include "txt_reader.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QScopedPointer>
+#include <QTextBlock>
+#include <QTextBlockFormat>
+#include <QTextCharFormat>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextDocumentWriter>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	std::atomic<quint64> allocation_count(0);
+	std::atomic<quint64> allocation_bytes(0);
+}
+
+void* operator new(std::size_t size)
+{
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+	void* p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Roughly one screenplay page
+	const int lines_per_page = 55;
+
+	qint64 peakResidentKiB()
+	{
+#if defined(Q_OS_WIN)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return qint64(counters.PeakWorkingSetSize / 1024);
+		}
+		return 0;
+#else
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+#if defined(Q_OS_MAC)
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+#endif
+	}
+
+	QString sceneText(int line)
+	{
+		static const char* const words[] = {
+			"door", "window", "light", "quietly", "across", "the", "room", "she",
+			"he", "looks", "back", "at", "table", "coffee", "rain", "street",
+			"café", "naïve", "Überweg", "тишина"
+		};
+		const int count = sizeof(words) / sizeof(words[0]);
+		QString text;
+		const int length = 6 + (line * 7) % 18;
+		for (int i = 0; i < length; ++i) {
+			if (i) {
+				text += QLatin1Char(' ');
+			}
+			text += QString::fromUtf8(words[(line * 31 + i * 17) % count]);
+		}
+		return text;
+	}
+
+	// A script with scene headings, action, characters and dialogue, using
+	// a handful of shared formats the way real scripts do
+	QTextDocument* generateScript(int pages)
+	{
+		QTextDocument* document = new QTextDocument;
+		QTextCursor cursor(document);
+
+		QTextBlockFormat heading_format;
+		heading_format.setProperty(QTextFormat::UserProperty, 2);
+		QTextBlockFormat action_format;
+		QTextBlockFormat character_format;
+		character_format.setAlignment(Qt::AlignCenter);
+		QTextBlockFormat dialogue_format;
+		dialogue_format.setIndent(1);
+
+		QTextCharFormat plain;
+		QTextCharFormat bold;
+		bold.setFontWeight(QFont::Bold);
+		QTextCharFormat italic;
+		italic.setFontItalic(true);
+
+		const int lines = pages * lines_per_page;
+		for (int line = 0; line < lines; ++line) {
+			if (line) {
+				cursor.insertBlock();
+			}
+			switch (line % 11) {
+			case 0:
+				cursor.setBlockFormat(heading_format);
+				cursor.insertText(QString::fromLatin1("INT. ROOM %1 - NIGHT").arg(line), bold);
+				break;
+			case 3:
+			case 7:
+				cursor.setBlockFormat(character_format);
+				cursor.insertText(QString::fromLatin1("CHARACTER %1").arg(line % 5), plain);
+				break;
+			case 4:
+			case 8:
+				cursor.setBlockFormat(dialogue_format);
+				cursor.insertText(sceneText(line), plain);
+				cursor.insertText(QString::fromLatin1(" (beat) "), italic);
+				cursor.insertText(sceneText(line + 1), plain);
+				break;
+			default:
+				cursor.setBlockFormat(action_format);
+				cursor.insertText(sceneText(line), plain);
+				break;
+			}
+		}
+		return document;
+	}
+
+	QByteArray toRtf(const QTextDocument* document)
+	{
+		QByteArray rtf = "{\\rtf1\\ansi\\ansicpg1252\\deff0{\\fonttbl{\\f0 Courier New;}}\n";
+		for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+			rtf += "\\pard";
+			if (block.blockFormat().alignment() & Qt::AlignHCenter) {
+				rtf += "\\qc";
+			}
+			rtf += ' ';
+			for (QTextBlock::iterator iter = block.begin(); !iter.atEnd(); ++iter) {
+				const QTextFragment fragment = iter.fragment();
+				const bool bold = fragment.charFormat().fontWeight() == QFont::Bold;
+				const bool italic = fragment.charFormat().fontItalic();
+				rtf += bold ? "{\\b " : (italic ? "{\\i " : "{");
+				const QString text = fragment.text();
+				for (int i = 0; i < text.length(); ++i) {
+					const ushort c = text.at(i).unicode();
+					if (c == '\\' || c == '{' || c == '}') {
+						rtf += '\\';
+						rtf += char(c);
+					} else if (c < 0x80) {
+						rtf += char(c);
+					} else if (c < 0x100) {
+						rtf += "\\'" + QByteArray::number(c, 16);
+					} else {
+						rtf += "\\u" + QByteArray::number(short(c)) + '?';
+					}
+				}
+				rtf += '}';
+			}
+			rtf += "\\par\n";
+		}
+		rtf += '}';
+		return rtf;
+	}
+
+	QByteArray toDocx(const QTextDocument* document)
+	{
+		QByteArray data;
+		QBuffer buffer(&data);
+		buffer.open(QIODevice::WriteOnly);
+		DocxWriter writer;
+		writer.write(&buffer, document);
+		return data;
+	}
+
+	QByteArray toOdt(QTextDocument* document)
+	{
+		QByteArray data;
+		QBuffer buffer(&data);
+		buffer.open(QIODevice::WriteOnly);
+		QTextDocumentWriter writer(&buffer, "odf");
+		writer.write(document);
+		return data;
+	}
+
+	struct Measurement
+	{
+		double seconds;
+		quint64 allocations;
+		quint64 allocated_bytes;
+	};
+
+	template <typename Run>
+	Measurement measure(int iterations, Run run)
+	{
+		const quint64 count = allocation_count.load();
+		const quint64 bytes = allocation_bytes.load();
+		QElapsedTimer timer;
+		timer.start();
+		for (int i = 0; i < iterations; ++i) {
+			run();
+		}
+		Measurement result;
+		result.seconds = timer.nsecsElapsed() / 1e9;
+		result.allocations = (allocation_count.load() - count) / iterations;
+		result.allocated_bytes = (allocation_bytes.load() - bytes) / iterations;
+		return result;
+	}
+
+	template <typename Reader>
+	Measurement measureReader(const QByteArray& data, int iterations, QString* error)
+	{
+		return measure(iterations, [&data, error] {
+			QByteArray bytes = data;
+			QBuffer buffer(&bytes);
+			buffer.open(QIODevice::ReadOnly);
+			QTextDocument document;
+			Reader reader;
+			reader.read(&buffer, &document);
+			if (reader.hasError()) {
+				*error = reader.errorString();
+			}
+		});
+	}
+
+	void report(const char* name, int pages, qint64 size, int iterations, const Measurement& measurement, const QString& error)
+	{
+		const double megabytes = size / (1024.0 * 1024.0);
+		std::printf("%-12s\t%4d pages\t%8.2f MB\t%9.2f MB/s\t%10llu allocs\t%10llu KiB allocated\t%8lld KiB peak RSS%s%s\n",
+				name,
+				pages,
+				megabytes,
+				megabytes * iterations / measurement.seconds,
+				static_cast<unsigned long long>(measurement.allocations),
+				static_cast<unsigned long long>(measurement.allocated_bytes / 1024),
+				static_cast<long long>(peakResidentKiB()),
+				error.isEmpty() ? "" : "\terror: ",
+				qPrintable(error));
+		std::fflush(stdout);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+	// Layout needs a platform plugin, but nothing is ever shown
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	QGuiApplication app(argc, argv);
+
+	const int iterations = (argc > 1) ? qMax(1, atoi(argv[1])) : 3;
+	const int sizes[] = { 10, 50, 100, 250, 500 };
+
+	for (int size : sizes) {
+		QScopedPointer<QTextDocument> script(generateScript(size));
+		const QByteArray rtf = toRtf(script.data());
+		const QByteArray docx = toDocx(script.data());
+		const QByteArray odt = toOdt(script.data());
+		const QByteArray txt = script->toPlainText().toUtf8();
+
+		QString error;
+		report("RtfReader", size, rtf.size(), iterations, measureReader<RtfReader>(rtf, iterations, &error), error);
+		error.clear();
+		report("DocxReader", size, docx.size(), iterations, measureReader<DocxReader>(docx, iterations, &error), error);
+		error.clear();
+		report("OdtReader", size, odt.size(), iterations, measureReader<OdtReader>(odt, iterations, &error), error);
+		error.clear();
+		report("TxtReader", size, txt.size(), iterations, measureReader<TxtReader>(txt, iterations, &error), error);
+		error.clear();
+
+		const Measurement writing = measure(iterations, [&script] {
+			toDocx(script.data());
+		});
+		report("DocxWriter", size, docx.size(), iterations, writing, error);
+	}
+
+	return 0;
+}
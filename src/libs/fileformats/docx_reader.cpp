@@ -23,8 +23,15 @@
 
 #include "qtzip/QtZipReader"
 
+#include <QFuture>
+#include <QScopedPointer>
+#include <QTextBlock>
 #include <QTextDocument>
 #include <QXmlStreamAttributes>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <set>
 
 namespace {
     qreal pixelsFromTwips(qint32 _twips)
@@ -34,6 +41,17 @@ namespace {
         return pixels;
     }
 
+    //
+    // Сравнение идентификаторов стилей без создания строк
+    //
+    struct StyleIdLess
+    {
+        bool operator()(const std::pair<QString, int>& _left, const QStringRef& _right) const
+        {
+            return QStringRef::compare(_right, _left.first) > 0;
+        }
+    };
+
     static bool readBool(const QStringRef& value)
     {
         // ECMA-376, ISO/IEC 29500 strict
@@ -57,48 +75,51 @@ namespace {
             return true;
         }
     }
-}
-
-//-----------------------------------------------------------------------------
 
-void DocxReader::Comment::insertIfReady(const QTextCursor& _cursor) const
-{
-    if (start_position != -1 && end_position != -1 && start_position < end_position && !text.isEmpty()) {
-        QTextCursor commentCursor(_cursor);
-        commentCursor.setPosition(start_position);
-        commentCursor.setPosition(end_position, QTextCursor::KeepAnchor);
-        QTextCharFormat format = commentCursor.charFormat();
-        //
+    //
+    // Формат отрезка текста с заданными комментариями
+    //
+    static QTextCharFormat commentsFormat(const QStringList& _comments, const QStringList& _authors,
+        const QStringList& _dates)
+    {
+        QTextCharFormat format;
         format.setProperty(Docx::IsComment, true);
+        format.setProperty(Docx::Comments, _comments);
+        format.setProperty(Docx::CommentsAuthors, _authors);
+        format.setProperty(Docx::CommentsDates, _dates);
         //
-        // Проверяем, не добавлен ли ещё этот комментарий
+        // Цвет настраивается по первому автору
         //
-        QStringList comments = format.property(Docx::Comments).toStringList();
-        if (!comments.contains(text)) {
-            comments.append(text);
-            format.setProperty(Docx::Comments, comments);
-            //
-            QStringList authors = format.property(Docx::CommentsAuthors).toStringList();
-            authors.append(author);
-            format.setProperty(Docx::CommentsAuthors, authors);
-            //
-            QStringList dates = format.property(Docx::CommentsDates).toStringList();
-            dates.append(date);
-            format.setProperty(Docx::CommentsDates, dates);
-            //
-            // Цвет настраивается по первому автору
-            //
-            format.setBackground(Docx::commentColor(authors.first()));
+        if (!_authors.isEmpty()) {
+            format.setBackground(Docx::commentColor(_authors.first()));
             format.setForeground(Qt::black);
-            //
-            commentCursor.mergeCharFormat(format);
         }
+        return format;
     }
+
+    static void mergeFormat(QTextCursor& _cursor, int _start, int _end, const QTextCharFormat& _format)
+    {
+        if (_start < _end) {
+            _cursor.setPosition(_start);
+            _cursor.setPosition(_end, QTextCursor::KeepAnchor);
+            _cursor.mergeCharFormat(_format);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool DocxReader::Comment::isReady() const
+{
+    return start_position != -1 && end_position != -1 && start_position < end_position && !text.isEmpty();
 }
 
 //-----------------------------------------------------------------------------
 
 DocxReader::DocxReader() :
+    m_read_size(0),
+    m_part_size(0),
+    m_total_size(0),
     m_in_block(false)
 {
     m_xml.setNamespaceProcessing(false);
@@ -113,6 +134,13 @@ bool DocxReader::canRead(QIODevice* device)
 
 //-----------------------------------------------------------------------------
 
+bool DocxReader::canRead(const QByteArray& header)
+{
+    return QtZipReader::canRead(header);
+}
+
+//-----------------------------------------------------------------------------
+
 void DocxReader::readData(QIODevice* device)
 {
     m_in_block = m_cursor.document()->blockCount();
@@ -123,23 +151,51 @@ void DocxReader::readData(QIODevice* device)
 
     // Read archive
     if (zip.isReadable()) {
-        const QString files[] = {
-            QString::fromLatin1("word/styles.xml"),
-            QString::fromLatin1("word/comments.xml"),
-            QString::fromLatin1("word/document.xml")
-        };
+        //
+        // Читаем части архива потоком, не распаковывая их целиком в память
+        //
+        QScopedPointer<QIODevice> styles(zip.openEntry(QString::fromLatin1("word/styles.xml")));
+        QScopedPointer<QIODevice> comments(zip.openEntry(QString::fromLatin1("word/comments.xml")));
+        QScopedPointer<QIODevice> document(zip.openEntry(QString::fromLatin1("word/document.xml")));
+        QIODevice* const entries[] = { styles.data(), comments.data(), document.data() };
+        m_read_size = 0;
+        m_total_size = 0;
         for (int i = 0; i < 3; ++i) {
-            QByteArray data = zip.fileData(files[i]);
-            if (data.isEmpty()) {
-                continue;
+            if (entries[i] != 0) {
+                m_total_size += entries[i]->bytesAvailable();
             }
-            m_xml.addData(data);
-            readContent();
-            if (m_xml.hasError()) {
-                m_error = m_xml.errorString();
-                break;
+        }
+
+        //
+        // Комментарии разбираются потоком из своей части архива в отдельном потоке, пока
+        // здесь читаются стили, документу нужны и те и другие. Части архива, который
+        // не удалось отобразить в память, читаются через общее устройство, поэтому
+        // тогда комментарии разбираются здесь же
+        //
+        QFuture<CommentsPart> commentsPart;
+        const bool hasComments = !comments.isNull() && comments->bytesAvailable() > 0;
+        const bool concurrentComments = hasComments && zip.isMapped();
+        const qint64 commentsSize = hasComments ? comments->bytesAvailable() : 0;
+        if (concurrentComments) {
+            commentsPart = QtConcurrent::run(&DocxReader::readCommentsPart, comments.data());
+        }
+
+        bool ok = readPart(styles.data());
+
+        if (hasComments) {
+            const CommentsPart result = concurrentComments ? commentsPart.result()
+                                                           : readCommentsPart(comments.data());
+            m_comments = result.comments;
+            if (ok && !result.error.isEmpty()) {
+                m_error = result.error;
+                ok = false;
             }
-            m_xml.clear();
+            m_read_size += commentsSize;
+            setProgress(m_read_size, m_total_size);
+        }
+
+        if (ok) {
+            readPart(document.data());
         }
     } else {
         m_error = tr("Unable to open archive.");
@@ -147,8 +203,27 @@ void DocxReader::readData(QIODevice* device)
 
     // Close archive
     zip.close();
+}
+
+//-----------------------------------------------------------------------------
+
+bool DocxReader::readPart(QIODevice* entry)
+{
+    if (entry == 0 || entry->bytesAvailable() == 0) {
+        return true;
+    }
 
-    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    m_part_size = entry->bytesAvailable();
+    m_xml.setDevice(entry);
+    readContent();
+    const bool hasError = m_xml.hasError();
+    if (hasError) {
+        m_error = m_xml.errorString();
+    }
+    m_xml.clear();
+    m_read_size += m_part_size;
+    setProgress(m_read_size, m_total_size);
+    return !hasError;
 }
 
 //-----------------------------------------------------------------------------
@@ -158,8 +233,6 @@ void DocxReader::readContent()
     m_xml.readNextStartElement();
     if (m_xml.qualifiedName() == "w:styles") {
         readStyles();
-    } else if (m_xml.qualifiedName() == "w:comments") {
-        readComments();
     } else if (m_xml.qualifiedName() == "w:document") {
         readDocument();
     }
@@ -202,6 +275,7 @@ void DocxReader::readStyles()
     // Read styles
     QHash<Style::Type, QString> default_style;
     QHash<QString, QStringList> style_tree;
+    QHash<QString, int> style_index;
 
     do {
         if (m_xml.qualifiedName() == "w:style") {
@@ -220,7 +294,7 @@ void DocxReader::readStyles()
 
             // Find style ID
             QString style_id = m_xml.attributes().value(QLatin1String("w:styleId")).toString();
-            if (m_styles.contains(style_id)) {
+            if (style_index.contains(style_id)) {
                 m_xml.skipCurrentElement();
                 continue;
             }
@@ -246,8 +320,9 @@ void DocxReader::readStyles()
                     m_xml.skipCurrentElement();
                 } else if (m_xml.qualifiedName() == "w:basedOn") {
                     QString parent_style_id = m_xml.attributes().value("w:val").toString();
-                    if (m_styles.contains(parent_style_id) && (style.type == m_styles[parent_style_id].type)) {
-                        Style newstyle = m_styles[parent_style_id];
+                    const int parent = style_index.value(parent_style_id, -1);
+                    if ((parent != -1) && (style.type == m_styles[parent].type)) {
+                        Style newstyle = m_styles[parent];
                         newstyle.block_format.merge(style.block_format);
                         newstyle.char_format.merge(style.char_format);
                         style = newstyle;
@@ -264,15 +339,20 @@ void DocxReader::readStyles()
             }
 
             // Add to style list
-            m_styles.insert(style_id, style);
+            style_index.insert(style_id, int(m_styles.size()));
+            m_styles.push_back(style);
 
             // Recursively apply style to children
             QStringList children = style_tree.value(style_id);
             while (!children.isEmpty()) {
                 QString child_id = children.takeFirst();
+                const int child = style_index.value(child_id, -1);
+                if (child == -1) {
+                    continue;
+                }
 
                 Style newstyle = style;
-                Style& childstyle = m_styles[child_id];
+                Style& childstyle = m_styles[child];
                 newstyle.merge(childstyle);
                 childstyle = newstyle;
 
@@ -283,63 +363,101 @@ void DocxReader::readStyles()
         }
     } while (m_xml.readNextStartElement());
 
+    //
+    // Интернируем идентификаторы стилей, в документе они ищутся двоичным поиском
+    //
+    m_style_ids.clear();
+    m_style_ids.reserve(style_index.size());
+    for (QHash<QString, int>::const_iterator iter = style_index.constBegin(); iter != style_index.constEnd(); ++iter) {
+        m_style_ids.push_back(std::make_pair(iter.key(), iter.value()));
+    }
+    std::sort(m_style_ids.begin(), m_style_ids.end());
+
     // Apply default style
-    m_current_style.block_format.merge(m_styles.value(default_style.value(Style::Paragraph)).block_format);
-    m_current_style.char_format.merge(m_styles.value(default_style.value(Style::Character)).char_format);
+    m_current_style.block_format.merge(findStyle(QStringRef(&default_style[Style::Paragraph])).block_format);
+    m_current_style.char_format.merge(findStyle(QStringRef(&default_style[Style::Character])).char_format);
 }
 
 //-----------------------------------------------------------------------------
 
-void DocxReader::readComments()
+DocxReader::Style DocxReader::findStyle(const QStringRef& style_id) const
 {
-    if (!m_xml.readNextStartElement()) {
+    std::vector<std::pair<QString, int> >::const_iterator iter =
+            std::lower_bound(m_style_ids.begin(), m_style_ids.end(), style_id, StyleIdLess());
+    if ((iter != m_style_ids.end()) && (style_id == iter->first)) {
+        return m_styles[iter->second];
+    }
+    return Style();
+}
+
+//-----------------------------------------------------------------------------
+
+DocxReader::CommentsPart DocxReader::readCommentsPart(QIODevice* entry)
+{
+    CommentsPart part;
+    QXmlStreamReader xml(entry);
+    xml.setNamespaceProcessing(false);
+    if (xml.readNextStartElement() && (xml.qualifiedName() == "w:comments")) {
+        readComments(xml, part.comments);
+    }
+    if (xml.hasError()) {
+        part.error = xml.errorString();
+    }
+    return part;
+}
+
+//-----------------------------------------------------------------------------
+
+void DocxReader::readComments(QXmlStreamReader& xml, QHash<QString, Comment>& comments)
+{
+    if (!xml.readNextStartElement()) {
         return;
     }
 
     // Read comments
     do {
-        if (m_xml.qualifiedName() == "w:comment") {
+        if (xml.qualifiedName() == "w:comment") {
             Comment comment;
 
             // Find comment ID
-            const QString comment_id = m_xml.attributes().value(QLatin1String("w:id")).toString();
-            if (m_comments.contains(comment_id)) {
-                m_xml.skipCurrentElement();
+            const QString comment_id = xml.attributes().value(QLatin1String("w:id")).toString();
+            if (comments.contains(comment_id)) {
+                xml.skipCurrentElement();
                 continue;
             }
 
             // Read comment contents
-            comment.author = m_xml.attributes().value(QLatin1String("w:author")).toString();
-            comment.date = m_xml.attributes().value(QLatin1String("w:date")).toString();
-            while (m_xml.readNextStartElement()) {
-                if (m_xml.qualifiedName() == "w:p") {
+            comment.author = xml.attributes().value(QLatin1String("w:author")).toString();
+            comment.date = xml.attributes().value(QLatin1String("w:date")).toString();
+            while (xml.readNextStartElement()) {
+                if (xml.qualifiedName() == "w:p") {
                     if (!comment.text.isEmpty()) {
                         comment.text.append("\n");
                     }
-                    while (m_xml.readNextStartElement()) {
-                        if (m_xml.qualifiedName() == "w:r") {
-                            while (m_xml.readNextStartElement()) {
-                                if (m_xml.qualifiedName() == "w:t") {
-                                    comment.text.append(m_xml.readElementText());
+                    while (xml.readNextStartElement()) {
+                        if (xml.qualifiedName() == "w:r") {
+                            while (xml.readNextStartElement()) {
+                                if (xml.qualifiedName() == "w:t") {
+                                    comment.text.append(xml.readElementText());
                                 } else {
-                                    m_xml.skipCurrentElement();
+                                    xml.skipCurrentElement();
                                 }
                             }
                         } else {
-                            m_xml.skipCurrentElement();
+                            xml.skipCurrentElement();
                         }
                     }
                 } else {
-                    m_xml.skipCurrentElement();
+                    xml.skipCurrentElement();
                 }
             }
 
             // Add to comments list
-            m_comments.insert(comment_id, comment);
-        } else if (m_xml.tokenType() != QXmlStreamReader::EndElement) {
-            m_xml.skipCurrentElement();
+            comments.insert(comment_id, comment);
+        } else if (xml.tokenType() != QXmlStreamReader::EndElement) {
+            xml.skipCurrentElement();
         }
-    } while (m_xml.readNextStartElement());
+    } while (xml.readNextStartElement());
 }
 
 //-----------------------------------------------------------------------------
@@ -354,11 +472,123 @@ void DocxReader::readDocument()
             m_xml.skipCurrentElement();
         }
     }
+    applyComments();
     m_cursor.endEditBlock();
 }
 
 //-----------------------------------------------------------------------------
 
+void DocxReader::addComment()
+{
+    //
+    // Комментарии применяются все сразу, когда текст документа уже загружен
+    //
+    if (m_current_comment.isReady()) {
+        m_comment_ranges.append(m_current_comment);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void DocxReader::applyComments()
+{
+    if (m_comment_ranges.isEmpty()) {
+        return;
+    }
+
+    //
+    // Упорядочиваем границы диапазонов: между соседними границами набор комментариев
+    // не меняется, поэтому формат каждого отрезка текста обновляется только один раз
+    //
+    std::vector<std::pair<int, int> > bounds;
+    bounds.reserve(m_comment_ranges.size() * 2);
+    for (int i = 0; i < m_comment_ranges.size(); ++i) {
+        bounds.push_back(std::make_pair(m_comment_ranges.at(i).start_position, i + 1));
+        bounds.push_back(std::make_pair(m_comment_ranges.at(i).end_position, -(i + 1)));
+    }
+    std::sort(bounds.begin(), bounds.end());
+
+    QTextCursor cursor(m_cursor);
+    std::set<int> active;
+    size_t index = 0;
+    while (index < bounds.size()) {
+        const int position = bounds[index].first;
+        for (; index < bounds.size() && bounds[index].first == position; ++index) {
+            if (bounds[index].second > 0) {
+                active.insert(bounds[index].second - 1);
+            } else {
+                active.erase(-bounds[index].second - 1);
+            }
+        }
+        if (active.empty() || index == bounds.size()) {
+            continue;
+        }
+
+        //
+        // Комментарии отрезка в порядке их появления, одинаковые не повторяем
+        //
+        QStringList comments;
+        QStringList authors;
+        QStringList dates;
+        for (std::set<int>::const_iterator iter = active.begin(); iter != active.end(); ++iter) {
+            const Comment& comment = m_comment_ranges.at(*iter);
+            if (!comments.contains(comment.text)) {
+                comments.append(comment.text);
+                authors.append(comment.author);
+                dates.append(comment.date);
+            }
+        }
+
+        //
+        // Комментарии, которые уже были в документе до чтения, сохраняем, дополняя
+        // их прочитанными. Их отрезки собираем заранее, т.к. изменение формата
+        // перестраивает фрагменты текста
+        //
+        const int end = bounds[index].first;
+        std::vector<std::pair<int, int> > commented;
+        QVector<QTextCharFormat> commentedFormats;
+        for (QTextBlock block = m_cursor.document()->findBlock(position);
+             block.isValid() && block.position() < end;
+             block = block.next()) {
+            for (QTextBlock::iterator iter = block.begin(); !iter.atEnd(); ++iter) {
+                const QTextFragment fragment = iter.fragment();
+                const int fragmentStart = qMax(fragment.position(), position);
+                const int fragmentEnd = qMin(fragment.position() + fragment.length(), end);
+                if ((fragmentStart < fragmentEnd)
+                    && fragment.charFormat().hasProperty(Docx::Comments)) {
+                    commented.push_back(std::make_pair(fragmentStart, fragmentEnd));
+                    commentedFormats.append(fragment.charFormat());
+                }
+            }
+        }
+
+        const QTextCharFormat format = commentsFormat(comments, authors, dates);
+        int uncommentedStart = position;
+        for (size_t i = 0; i < commented.size(); ++i) {
+            mergeFormat(cursor, uncommentedStart, commented[i].first, format);
+
+            const QTextCharFormat& existing = commentedFormats.at(int(i));
+            QStringList mergedComments = existing.property(Docx::Comments).toStringList();
+            QStringList mergedAuthors = existing.property(Docx::CommentsAuthors).toStringList();
+            QStringList mergedDates = existing.property(Docx::CommentsDates).toStringList();
+            for (int j = 0; j < comments.size(); ++j) {
+                if (!mergedComments.contains(comments.at(j))) {
+                    mergedComments.append(comments.at(j));
+                    mergedAuthors.append(authors.at(j));
+                    mergedDates.append(dates.at(j));
+                }
+            }
+            mergeFormat(cursor, commented[i].first, commented[i].second,
+                commentsFormat(mergedComments, mergedAuthors, mergedDates));
+            uncommentedStart = commented[i].second;
+        }
+        mergeFormat(cursor, uncommentedStart, end, format);
+    }
+    m_comment_ranges.clear();
+}
+
+//-----------------------------------------------------------------------------
+
 void DocxReader::readBody()
 {
     while (m_xml.readNextStartElement()) {
@@ -372,7 +602,7 @@ void DocxReader::readBody()
         } else if ((m_xml.qualifiedName() == "w:commentRangeEnd")
                    || (m_xml.qualifiedName() == "w:bookmarkEnd")) {
             m_current_comment.end_position = m_cursor.position();
-            m_current_comment.insertIfReady(m_cursor);
+            addComment();
 
             m_xml.skipCurrentElement();
         } else {
@@ -417,7 +647,7 @@ void DocxReader::readParagraph()
             } else if ((m_xml.qualifiedName() == "w:commentRangeEnd")
                        || (m_xml.qualifiedName() == "w:bookmarkEnd")) {
                 m_current_comment.end_position = m_cursor.position();
-                m_current_comment.insertIfReady(m_cursor);
+                addComment();
 
                 m_xml.skipCurrentElement();
             } else if (m_xml.tokenType() != QXmlStreamReader::EndElement) {
@@ -432,7 +662,21 @@ void DocxReader::readParagraph()
         m_current_style = m_previous_styles.pop();
     }
 
-    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    updateProgress();
+}
+
+//-----------------------------------------------------------------------------
+
+void DocxReader::updateProgress()
+{
+    //
+    // Отмена прерывает разбор так же, как ошибка в документе
+    //
+    if (isCancelled()) {
+        m_xml.raiseError(cancelledError());
+        return;
+    }
+    setProgress(m_read_size + m_part_size - m_xml.device()->bytesAvailable(), m_total_size);
 }
 
 //-----------------------------------------------------------------------------
@@ -487,7 +731,7 @@ void DocxReader::readParagraphProperties(Style& style, bool allowstyles)
             int heading = qBound(1, m_xml.attributes().value("w:val").toString().toInt() + 1, 6);
             style.block_format.setProperty(QTextFormat::UserProperty, heading);
         } else if ((m_xml.qualifiedName() == "w:pStyle") && allowstyles) {
-            Style pstyle = m_styles.value(value.toString());
+            Style pstyle = findStyle(value);
             pstyle.merge(style);
             style = pstyle;
         } else if (m_xml.qualifiedName() == "w:rPr") {
@@ -549,7 +793,7 @@ void DocxReader::readRun()
                 m_current_comment.text = m_comments.value(comment_id).text;
                 m_current_comment.author = m_comments.value(comment_id).author;
                 m_current_comment.date = m_comments.value(comment_id).date;
-                m_current_comment.insertIfReady(m_cursor);
+                addComment();
                 m_xml.skipCurrentElement();
             } else if (m_xml.tokenType() != QXmlStreamReader::EndElement) {
                 m_xml.skipCurrentElement();
@@ -611,7 +855,7 @@ void DocxReader::readRunProperties(Style& style, bool allowstyles)
                 style.char_format.setFontCapitalization(QFont::AllUppercase);
             }
         } else if ((m_xml.qualifiedName() == "w:rStyle") && allowstyles) {
-            Style rstyle = m_styles.value(value.toString());
+            Style rstyle = findStyle(value);
             rstyle.merge(style);
             style = rstyle;
         }
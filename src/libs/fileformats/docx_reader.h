@@ -25,10 +25,14 @@
 #include <QCoreApplication>
 #include <QHash>
 #include <QStack>
+#include <QVector>
 #include <QTextBlockFormat>
 #include <QTextCharFormat>
 #include <QXmlStreamReader>
 
+#include <utility>
+#include <vector>
+
 class DocxReader : public FormatReader
 {
 	Q_DECLARE_TR_FUNCTIONS(DocxReader)
@@ -71,7 +75,13 @@ class DocxReader : public FormatReader
 			date.clear();
 		}
 
-		void insertIfReady(const QTextCursor& _cursor) const;
+		bool isReady() const;
+	};
+
+	struct CommentsPart
+	{
+		QHash<QString, Comment> comments;
+		QString error;
 	};
 
 public:
@@ -84,12 +94,16 @@ public:
 	}
 
 	static bool canRead(QIODevice* device);
+	static bool canRead(const QByteArray& header);
 
 private:
 	void readData(QIODevice* device);
+	bool readPart(QIODevice* entry);
 	void readContent();
 	void readStyles();
-	void readComments();
+	static CommentsPart readCommentsPart(QIODevice* entry);
+	static void readComments(QXmlStreamReader& xml, QHash<QString, Comment>& comments);
+	Style findStyle(const QStringRef& style_id) const;
 	void readDocument();
 	void readBody();
 	void readParagraph();
@@ -97,16 +111,26 @@ private:
 	void readRun();
 	void readRunProperties(Style& style, bool allowstyles = true);
 	void readText();
+	void addComment();
+	void applyComments();
+	void updateProgress();
 
 private:
 	QXmlStreamReader m_xml;
-
-	QHash<QString, Style> m_styles;
+	qint64 m_read_size;
+	qint64 m_part_size;
+	qint64 m_total_size;
+
+	// Styles with the formats of their parents already merged in, and their
+	// ids sorted for lookup without hashing
+	std::vector<Style> m_styles;
+	std::vector<std::pair<QString, int> > m_style_ids;
 	QStack<Style> m_previous_styles;
 	Style m_current_style;
 
 	QHash<QString, Comment> m_comments;
 	Comment m_current_comment;
+	QVector<Comment> m_comment_ranges;
 
 	bool m_in_block;
 };
@@ -26,6 +26,7 @@
 #include <QTextBlockFormat>
 #include <QTextCharFormat>
 #include <QTextDocument>
+#include <QThreadPool>
 
 //-----------------------------------------------------------------------------
 
@@ -49,6 +50,7 @@ bool DocxWriter::write(QIODevice* device, const QTextDocument* document)
 	if (zip.status() != QtZipWriter::NoError) {
 		return false;
 	}
+	zip.setThreadPool(QThreadPool::globalInstance());
 
 	zip.addFile(QString::fromLatin1("_rels/.rels"),
 		"<?xml version=\"1.0\"?>"
@@ -62,9 +64,6 @@ bool DocxWriter::write(QIODevice* device, const QTextDocument* document)
 		"<Relationship Target=\"styles.xml\" Id=\"docRId0\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\"/>"
 		"</Relationships>");
 
-	zip.addFile(QString::fromLatin1("word/document.xml"),
-		writeDocument(document));
-
 	zip.addFile(QString::fromLatin1("word/styles.xml"),
 		"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
 		"<w:styles xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\">"
@@ -157,6 +156,13 @@ bool DocxWriter::write(QIODevice* device, const QTextDocument* document)
 		"<Override PartName=\"/word/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.wordprocessingml.styles+xml\"/>"
 		"</Types>");
 
+	// The document body is compressed into the archive while it is written
+	QIODevice* entry = zip.beginEntry(QString::fromLatin1("word/document.xml"));
+	if (entry) {
+		writeDocument(document, entry);
+		zip.endEntry();
+	}
+
 	zip.close();
 
 	return zip.status() == QtZipWriter::NoError;
@@ -164,12 +170,9 @@ bool DocxWriter::write(QIODevice* device, const QTextDocument* document)
 
 //-----------------------------------------------------------------------------
 
-QByteArray DocxWriter::writeDocument(const QTextDocument* document)
+void DocxWriter::writeDocument(const QTextDocument* document, QIODevice* device)
 {
-	QByteArray data;
-	QBuffer buffer(&data);
-	buffer.open(QIODevice::WriteOnly);
-	m_xml.setDevice(&buffer);
+	m_xml.setDevice(device);
 	m_xml.setCodec("UTF-8");
 	m_xml.writeNamespace(QString::fromLatin1("http://schemas.openxmlformats.org/wordprocessingml/2006/main"), QString::fromLatin1("w"));
 	m_xml.writeStartDocument(QString::fromLatin1("1.0"), true);
@@ -185,9 +188,10 @@ QByteArray DocxWriter::writeDocument(const QTextDocument* document)
 	m_xml.writeEndElement();
 
 	m_xml.writeEndDocument();
-	buffer.close();
+	m_xml.setDevice(0);
 
-	return data;
+	m_paragraph_properties.clear();
+	m_run_properties.clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -195,13 +199,34 @@ QByteArray DocxWriter::writeDocument(const QTextDocument* document)
 void DocxWriter::writeParagraph(const QTextBlock& block)
 {
 	m_xml.writeStartElement(QString::fromLatin1("w:p"));
-	writeParagraphProperties(block.blockFormat(), block.charFormat());
+
+	// Formats are shared by index within a document, so their properties are only serialized once
+	qint64 key = (qint64(block.blockFormatIndex()) << 32) | quint32(block.charFormatIndex());
+	QHash<qint64, QByteArray>::iterator properties = m_paragraph_properties.find(key);
+	if (properties == m_paragraph_properties.end()) {
+		QBuffer buffer;
+		buffer.open(QIODevice::WriteOnly);
+		m_properties_xml.setDevice(&buffer);
+		writeParagraphProperties(block.blockFormat(), block.charFormat());
+		m_properties_xml.setDevice(0);
+		properties = m_paragraph_properties.insert(key, buffer.data());
+	}
+	writeProperties(*properties);
 
 	for (QTextBlock::iterator iter = block.begin(); !(iter.atEnd()); ++iter) {
 		m_xml.writeStartElement(QString::fromLatin1("w:r"));
 
 		QTextFragment fragment = iter.fragment();
-		writeRunProperties(fragment.charFormat());
+		QHash<int, QByteArray>::iterator properties = m_run_properties.find(fragment.charFormatIndex());
+		if (properties == m_run_properties.end()) {
+			QBuffer buffer;
+			buffer.open(QIODevice::WriteOnly);
+			m_properties_xml.setDevice(&buffer);
+			writeRunProperties(fragment.charFormat());
+			m_properties_xml.setDevice(0);
+			properties = m_run_properties.insert(fragment.charFormatIndex(), buffer.data());
+		}
+		writeProperties(*properties);
 
 		QString text = fragment.text();
 		int start = 0;
@@ -240,6 +265,17 @@ void DocxWriter::writeText(const QString& text, int start, int end)
 
 //-----------------------------------------------------------------------------
 
+void DocxWriter::writeProperties(const QByteArray& properties)
+{
+	if (!properties.isEmpty()) {
+		// Close the pending start tag before copying serialized elements past the writer
+		m_xml.writeCharacters(QString());
+		m_xml.device()->write(properties);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
 void DocxWriter::writeParagraphProperties(const QTextBlockFormat& block_format, const QTextCharFormat& char_format)
 {
 	bool empty = true;
@@ -247,53 +283,53 @@ void DocxWriter::writeParagraphProperties(const QTextBlockFormat& block_format,
 	int heading = block_format.property(QTextFormat::UserProperty).toInt();
 	if (heading) {
 		writePropertyElement(QString::fromLatin1("w:pPr"), empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:pStyle"));
-		m_xml.writeAttribute(QString::fromLatin1("w:val"), QString("Heading%1").arg(heading));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:pStyle"));
+		m_properties_xml.writeAttribute(QString::fromLatin1("w:val"), QString("Heading%1").arg(heading));
 	}
 
 	bool rtl = block_format.layoutDirection() == Qt::RightToLeft;
 	if (rtl) {
 		writePropertyElement(QString::fromLatin1("w:pPr"), empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:textDirection"));
-		m_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("rl"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:textDirection"));
+		m_properties_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("rl"));
 	}
 
 	Qt::Alignment align = block_format.alignment();
 	if (rtl && (align & Qt::AlignLeft)) {
 		writePropertyElement(QString::fromLatin1("w:pPr"), empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:jc"));
-		m_xml.writeAttribute(QString::fromLatin1("w:val"), m_strict ? QString::fromLatin1("start") : QString::fromLatin1("left"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:jc"));
+		m_properties_xml.writeAttribute(QString::fromLatin1("w:val"), m_strict ? QString::fromLatin1("start") : QString::fromLatin1("left"));
 	} else if (align & Qt::AlignRight) {
 		writePropertyElement(QString::fromLatin1("w:pPr"), empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:jc"));
-		m_xml.writeAttribute(QString::fromLatin1("w:val"), m_strict ? QString::fromLatin1("end") : QString::fromLatin1("right"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:jc"));
+		m_properties_xml.writeAttribute(QString::fromLatin1("w:val"), m_strict ? QString::fromLatin1("end") : QString::fromLatin1("right"));
 	} else if (align & Qt::AlignCenter) {
 		writePropertyElement(QString::fromLatin1("w:pPr"), empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:jc"));
-		m_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("center"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:jc"));
+		m_properties_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("center"));
 	} else if (align & Qt::AlignJustify) {
 		writePropertyElement(QString::fromLatin1("w:pPr"), empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:jc"));
-		m_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("both"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:jc"));
+		m_properties_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("both"));
 	}
 
 	if (block_format.indent() > 0) {
 		writePropertyElement(QString::fromLatin1("w:pPr"), empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:ind"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:ind"));
 		QString indent = QString::number(block_format.indent() * 720);
 		if (m_strict) {
-			m_xml.writeAttribute(QString::fromLatin1("w:start"), indent);
+			m_properties_xml.writeAttribute(QString::fromLatin1("w:start"), indent);
 		} else if (rtl) {
-			m_xml.writeAttribute(QString::fromLatin1("w:right"), indent);
+			m_properties_xml.writeAttribute(QString::fromLatin1("w:right"), indent);
 		} else {
-			m_xml.writeAttribute(QString::fromLatin1("w:left"), indent);
+			m_properties_xml.writeAttribute(QString::fromLatin1("w:left"), indent);
 		}
 	}
 
 	empty &= writeRunProperties(char_format, QString::fromLatin1("w:pPr"));
 
 	if (!empty) {
-		m_xml.writeEndElement();
+		m_properties_xml.writeEndElement();
 	}
 }
 
@@ -305,37 +341,37 @@ bool DocxWriter::writeRunProperties(const QTextCharFormat& char_format, const QS
 
 	if (char_format.fontWeight() == QFont::Bold) {
 		writePropertyElement(QString::fromLatin1("w:rPr"), parent_element, empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:b"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:b"));
 	}
 
 	if (char_format.fontItalic()) {
 		writePropertyElement(QString::fromLatin1("w:rPr"), parent_element, empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:i"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:i"));
 	}
 
 	if (char_format.fontUnderline()) {
 		writePropertyElement(QString::fromLatin1("w:rPr"), parent_element, empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:u"));
-		m_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("single"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:u"));
+		m_properties_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("single"));
 	}
 
 	if (char_format.fontStrikeOut()) {
 		writePropertyElement(QString::fromLatin1("w:rPr"), parent_element, empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:strike"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:strike"));
 	}
 
 	if (char_format.verticalAlignment() == QTextCharFormat::AlignSuperScript) {
 		writePropertyElement(QString::fromLatin1("w:rPr"), parent_element, empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:vertAlign"));
-		m_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("superscript"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:vertAlign"));
+		m_properties_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("superscript"));
 	} else if (char_format.verticalAlignment() == QTextCharFormat::AlignSubScript) {
 		writePropertyElement(QString::fromLatin1("w:rPr"), parent_element, empty);
-		m_xml.writeEmptyElement(QString::fromLatin1("w:vertAlign"));
-		m_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("subscript"));
+		m_properties_xml.writeEmptyElement(QString::fromLatin1("w:vertAlign"));
+		m_properties_xml.writeAttribute(QString::fromLatin1("w:val"), QString::fromLatin1("subscript"));
 	}
 
 	if (!empty) {
-		m_xml.writeEndElement();
+		m_properties_xml.writeEndElement();
 	}
 	return empty;
 }
@@ -346,7 +382,7 @@ void DocxWriter::writePropertyElement(const QString& element, bool& empty)
 {
 	if (empty) {
 		empty = false;
-		m_xml.writeStartElement(element);
+		m_properties_xml.writeStartElement(element);
 	}
 }
 
@@ -357,9 +393,9 @@ void DocxWriter::writePropertyElement(const QString& element, const QString& par
 	if (empty) {
 		empty = false;
 		if (!parent_element.isEmpty()) {
-			m_xml.writeStartElement(parent_element);
+			m_properties_xml.writeStartElement(parent_element);
 		}
-		m_xml.writeStartElement(element);
+		m_properties_xml.writeStartElement(element);
 	}
 }
 
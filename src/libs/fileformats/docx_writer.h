@@ -20,7 +20,9 @@
 #ifndef DOCX_WRITER_H
 #define DOCX_WRITER_H
 
+#include <QByteArray>
 #include <QCoreApplication>
+#include <QHash>
 #include <QString>
 #include <QXmlStreamWriter>
 class QIODevice;
@@ -45,9 +47,10 @@ public:
 	bool write(QIODevice* device, const QTextDocument* document);
 
 private:
-	QByteArray writeDocument(const QTextDocument* document);
+	void writeDocument(const QTextDocument* document, QIODevice* device);
 	void writeParagraph(const QTextBlock& block);
 	void writeText(const QString& text, int start, int end);
+	void writeProperties(const QByteArray& properties);
 	void writeParagraphProperties(const QTextBlockFormat& block_format, const QTextCharFormat& char_format);
 	bool writeRunProperties(const QTextCharFormat& char_format, const QString& parent_element = QString());
 	void writePropertyElement(const QString& element, bool& empty);
@@ -55,6 +58,9 @@ private:
 
 private:
 	QXmlStreamWriter m_xml;
+	QXmlStreamWriter m_properties_xml;
+	QHash<qint64, QByteArray> m_paragraph_properties;
+	QHash<int, QByteArray> m_run_properties;
 	bool m_strict;
 	QString m_error;
 };
@@ -0,0 +1,31 @@
+#
+# Sources of the library, shared with the benchmark and fuzzing targets
+#
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+HEADERS += \
+    $$PWD/docx_reader.h \
+    $$PWD/docx_writer.h \
+    $$PWD/format_manager.h \
+    $$PWD/format_reader.h \
+    $$PWD/odt_reader.h \
+    $$PWD/rtf_reader.h \
+    $$PWD/rtf_tokenizer.h \
+    $$PWD/txt_reader.h \
+    $$PWD/qtzip/qtzipreader.h \
+    $$PWD/qtzip/QtZipReader \
+    $$PWD/qtzip/qtzipwriter.h \
+    $$PWD/qtzip/QtZipWriter \
+    $$PWD/format_helpers.h \
+    $$PWD/fileformatsglobal.h
+
+SOURCES += \
+    $$PWD/docx_reader.cpp \
+    $$PWD/docx_writer.cpp \
+    $$PWD/format_manager.cpp \
+    $$PWD/odt_reader.cpp \
+    $$PWD/rtf_reader.cpp \
+    $$PWD/rtf_tokenizer.cpp \
+    $$PWD/txt_reader.cpp \
+    $$PWD/qtzip/qtzip.cpp
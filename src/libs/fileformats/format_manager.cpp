@@ -24,47 +24,201 @@
 #include "rtf_reader.h"
 #include "txt_reader.h"
 
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QScopedPointer>
 #include <QStringList>
+#include <QTextDocument>
+#include <QThread>
+#include <QThreadStorage>
 
 //-----------------------------------------------------------------------------
 
-FormatReader* FormatManager::createReader(QIODevice* device, const QString& type)
+namespace
 {
-	FormatReader* reader = 0;
+	// Enough of the file for every reader to recognize its format
+	const int header_size = 77;
 
-	// Try file extension first
-	if (type == "odt") {
-		if (OdtReader::canRead(device)) {
-			reader = new OdtReader;
-		}
-	} else if (type == "docx") {
-		if (DocxReader::canRead(device)) {
-			reader = new DocxReader;
-		}
-	} else if (type == "rtf") {
-		if (RtfReader::canRead(device)) {
-			reader = new RtfReader;
+	template <typename T>
+	FormatReader* createFormatReader()
+	{
+		return new T;
+	}
+
+	struct Format
+	{
+		const char* type;
+		bool (*canRead)(const QByteArray& header);
+		FormatReader* (*create)();
+	};
+
+	// Checked in order when the contents do not match the file extension;
+	// plain text has no signature and is used when nothing else matches
+	const Format formats[] = {
+		{ "odt", &OdtReader::canRead, &createFormatReader<OdtReader> },
+		{ "docx", &DocxReader::canRead, &createFormatReader<DocxReader> },
+		{ "rtf", &RtfReader::canRead, &createFormatReader<RtfReader> },
+		{ "txt", 0, &createFormatReader<TxtReader> }
+	};
+	const int format_count = sizeof(formats) / sizeof(formats[0]);
+
+	int findFormat(const QByteArray& header, const QString& type)
+	{
+		int found = format_count - 1;
+		for (int i = 0; i < format_count; ++i) {
+			if (!formats[i].canRead || !formats[i].canRead(header)) {
+				continue;
+			}
+			// Prefer the format named by the file extension
+			if (type == QLatin1String(formats[i].type)) {
+				return i;
+			} else if (found == format_count - 1) {
+				found = i;
+			}
 		}
+		return found;
 	}
 
-	// Fall back to finding format from contents
-	if (!reader) {
-		if (OdtReader::canRead(device)) {
-			reader = new OdtReader;
-		} else if (DocxReader::canRead(device)) {
-			reader = new DocxReader;
-		} else if (RtfReader::canRead(device)) {
-			reader = new RtfReader;
+	struct CachedFormat
+	{
+		QDateTime modified;
+		qint64 size;
+		int format;
+	};
+
+	struct FormatCache
+	{
+		QMutex mutex;
+		QHash<QString, CachedFormat> formats;
+	};
+	Q_GLOBAL_STATIC(FormatCache, format_cache)
+
+	// Detected formats are remembered until the file changes, so batch imports
+	// do not have to reopen and sniff files that were already looked at
+	int findCachedFormat(const QString& filename, QIODevice* device)
+	{
+		QFileInfo info(filename);
+		const QString path = info.absoluteFilePath();
+		const QDateTime modified = info.lastModified();
+		const qint64 size = info.size();
+
+		FormatCache* cache = format_cache();
+		{
+			QMutexLocker locker(&cache->mutex);
+			QHash<QString, CachedFormat>::const_iterator iter = cache->formats.constFind(path);
+			if ((iter != cache->formats.constEnd()) && (iter->modified == modified) && (iter->size == size)) {
+				return iter->format;
+			}
+		}
+
+		QByteArray header;
+		if (device) {
+			header = device->peek(header_size);
 		} else {
-			reader = new TxtReader;
+			QFile file(filename);
+			if (file.open(QIODevice::ReadOnly)) {
+				header = file.read(header_size);
+			}
+		}
+		CachedFormat cached;
+		cached.modified = modified;
+		cached.size = size;
+		cached.format = findFormat(header, info.suffix().toLower());
+
+		QMutexLocker locker(&cache->mutex);
+		if (cache->formats.size() >= 1024) {
+			cache->formats.clear();
 		}
+		cache->formats.insert(path, cached);
+		return cached.format;
 	}
 
+	struct ThreadProgress
+	{
+		ThreadProgress() :
+			progress(0),
+			cancelled(0)
+		{
+		}
+
+		QAtomicInt* progress;
+		const QAtomicInt* cancelled;
+	};
+	Q_GLOBAL_STATIC(QThreadStorage<ThreadProgress>, thread_progress)
+}
+
+//-----------------------------------------------------------------------------
+
+FormatReader* FormatManager::createReader(QIODevice* device, const QString& type)
+{
+	FormatReader* reader = formats[findFormat(device->peek(header_size), type)].create();
+	if (thread_progress()->hasLocalData()) {
+		const ThreadProgress& current = thread_progress()->localData();
+		reader->setProgressCounter(current.progress);
+		reader->setCancellationToken(current.cancelled);
+	}
 	return reader;
 }
 
 //-----------------------------------------------------------------------------
 
+QString FormatManager::detectType(const QString& filename)
+{
+	return QString::fromLatin1(formats[findCachedFormat(filename, 0)].type);
+}
+
+//-----------------------------------------------------------------------------
+
+QTextDocument* FormatManager::readDocument(const QString& filename, QThread* thread, QString* error,
+		QAtomicInt* progress, const QAtomicInt* cancelled)
+{
+	// Meant to run on a worker thread: the document is built detached from
+	// any parent and then moved to the thread that is going to use it
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly)) {
+		if (error) {
+			*error = file.errorString();
+		}
+		return 0;
+	}
+
+	QScopedPointer<FormatReader> reader(formats[findCachedFormat(filename, &file)].create());
+	reader->setProgressCounter(progress);
+	reader->setCancellationToken(cancelled);
+
+	QTextDocument* document = new QTextDocument;
+	reader->read(&file, document);
+	if (reader->hasError()) {
+		if (error) {
+			*error = reader->errorString();
+		}
+		delete document;
+		return 0;
+	}
+
+	if (thread) {
+		document->moveToThread(thread);
+	}
+	return document;
+}
+
+//-----------------------------------------------------------------------------
+
+void FormatManager::setThreadProgress(QAtomicInt* progress, const QAtomicInt* cancelled)
+{
+	// Readers made by createReader() on this thread report into these, so
+	// importers that create their own readers can still be followed and cancelled
+	ThreadProgress current;
+	current.progress = progress;
+	current.cancelled = cancelled;
+	thread_progress()->setLocalData(current);
+}
+
+//-----------------------------------------------------------------------------
+
 QString FormatManager::filter(const QString& type)
 {
 	if (type == "odt") {
@@ -27,14 +27,21 @@ class FormatReader;
 #include <QCoreApplication>
 #include <QString>
 
+class QAtomicInt;
 class QIODevice;
 class QStringList;
+class QTextDocument;
+class QThread;
 
 
 class FILEFORMATS_EXPORT FormatManager
 {
 public:
 	static FormatReader* createReader(QIODevice* device, const QString& type = QString());
+	static QString detectType(const QString& filename);
+	static QTextDocument* readDocument(const QString& filename, QThread* thread = 0, QString* error = 0,
+			QAtomicInt* progress = 0, const QAtomicInt* cancelled = 0);
+	static void setThreadProgress(QAtomicInt* progress, const QAtomicInt* cancelled);
 	static QString filter(const QString& type);
 	static QStringList filters(const QString& type = QString());
 	static bool isRichText(const QString& filename);
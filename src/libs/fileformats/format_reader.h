@@ -22,6 +22,10 @@
 
 #include "fileformatsglobal.h"
 
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QFile>
 #include <QString>
 #include <QTextCursor>
 
@@ -31,6 +35,12 @@ class QTextDocument;
 class FILEFORMATS_EXPORT FormatReader
 {
 public:
+	FormatReader() :
+		m_progress(0),
+		m_cancelled(0)
+	{
+	}
+
 	virtual ~FormatReader()
 	{
 	}
@@ -53,13 +63,28 @@ public:
 	void read(QIODevice* device, QTextDocument* document)
 	{
 		m_cursor = QTextCursor(document);
-		readData(device);
+		readMapped(device);
 	}
 
 	void read(QIODevice* device, const QTextCursor& cursor)
 	{
 		m_cursor = cursor;
-		readData(device);
+		readMapped(device);
+	}
+
+	/*
+	 * Reading can run on a worker thread: the percentage read so far is stored
+	 * into the progress counter, and the read stops with an error as soon as
+	 * the cancellation token becomes non-zero.
+	 */
+	void setProgressCounter(QAtomicInt* progress)
+	{
+		m_progress = progress;
+	}
+
+	void setCancellationToken(const QAtomicInt* cancelled)
+	{
+		m_cancelled = cancelled;
 	}
 
 	enum { Type = 0 };
@@ -68,12 +93,59 @@ public:
 		return Type;
 	}
 
+protected:
+	bool isCancelled() const
+	{
+		return m_cancelled && m_cancelled->load();
+	}
+
+	QString cancelledError() const
+	{
+		return QCoreApplication::translate("FormatReader", "Reading was cancelled.");
+	}
+
+	void setProgress(qint64 done, qint64 total)
+	{
+		if (m_progress && (total > 0)) {
+			m_progress->store(int(qBound(qint64(0), done * 100 / total, qint64(100))));
+		}
+	}
+
 protected:
 	QTextCursor m_cursor;
 	QString m_error;
 	QByteArray m_encoding;
 
 private:
+	QAtomicInt* m_progress;
+	const QAtomicInt* m_cancelled;
+
+private:
+	/*
+	 * Files are mapped into memory and handed to the reader as a buffer over
+	 * the mapping, which lets readers scan the bytes in place instead of
+	 * copying them out of the device.
+	 */
+	void readMapped(QIODevice* device)
+	{
+		QFile* file = qobject_cast<QFile*>(device);
+		const qint64 start = file ? file->pos() : 0;
+		const qint64 size = file ? file->size() - start : 0;
+		uchar* data = (file && file->isReadable() && size > 0 && size <= 0x7fffffff) ? file->map(start, size) : 0;
+		if (!data) {
+			readData(device);
+			return;
+		}
+
+		QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), int(size));
+		QBuffer buffer(&bytes);
+		buffer.open(QIODevice::ReadOnly);
+		readData(&buffer);
+		file->seek(start + buffer.pos());
+		buffer.close();
+		file->unmap(data);
+	}
+
 	virtual void readData(QIODevice* device) = 0;
 };
 
@@ -0,0 +1,23 @@
+TEMPLATE = app
+
+#
+# Build configuration
+#
+CONFIG += console thread warn_on
+CONFIG -= app_bundle
+QT -= gui
+
+QMAKE_CXXFLAGS += -fsanitize=fuzzer,address,undefined
+QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+
+#
+# Конфигурируем расположение файлов сборки
+#
+DESTDIR = $$PWD/../../../../build/Fuzz/libs/fileformats
+
+OBJECTS_DIR = $$DESTDIR/.obj/$$TARGET
+MOC_DIR = $$DESTDIR/.moc/$$TARGET
+#
+
+INCLUDEPATH += $$PWD/..
+DEPENDPATH += $$PWD/..
@@ -0,0 +1,16 @@
+#
+# libFuzzer targets for the parsers that take untrusted input. They need
+# clang, so they are only built on request:
+#
+#     qmake -spec linux-clang fuzz.pro && make
+#     ./rtf_tokenizer_fuzzer corpus/
+#     ./qtzip_reader_fuzzer corpus/qtzip_reader/
+#
+# corpus/qtzip_reader holds the seed archives for the zip reader, among them
+# entries with crafted ZIP64 sizes and offsets which have to be rejected.
+#
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    rtf_tokenizer_fuzzer.pro \
+    qtzip_reader_fuzzer.pro
@@ -0,0 +1,45 @@
+/*
+ * libFuzzer entry point for QtZipReader.
+ *
+ * Opens the input as an archive and inflates every entry through both
+ * fileData() and the streaming openEntry() device. Entries are looked up by
+ * their stored names, the cleaned up fileInfoList() paths may not match them.
+ */
+
+#include "qtzip/QtZipReader"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QStringList>
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), int(size));
+	QBuffer buffer(&bytes);
+	buffer.open(QIODevice::ReadOnly);
+
+	QtZipReader zip(&buffer);
+	if (zip.status() != QtZipReader::NoError) {
+		return 0;
+	}
+
+	zip.fileInfoList();
+
+	const QStringList names = zip.entryNames();
+	for (int i = 0; i < names.count(); ++i) {
+		const QString& name = names.at(i);
+		zip.fileData(name);
+
+		QScopedPointer<QIODevice> entry(zip.openEntry(name));
+		if (entry) {
+			char chunk[4096];
+			while (entry->read(chunk, sizeof(chunk)) > 0) {
+			}
+		}
+	}
+	return 0;
+}
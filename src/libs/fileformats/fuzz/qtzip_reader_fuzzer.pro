@@ -0,0 +1,17 @@
+TARGET = qtzip_reader_fuzzer
+
+include(fuzz.pri)
+
+QT += concurrent
+
+mac {
+     LIBS += -lz
+}
+
+HEADERS += \
+    ../qtzip/qtzipreader.h \
+    ../qtzip/qtzipwriter.h
+
+SOURCES += \
+    ../qtzip/qtzip.cpp \
+    qtzip_reader_fuzzer.cpp
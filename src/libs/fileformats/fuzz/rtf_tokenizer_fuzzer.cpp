@@ -0,0 +1,107 @@
+/*
+ * libFuzzer entry point for RtfTokenizer.
+ *
+ * Every input is tokenized twice: once from a QBuffer, which the tokenizer
+ * scans in place, and once from a sequential device handing out a few bytes
+ * per read, which forces tokens across buffer refills.
+ */
+
+#include "rtf_tokenizer.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include <cstring>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace
+{
+	class TrickleDevice : public QIODevice
+	{
+	public:
+		TrickleDevice(const QByteArray& data) :
+			m_data(data),
+			m_pos(0)
+		{
+		}
+
+		bool isSequential() const
+		{
+			return true;
+		}
+
+		// Without these a sequential device counts as finished whenever
+		// QIODevice's own buffer runs empty
+		qint64 bytesAvailable() const
+		{
+			return m_data.size() - m_pos + QIODevice::bytesAvailable();
+		}
+
+		bool atEnd() const
+		{
+			return bytesAvailable() == 0;
+		}
+
+	protected:
+		qint64 readData(char* data, qint64 maxlen)
+		{
+			const qint64 count = qMin(qMin(maxlen, qint64(7)), qint64(m_data.size() - m_pos));
+			std::memcpy(data, m_data.constData() + m_pos, size_t(count));
+			m_pos += int(count);
+			return count;
+		}
+
+		qint64 writeData(const char*, qint64)
+		{
+			return -1;
+		}
+
+	private:
+		const QByteArray& m_data;
+		int m_pos;
+	};
+
+	unsigned int tokenize(QIODevice* device)
+	{
+		unsigned int checksum = 0;
+		RtfTokenizer tokenizer;
+		try {
+			tokenizer.setDevice(device);
+			while (tokenizer.hasNext()) {
+				tokenizer.readNext();
+				checksum += tokenizer.type() + tokenizer.value() + uchar(tokenizer.hex());
+				// Token text must stay readable until the next token
+				const char* text = tokenizer.text();
+				for (int i = 0; i < tokenizer.textLength(); ++i) {
+					checksum += uchar(text[i]);
+				}
+			}
+		} catch (const QString&) {
+			// Malformed input is reported with an exception, which is fine
+		}
+		return checksum;
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), int(size));
+
+	QBuffer buffer(&bytes);
+	buffer.open(QIODevice::ReadOnly);
+	const unsigned int in_memory = tokenize(&buffer);
+
+	TrickleDevice trickle(bytes);
+	trickle.open(QIODevice::ReadOnly);
+	const unsigned int streamed = tokenize(&trickle);
+
+	// Both paths have to see the same tokens
+	if (in_memory != streamed) {
+		__builtin_trap();
+	}
+	return 0;
+}
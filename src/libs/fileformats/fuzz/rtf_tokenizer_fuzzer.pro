@@ -0,0 +1,10 @@
+TARGET = rtf_tokenizer_fuzzer
+
+include(fuzz.pri)
+
+HEADERS += \
+    ../rtf_tokenizer.h
+
+SOURCES += \
+    ../rtf_tokenizer.cpp \
+    rtf_tokenizer_fuzzer.cpp
@@ -21,6 +21,7 @@
 
 #include "qtzip/QtZipReader"
 
+#include <QScopedPointer>
 #include <QTextDocument>
 
 namespace {
@@ -34,6 +35,9 @@ namespace {
 //-----------------------------------------------------------------------------
 
 OdtReader::OdtReader() :
+	m_read_size(0),
+	m_part_size(0),
+	m_total_size(0),
 	m_in_block(true)
 {
 	m_xml.setNamespaceProcessing(false);
@@ -43,8 +47,15 @@ OdtReader::OdtReader() :
 
 bool OdtReader::canRead(QIODevice* device)
 {
-	return QtZipReader::canRead(device) &&
-			(device->peek(77).right(47) == "mimetypeapplication/vnd.oasis.opendocument.text");
+	return canRead(device->peek(77));
+}
+
+//-----------------------------------------------------------------------------
+
+bool OdtReader::canRead(const QByteArray& header)
+{
+	return QtZipReader::canRead(header) &&
+			(header.left(77).right(47) == "mimetypeapplication/vnd.oasis.opendocument.text");
 }
 
 //-----------------------------------------------------------------------------
@@ -60,18 +71,32 @@ void OdtReader::readData(QIODevice* device)
 	// Read archive
 	if (zip.isReadable()) {
 		const QString files[] = { QString::fromLatin1("styles.xml"), QString::fromLatin1("content.xml") };
+		QScopedPointer<QIODevice> entries[2];
+		m_read_size = 0;
+		m_total_size = 0;
 		for (int i = 0; i < 2; ++i) {
-			QByteArray data = zip.fileData(files[i]);
-			if (data.isEmpty()) {
+			entries[i].reset(zip.openEntry(files[i]));
+			if (!entries[i].isNull()) {
+				m_total_size += entries[i]->bytesAvailable();
+			}
+		}
+		for (int i = 0; i < 2; ++i) {
+			if (entries[i].isNull() || entries[i]->bytesAvailable() == 0) {
 				continue;
 			}
-			m_xml.addData(data);
+			m_part_size = entries[i]->bytesAvailable();
+			m_xml.setDevice(entries[i].data());
 			readDocument();
-			if (m_xml.hasError()) {
+			const bool hasError = m_xml.hasError();
+			if (hasError) {
 				m_error = m_xml.errorString();
-				break;
 			}
 			m_xml.clear();
+			if (hasError) {
+				break;
+			}
+			m_read_size += m_part_size;
+			setProgress(m_read_size, m_total_size);
 		}
 	} else {
 		m_error = tr("Unable to open archive.");
@@ -79,8 +104,6 @@ void OdtReader::readData(QIODevice* device)
 
 	// Close archive
 	zip.close();
-
-	QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
 }
 
 //-----------------------------------------------------------------------------
@@ -395,7 +418,19 @@ void OdtReader::readParagraph(int level)
 	readText();
 	m_in_block = false;
 
-	QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+	updateProgress();
+}
+
+//-----------------------------------------------------------------------------
+
+void OdtReader::updateProgress()
+{
+	// Cancelling stops parsing the same way an error in the document does
+	if (isCancelled()) {
+		m_xml.raiseError(cancelledError());
+		return;
+	}
+	setProgress(m_read_size + m_part_size - m_xml.device()->bytesAvailable(), m_total_size);
 }
 
 //-----------------------------------------------------------------------------
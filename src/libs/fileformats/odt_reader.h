@@ -40,6 +40,7 @@ public:
 	}
 
 	static bool canRead(QIODevice* device);
+	static bool canRead(const QByteArray& header);
 
 private:
 	void readData(QIODevice* device);
@@ -53,9 +54,13 @@ private:
 	void readParagraph(int level = 0);
 	void readSpan();
 	void readText();
+	void updateProgress();
 
 private:
 	QXmlStreamReader m_xml;
+	qint64 m_read_size;
+	qint64 m_part_size;
+	qint64 m_total_size;
 
 	struct Style
 	{
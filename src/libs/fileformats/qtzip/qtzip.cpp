@@ -41,8 +41,14 @@
 
 #include "qtzipreader.h"
 #include "qtzipwriter.h"
+#include <QBuffer>
 #include <QDateTime>
 #include <QDir>
+#include <QFile>
+#include <QFuture>
+#include <QHash>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 #include <QtDebug>
 #include <QtEndian>
 #include <QtGlobal>
@@ -57,6 +63,8 @@
 // Zip standard version for archives handled by this API
 // (actually, the only basic support of this version is implemented but it is enough for now)
 #define ZIP_VERSION 20
+// Version needed to extract archives with ZIP64 extensions
+#define ZIP64_VERSION 45
 
 #if defined(Q_OS_WIN)
 #  undef S_IFREG
@@ -112,6 +120,11 @@ static inline ushort readUShort(const uchar *data)
 	return (data[0]) + (data[1]<<8);
 }
 
+static inline quint64 readULongLong(const uchar *data)
+{
+	return quint64(readUInt(data)) + (quint64(readUInt(data + 4)) << 32);
+}
+
 static inline void writeUInt(uchar *data, uint i)
 {
 	data[0] = i & 0xff;
@@ -126,6 +139,12 @@ static inline void writeUShort(uchar *data, ushort i)
 	data[1] = (i>>8) & 0xff;
 }
 
+static inline void writeULongLong(uchar *data, quint64 i)
+{
+	writeUInt(data, uint(i & 0xffffffff));
+	writeUInt(data + 4, uint(i >> 32));
+}
+
 static inline void copyUInt(uchar *dest, const uchar *src)
 {
 	dest[0] = src[0];
@@ -196,41 +215,6 @@ static quint32 permissionsToMode(QFile::Permissions perms)
 	return mode;
 }
 
-static int inflate(Bytef *dest, ulong *destLen, const Bytef *source, ulong sourceLen)
-{
-	z_stream stream;
-	int err;
-
-	stream.next_in = (Bytef*)source;
-	stream.avail_in = (uInt)sourceLen;
-	if ((uLong)stream.avail_in != sourceLen)
-		return Z_BUF_ERROR;
-
-	stream.next_out = dest;
-	stream.avail_out = (uInt)*destLen;
-	if ((uLong)stream.avail_out != *destLen)
-		return Z_BUF_ERROR;
-
-	stream.zalloc = (alloc_func)0;
-	stream.zfree = (free_func)0;
-
-	err = inflateInit2(&stream, -MAX_WBITS);
-	if (err != Z_OK)
-		return err;
-
-	err = inflate(&stream, Z_FINISH);
-	if (err != Z_STREAM_END) {
-		inflateEnd(&stream);
-		if (err == Z_NEED_DICT || (err == Z_BUF_ERROR && stream.avail_in == 0))
-			return Z_DATA_ERROR;
-		return err;
-	}
-	*destLen = stream.total_out;
-
-	err = inflateEnd(&stream);
-	return err;
-}
-
 static int deflate (Bytef *dest, ulong *destLen, const Bytef *source, ulong sourceLen)
 {
 	z_stream stream;
@@ -388,6 +372,13 @@ struct DataDescriptor
 	uchar uncompressed_size[4];
 };
 
+struct DataDescriptor64
+{
+	uchar crc_32[4];
+	uchar compressed_size[8];
+	uchar uncompressed_size[8];
+};
+
 struct CentralFileHeader
 {
 	uchar signature[4]; // 0x02014b50
@@ -421,14 +412,143 @@ struct EndOfDirectory
 	uchar comment_length[2];
 };
 
+struct EndOfDirectory64
+{
+	uchar signature[4]; // 0x06064b50
+	uchar record_size[8];
+	uchar version_made[2];
+	uchar version_needed[2];
+	uchar this_disk[4];
+	uchar start_of_directory_disk[4];
+	uchar num_dir_entries_this_disk[8];
+	uchar num_dir_entries[8];
+	uchar directory_size[8];
+	uchar dir_start_offset[8];
+};
+
+struct EndOfDirectory64Locator
+{
+	uchar signature[4]; // 0x07064b50
+	uchar start_of_directory_disk[4];
+	uchar eod_offset[8];
+	uchar num_disks[4];
+};
+
+// ZIP64 extended information extra field, see APPNOTE.TXT 4.5.3
+static const ushort Zip64ExtraFieldTag = 0x0001;
+static const quint64 Zip64Marker = 0xffffffff;
+
+// Open Packaging growth hint, padding which readers skip. It keeps room for
+// a ZIP64 extra field in the local header of an entry of unknown size.
+static const ushort GrowthHintExtraFieldTag = 0xa220;
+static const ushort GrowthHintSignature = 0xa028;
+
+// deflate cannot encode more than 258 bytes in less than 2 bits
+static const qint64 MaxDeflateRatio = 1032;
+
 struct FileHeader
 {
+	FileHeader()
+		: compressed_size(0), uncompressed_size(0), offset_local_header(0)
+	{
+	}
+
+	void readZip64ExtraField();
+	QByteArray zip64ExtraField(CentralFileHeader &central) const;
+
 	CentralFileHeader h;
 	QByteArray file_name;
 	QByteArray extra_field;
 	QByteArray file_comment;
+
+	// actual values, the 32 bit fields of h are only markers for ZIP64 entries
+	quint64 compressed_size;
+	quint64 uncompressed_size;
+	quint64 offset_local_header;
 };
 
+/*
+	Resolve the sizes and offset from the central header, reading the ZIP64
+	extended information for the fields which overflowed 32 bits.
+*/
+void FileHeader::readZip64ExtraField()
+{
+	compressed_size = readUInt(h.compressed_size);
+	uncompressed_size = readUInt(h.uncompressed_size);
+	offset_local_header = readUInt(h.offset_local_header);
+	if (compressed_size != Zip64Marker && uncompressed_size != Zip64Marker && offset_local_header != Zip64Marker)
+		return;
+
+	const uchar *extra = (const uchar *)extra_field.constData();
+	const int size = extra_field.size();
+	int pos = 0;
+	while (pos + 4 <= size) {
+		const ushort tag = readUShort(extra + pos);
+		const int length = readUShort(extra + pos + 2);
+		pos += 4;
+		if (pos + length > size)
+			break;
+
+		if (tag == Zip64ExtraFieldTag) {
+			// only the overflowed fields are present, always in this order
+			const uchar *field = extra + pos;
+			const uchar *end = field + length;
+			if (uncompressed_size == Zip64Marker && field + 8 <= end) {
+				uncompressed_size = readULongLong(field);
+				field += 8;
+			}
+			if (compressed_size == Zip64Marker && field + 8 <= end) {
+				compressed_size = readULongLong(field);
+				field += 8;
+			}
+			if (offset_local_header == Zip64Marker && field + 8 <= end)
+				offset_local_header = readULongLong(field);
+			return;
+		}
+		pos += length;
+	}
+	qWarning("QtZip: ZIP64 extended information not found, entry may be unreadable");
+}
+
+/*
+	Fill the 32 bit fields of \a central and return the ZIP64 extended
+	information for the values which do not fit there, if any.
+*/
+QByteArray FileHeader::zip64ExtraField(CentralFileHeader &central) const
+{
+	QByteArray values;
+	uchar buf[8];
+	if (uncompressed_size >= Zip64Marker) {
+		writeUInt(central.uncompressed_size, uint(Zip64Marker));
+		writeULongLong(buf, uncompressed_size);
+		values.append((const char *)buf, 8);
+	} else {
+		writeUInt(central.uncompressed_size, uint(uncompressed_size));
+	}
+	if (compressed_size >= Zip64Marker) {
+		writeUInt(central.compressed_size, uint(Zip64Marker));
+		writeULongLong(buf, compressed_size);
+		values.append((const char *)buf, 8);
+	} else {
+		writeUInt(central.compressed_size, uint(compressed_size));
+	}
+	if (offset_local_header >= Zip64Marker) {
+		writeUInt(central.offset_local_header, uint(Zip64Marker));
+		writeULongLong(buf, offset_local_header);
+		values.append((const char *)buf, 8);
+	} else {
+		writeUInt(central.offset_local_header, uint(offset_local_header));
+	}
+
+	if (values.isEmpty())
+		return values;
+
+	writeUShort(central.version_needed, ZIP64_VERSION);
+	writeUShort(buf, Zip64ExtraFieldTag);
+	writeUShort(buf + 2, values.size());
+	return QByteArray((const char *)buf, 4) + values;
+}
+
 QtZipReader::FileInfo::FileInfo()
 	: isDir(false), isFile(false), isSymLink(false), crc(0), size(0)
 {
@@ -482,12 +602,12 @@ public:
 	bool dirtyFileTree;
 	QList<FileHeader> fileHeaders;
 	QByteArray comment;
-	uint start_of_directory;
+	qint64 start_of_directory;
 };
 
 void QtZipPrivate::fillFileInfo(int index, QtZipReader::FileInfo &fileInfo) const
 {
-	FileHeader header = fileHeaders.at(index);
+	const FileHeader &header = fileHeaders.at(index);
 	quint32 mode = readUInt(header.h.external_file_attributes);
 	const HostOS hostOS = HostOS(readUShort(header.h.version_made) >> 8);
 	switch (hostOS) {
@@ -525,7 +645,7 @@ void QtZipPrivate::fillFileInfo(int index, QtZipReader::FileInfo &fileInfo) cons
 	const bool inUtf8 = (general_purpose_bits & Utf8Names) != 0;
 	fileInfo.filePath = inUtf8 ? QString::fromUtf8(header.file_name) : QString::fromLocal8Bit(header.file_name);
 	fileInfo.crc = readUInt(header.h.crc_32);
-	fileInfo.size = readUInt(header.h.uncompressed_size);
+	fileInfo.size = header.uncompressed_size;
 	fileInfo.lastModified = readMSDosDate(header.h.last_mod_file);
 
 	// fix the file path, if broken (convert separators, eat leading and trailing ones)
@@ -540,15 +660,401 @@ class QtZipReaderPrivate : public QtZipPrivate
 {
 public:
 	QtZipReaderPrivate(QIODevice *device, bool ownDev)
-		: QtZipPrivate(device, ownDev), status(QtZipReader::NoError)
+		: QtZipPrivate(device, ownDev), status(QtZipReader::NoError), mappedFile(0)
 	{
 	}
 
+	~QtZipReaderPrivate()
+	{
+		// closing the file unmaps it as well
+		if (mappedFile && mappedFile->isOpen())
+			mappedFile->unmap((uchar *)mapped.constData());
+	}
+
+	void mapDevice();
+	QByteArray readAt(qint64 pos, qint64 len) const;
 	void scanFiles();
+	int findEntry(const QString &fileName) const;
+	QString entryName(int index) const;
 
 	QtZipReader::Status status;
+	QHash<QString, int> entryIndex;
+
+	// the whole archive, when it can be addressed in memory without copying
+	QByteArray mapped;
+	QFile *mappedFile;
+};
+
+/*
+	Make the archive addressable in memory: files are mapped, buffers are used
+	as they are. Everything else is read through the device.
+*/
+void QtZipReaderPrivate::mapDevice()
+{
+	if (!mapped.isNull() || !device->isOpen() || device->isSequential())
+		return;
+
+	if (QBuffer *buffer = qobject_cast<QBuffer *>(device)) {
+		mapped = buffer->data();
+	} else if (QFile *file = qobject_cast<QFile *>(device)) {
+		const qint64 size = file->size();
+		if (size <= 0 || size > 0x7fffffff)
+			return;
+		uchar *data = file->map(0, size);
+		if (data) {
+			mapped = QByteArray::fromRawData((const char *)data, int(size));
+			mappedFile = file;
+		}
+	}
+}
+
+/*
+	Return \a len bytes of the archive starting at \a pos. When the archive is
+	in memory the result refers to it instead of holding a copy.
+*/
+QByteArray QtZipReaderPrivate::readAt(qint64 pos, qint64 len) const
+{
+	if (!mapped.isNull()) {
+		if (pos < 0 || pos > mapped.size())
+			return QByteArray();
+		len = qMin(len, mapped.size() - pos);
+		return QByteArray::fromRawData(mapped.constData() + pos, int(len));
+	}
+	if (!device->seek(pos))
+		return QByteArray();
+	return device->read(len);
+}
+
+/*
+	Sequential device that streams one entry of the archive. Compressed data is
+	pulled from the archive device in small chunks and inflated on demand, so
+	neither the compressed nor the uncompressed entry is ever held in memory.
+*/
+class QtZipEntryDevice : public QIODevice
+{
+public:
+	QtZipEntryDevice(QIODevice *archive, const char *mapped, qint64 dataStart, qint64 compressedSize,
+					 qint64 uncompressedSize, uint crc, bool deflated);
+	~QtZipEntryDevice();
+
+	bool isSequential() const;
+	bool atEnd() const;
+	qint64 bytesAvailable() const;
+
+protected:
+	qint64 readData(char *data, qint64 maxlen);
+	qint64 writeData(const char *data, qint64 len);
+
+private:
+	qint64 readSource(char *data, qint64 maxlen);
+
+	enum { ChunkSize = 16384 };
+
+	QIODevice *archive;
+	const char *mapped;
+	qint64 dataStart;
+	qint64 compressedSize;
+	qint64 uncompressedSize;
+	qint64 consumed;
+	qint64 produced;
+	uint expectedCrc;
+	uint crc;
+	bool deflated;
+	bool finished;
+	z_stream stream;
+	QByteArray input;
 };
 
+QtZipEntryDevice::QtZipEntryDevice(QIODevice *archive, const char *mapped, qint64 dataStart, qint64 compressedSize,
+								   qint64 uncompressedSize, uint crc, bool deflated)
+	: archive(archive), mapped(mapped), dataStart(dataStart), compressedSize(compressedSize),
+	uncompressedSize(uncompressedSize), consumed(0), produced(0), expectedCrc(crc),
+	crc(::crc32(0, 0, 0)), deflated(deflated), finished(false)
+{
+	memset(&stream, 0, sizeof(z_stream));
+	if (deflated) {
+		// a mapped archive is inflated in place
+		if (!mapped)
+			input.resize(ChunkSize);
+		if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+			qWarning("QtZip: Z_MEM_ERROR: Not enough memory");
+			finished = true;
+		}
+	}
+	open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+QtZipEntryDevice::~QtZipEntryDevice()
+{
+	if (deflated)
+		inflateEnd(&stream);
+}
+
+bool QtZipEntryDevice::isSequential() const
+{
+	return true;
+}
+
+bool QtZipEntryDevice::atEnd() const
+{
+	return finished && QIODevice::bytesAvailable() == 0;
+}
+
+qint64 QtZipEntryDevice::bytesAvailable() const
+{
+	return qMax(uncompressedSize - produced, qint64(0)) + QIODevice::bytesAvailable();
+}
+
+qint64 QtZipEntryDevice::readSource(char *data, qint64 maxlen)
+{
+	const qint64 len = qMin(maxlen, compressedSize - consumed);
+	if (len <= 0)
+		return 0;
+	if (mapped) {
+		memcpy(data, mapped + dataStart + consumed, len);
+		consumed += len;
+		return len;
+	}
+	// the archive device may be shared by several entries, so always seek first
+	if (!archive->seek(dataStart + consumed))
+		return 0;
+	const qint64 read = archive->read(data, len);
+	if (read > 0)
+		consumed += read;
+	return read;
+}
+
+qint64 QtZipEntryDevice::readData(char *data, qint64 maxlen)
+{
+	if (finished)
+		return -1;
+
+	// keep every chunk addressable by zlib
+	maxlen = qMin(maxlen, qint64(0x7fffffff));
+	qint64 read = 0;
+	if (!deflated) {
+		read = readSource(data, maxlen);
+		if (read <= 0 || consumed == compressedSize)
+			finished = true;
+	} else {
+		stream.next_out = (Bytef *)data;
+		stream.avail_out = (uInt)maxlen;
+		while (stream.avail_out > 0) {
+			if (stream.avail_in == 0) {
+				const char *chunk_data = mapped ? mapped + dataStart + consumed : input.constData();
+				const qint64 chunk = mapped ? qMin(compressedSize - consumed, qint64(0x7fffffff))
+					: readSource(input.data(), input.size());
+				if (chunk <= 0) {
+					qWarning("QtZip: Z_DATA_ERROR: Input data is corrupted");
+					setErrorString(QLatin1String("Unexpected end of compressed data"));
+					finished = true;
+					break;
+				}
+				if (mapped)
+					consumed += chunk;
+				stream.next_in = (Bytef *)chunk_data;
+				stream.avail_in = (uInt)chunk;
+			}
+
+			const int res = ::inflate(&stream, Z_NO_FLUSH);
+			if (res == Z_STREAM_END) {
+				finished = true;
+				break;
+			} else if (res != Z_OK) {
+				if (res == Z_MEM_ERROR)
+					qWarning("QtZip: Z_MEM_ERROR: Not enough memory");
+				else
+					qWarning("QtZip: Z_DATA_ERROR: Input data is corrupted");
+				setErrorString(QLatin1String("Failed to inflate compressed data"));
+				finished = true;
+				break;
+			}
+		}
+		read = (char *)stream.next_out - data;
+	}
+
+	if (read > 0) {
+		crc = ::crc32(crc, (const uchar *)data, (uInt)read);
+		produced += read;
+	}
+	if (finished && produced == uncompressedSize && crc != expectedCrc)
+		qWarning("QtZip: CRC mismatch, extracted data may be corrupted");
+
+	return (read > 0 || !finished) ? read : -1;
+}
+
+qint64 QtZipEntryDevice::writeData(const char *, qint64)
+{
+	return -1;
+}
+
+/*
+	Write-only device for the entry being streamed into the archive. Incoming
+	data is collected into chunks which are deflated straight into the archive
+	device, while the checksum and sizes are accumulated for the data descriptor.
+*/
+class QtZipEntryWriteDevice : public QIODevice
+{
+public:
+	QtZipEntryWriteDevice(QIODevice *archive, bool compress);
+	~QtZipEntryWriteDevice();
+
+	bool isSequential() const;
+	bool finish();
+
+	uint crc() const { return crc_32; }
+	quint64 compressedSize() const { return compressed; }
+	quint64 uncompressedSize() const { return uncompressed; }
+
+protected:
+	qint64 readData(char *data, qint64 maxlen);
+	qint64 writeData(const char *data, qint64 len);
+
+private:
+	void deflateInput(int flush);
+
+	enum { ChunkSize = 65536 };
+
+	QIODevice *archive;
+	bool compress;
+	bool failed;
+	z_stream stream;
+	QByteArray input;
+	QByteArray output;
+	uint crc_32;
+	quint64 compressed;
+	quint64 uncompressed;
+};
+
+QtZipEntryWriteDevice::QtZipEntryWriteDevice(QIODevice *archive, bool compress)
+	: archive(archive), compress(compress), failed(false), crc_32(::crc32(0, 0, 0)),
+	compressed(0), uncompressed(0)
+{
+	memset(&stream, 0, sizeof(z_stream));
+	if (compress) {
+		input.reserve(ChunkSize);
+		output.resize(ChunkSize);
+		if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			qWarning("QtZip: Z_MEM_ERROR: Not enough memory to compress file");
+			failed = true;
+		}
+	}
+	open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+QtZipEntryWriteDevice::~QtZipEntryWriteDevice()
+{
+	if (compress)
+		deflateEnd(&stream);
+}
+
+bool QtZipEntryWriteDevice::isSequential() const
+{
+	return true;
+}
+
+/*
+	Flush the pending input and terminate the deflate stream.
+	Returns false if anything could not be written.
+*/
+bool QtZipEntryWriteDevice::finish()
+{
+	if (compress && !failed)
+		deflateInput(Z_FINISH);
+	close();
+	return !failed;
+}
+
+qint64 QtZipEntryWriteDevice::readData(char *, qint64)
+{
+	return -1;
+}
+
+qint64 QtZipEntryWriteDevice::writeData(const char *data, qint64 len)
+{
+	if (failed)
+		return -1;
+
+	for (qint64 pos = 0; pos < len; ) {
+		const uInt chunk = (uInt)qMin(len - pos, qint64(ChunkSize));
+		crc_32 = ::crc32(crc_32, (const uchar *)data + pos, chunk);
+		if (!compress) {
+			if (archive->write(data + pos, chunk) != chunk) {
+				failed = true;
+				return -1;
+			}
+			compressed += chunk;
+		} else {
+			input.append(data + pos, chunk);
+			if (input.size() >= ChunkSize)
+				deflateInput(Z_NO_FLUSH);
+		}
+		pos += chunk;
+	}
+	uncompressed += len;
+	return failed ? -1 : len;
+}
+
+void QtZipEntryWriteDevice::deflateInput(int flush)
+{
+	stream.next_in = (Bytef *)input.data();
+	stream.avail_in = (uInt)input.size();
+	do {
+		stream.next_out = (Bytef *)output.data();
+		stream.avail_out = (uInt)output.size();
+		::deflate(&stream, flush);
+		const qint64 have = output.size() - stream.avail_out;
+		if (archive->write(output.constData(), have) != have)
+			failed = true;
+		compressed += have;
+	} while (stream.avail_out == 0);
+	input.resize(0);
+}
+
+/*
+	Result of compressing an in-memory entry, possibly on a worker thread.
+*/
+struct CompressedEntry
+{
+	CompressedEntry() : crc_32(0), uncompressed_size(0) {}
+
+	QByteArray data;
+	uint crc_32;
+	int uncompressed_size;
+};
+
+static CompressedEntry compressEntry(const QByteArray &contents, bool compress)
+{
+	CompressedEntry entry;
+	entry.uncompressed_size = contents.length();
+	entry.crc_32 = ::crc32(::crc32(0, 0, 0), (const uchar *)contents.constData(), contents.length());
+	entry.data = contents;
+	if (compress) {
+		ulong len = contents.length();
+		// shamelessly copied form zlib
+		len += (len >> 12) + (len >> 14) + 11;
+		int res;
+		do {
+			entry.data.resize(len);
+			res = deflate((uchar*)entry.data.data(), &len, (const uchar*)contents.constData(), contents.length());
+
+			switch (res) {
+			case Z_OK:
+				entry.data.resize(len);
+				break;
+			case Z_MEM_ERROR:
+				qWarning("QtZip: Z_MEM_ERROR: Not enough memory to compress file, skipping");
+				entry.data.resize(0);
+				break;
+			case Z_BUF_ERROR:
+				len *= 2;
+				break;
+			}
+		} while (res == Z_BUF_ERROR);
+	}
+	return entry;
+}
+
 class QtZipWriterPrivate : public QtZipPrivate
 {
 public:
@@ -556,17 +1062,45 @@ public:
 		: QtZipPrivate(device, ownDev),
 		status(QtZipWriter::NoError),
 		permissions(QFile::ReadOwner | QFile::WriteOwner),
-		compressionPolicy(QtZipWriter::AlwaysCompress)
+		compressionPolicy(QtZipWriter::AlwaysCompress),
+		threadPool(0),
+		entryDevice(0)
 	{
 	}
 
+	~QtZipWriterPrivate()
+	{
+		delete entryDevice;
+	}
+
 	QtZipWriter::Status status;
 	QFile::Permissions permissions;
 	QtZipWriter::CompressionPolicy compressionPolicy;
+	QThreadPool *threadPool;
 
 	enum EntryType { Directory, File, Symlink };
 
+	bool prepareDevice();
+	FileHeader createHeader(EntryType type, const QString &fileName, bool compress) const;
 	void addEntry(EntryType type, const QString &fileName, const QByteArray &contents);
+	void addEntry(EntryType type, const QString &fileName, QIODevice *source);
+	QIODevice *beginEntry(EntryType type, const QString &fileName, bool compress);
+	QByteArray entryLocalHeader(bool zip64) const;
+	void endEntry();
+	void writeEntry(FileHeader header, const CompressedEntry &entry);
+	void writePendingEntries(bool wait);
+
+	// entry being streamed with beginEntry()
+	QtZipEntryWriteDevice *entryDevice;
+	FileHeader entryHeader;
+
+	// entries compressed on the thread pool, written in the order they were added
+	struct PendingEntry
+	{
+		FileHeader header;
+		QFuture<CompressedEntry> result;
+	};
+	QList<PendingEntry> pendingEntries;
 };
 
 LocalFileHeader CentralFileHeader::toLocalHeader() const
@@ -601,143 +1135,190 @@ void QtZipReaderPrivate::scanFiles()
 	}
 
 	dirtyFileTree = false;
-	uchar tmp[4];
-	device->read((char *)tmp, 4);
-	if (readUInt(tmp) != 0x04034b50) {
+	fileHeaders.clear();
+	entryIndex.clear();
+	mapDevice();
+	const QByteArray signature = readAt(0, 4);
+	if (signature.size() != 4 || readUInt((const uchar *)signature.constData()) != 0x04034b50) {
 		qWarning() << "QtZip: not a zip file!";
 		return;
 	}
 
-	// find EndOfDirectory header
-	int i = 0;
-	int start_of_directory = -1;
-	int num_dir_entries = 0;
-	EndOfDirectory eod;
-	while (start_of_directory == -1) {
-		const int pos = device->size() - int(sizeof(EndOfDirectory)) - i;
-		if (pos < 0 || i > 65535) {
-			qWarning() << "QtZip: EndOfDirectory not found";
-			return;
-		}
-
-		device->seek(pos);
-		device->read((char *)&eod, sizeof(EndOfDirectory));
-		if (readUInt(eod.signature) == 0x06054b50)
+	// find EndOfDirectory header: it is followed only by the archive comment
+	// (at most 65535 bytes), so read the whole tail once and search it backwards
+	const qint64 size = device->size();
+	const qint64 tail_size = qMin(size, qint64(sizeof(EndOfDirectory)) + 0xffff);
+	const qint64 tail_start = size - tail_size;
+	const QByteArray tail = readAt(tail_start, tail_size);
+	const uchar *tail_data = (const uchar *)tail.constData();
+
+	int eod_pos = -1;
+	for (int pos = tail.size() - int(sizeof(EndOfDirectory)); pos >= 0; --pos) {
+		if (tail_data[pos] != 0x50 || readUInt(tail_data + pos) != 0x06054b50)
+			continue;
+		// the comment has to reach exactly the end of the archive, otherwise
+		// the signature is most likely a part of the comment itself
+		const int comment_length = readUShort(tail_data + pos + 20);
+		if (pos + int(sizeof(EndOfDirectory)) + comment_length == tail.size()) {
+			eod_pos = pos;
 			break;
-		++i;
+		}
+		if (eod_pos == -1)
+			eod_pos = pos;
+	}
+	if (eod_pos == -1) {
+		qWarning() << "QtZip: EndOfDirectory not found";
+		return;
 	}
 
 	// have the eod
-	start_of_directory = readUInt(eod.dir_start_offset);
-	num_dir_entries = readUShort(eod.num_dir_entries);
-	ZDEBUG("start_of_directory at %d, num_dir_entries=%d", start_of_directory, num_dir_entries);
-	int comment_length = readUShort(eod.comment_length);
-	if (comment_length != i)
+	EndOfDirectory eod;
+	memcpy(&eod, tail_data + eod_pos, sizeof(EndOfDirectory));
+	quint64 start_of_directory = readUInt(eod.dir_start_offset);
+	quint64 directory_size = readUInt(eod.directory_size);
+	quint64 num_dir_entries = readUShort(eod.num_dir_entries);
+
+	// values which overflowed are stored in the ZIP64 end of central directory
+	// record, found through the locator right before the eod
+	if (start_of_directory == Zip64Marker || directory_size == Zip64Marker || num_dir_entries == 0xffff) {
+		EndOfDirectory64Locator locator;
+		const qint64 locator_pos = tail_start + eod_pos - qint64(sizeof(EndOfDirectory64Locator));
+		if (eod_pos >= int(sizeof(EndOfDirectory64Locator))) {
+			memcpy(&locator, tail_data + eod_pos - sizeof(EndOfDirectory64Locator), sizeof(EndOfDirectory64Locator));
+		} else {
+			const QByteArray data = readAt(locator_pos, sizeof(EndOfDirectory64Locator));
+			if (data.size() == sizeof(EndOfDirectory64Locator))
+				memcpy(&locator, data.constData(), sizeof(EndOfDirectory64Locator));
+			else
+				memset(&locator, 0, sizeof(EndOfDirectory64Locator));
+		}
+
+		if (readUInt(locator.signature) == 0x07064b50) {
+			EndOfDirectory64 eod64;
+			const QByteArray data = readAt(readULongLong(locator.eod_offset), sizeof(EndOfDirectory64));
+			if (data.size() == sizeof(EndOfDirectory64))
+				memcpy(&eod64, data.constData(), sizeof(EndOfDirectory64));
+			if (data.size() == sizeof(EndOfDirectory64) && readUInt(eod64.signature) == 0x06064b50) {
+				start_of_directory = readULongLong(eod64.dir_start_offset);
+				directory_size = readULongLong(eod64.directory_size);
+				num_dir_entries = readULongLong(eod64.num_dir_entries);
+			} else {
+				qWarning() << "QtZip: ZIP64 EndOfDirectory not found";
+				return;
+			}
+		}
+	}
+	ZDEBUG("start_of_directory at %llu, num_dir_entries=%llu", start_of_directory, num_dir_entries);
+	const int comment_start = eod_pos + int(sizeof(EndOfDirectory));
+	const int comment_length = readUShort(eod.comment_length);
+	if (comment_start + comment_length != tail.size())
 		qWarning() << "QtZip: failed to parse zip file.";
-	comment = device->read(qMin(comment_length, i));
+	comment = tail.mid(comment_start, comment_length);
 
+	// read the whole central directory at once and parse it in memory
+	if (directory_size > 0x7fffffff) {
+		qWarning() << "QtZip: central directory is too large";
+		return;
+	}
+	QByteArray directory;
+	if (mapped.isNull() && start_of_directory >= quint64(tail_start)
+		&& start_of_directory + directory_size <= quint64(tail_start + eod_pos)) {
+		directory = tail.mid(start_of_directory - tail_start, directory_size);
+	} else {
+		directory = readAt(start_of_directory, directory_size);
+	}
+	const uchar *dir_data = (const uchar *)directory.constData();
+	const int dir_size = directory.size();
 
-	device->seek(start_of_directory);
-	for (i = 0; i < num_dir_entries; ++i) {
+	fileHeaders.reserve(int(qMin(num_dir_entries, quint64(directory_size / sizeof(CentralFileHeader)))));
+	int pos = 0;
+	for (quint64 i = 0; i < num_dir_entries; ++i) {
 		FileHeader header;
-		int read = device->read((char *) &header.h, sizeof(CentralFileHeader));
-		if (read < (int)sizeof(CentralFileHeader)) {
+		if (dir_size - pos < (int)sizeof(CentralFileHeader)) {
 			qWarning() << "QtZip: Failed to read complete header, index may be incomplete";
 			break;
 		}
+		memcpy(&header.h, dir_data + pos, sizeof(CentralFileHeader));
+		pos += sizeof(CentralFileHeader);
 		if (readUInt(header.h.signature) != 0x02014b50) {
 			qWarning() << "QtZip: invalid header signature, index may be incomplete";
 			break;
 		}
 
 		int l = readUShort(header.h.file_name_length);
-		header.file_name = device->read(l);
-		if (header.file_name.length() != l) {
+		if (dir_size - pos < l) {
 			qWarning() << "QtZip: Failed to read filename from zip index, index may be incomplete";
 			break;
 		}
+		header.file_name = directory.mid(pos, l);
+		pos += l;
 		l = readUShort(header.h.extra_field_length);
-		header.extra_field = device->read(l);
-		if (header.extra_field.length() != l) {
+		if (dir_size - pos < l) {
 			qWarning() << "QtZip: Failed to read extra field in zip file, skipping file, index may be incomplete";
 			break;
 		}
+		header.extra_field = directory.mid(pos, l);
+		pos += l;
 		l = readUShort(header.h.file_comment_length);
-		header.file_comment = device->read(l);
-		if (header.file_comment.length() != l) {
+		if (dir_size - pos < l) {
 			qWarning() << "QtZip: Failed to read read file comment, index may be incomplete";
 			break;
 		}
+		header.file_comment = directory.mid(pos, l);
+		pos += l;
+		header.readZip64ExtraField();
 
 		ZDEBUG("found file '%s'", header.file_name.data());
 		fileHeaders.append(header);
+
+		const QString name = entryName(fileHeaders.size() - 1);
+		if (!entryIndex.contains(name))
+			entryIndex.insert(name, fileHeaders.size() - 1);
 	}
 }
 
-void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const QByteArray &contents/*, QFile::Permissions permissions, QtZip::Method m*/)
+int QtZipReaderPrivate::findEntry(const QString &fileName) const
 {
-#ifndef NDEBUG
-	static const char *entryTypes[] = {
-		"directory",
-		"file     ",
-		"symlink  " };
-	ZDEBUG() << "adding" << entryTypes[type] <<":" << fileName.toUtf8().data() << (type == 2 ? QByteArray(" -> " + contents).constData() : "");
-#endif
+	return entryIndex.value(fileName, -1);
+}
+
+/*
+	The name an entry is looked up by: the file name exactly as it is stored in
+	the directory, without the cleanup fillFileInfo() applies to filePath.
+*/
+QString QtZipReaderPrivate::entryName(int index) const
+{
+	const FileHeader &header = fileHeaders.at(index);
+	// if bit 11 is set, the filename must be encoded using UTF-8
+	const bool inUtf8 = (readUShort(header.h.general_purpose_bits) & Utf8Names) != 0;
+	return inUtf8 ? QString::fromUtf8(header.file_name) : QString::fromLocal8Bit(header.file_name);
+}
+
+bool QtZipWriterPrivate::prepareDevice()
+{
+	// entries can't be interleaved with the one being streamed
+	if (entryDevice)
+		endEntry();
 
 	if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
 		status = QtZipWriter::FileOpenError;
-		return;
+		return false;
 	}
 	device->seek(start_of_directory);
+	return true;
+}
 
-	// don't compress small files
-	QtZipWriter::CompressionPolicy compression = compressionPolicy;
-	if (compressionPolicy == QtZipWriter::AutoCompress) {
-		if (contents.length() < 64)
-			compression = QtZipWriter::NeverCompress;
-		else
-			compression = QtZipWriter::AlwaysCompress;
-	}
-
+FileHeader QtZipWriterPrivate::createHeader(EntryType type, const QString &fileName, bool compress) const
+{
 	FileHeader header;
 	memset(&header.h, 0, sizeof(CentralFileHeader));
 	writeUInt(header.h.signature, 0x02014b50);
 
 	writeUShort(header.h.version_needed, ZIP_VERSION);
-	writeUInt(header.h.uncompressed_size, contents.length());
 	writeMSDosDate(header.h.last_mod_file, QDateTime::currentDateTime());
-	QByteArray data = contents;
-	if (compression == QtZipWriter::AlwaysCompress) {
+	if (compress)
 		writeUShort(header.h.compression_method, CompressionMethodDeflated);
 
-	   ulong len = contents.length();
-		// shamelessly copied form zlib
-		len += (len >> 12) + (len >> 14) + 11;
-		int res;
-		do {
-			data.resize(len);
-			res = deflate((uchar*)data.data(), &len, (const uchar*)contents.constData(), contents.length());
-
-			switch (res) {
-			case Z_OK:
-				data.resize(len);
-				break;
-			case Z_MEM_ERROR:
-				qWarning("QtZip: Z_MEM_ERROR: Not enough memory to compress file, skipping");
-				data.resize(0);
-				break;
-			case Z_BUF_ERROR:
-				len *= 2;
-				break;
-			}
-		} while (res == Z_BUF_ERROR);
-	}
-// TODO add a check if data.length() > contents.length().  Then try to store the original and revert the compression method to be uncompressed
-	writeUInt(header.h.compressed_size, data.length());
-	uint crc_32 = ::crc32(0, 0, 0);
-	crc_32 = ::crc32(crc_32, (const uchar *)contents.constData(), contents.length());
-	writeUInt(header.h.crc_32, crc_32);
-
 	// if bit 11 is set, the filename and comment fields must be encoded using UTF-8
 	ushort general_purpose_bits = Utf8Names; // always use utf-8
 	writeUShort(header.h.general_purpose_bits, general_purpose_bits);
@@ -765,15 +1346,214 @@ void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
 		case Symlink: mode |= S_IFLNK; break;
 	}
 	writeUInt(header.h.external_file_attributes, mode << 16);
-	writeUInt(header.h.offset_local_header, start_of_directory);
 
+	return header;
+}
+
+void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const QByteArray &contents/*, QFile::Permissions permissions, QtZip::Method m*/)
+{
+#ifndef NDEBUG
+	static const char *entryTypes[] = {
+		"directory",
+		"file     ",
+		"symlink  " };
+	ZDEBUG() << "adding" << entryTypes[type] <<":" << fileName.toUtf8().data() << (type == 2 ? QByteArray(" -> " + contents).constData() : "");
+#endif
+
+	if (!prepareDevice())
+		return;
+
+	// don't compress small files
+	QtZipWriter::CompressionPolicy compression = compressionPolicy;
+	if (compressionPolicy == QtZipWriter::AutoCompress) {
+		if (contents.length() < 64)
+			compression = QtZipWriter::NeverCompress;
+		else
+			compression = QtZipWriter::AlwaysCompress;
+	}
+	const bool compress = compression == QtZipWriter::AlwaysCompress;
+
+	FileHeader header = createHeader(type, fileName, compress);
+	if (threadPool != 0 && compress) {
+		PendingEntry pending;
+		pending.header = header;
+		pending.result = QtConcurrent::run(threadPool, compressEntry, contents, true);
+		pendingEntries.append(pending);
+		writePendingEntries(false);
+		return;
+	}
+
+	writePendingEntries(true);
+	writeEntry(header, compressEntry(contents, compress));
+}
+
+/*
+	Write the local header and the data of an entry compressed in memory.
+	The entry is placed at the current end of the archive.
+*/
+void QtZipWriterPrivate::writeEntry(FileHeader header, const CompressedEntry &entry)
+{
+// TODO add a check if data.length() > contents.length().  Then try to store the original and revert the compression method to be uncompressed
+	header.offset_local_header = start_of_directory;
+	header.compressed_size = entry.data.length();
+	header.uncompressed_size = entry.uncompressed_size;
+	writeUInt(header.h.compressed_size, entry.data.length());
+	writeUInt(header.h.uncompressed_size, entry.uncompressed_size);
+	writeUInt(header.h.crc_32, entry.crc_32);
 
 	fileHeaders.append(header);
 
+	device->seek(start_of_directory);
 	LocalFileHeader h = header.h.toLocalHeader();
 	device->write((const char *)&h, sizeof(LocalFileHeader));
 	device->write(header.file_name);
-	device->write(data);
+	if (device->write(entry.data) != entry.data.size())
+		status = QtZipWriter::FileWriteError;
+	start_of_directory = device->pos();
+	dirtyFileTree = true;
+}
+
+/*
+	Write the entries compressed on the thread pool, keeping the order in which
+	they were added. Unless \a wait is set, stop at the first unfinished one.
+*/
+void QtZipWriterPrivate::writePendingEntries(bool wait)
+{
+	while (!pendingEntries.isEmpty()) {
+		if (!wait && !pendingEntries.first().result.isFinished())
+			break;
+		const PendingEntry pending = pendingEntries.takeFirst();
+		writeEntry(pending.header, pending.result.result());
+	}
+}
+
+void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, QIODevice *source)
+{
+	QtZipWriter::CompressionPolicy compression = compressionPolicy;
+	if (compressionPolicy == QtZipWriter::AutoCompress) {
+		// the size of a sequential device is unknown, so compress it
+		if (!source->isSequential() && source->size() - source->pos() < 64)
+			compression = QtZipWriter::NeverCompress;
+		else
+			compression = QtZipWriter::AlwaysCompress;
+	}
+
+	QIODevice *entry = beginEntry(type, fileName, compression == QtZipWriter::AlwaysCompress);
+	if (entry == 0)
+		return;
+
+	QByteArray buffer(65536, Qt::Uninitialized);
+	forever {
+		const qint64 read = source->read(buffer.data(), buffer.size());
+		if (read < 0)
+			status = QtZipWriter::FileError;
+		if (read > 0)
+			entry->write(buffer.constData(), read);
+		if (read <= 0 || source->atEnd())
+			break;
+	}
+	endEntry();
+}
+
+/*
+	Start an entry whose contents are written through the returned device. The
+	sizes and the checksum are not known while the local header is written, so
+	they follow the data in a data descriptor.
+*/
+QIODevice *QtZipWriterPrivate::beginEntry(EntryType type, const QString &fileName, bool compress)
+{
+	if (!prepareDevice())
+		return 0;
+
+	// entries added before this one go first
+	writePendingEntries(true);
+	device->seek(start_of_directory);
+
+	entryHeader = createHeader(type, fileName, compress);
+	entryHeader.offset_local_header = start_of_directory;
+	writeUShort(entryHeader.h.general_purpose_bits, readUShort(entryHeader.h.general_purpose_bits) | HasDataDescriptor);
+	device->write(entryLocalHeader(false));
+
+	entryDevice = new QtZipEntryWriteDevice(device, compress);
+	return entryDevice;
+}
+
+/*
+	Return the local header of the streamed entry, with its file name and extra
+	field. Both variants have the same size: the one written first reserves the
+	room of the ZIP64 extra field with a growth hint, which is replaced by the
+	ZIP64 one only if the entry turns out to exceed 4 GB. Zeroed ZIP64 sizes
+	tell readers that the descriptor holds 64 bit sizes (APPNOTE.TXT 4.3.9).
+*/
+QByteArray QtZipWriterPrivate::entryLocalHeader(bool zip64) const
+{
+	uchar extra[20];
+	memset(extra, 0, sizeof(extra));
+	writeUShort(extra + 2, sizeof(extra) - 4);
+
+	LocalFileHeader h = entryHeader.h.toLocalHeader();
+	writeUInt(h.crc_32, 0);
+	writeUShort(h.extra_field_length, sizeof(extra));
+	if (zip64) {
+		writeUShort(h.version_needed, ZIP64_VERSION);
+		writeUInt(h.compressed_size, uint(Zip64Marker));
+		writeUInt(h.uncompressed_size, uint(Zip64Marker));
+		writeUShort(extra, Zip64ExtraFieldTag);
+	} else {
+		writeUShort(extra, GrowthHintExtraFieldTag);
+		writeUShort(extra + 4, GrowthHintSignature);
+	}
+
+	QByteArray header((const char *)&h, sizeof(LocalFileHeader));
+	header += entryHeader.file_name;
+	header += QByteArray((const char *)extra, sizeof(extra));
+	return header;
+}
+
+void QtZipWriterPrivate::endEntry()
+{
+	if (entryDevice == 0)
+		return;
+
+	if (!entryDevice->finish())
+		status = QtZipWriter::FileWriteError;
+
+	const uint crc_32 = entryDevice->crc();
+	entryHeader.compressed_size = entryDevice->compressedSize();
+	entryHeader.uncompressed_size = entryDevice->uncompressedSize();
+	delete entryDevice;
+	entryDevice = 0;
+
+	// an entry beyond 4 GB needs the ZIP64 local header after all, which
+	// takes the place of the reserved one
+	const bool zip64 = entryHeader.compressed_size >= Zip64Marker || entryHeader.uncompressed_size >= Zip64Marker;
+	if (zip64) {
+		const qint64 end = device->pos();
+		const QByteArray header = entryLocalHeader(true);
+		if (!device->seek(entryHeader.offset_local_header) || device->write(header) != header.size()
+			|| !device->seek(end))
+			status = QtZipWriter::FileWriteError;
+	}
+	writeUInt(entryHeader.h.crc_32, crc_32);
+
+	uchar signature[4];
+	writeUInt(signature, 0x08074b50);
+	device->write((const char *)signature, 4);
+	if (zip64) {
+		DataDescriptor64 descriptor;
+		writeUInt(descriptor.crc_32, crc_32);
+		writeULongLong(descriptor.compressed_size, entryHeader.compressed_size);
+		writeULongLong(descriptor.uncompressed_size, entryHeader.uncompressed_size);
+		device->write((const char *)&descriptor, sizeof(DataDescriptor64));
+	} else {
+		DataDescriptor descriptor;
+		writeUInt(descriptor.crc_32, crc_32);
+		writeUInt(descriptor.compressed_size, uint(entryHeader.compressed_size));
+		writeUInt(descriptor.uncompressed_size, uint(entryHeader.uncompressed_size));
+		device->write((const char *)&descriptor, sizeof(DataDescriptor));
+	}
+
+	fileHeaders.append(entryHeader);
 	start_of_directory = device->pos();
 	dirtyFileTree = true;
 }
@@ -947,6 +1727,20 @@ QStringList QtZipReader::fileList() const
 	return files;
 }
 
+/*!
+	Returns the names of the entries as they are stored in the archive, in
+	directory order. Unlike the paths in fileInfoList() they are not cleaned
+	up, so each of them can be passed to fileData() and openEntry().
+*/
+QStringList QtZipReader::entryNames() const
+{
+	d->scanFiles();
+	QStringList names;
+	for (int i = 0; i < d->fileHeaders.size(); ++i)
+		names.append(d->entryName(i));
+	return names;
+}
+
 /*!
 	Return the number of items in the zip archive.
 */
@@ -974,85 +1768,115 @@ QtZipReader::FileInfo QtZipReader::entryInfoAt(int index) const
 
 /*!
 	Fetch the file contents from the zip archive and return the uncompressed bytes.
+
+	\sa openEntry()
 */
 QByteArray QtZipReader::fileData(const QString &fileName) const
 {
-	d->scanFiles();
-	int i;
-	for (i = 0; i < d->fileHeaders.size(); ++i) {
-		if (QString::fromLocal8Bit(d->fileHeaders.at(i).file_name) == fileName)
-			break;
-	}
-	if (i == d->fileHeaders.size())
+	QScopedPointer<QIODevice> entry(openEntry(fileName));
+	if (entry.isNull())
 		return QByteArray();
 
-	FileHeader header = d->fileHeaders.at(i);
+	QByteArray data = entry->read(entry->bytesAvailable());
+	if (!entry->atEnd())
+		data += entry->readAll();
+	return data;
+}
+
+/*!
+	Open the file \a fileName from the zip archive for streamed reading.
+
+	Returns a sequential, read-only device that inflates the entry chunk by
+	chunk as it is read, or 0 if the entry does not exist or cannot be
+	extracted. The caller takes ownership of the device; it reads from
+	device() and must not outlive the reader.
+
+	\sa fileData()
+*/
+QIODevice* QtZipReader::openEntry(const QString &fileName) const
+{
+	d->scanFiles();
+	const int i = d->findEntry(fileName);
+	if (i == -1)
+		return 0;
+
+	const FileHeader &header = d->fileHeaders.at(i);
 
 	ushort version_needed = readUShort(header.h.version_needed);
-	if (version_needed > ZIP_VERSION) {
+	if (version_needed > ZIP64_VERSION) {
 		qWarning("QtZip: .ZIP specification version %d implementationis needed to extract the data.", version_needed);
-		return QByteArray();
+		return 0;
 	}
 
 	ushort general_purpose_bits = readUShort(header.h.general_purpose_bits);
-	int compressed_size = readUInt(header.h.compressed_size);
-	int uncompressed_size = readUInt(header.h.uncompressed_size);
-	int start = readUInt(header.h.offset_local_header);
-	//qDebug("uncompressing file %d: local header at %d", i, start);
+	if ((general_purpose_bits & Encrypted) != 0) {
+		qWarning("QtZip: Unsupported encryption method is needed to extract the data.");
+		return 0;
+	}
+
+	const qint64 compressed_size = header.compressed_size;
+	const qint64 uncompressed_size = header.uncompressed_size;
+	const qint64 start = header.offset_local_header;
+
+	// the ZIP64 values are untrusted 64 bit numbers, so never add them up
+	// before they are known to lie within the archive
+	const qint64 archive_size = d->mapped.isNull() ? d->device->size() : qint64(d->mapped.size());
+	if (start < 0 || start > archive_size - qint64(sizeof(LocalFileHeader))) {
+		qWarning("QtZip: Local file header lies outside the archive");
+		return 0;
+	}
 
-	d->device->seek(start);
 	LocalFileHeader lh;
-	d->device->read((char *)&lh, sizeof(LocalFileHeader));
-	uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
-	d->device->seek(d->device->pos() + skip);
+	const QByteArray local_header = d->readAt(start, sizeof(LocalFileHeader));
+	if (local_header.size() == sizeof(LocalFileHeader))
+		memcpy(&lh, local_header.constData(), sizeof(LocalFileHeader));
+	if (local_header.size() != sizeof(LocalFileHeader) || readUInt(lh.signature) != 0x04034b50) {
+		qWarning("QtZip: Failed to read local file header");
+		return 0;
+	}
+	const qint64 dataStart = start + sizeof(LocalFileHeader)
+		+ readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
 
-	int compression_method = readUShort(lh.compression_method);
-	//qDebug("file=%s: compressed_size=%d, uncompressed_size=%d", fileName.toLocal8Bit().data(), compressed_size, uncompressed_size);
+	const int compression_method = readUShort(lh.compression_method);
+	if (compression_method != CompressionMethodStored && compression_method != CompressionMethodDeflated) {
+		qWarning("QtZip: Unsupported compression method %d is needed to extract the data.", compression_method);
+		return 0;
+	}
 
-	if ((general_purpose_bits & Encrypted) != 0) {
-		qWarning("QtZip: Unsupported encryption method is needed to extract the data.");
-		return QByteArray();
+	if (compressed_size < 0 || dataStart > archive_size || compressed_size > archive_size - dataStart) {
+		qWarning("QtZip: Entry data exceeds the archive");
+		return 0;
+	}
+	// deflate cannot expand its input more than MaxDeflateRatio times, a larger
+	// size would only make fileData() preallocate memory it never fills
+	if (uncompressed_size < 0
+		|| (compression_method == CompressionMethodDeflated
+			&& uncompressed_size / MaxDeflateRatio > compressed_size)) {
+		qWarning("QtZip: Entry size does not match its compressed data");
+		return 0;
 	}
 
-	//qDebug("file at %lld", d->device->pos());
-	QByteArray compressed = d->device->read(compressed_size);
-	if (compression_method == CompressionMethodStored) {
-		// no compression
-		compressed.truncate(uncompressed_size);
-		return compressed;
-	} else if (compression_method == CompressionMethodDeflated) {
-		// Deflate
-		//qDebug("compressed=%d", compressed.size());
-		compressed.truncate(compressed_size);
-		QByteArray baunzip;
-		ulong len = qMax(uncompressed_size,  1);
-		int res;
-		do {
-			baunzip.resize(len);
-			res = inflate((uchar*)baunzip.data(), &len,
-						  (uchar*)compressed.constData(), compressed_size);
+	// a mapped entry is read in place
+	const char *mapped = d->mapped.isNull() ? 0 : d->mapped.constData();
 
-			switch (res) {
-			case Z_OK:
-				if ((int)len != baunzip.size())
-					baunzip.resize(len);
-				break;
-			case Z_MEM_ERROR:
-				qWarning("QtZip: Z_MEM_ERROR: Not enough memory");
-				break;
-			case Z_BUF_ERROR:
-				len *= 2;
-				break;
-			case Z_DATA_ERROR:
-				qWarning("QtZip: Z_DATA_ERROR: Input data is corrupted");
-				break;
-			}
-		} while (res == Z_BUF_ERROR);
-		return baunzip;
+	if (compression_method == CompressionMethodStored) {
+		const qint64 size = qMin(compressed_size, uncompressed_size);
+		return new QtZipEntryDevice(d->device, mapped, dataStart, size, size, readUInt(header.h.crc_32), false);
 	}
+	return new QtZipEntryDevice(d->device, mapped, dataStart, compressed_size, uncompressed_size,
+								readUInt(header.h.crc_32), true);
+}
 
-	qWarning("QtZip: Unsupported compression method %d is needed to extract the data.", compression_method);
-	return QByteArray();
+/*!
+	Returns \c true if the archive is read from memory: a buffer, or a file
+	that could be mapped. The devices returned by openEntry() then read the
+	archive in place instead of seeking device(), so several of them can be
+	read from different threads at once.
+*/
+bool QtZipReader::isMapped() const
+{
+	d->scanFiles();
+	return !d->mapped.isNull();
 }
 
 /*!
@@ -1136,6 +1960,11 @@ QtZipReader::Status QtZipReader::status() const
 */
 void QtZipReader::close()
 {
+	if (d->mappedFile && d->mappedFile->isOpen())
+		d->mappedFile->unmap((uchar *)d->mapped.constData());
+	d->mapped.clear();
+	d->mappedFile = 0;
+	d->dirtyFileTree = true;
 	d->device->close();
 }
 
@@ -1144,9 +1973,18 @@ void QtZipReader::close()
 */
 bool QtZipReader::canRead(QIODevice* device)
 {
-	uchar tmp[4];
-	device->peek((char *)tmp, 4);
-	return (readUInt(tmp) == 0x04034b50);
+	return canRead(device->peek(4));
+}
+
+/*!
+	Returns true if \a header, the first bytes of a file, starts with a local
+	file header signature.
+*/
+bool QtZipReader::canRead(const QByteArray &header)
+{
+	if (header.size() < 4)
+		return false;
+	return (readUInt(reinterpret_cast<const uchar *>(header.constData())) == 0x04034b50);
 }
 
 ////////////////////////////// Writer
@@ -1331,8 +2169,8 @@ void QtZipWriter::addFile(const QString &fileName, const QByteArray &data)
 
 /*!
 	Add a file to the archive with \a device as the source of the contents.
-	The contents returned from QIODevice::readAll() will be used as the
-	filedata.
+	The contents are copied from the device in chunks until its end, so the
+	file is never loaded into memory as a whole.
 	The file will be stored in the archive using the \a fileName which
 	includes the full path in the archive.
 */
@@ -1348,7 +2186,7 @@ void QtZipWriter::addFile(const QString &fileName, QIODevice *device)
 			return;
 		}
 	}
-	d->addEntry(QtZipWriterPrivate::File, QDir::fromNativeSeparators(fileName), device->readAll());
+	d->addEntry(QtZipWriterPrivate::File, QDir::fromNativeSeparators(fileName), device);
 	if (opened)
 		device->close();
 }
@@ -1376,6 +2214,68 @@ void QtZipWriter::addSymLink(const QString &fileName, const QString &destination
 	d->addEntry(QtZipWriterPrivate::Symlink, QDir::fromNativeSeparators(fileName), QFile::encodeName(destination));
 }
 
+/*!
+	Start a new file in the archive named \a fileName and return the device
+	its contents should be written to. The contents are compressed and written
+	to the archive as they arrive, so the file is never held in memory.
+
+	The device is owned by the writer and stays valid until endEntry() is
+	called. Adding any other entry or closing the archive ends the entry too.
+
+	\sa endEntry()
+*/
+QIODevice* QtZipWriter::beginEntry(const QString &fileName)
+{
+	return d->beginEntry(QtZipWriterPrivate::File, QDir::fromNativeSeparators(fileName),
+		d->compressionPolicy != NeverCompress);
+}
+
+/*!
+	Write \a len bytes of \a data to the entry started with beginEntry().
+	Returns the number of bytes written, or -1 if no entry is open.
+*/
+qint64 QtZipWriter::write(const char *data, qint64 len)
+{
+	return d->entryDevice ? d->entryDevice->write(data, len) : -1;
+}
+
+/*!
+	\overload
+*/
+qint64 QtZipWriter::write(const QByteArray &data)
+{
+	return write(data.constData(), data.size());
+}
+
+/*!
+	Finish the entry started with beginEntry(), writing its checksum and sizes.
+*/
+void QtZipWriter::endEntry()
+{
+	d->endEntry();
+}
+
+/*!
+	Compress the files added from memory on the threads of \a pool, while
+	the caller continues adding entries. The entries keep the order in
+	which they were added. The default is 0, which compresses every file
+	in the calling thread.
+*/
+void QtZipWriter::setThreadPool(QThreadPool *pool)
+{
+	d->threadPool = pool;
+}
+
+/*!
+	Returns the thread pool used to compress the files added from memory.
+
+	\sa setThreadPool()
+*/
+QThreadPool* QtZipWriter::threadPool() const
+{
+	return d->threadPool;
+}
+
 /*!
    Closes the zip file.
 */
@@ -1386,27 +2286,60 @@ void QtZipWriter::close()
 		return;
 	}
 
+	// finish the streamed entry and wait for the ones compressed in the background
+	d->endEntry();
+	d->writePendingEntries(true);
+
 	//qDebug("QtZip::close writing directory, %d entries", d->fileHeaders.size());
 	d->device->seek(d->start_of_directory);
 	// write new directory
 	for (int i = 0; i < d->fileHeaders.size(); ++i) {
 		const FileHeader &header = d->fileHeaders.at(i);
-		d->device->write((const char *)&header.h, sizeof(CentralFileHeader));
+		CentralFileHeader h = header.h;
+		const QByteArray extra_field = header.zip64ExtraField(h) + header.extra_field;
+		writeUShort(h.extra_field_length, extra_field.size());
+		d->device->write((const char *)&h, sizeof(CentralFileHeader));
 		d->device->write(header.file_name);
-		d->device->write(header.extra_field);
+		d->device->write(extra_field);
 		d->device->write(header.file_comment);
 	}
-	int dir_size = d->device->pos() - d->start_of_directory;
+	const quint64 num_dir_entries = d->fileHeaders.size();
+	const quint64 dir_start = d->start_of_directory;
+	const quint64 dir_size = d->device->pos() - d->start_of_directory;
+
+	// write ZIP64 end of directory with its locator, if the values don't fit
+	if (num_dir_entries >= 0xffff || dir_size >= Zip64Marker || dir_start >= Zip64Marker) {
+		const qint64 eod64_pos = d->device->pos();
+		EndOfDirectory64 eod64;
+		memset(&eod64, 0, sizeof(EndOfDirectory64));
+		writeUInt(eod64.signature, 0x06064b50);
+		writeULongLong(eod64.record_size, sizeof(EndOfDirectory64) - 12);
+		writeUShort(eod64.version_made, (HostUnix << 8) | ZIP64_VERSION);
+		writeUShort(eod64.version_needed, ZIP64_VERSION);
+		writeULongLong(eod64.num_dir_entries_this_disk, num_dir_entries);
+		writeULongLong(eod64.num_dir_entries, num_dir_entries);
+		writeULongLong(eod64.directory_size, dir_size);
+		writeULongLong(eod64.dir_start_offset, dir_start);
+		d->device->write((const char *)&eod64, sizeof(EndOfDirectory64));
+
+		EndOfDirectory64Locator locator;
+		memset(&locator, 0, sizeof(EndOfDirectory64Locator));
+		writeUInt(locator.signature, 0x07064b50);
+		writeULongLong(locator.eod_offset, eod64_pos);
+		writeUInt(locator.num_disks, 1);
+		d->device->write((const char *)&locator, sizeof(EndOfDirectory64Locator));
+	}
+
 	// write end of directory
 	EndOfDirectory eod;
 	memset(&eod, 0, sizeof(EndOfDirectory));
 	writeUInt(eod.signature, 0x06054b50);
 	//uchar this_disk[2];
 	//uchar start_of_directory_disk[2];
-	writeUShort(eod.num_dir_entries_this_disk, d->fileHeaders.size());
-	writeUShort(eod.num_dir_entries, d->fileHeaders.size());
-	writeUInt(eod.directory_size, dir_size);
-	writeUInt(eod.dir_start_offset, d->start_of_directory);
+	writeUShort(eod.num_dir_entries_this_disk, ushort(qMin(num_dir_entries, quint64(0xffff))));
+	writeUShort(eod.num_dir_entries, ushort(qMin(num_dir_entries, quint64(0xffff))));
+	writeUInt(eod.directory_size, uint(qMin(dir_size, Zip64Marker)));
+	writeUInt(eod.dir_start_offset, uint(qMin(dir_start, Zip64Marker)));
 	writeUShort(eod.comment_length, d->comment.length());
 
 	d->device->write((const char *)&eod, sizeof(EndOfDirectory));
@@ -83,10 +83,13 @@ public:
 
 	QList<FileInfo> fileInfoList() const;
 	QStringList fileList() const;
+	QStringList entryNames() const;
 	int count() const;
 
 	FileInfo entryInfoAt(int index) const;
 	QByteArray fileData(const QString &fileName) const;
+	QIODevice* openEntry(const QString &fileName) const;
+	bool isMapped() const;
 	bool extractAll(const QString &destinationDir) const;
 
 	enum Status {
@@ -102,6 +105,7 @@ public:
 	void close();
 
 	static bool canRead(QIODevice* device);
+	static bool canRead(const QByteArray &header);
 
 private:
 	QtZipReaderPrivate *d;
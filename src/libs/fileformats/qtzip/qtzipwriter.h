@@ -46,6 +46,7 @@
 #include <QFile>
 #include <QString>
 
+class QThreadPool;
 class QtZipWriterPrivate;
 
 class FILEFORMATS_EXPORT QtZipWriter
@@ -91,6 +92,14 @@ public:
 
 	void addSymLink(const QString &fileName, const QString &destination);
 
+	QIODevice* beginEntry(const QString &fileName);
+	qint64 write(const char *data, qint64 len);
+	qint64 write(const QByteArray &data);
+	void endEntry();
+
+	void setThreadPool(QThreadPool *pool);
+	QThreadPool* threadPool() const;
+
 	void close();
 private:
 	QtZipWriterPrivate *d;
@@ -28,6 +28,7 @@
 #include <QTextBlock>
 #include <QTextCodec>
 #include <QTextDecoder>
+#include <QTextDocument>
 
 //-----------------------------------------------------------------------------
 
@@ -52,6 +53,51 @@ namespace
 		return QTextCodec::codecForName(codec);
 	}
 
+	// Control words handled by the reader, sorted by byte value. The index
+	// of a word is its id in the function tables.
+	const char* const control_words[] = {
+		"\n", "\r", "'", "*", "-", "\\", "_", "ansi", "ansicpg", "b", "bullet", "caps", "colortbl",
+		"cpg", "deff", "emdash", "emspace", "endash", "enspace", "f", "fcharset", "filetbl", "fonttbl",
+		"i", "info", "ldblquote", "li", "line", "lquote", "ltrmark", "ltrpar", "mac", "nosupersub",
+		"outlinelevel", "par", "pard", "pc", "pca", "pict", "plain", "qc", "qj", "ql", "qmspace", "qr",
+		"rdblquote", "ri", "rquote", "rtlmark", "rtlpar", "s", "sa", "sb", "sbasedon", "strike",
+		"striked", "stylesheet", "sub", "super", "tab", "u", "uc", "ul", "uld", "uldash", "uldashd",
+		"uldb", "ulhwave", "ulnone", "ulth", "ululdbwave", "ulw", "ulwave", "zwj", "zwnj", "{", "|", "}",
+		"~"
+	};
+	const int control_word_count = sizeof(control_words) / sizeof(control_words[0]);
+
+	int compareControlWord(const char* word, const char* text, int length)
+	{
+		for (int i = 0; i < length; ++i) {
+			const unsigned char c = word[i];
+			if (c == 0) {
+				return -1;
+			} else if (c != static_cast<unsigned char>(text[i])) {
+				return c - static_cast<unsigned char>(text[i]);
+			}
+		}
+		return word[length] ? 1 : 0;
+	}
+
+	int findControlWord(const char* text, int length)
+	{
+		int first = 0;
+		int last = control_word_count - 1;
+		while (first <= last) {
+			int middle = (first + last) / 2;
+			int result = compareControlWord(control_words[middle], text, length);
+			if (result == 0) {
+				return middle;
+			} else if (result < 0) {
+				first = middle + 1;
+			} else {
+				last = middle - 1;
+			}
+		}
+		return -1;
+	}
+
 	qreal pixelsFromTwips(qint32 _twips)
 	{
 		qreal inches = _twips / 1440.0;
@@ -67,18 +113,19 @@ class RtfReader::FunctionTable
 public:
 	FunctionTable() :
 		m_group_end_func(0),
-		m_insert_text_func(0)
+		m_insert_text_func(0),
+		m_count(0)
 	{
 	}
 
-	void call(RtfReader* reader, const RtfTokenizer& token) const
+	void call(RtfReader* reader, const RtfTokenizer& token, int id) const
 	{
-		m_functions[token.text()].call(reader, token);
+		m_functions[id].call(reader, token);
 	}
 
-	bool contains(const QByteArray& name) const
+	bool contains(int id) const
 	{
-		return m_functions.contains(name);
+		return (id != -1) && m_functions[id].isValid();
 	}
 
 	void groupEnd(RtfReader* reader) const
@@ -95,12 +142,17 @@ public:
 
 	bool isEmpty() const
 	{
-		return m_functions.isEmpty();
+		return m_count == 0;
 	}
 
-	void set(const QByteArray& name, void (RtfReader::*func)(qint32), qint32 value = 0)
+	void set(const char* name, void (RtfReader::*func)(qint32), qint32 value = 0)
 	{
-		m_functions[name] = Function(func, value);
+		int id = findControlWord(name, qstrlen(name));
+		Q_ASSERT(id != -1);
+		if (!m_functions[id].isValid()) {
+			++m_count;
+		}
+		m_functions[id] = Function(func, value);
 	}
 
 	void setGroupEnd(void (RtfReader::*groupEndFunc)())
@@ -113,9 +165,13 @@ public:
 		m_insert_text_func = insertTextFunc;
 	}
 
-	void unset(const QByteArray& name)
+	void unset(const char* name)
 	{
-		m_functions.remove(name);
+		int id = findControlWord(name, qstrlen(name));
+		if ((id != -1) && m_functions[id].isValid()) {
+			m_functions[id] = Function();
+			--m_count;
+		}
 	}
 
 private:
@@ -136,11 +192,17 @@ private:
 			(reader->*m_func)(token.hasValue() ? token.value() : m_value);
 		}
 
+		bool isValid() const
+		{
+			return m_func != 0;
+		}
+
 	private:
 		void (RtfReader::*m_func)(qint32);
 		qint32 m_value;
 	};
-	QHash<QByteArray, Function> m_functions;
+	Function m_functions[control_word_count];
+	int m_count;
 }
 functions,
 stylesheet_functions,
@@ -317,20 +379,37 @@ RtfReader::~RtfReader()
 
 bool RtfReader::canRead(QIODevice* device)
 {
-	return device->peek(5) == "{\\rtf";
+	return canRead(device->peek(5));
+}
+
+//-----------------------------------------------------------------------------
+
+bool RtfReader::canRead(const QByteArray& header)
+{
+	return header.startsWith("{\\rtf");
 }
 
 //-----------------------------------------------------------------------------
 
 void RtfReader::readData(QIODevice* device)
 {
+	// Nothing to undo in a freshly loaded document, so skip recording it
+	QTextDocument* document = m_cursor.document();
+	const bool undo_enabled = document->isUndoRedoEnabled();
+	if (undo_enabled && (document->availableUndoSteps() == 0)) {
+		document->setUndoRedoEnabled(false);
+	}
+
 	try {
 		// Use theme spacings
 		m_block_format = m_cursor.blockFormat();
 		m_state.block_format = m_block_format;
+		m_char_format = m_cursor.charFormat();
+		m_pending_format = m_char_format;
 
 		// Open file
 		m_cursor.beginEditBlock();
+		const qint64 size = device->size() - device->pos();
 		m_token.setDevice(device);
 
 		// Check file type
@@ -341,15 +420,24 @@ void RtfReader::readData(QIODevice* device)
 			throw tr("Not a supported RTF file.");
 		}
 		m_token.readNext();
-		if (m_token.type() != ControlWordToken || m_token.text() != "rtf" || m_token.value() != 1) {
+		if (m_token.type() != ControlWordToken || !m_token.textIs("rtf") || m_token.value() != 1) {
 			throw tr("Not a supported RTF file.");
 		}
 
 		// Parse file contents
+		int count = 0;
 		while (!m_states.isEmpty() && m_token.hasNext()) {
+			if ((++count & 0x3ff) == 0) {
+				if (isCancelled()) {
+					throw cancelledError();
+				}
+				setProgress(m_token.position(), size);
+			}
 			m_token.readNext();
 
 			if ((m_token.type() != EndGroupToken) && !m_in_block) {
+				flushText();
+				m_cursor.setCharFormat(m_char_format);
 				m_cursor.insertBlock(m_state.block_format);
 				m_in_block = true;
 			}
@@ -360,19 +448,62 @@ void RtfReader::readData(QIODevice* device)
 				m_state.functions->groupEnd(this);
 				popState();
 			} else if (m_token.type() == ControlWordToken) {
-				if (!m_state.ignore_control_word && m_state.functions->contains(m_token.text())) {
-					m_state.functions->call(this, m_token);
+				if (!m_state.ignore_control_word) {
+					int id = findControlWord(m_token.text(), m_token.textLength());
+					if (m_state.functions->contains(id)) {
+						m_state.functions->call(this, m_token, id);
+					}
 				}
 			} else if (m_token.type() == TextToken) {
 				if (!m_state.ignore_text) {
-					m_state.functions->insertText(this, m_decoder->toUnicode(m_token.text()));
+					m_state.functions->insertText(this, m_decoder->toUnicode(m_token.text(), m_token.textLength()));
 				}
 			}
 		}
 	} catch (const QString& error) {
 		m_error = error;
 	}
+	flushText();
+	m_cursor.setCharFormat(m_char_format);
 	m_cursor.endEditBlock();
+
+	document->setUndoRedoEnabled(undo_enabled);
+}
+
+//-----------------------------------------------------------------------------
+
+void RtfReader::appendText(const QString& text)
+{
+	// Text is collected until the format changes
+	if (!m_pending_text.isEmpty() && (m_pending_format != m_char_format)) {
+		flushText();
+	}
+	m_pending_format = m_char_format;
+	m_pending_text += text;
+}
+
+//-----------------------------------------------------------------------------
+
+void RtfReader::flushText()
+{
+	if (!m_pending_text.isEmpty()) {
+		m_cursor.insertText(m_pending_text, m_pending_format);
+		m_pending_text.resize(0);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void RtfReader::mergeCharFormat(const QTextCharFormat& format)
+{
+	m_char_format.merge(format);
+}
+
+//-----------------------------------------------------------------------------
+
+void RtfReader::setCharFormat(const QTextCharFormat& format)
+{
+	m_char_format = format;
 }
 
 //-----------------------------------------------------------------------------
@@ -401,36 +532,37 @@ void RtfReader::ignoreText(qint32)
 
 void RtfReader::insertHexSymbol(qint32)
 {
-	m_cursor.insertText(m_decoder->toUnicode(m_token.hex()));
+	char hex = m_token.hex();
+	appendText(m_decoder->toUnicode(&hex, 1));
 }
 
 //-----------------------------------------------------------------------------
 
 void RtfReader::insertSymbol(qint32 value)
 {
-	m_cursor.insertText(QChar(value));
+	appendText(QChar(value));
 }
 
 //-----------------------------------------------------------------------------
 
 void RtfReader::insertText(const QString& text)
 {
-	m_cursor.insertText(text);
+	appendText(text);
 }
 
 //-----------------------------------------------------------------------------
 
 void RtfReader::insertUnicodeSymbol(qint32 value)
 {
-	m_cursor.insertText(QChar(value));
+	appendText(QChar(value));
 
 	for (int i = m_state.skip; i > 0;) {
 		m_token.readNext();
 
 		if (m_token.type() == TextToken) {
-			int len = m_token.text().count();
+			int len = m_token.textLength();
 			if (len > i) {
-				m_cursor.insertText(m_decoder->toUnicode(m_token.text().mid(i)));
+				appendText(m_decoder->toUnicode(m_token.text() + i, len - i));
 				break;
 			} else {
 				i -= len;
@@ -462,7 +594,7 @@ void RtfReader::popState()
 		return;
 	}
 	m_state = m_states.pop();
-	m_cursor.setCharFormat(m_state.char_format);
+	setCharFormat(m_state.char_format);
 	setFont(m_state.active_codepage);
 }
 
@@ -479,7 +611,7 @@ void RtfReader::resetBlockFormatting(qint32)
 void RtfReader::resetTextFormatting(qint32)
 {
 	m_state.char_format = QTextCharFormat();
-	m_cursor.setCharFormat(m_state.char_format);
+	setCharFormat(m_state.char_format);
 }
 
 //-----------------------------------------------------------------------------
@@ -534,7 +666,7 @@ void RtfReader::setBlockBottomIndent(qint32 value)
 void RtfReader::setTextBold(qint32 value)
 {
 	m_state.char_format.setFontWeight(value ? QFont::Bold : QFont::Normal);
-	m_cursor.mergeCharFormat(m_state.char_format);
+	mergeCharFormat(m_state.char_format);
 }
 
 //-----------------------------------------------------------------------------
@@ -542,7 +674,7 @@ void RtfReader::setTextBold(qint32 value)
 void RtfReader::setTextItalic(qint32 value)
 {
 	m_state.char_format.setFontItalic(value);
-	m_cursor.mergeCharFormat(m_state.char_format);
+	mergeCharFormat(m_state.char_format);
 }
 
 //-----------------------------------------------------------------------------
@@ -550,7 +682,7 @@ void RtfReader::setTextItalic(qint32 value)
 void RtfReader::setTextStrikeOut(qint32 value)
 {
 	m_state.char_format.setFontStrikeOut(value);
-	m_cursor.mergeCharFormat(m_state.char_format);
+	mergeCharFormat(m_state.char_format);
 }
 
 //-----------------------------------------------------------------------------
@@ -558,7 +690,7 @@ void RtfReader::setTextStrikeOut(qint32 value)
 void RtfReader::setTextUnderline(qint32 value)
 {
 	m_state.char_format.setFontUnderline(value);
-	m_cursor.mergeCharFormat(m_state.char_format);
+	mergeCharFormat(m_state.char_format);
 }
 
 //-----------------------------------------------------------------------------
@@ -566,13 +698,13 @@ void RtfReader::setTextUnderline(qint32 value)
 void RtfReader::setTextVerticalAlignment(qint32 value)
 {
 	m_state.char_format.setVerticalAlignment(QTextCharFormat::VerticalAlignment(value));
-	m_cursor.mergeCharFormat(m_state.char_format);
+	mergeCharFormat(m_state.char_format);
 }
 
 void RtfReader::setTextCapitalization(qint32 value)
 {
 	m_state.char_format.setFontCapitalization(QFont::Capitalization(value));
-	m_cursor.mergeCharFormat(m_state.char_format);
+	mergeCharFormat(m_state.char_format);
 }
 
 //-----------------------------------------------------------------------------
@@ -711,7 +843,7 @@ void RtfReader::setStyle(qint32 value)
 		m_cursor.mergeBlockFormat(m_state.block_format);
 
 		m_state.char_format.merge(style->char_format);
-		m_cursor.mergeCharFormat(m_state.char_format);
+		mergeCharFormat(m_state.char_format);
 
 		m_state.functions = style->functions;
 	}
@@ -26,9 +26,9 @@
 #include <QCoreApplication>
 #include <QSet>
 #include <QStack>
+#include <QString>
 #include <QTextBlockFormat>
 #include <QTextCharFormat>
-class QString;
 class QTextDecoder;
 
 class RtfReader : public FormatReader
@@ -46,9 +46,14 @@ public:
 	}
 
 	static bool canRead(QIODevice* device);
+	static bool canRead(const QByteArray& header);
 
 private:
 	void readData(QIODevice* device);
+	void appendText(const QString& text);
+	void flushText();
+	void mergeCharFormat(const QTextCharFormat& format);
+	void setCharFormat(const QTextCharFormat& format);
 	void endBlock(qint32);
 	void ignoreGroup(qint32);
 	void ignoreText(qint32);
@@ -118,6 +123,11 @@ private:
 	State m_state;
 	QTextBlockFormat m_block_format;
 
+	// Text waiting to be inserted with one call, and the format it uses
+	QTextCharFormat m_char_format;
+	QTextCharFormat m_pending_format;
+	QString m_pending_text;
+
 	QTextCodec* m_codec;
 	QTextDecoder* m_decoder;
 	QTextCodec* m_codepage;
@@ -24,26 +24,134 @@
 
 #include "rtf_tokenizer.h"
 
-#include <QCoreApplication>
+#include <QBuffer>
 #include <QIODevice>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	enum CharClass
+	{
+		Letter = 0x01,
+		Digit = 0x02,
+		TextEnd = 0x04,
+		LineBreak = 0x08,
+		HexDigit = 0x10,
+		Space = 0x20
+	};
+
+	// Classes of all byte values, see CharClass
+	const unsigned char char_class[256] = {
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x2c, 0x20, 0x20, 0x2c, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x12, 0x12, 0x12, 0x12, 0x12, 0x12, 0x12, 0x12, 0x12, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x04, 0x00, 0x00, 0x00,
+		0x00, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x04, 0x00, 0x04, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+	};
+
+	inline bool isClass(char c, int flags)
+	{
+		return char_class[static_cast<unsigned char>(c)] & flags;
+	}
+
+	int hexValue(char c)
+	{
+		if (c <= '9') {
+			return c - '0';
+		}
+		return (c | 0x20) - 'a' + 10;
+	}
+
+	// Value of a \'xx escape, parsed as leniently as QByteArray::toInt(0, 16)
+	char hexPair(char high, char low)
+	{
+		if (isClass(high, HexDigit)) {
+			if (isClass(low, HexDigit)) {
+				return char((hexValue(high) << 4) | hexValue(low));
+			}
+			return (isClass(low, Space) || low == '\0') ? char(hexValue(high)) : 0;
+		} else if (isClass(low, HexDigit)) {
+			if (isClass(high, Space) || high == '+') {
+				return char(hexValue(low));
+			} else if (high == '-') {
+				return char(-hexValue(low));
+			}
+		}
+		return 0;
+	}
+
+	// Find the first character that ends a run of text
+	const char* findTextEnd(const char* begin, const char* end)
+	{
+		const char* p = begin;
+#ifdef __SSE2__
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i open_brace = _mm_set1_epi8('{');
+		const __m128i close_brace = _mm_set1_epi8('}');
+		const __m128i cr = _mm_set1_epi8('\r');
+		const __m128i lf = _mm_set1_epi8('\n');
+		for (; end - p >= 16; p += 16) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			const __m128i found = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, backslash), _mm_cmpeq_epi8(chunk, open_brace)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, close_brace),
+					_mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf))));
+			const int mask = _mm_movemask_epi8(found);
+			if (mask) {
+				int offset = 0;
+				while (!(mask & (1 << offset))) {
+					++offset;
+				}
+				return p + offset;
+			}
+		}
+#endif
+		while (p < end && !isClass(*p, TextEnd)) {
+			++p;
+		}
+		return p;
+	}
+}
+
 //-----------------------------------------------------------------------------
 
 RtfTokenizer::RtfTokenizer() :
 	m_device(0),
+	m_in_memory(false),
+	m_data(0),
+	m_size(0),
 	m_position(0),
+	m_offset(0),
+	m_type(TextToken),
+	m_text(0),
+	m_text_length(0),
+	m_hex(0),
 	m_value(0),
 	m_has_value(false)
 {
-	m_buffer.reserve(8192);
-	m_text.reserve(8192);
 }
 
 //-----------------------------------------------------------------------------
 
 bool RtfTokenizer::hasNext() const
 {
-	return (m_position < m_buffer.size() - 1) || !m_device->atEnd();
+	return (m_position < m_size) || (!m_in_memory && !m_device->atEnd());
 }
 
 //-----------------------------------------------------------------------------
@@ -52,21 +160,27 @@ void RtfTokenizer::readNext()
 {
 	// Reset values
 	m_type = TextToken;
-	m_hex.clear();
-	m_text.resize(0);
+	m_text = 0;
+	m_text_length = 0;
+	m_hex = 0;
 	m_value = 0;
 	m_has_value = false;
 	if (!m_device) {
 		return;
 	}
 
-	// Read first character
-	char c;
-	do {
-		c = next();
-	} while (c == '\n' || c == '\r');
+	// Skip line breaks
+	int start = m_position;
+	while (isClass(peek(start), LineBreak)) {
+		++m_position;
+		start = m_position;
+	}
 
-	// Determine token type
+	// Determine token type; text offsets are relative to the token start,
+	// since refilling the buffer moves the token
+	int text_begin = 0;
+	int text_end = 0;
+	char c = m_data[m_position++];
 	if (c == '{') {
 		m_type = StartGroupToken;
 	} else if (c == '}') {
@@ -74,62 +188,75 @@ void RtfTokenizer::readNext()
 	} else if (c == '\\') {
 		m_type = ControlWordToken;
 
-		c = next();
+		c = peek(start);
+		++m_position;
+		text_begin = m_position - 1 - start;
 
-		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+		if (isClass(c, Letter)) {
 			// Read control word
-			while ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
-				m_text.append(c);
-				c = next();
+			while (isClass(peek(start), Letter)) {
+				++m_position;
 			}
+			text_end = m_position - start;
 
 			// Read integer value
-			int sign = (c != '-') ? 1 : -1;
-			if (sign == -1) {
-				c = next();
+			c = peek(start);
+			bool negative = (c == '-');
+			if (negative) {
+				++m_position;
+				c = peek(start);
 			}
-			QByteArray value;
-			while (isdigit(c)) {
-				value.append(c);
-				c = next();
+			qint64 value = 0;
+			bool overflow = false;
+			while (isClass(c, Digit)) {
+				m_has_value = true;
+				value = value * 10 + (c - '0');
+				if (value > 0x7fffffff) {
+					overflow = true;
+					value = 0;
+				}
+				++m_position;
+				c = peek(start);
 			}
-			m_has_value = !value.isEmpty();
-			m_value = value.toInt() * sign;
+			m_value = overflow ? 0 : qint32(negative ? -value : value);
 
 			// Eat space after control word
-			if (c != ' ') {
-				--m_position;
+			if (c == ' ') {
+				++m_position;
 			}
 
 			// Eat binary value
-			if (m_text == "bin") {
-				if (m_value > 0) {
-					for (int i = 0; i < m_value; i++) {
-						c = next();
-					}
-				}
+			if ((text_end - text_begin == 3) && !memcmp(m_data + start + text_begin, "bin", 3)) {
+				skip(m_value);
 				return readNext();
 			}
 		} else if (c == '\'') {
 			// Read hexadecimal value
-			m_text.append(c);
-			QByteArray hex(2, 0);
-			hex[0] = next();
-			hex[1] = next();
-			m_hex.append(hex.toInt(0, 16));
+			text_end = text_begin + 1;
+			char high = peek(start);
+			++m_position;
+			char low = peek(start);
+			++m_position;
+			m_hex = hexPair(high, low);
 		} else {
 			// Read escaped character
-			m_text.append(c);
+			text_end = text_begin + 1;
 		}
 	} else {
-		// Read text
+		// Read text up to the next control character
 		m_type = TextToken;
-		while (c != '\\' && c != '{' && c != '}' && c != '\n' && c != '\r') {
-			m_text.append(c);
-			c = next();
+		forever {
+			m_position = int(findTextEnd(m_data + m_position, m_data + m_size) - m_data);
+			if (m_position < m_size) {
+				break;
+			}
+			peek(start);
 		}
-		m_position--;
+		text_end = m_position - start;
 	}
+
+	m_text = m_data + start + text_begin;
+	m_text_length = text_end - text_begin;
 }
 
 //-----------------------------------------------------------------------------
@@ -137,24 +264,76 @@ void RtfTokenizer::readNext()
 void RtfTokenizer::setDevice(QIODevice* device)
 {
 	m_device = device;
+	m_buffer.clear();
+	m_in_memory = false;
+	m_data = 0;
+	m_size = 0;
+	m_position = 0;
+	m_offset = 0;
+
+	// Scan data that is already in memory directly
+	QBuffer* buffer = qobject_cast<QBuffer*>(device);
+	if (buffer && buffer->isReadable()) {
+		m_in_memory = true;
+		m_data = buffer->data().constData() + buffer->pos();
+		m_size = buffer->data().size() - buffer->pos();
+		buffer->seek(buffer->data().size());
+	}
 }
 
 //-----------------------------------------------------------------------------
 
-char RtfTokenizer::next()
+char RtfTokenizer::peek(int& start)
 {
-	m_position++;
-	if (m_position >= m_buffer.size()) {
-		m_buffer.resize(8192);
-		int size = m_device->read(m_buffer.data(), m_buffer.size());
-		if (size < 1) {
-			throw tr("Unexpectedly reached end of file.");
-		}
-		m_buffer.resize(size);
-		m_position = 0;
-		QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+	if (m_position >= m_size && !refill(start)) {
+		throw tr("Unexpectedly reached end of file.");
+	}
+	return m_data[m_position];
+}
+
+//-----------------------------------------------------------------------------
+
+bool RtfTokenizer::refill(int& start)
+{
+	if (m_in_memory) {
+		return false;
+	}
+
+	// Keep the current token at the front of the buffer
+	int kept = m_size - start;
+	if (kept > 0 && start > 0) {
+		memmove(m_buffer.data(), m_buffer.constData() + start, kept);
+	}
+	m_position -= start;
+	m_offset += start;
+	start = 0;
+
+	int capacity = qMax(m_buffer.size(), 8192);
+	if (kept == capacity) {
+		capacity *= 2;
+	}
+	m_buffer.resize(capacity);
+	int size = m_device->read(m_buffer.data() + kept, capacity - kept);
+	m_data = m_buffer.constData();
+	if (size < 1) {
+		m_size = kept;
+		return false;
+	}
+	m_size = kept + size;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void RtfTokenizer::skip(qint32 count)
+{
+	while (count > 0) {
+		int start = m_position;
+		peek(start);
+		int step = qMin(count, m_size - m_position);
+		m_position += step;
+		count -= step;
 	}
-	return m_buffer.at(m_position);
 }
 
 //-----------------------------------------------------------------------------
@@ -22,6 +22,8 @@
 
 #include <QByteArray>
 #include <QCoreApplication>
+
+#include <cstring>
 class QIODevice;
 
 enum RtfTokenType
@@ -40,9 +42,12 @@ public:
 	RtfTokenizer();
 
 	bool hasNext() const;
+	qint64 position() const;
 	bool hasValue() const;
-	QByteArray hex() const;
-	QByteArray text() const;
+	char hex() const;
+	const char* text() const;
+	int textLength() const;
+	bool textIs(const char* text) const;
 	RtfTokenType type() const;
 	qint32 value() const;
 
@@ -50,35 +55,58 @@ public:
 	void setDevice(QIODevice* device);
 
 private:
-	char next();
+	char peek(int& start);
+	bool refill(int& start);
+	void skip(qint32 count);
 
 private:
 	QIODevice* m_device;
 	QByteArray m_buffer;
+	bool m_in_memory;
+	const char* m_data;
+	int m_size;
 	int m_position;
+	qint64 m_offset;
 
+	// Token text points into the scanned data and stays valid until the next readNext()
 	RtfTokenType m_type;
-	QByteArray m_hex;
-	QByteArray m_text;
+	const char* m_text;
+	int m_text_length;
+	char m_hex;
 	qint32 m_value;
 	bool m_has_value;
 };
 
+inline qint64 RtfTokenizer::position() const
+{
+	return m_offset + m_position;
+}
+
 inline bool RtfTokenizer::hasValue() const
 {
 	return m_has_value;
 }
 
-inline QByteArray RtfTokenizer::hex() const
+inline char RtfTokenizer::hex() const
 {
 	return m_hex;
 }
 
-inline QByteArray RtfTokenizer::text() const
+inline const char* RtfTokenizer::text() const
 {
 	return m_text;
 }
 
+inline int RtfTokenizer::textLength() const
+{
+	return m_text_length;
+}
+
+inline bool RtfTokenizer::textIs(const char* text) const
+{
+	return (qstrlen(text) == uint(m_text_length)) && !memcmp(m_text, text, m_text_length);
+}
+
 inline RtfTokenType RtfTokenizer::type() const
 {
 	return m_type;
@@ -19,10 +19,52 @@
 
 #include "txt_reader.h"
 
-#include <QCoreApplication>
+#include <QBuffer>
 #include <QTextCodec>
 #include <QTextStream>
 
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Copies leading ASCII bytes into UTF-16 code units, returns how many were copied
+	int widenAscii(const char* data, int size, ushort* out)
+	{
+		int i = 0;
+#ifdef __SSE2__
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= size; i += 16) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+			if (_mm_movemask_epi8(chunk)) {
+				break;
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(chunk, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(chunk, zero));
+		}
+#endif
+		for (; (i < size) && !(data[i] & 0x80); ++i) {
+			out[i] = uchar(data[i]);
+		}
+		return i;
+	}
+
+	// Counts leading non-ASCII bytes; multi-byte UTF-8 sequences never contain ASCII
+	int countNonAscii(const char* data, int size)
+	{
+		int i = 0;
+		while ((i < size) && (data[i] & 0x80)) {
+			++i;
+		}
+		return i;
+	}
+}
+
 //-----------------------------------------------------------------------------
 
 TxtReader::TxtReader()
@@ -35,21 +77,93 @@ void TxtReader::readData(QIODevice* device)
 {
 	m_cursor.beginEditBlock();
 
-	QTextStream stream(device);
 	QTextCodec* codec = QTextCodec::codecForUtfText(device->peek(4), NULL);
 	if (codec != NULL) {
 		m_encoding = codec->name().toUpper();
 	} else {
 		codec = QTextCodec::codecForName("UTF-8");
 	}
+	if (codec->mibEnum() == 106) {
+		readUtf8(device, codec);
+		m_cursor.endEditBlock();
+		return;
+	}
+
+	QTextStream stream(device);
 	stream.setCodec(codec);
 
 	while (!stream.atEnd()) {
+		if (isCancelled()) {
+			m_error = cancelledError();
+			break;
+		}
 		m_cursor.insertText(stream.read(0x4000));
-		QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+		setProgress(device->pos(), device->size());
 	}
 
 	m_cursor.endEditBlock();
 }
 
 //-----------------------------------------------------------------------------
+
+void TxtReader::readUtf8(QIODevice* device, QTextCodec* codec)
+{
+	QByteArray bytes;
+	const char* data = 0;
+	int size = 0;
+	QBuffer* buffer = qobject_cast<QBuffer*>(device);
+	if (buffer && buffer->isReadable()) {
+		data = buffer->data().constData() + buffer->pos();
+		size = buffer->data().size() - int(buffer->pos());
+		buffer->seek(buffer->data().size());
+	} else {
+		bytes = device->readAll();
+		data = bytes.constData();
+		size = bytes.size();
+	}
+	if ((size >= 3) && (std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)) {
+		data += 3;
+		size -= 3;
+	}
+
+	// UTF-8 never takes more UTF-16 code units than bytes, so decode straight
+	// into a buffer of that size; only runs of non-ASCII bytes go through the codec
+	QString text(size, Qt::Uninitialized);
+	ushort* out = reinterpret_cast<ushort*>(text.data());
+	int length = 0;
+	int pos = 0;
+	while (pos < size) {
+		if (isCancelled()) {
+			m_error = cancelledError();
+			return;
+		}
+
+		// Decode in 1 MB steps, reporting the progress after each one
+		const int end = qMin(size, pos + 0x100000);
+		while (pos < end) {
+			const int ascii = widenAscii(data + pos, end - pos, out + length);
+			pos += ascii;
+			length += ascii;
+			if (pos == end) {
+				break;
+			}
+
+			const int count = countNonAscii(data + pos, size - pos);
+			QTextCodec::ConverterState state(QTextCodec::IgnoreHeader);
+			QString decoded = codec->toUnicode(data + pos, count, &state);
+			if (state.remainingChars) {
+				decoded += QChar(QChar::ReplacementCharacter);
+			}
+			std::memcpy(out + length, decoded.constData(), decoded.size() * sizeof(QChar));
+			length += decoded.size();
+			pos += count;
+		}
+		setProgress(pos, size);
+	}
+	text.resize(length);
+
+	// Paragraph breaks are split out by the cursor in a single insertion
+	m_cursor.insertText(text);
+}
+
+//-----------------------------------------------------------------------------
@@ -22,6 +22,8 @@
 
 #include "format_reader.h"
 
+class QTextCodec;
+
 class TxtReader : public FormatReader
 {
 public:
@@ -39,8 +41,15 @@ public:
 		return true;
 	}
 
+	static bool canRead(const QByteArray& header)
+	{
+		Q_UNUSED(header)
+		return true;
+	}
+
 private:
 	void readData(QIODevice* device);
+	void readUtf8(QIODevice* device, QTextCodec* codec);
 };
 
 #endif
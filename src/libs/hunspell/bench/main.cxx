@@ -0,0 +1,242 @@
+/*
+ * hunspell-bench: load time, spell() and suggest() latency of dictionaries
+ *
+ *     hunspell-bench [-n words] [-s suggestions] [-w wordlist] dict...
+ *
+ * dict is a dictionary path without extension (e.g. Hunspell/ru_RU for
+ * ru_RU.aff and ru_RU.dic). Unless -w gives a word list (one word per line,
+ * in the dictionary encoding), the words are every k-th stem of the .dic
+ * file, n (10000) words in all, so a dictionary always gets the same list.
+ * Every word also gets one typo (a transposed, dropped or doubled character)
+ * at a fixed position.
+ *
+ * spell() is timed over the words and the typos, first with an empty
+ * result cache, then again over the same list, answered from the cache as
+ * far as it holds the results. suggest() is timed for the first s (300)
+ * rejected typos. Output is one tab-separated line per dictionary, which
+ * keeps it easy to diff between builds. The load time includes the
+ * compiled image (.hdic) when hcompile has made one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "hunspell.hxx"
+#include "csutil.hxx"
+
+#define DESC "Usage: hunspell-bench [-n words] [-s suggestions] [-w wordlist] dict...\n"
+
+#define BENCH_WORDS 10000
+#define BENCH_SUGGESTIONS 300
+#define BENCH_WORDLEN 256
+
+// monotonic time in microseconds
+static double now_us()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, t;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double) t.QuadPart * 1e6 / (double) freq.QuadPart;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+#endif
+}
+
+static int cmp_double(const void * a, const void * b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static void chomp(char * s)
+{
+    int n = strlen(s);
+    while (n && (s[n - 1] == '\n' || s[n - 1] == '\r')) s[--n] = '\0';
+}
+
+// words of the word list, or every k-th stem of the dictionary
+static int read_words(const char * path, int fromdic, int max, char *** words)
+{
+    *words = NULL;
+    FILE * f = fopen(path, "r");
+    if (!f) return 0;
+    char line[BENCH_WORDLEN * 4];
+    int step = 1;
+    if (fromdic) {
+        if (!fgets(line, sizeof(line), f)) {
+            fclose(f);
+            return 0;
+        }
+        int count = atoi(line);
+        if (count > max) step = count / max;
+    }
+    *words = (char **) malloc(max * sizeof(char *));
+    if (!*words) {
+        fclose(f);
+        return 0;
+    }
+    int n = 0;
+    for (int i = 0; n < max && fgets(line, sizeof(line), f); i++) {
+        if (i % step) continue;
+        chomp(line);
+        if (fromdic) line[strcspn(line, "/\t ")] = '\0';
+        if (!*line || strlen(line) >= BENCH_WORDLEN) continue;
+        (*words)[n] = mystrdup(line);
+        if ((*words)[n]) n++;
+    }
+    fclose(f);
+    return n;
+}
+
+// typo of the i-th word: a transposed, dropped or doubled character
+static void make_typo(const char * word, int i, int utf8, char * typo)
+{
+    int pos[BENCH_WORDLEN + 1];
+    int nc = 0;
+    int len = strlen(word);
+    for (int k = 0; k < len; k++) {
+        // character starts, UTF-8 continuation bytes are skipped
+        if (!utf8 || (word[k] & 0xc0) != 0x80) pos[nc++] = k;
+    }
+    pos[nc] = len;
+    strcpy(typo, word);
+    if (nc < 2) {
+        strcat(typo, word);
+        return;
+    }
+    int c = (i * 7) % (nc - 1);
+    int a = pos[c];
+    int b = pos[c + 1];
+    switch (i % 3) {
+        case 0: // transpose the characters c and c + 1
+            memcpy(typo + a, word + b, pos[c + 2] - b);
+            memcpy(typo + a + pos[c + 2] - b, word + a, b - a);
+            break;
+        case 1: // drop the character c
+            strcpy(typo + a, word + b);
+            break;
+        default: // double the character c
+            strcpy(typo + b, word + a);
+            break;
+    }
+}
+
+static void bench(const char * dict, const char * wordlist, int nwords, int nsug)
+{
+    char aff[1024];
+    char dic[1024];
+    snprintf(aff, sizeof(aff), "%s.aff", dict);
+    snprintf(dic, sizeof(dic), "%s.dic", dict);
+    FILE * f = fopen(aff, "r");
+    if (!f) {
+        fprintf(stderr, "hunspell-bench: can't open %s\n", aff);
+        return;
+    }
+    fclose(f);
+
+    double t = now_us();
+    Hunspell * pMS = new Hunspell(aff, dic);
+    double load = now_us() - t;
+
+    char ** words;
+    int n = read_words(wordlist ? wordlist : dic, !wordlist, nwords, &words);
+    if (!n) {
+        fprintf(stderr, "hunspell-bench: no words for %s\n", dict);
+        delete pMS;
+        return;
+    }
+    const char * enc = pMS->get_dic_encoding();
+    int utf8 = enc && strcmp(enc, "UTF-8") == 0;
+    char ** list = (char **) malloc(2 * n * sizeof(char *));
+    double * sug = (double *) malloc(nsug * sizeof(double));
+    if (!list || !sug) {
+        fprintf(stderr, "hunspell-bench: out of memory\n");
+        exit(1);
+    }
+    char typo[BENCH_WORDLEN * 2];
+    for (int i = 0; i < n; i++) {
+        make_typo(words[i], i, utf8, typo);
+        list[i] = words[i];
+        list[n + i] = mystrdup(typo);
+    }
+
+    // cold and cached spell() passes
+    int rejected = 0;
+    t = now_us();
+    for (int i = 0; i < 2 * n; i++) {
+        if (!pMS->spell(list[i])) rejected++;
+    }
+    double cold = now_us() - t;
+    t = now_us();
+    for (int i = 0; i < 2 * n; i++) pMS->spell(list[i]);
+    double cached = now_us() - t;
+
+    int ns = 0;
+    for (int i = n; i < 2 * n && ns < nsug; i++) {
+        if (pMS->spell(list[i])) continue;
+        char ** slst;
+        t = now_us();
+        int k = pMS->suggest(&slst, list[i]);
+        sug[ns++] = now_us() - t;
+        pMS->free_list(&slst, k);
+    }
+    qsort(sug, ns, sizeof(double), cmp_double);
+
+    const char * name = dict + strlen(dict);
+    while (name > dict && name[-1] != '/' && name[-1] != '\\') name--;
+    printf("%-12s\t%6d words\t%9.2f ms load\t%8.0f ns/spell\t%8.0f ns/cached"
+        "\t%6d rejected\t%4d sug\t%8.0f us p50\t%8.0f us p90\t%8.0f us p99\t%8.0f us max\n",
+        name, 2 * n, load / 1e3, cold * 1e3 / (2 * n), cached * 1e3 / (2 * n), rejected, ns,
+        ns ? sug[ns * 50 / 100] : 0.0, ns ? sug[ns * 90 / 100] : 0.0,
+        ns ? sug[ns * 99 / 100] : 0.0, ns ? sug[ns - 1] : 0.0);
+    fflush(stdout);
+
+    for (int i = 0; i < 2 * n; i++) free(list[i]);
+    free(list);
+    free(words);
+    free(sug);
+    delete pMS;
+}
+
+int main(int argc, char ** argv)
+{
+    int nwords = BENCH_WORDS;
+    int nsug = BENCH_SUGGESTIONS;
+    const char * wordlist = NULL;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            nwords = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            nsug = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            wordlist = argv[++i];
+        } else {
+            fprintf(stderr, DESC);
+            return 1;
+        }
+    }
+    if (i == argc || nwords < 1 || nsug < 0) {
+        fprintf(stderr, DESC);
+        return 1;
+    }
+    for (; i < argc; i++) {
+        // the extension of file.aff or file.dic is dropped
+        int len = strlen(argv[i]);
+        if (len > 4 && (strcmp(argv[i] + len - 4, ".aff") == 0 ||
+            strcmp(argv[i] + len - 4, ".dic") == 0)) argv[i][len - 4] = '\0';
+        bench(argv[i], wordlist, nwords, nsug);
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+TARGET   = hcompile
+TEMPLATE = app
+
+#
+# Build configuration
+#
+CONFIG += console thread warn_on
+CONFIG -= app_bundle qt
+
+#
+# The library sources are built into the tool, so nothing is imported
+#
+DEFINES += HUNSPELL_STATIC
+win32: DEFINES += _CRT_SECURE_NO_WARNINGS
+
+QMAKE_MAC_SDK = macosx10.12
+
+#
+# Конфигурируем расположение файлов сборки
+#
+CONFIG(debug, debug|release) {
+    DESTDIR = $$PWD/../../../../build/Debug/libs/hunspell/hcompile
+} else {
+    DESTDIR = $$PWD/../../../../build/Release/libs/hunspell/hcompile
+}
+
+OBJECTS_DIR = $$DESTDIR/.obj
+MOC_DIR = $$DESTDIR/.moc
+RCC_DIR = $$DESTDIR/.qrc
+UI_DIR = $$DESTDIR/.ui
+#
+
+include(../hunspell.pri)
+
+SOURCES += \
+    ../src/tools/hcompile.cxx
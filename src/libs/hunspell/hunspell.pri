@@ -0,0 +1,54 @@
+#
+# Исходные тексты библиотеки, общие с целями hunspell-tests и hunspell-bench
+#
+
+#
+# Пути поиска заголовочных файлов, config.h под unix создаётся в корне hunspell
+#
+INCLUDEPATH += $$PWD/src/hunspell
+unix: INCLUDEPATH += $$PWD
+else: win32: INCLUDEPATH += $$PWD/src/win_api
+
+#
+# Заголовочные файлы
+#
+HEADERS += \
+	$$PWD/src/hunspell/affentry.hxx \
+	$$PWD/src/hunspell/htypes.hxx \
+	$$PWD/src/hunspell/affixmgr.hxx \
+	$$PWD/src/hunspell/csutil.hxx \
+	$$PWD/src/hunspell/hunspell.hxx \
+	$$PWD/src/hunspell/atypes.hxx \
+	$$PWD/src/hunspell/dictmgr.hxx \
+	$$PWD/src/hunspell/hunspell.h \
+	$$PWD/src/hunspell/suggestmgr.hxx \
+	$$PWD/src/hunspell/baseaffix.hxx \
+	$$PWD/src/hunspell/hashmgr.hxx \
+	$$PWD/src/hunspell/langnum.hxx \
+	$$PWD/src/hunspell/phonet.hxx \
+	$$PWD/src/hunspell/filemgr.hxx \
+	$$PWD/src/hunspell/hunzip.hxx \
+	$$PWD/src/hunspell/w_char.hxx \
+	$$PWD/src/hunspell/replist.hxx \
+	$$PWD/src/hunspell/spellcache.hxx \
+	$$PWD/src/hunspell/hunvisapi.h
+
+#
+# Исходные тексты
+#
+SOURCES += \
+	$$PWD/src/hunspell/affentry.cxx \
+	$$PWD/src/hunspell/affixmgr.cxx \
+	$$PWD/src/hunspell/csutil.cxx \
+	$$PWD/src/hunspell/dictmgr.cxx \
+	$$PWD/src/hunspell/hashmgr.cxx \
+	$$PWD/src/hunspell/hunspell.cxx \
+	$$PWD/src/hunspell/suggestmgr.cxx \
+	$$PWD/src/hunspell/license.myspell \
+	$$PWD/src/hunspell/license.hunspell \
+	$$PWD/src/hunspell/phonet.cxx \
+	$$PWD/src/hunspell/filemgr.cxx \
+	$$PWD/src/hunspell/hunzip.cxx \
+	$$PWD/src/hunspell/replist.cxx \
+	$$PWD/src/hunspell/spellcache.cxx \
+	$$PWD/src/hunspell/utf_info.cxx
@@ -53,49 +53,4 @@ else: win32 {
 		src/win_api/hunspelldll.cxx
 }
 
-#
-# Пути поиска заголовочных файлов
-#
-INCLUDEPATH += src/hunspell
-
-#
-# Заголовочные файлы
-#
-HEADERS += \
-	src/hunspell/affentry.hxx \
-	src/hunspell/htypes.hxx \
-	src/hunspell/affixmgr.hxx \
-	src/hunspell/csutil.hxx \
-	src/hunspell/hunspell.hxx \
-	src/hunspell/atypes.hxx \
-	src/hunspell/dictmgr.hxx \
-	src/hunspell/hunspell.h \
-	src/hunspell/suggestmgr.hxx \
-	src/hunspell/baseaffix.hxx \
-	src/hunspell/hashmgr.hxx \
-	src/hunspell/langnum.hxx \
-	src/hunspell/phonet.hxx \
-	src/hunspell/filemgr.hxx \
-	src/hunspell/hunzip.hxx \
-	src/hunspell/w_char.hxx \
-	src/hunspell/replist.hxx \
-	src/hunspell/hunvisapi.h
-
-#
-# Исходные тексты
-#
-SOURCES += \
-	src/hunspell/affentry.cxx \
-	src/hunspell/affixmgr.cxx \
-	src/hunspell/csutil.cxx \
-	src/hunspell/dictmgr.cxx \
-	src/hunspell/hashmgr.cxx \
-	src/hunspell/hunspell.cxx \
-	src/hunspell/suggestmgr.cxx \
-	src/hunspell/license.myspell \
-	src/hunspell/license.hunspell \
-	src/hunspell/phonet.cxx \
-	src/hunspell/filemgr.cxx \
-	src/hunspell/hunzip.cxx \
-	src/hunspell/replist.cxx \
-	src/hunspell/utf_info.cxx
+include(hunspell.pri)
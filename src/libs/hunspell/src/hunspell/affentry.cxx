@@ -148,8 +148,27 @@ inline int PfxEntry::test_condition(const char * st)
     }
 }
 
+// set of the bytes the root may begin with by the first element of the
+// condition, 0 if it may begin with any byte (or the strip is added back)
+int PfxEntry::condition_bytes(unsigned char * set)
+{
+    if (numconds == 0 || stripl) return 0;
+    char * p = c.conds;
+    memset(set, 0, CONDBYTES_SIZE);
+    if (*p == '.') return 0;
+    if (*p != '[') {
+        set[(unsigned char) *p >> 3] |= 1 << (*p & 7);
+        return 1;
+    }
+    p = nextchar(p);
+    if (!p || *p == '^') return 0;
+    // every byte of the group, so multibyte characters are not decoded
+    for (; p && *p != ']'; p = nextchar(p)) set[(unsigned char) *p >> 3] |= 1 << (*p & 7);
+    return (p != NULL);
+}
+
 // check if this prefix entry matches
-struct hentry * PfxEntry::checkword(const char * word, int len, char in_compound, const FLAG needflag)
+struct hentry * PfxEntry::checkword(affix_ctx & ctx, const char * word, int len, char in_compound, const FLAG needflag)
 {
     int                 tmpl;   // length of tmpword
     struct hentry *     he;     // hash entry of root word or NULL
@@ -182,14 +201,14 @@ struct hentry * PfxEntry::checkword(const char * word, int len, char in_compound
                 tmpl += stripl;
                 if ((he = pmyMgr->lookup(tmpword)) != NULL) {
                    do {
-                      if (TESTAFF(he->astr, aflag, he->alen) &&
+                      if (TESTAFF(HENTRY_ASTR(he), aflag, he->alen) &&
                         // forbid single prefixes with needaffix flag
                         ! TESTAFF(contclass, pmyMgr->get_needaffix(), contclasslen) &&
                         // needflag
-                        ((!needflag) || TESTAFF(he->astr, needflag, he->alen) ||
+                        ((!needflag) || TESTAFF(HENTRY_ASTR(he), needflag, he->alen) ||
                          (contclass && TESTAFF(contclass, needflag, contclasslen))))
                             return he;
-                      he = he->next_homonym; // check homonyms
+                      he = HENTRY_HOMONYM(he); // check homonyms
                    } while (he);
                 }
 
@@ -199,7 +218,7 @@ struct hentry * PfxEntry::checkword(const char * word, int len, char in_compound
 
                 //if ((opts & aeXPRODUCT) && in_compound) {
                 if ((opts & aeXPRODUCT)) {
-                   he = pmyMgr->suffix_check(tmpword, tmpl, aeXPRODUCT, this, NULL,
+                   he = pmyMgr->suffix_check(ctx, tmpword, tmpl, aeXPRODUCT, this, NULL,
                         0, NULL, FLAG_NULL, needflag, in_compound);
                    if (he) return he;
                 }
@@ -209,7 +228,7 @@ struct hentry * PfxEntry::checkword(const char * word, int len, char in_compound
 }
 
 // check if this prefix entry matches
-struct hentry * PfxEntry::check_twosfx(const char * word, int len,
+struct hentry * PfxEntry::check_twosfx(affix_ctx & ctx, const char * word, int len,
     char in_compound, const FLAG needflag)
 {
     int                 tmpl;   // length of tmpword
@@ -248,7 +267,7 @@ struct hentry * PfxEntry::check_twosfx(const char * word, int len,
                 // cross checked combined with a suffix
 
                 if ((opts & aeXPRODUCT) && (in_compound != IN_CPD_BEGIN)) {
-                   he = pmyMgr->suffix_check_twosfx(tmpword, tmpl, aeXPRODUCT, this, needflag);
+                   he = pmyMgr->suffix_check_twosfx(ctx, tmpword, tmpl, aeXPRODUCT, this, needflag);
                    if (he) return he;
                 }
             }
@@ -257,7 +276,7 @@ struct hentry * PfxEntry::check_twosfx(const char * word, int len,
 }
 
 // check if this prefix entry matches
-char * PfxEntry::check_twosfx_morph(const char * word, int len,
+char * PfxEntry::check_twosfx_morph(affix_ctx & ctx, const char * word, int len,
          char in_compound, const FLAG needflag)
 {
     int                 tmpl;   // length of tmpword
@@ -295,7 +314,7 @@ char * PfxEntry::check_twosfx_morph(const char * word, int len,
                 // ross checked combined with a suffix
 
                 if ((opts & aeXPRODUCT) && (in_compound != IN_CPD_BEGIN)) {
-                    return pmyMgr->suffix_check_twosfx_morph(tmpword, tmpl,
+                    return pmyMgr->suffix_check_twosfx_morph(ctx, tmpword, tmpl,
                              aeXPRODUCT, this, needflag);
                 }
             }
@@ -342,11 +361,11 @@ char * PfxEntry::check_morph(const char * word, int len, char in_compound, const
                 tmpl += stripl;
                 if ((he = pmyMgr->lookup(tmpword)) != NULL) {
                     do {
-                      if (TESTAFF(he->astr, aflag, he->alen) &&
+                      if (TESTAFF(HENTRY_ASTR(he), aflag, he->alen) &&
                         // forbid single prefixes with needaffix flag
                         ! TESTAFF(contclass, pmyMgr->get_needaffix(), contclasslen) &&
                         // needflag
-                        ((!needflag) || TESTAFF(he->astr, needflag, he->alen) ||
+                        ((!needflag) || TESTAFF(HENTRY_ASTR(he), needflag, he->alen) ||
                          (contclass && TESTAFF(contclass, needflag, contclasslen)))) {
                             if (morphcode) {
                                 mystrcat(result, " ", MAXLNLEN);
@@ -371,7 +390,7 @@ char * PfxEntry::check_morph(const char * word, int len, char in_compound, const
                             }
                             mystrcat(result, "\n", MAXLNLEN);
                       }
-                      he = he->next_homonym;
+                      he = HENTRY_HOMONYM(he);
                     } while (he);
                 }
 
@@ -559,6 +578,26 @@ inline int SfxEntry::test_condition(const char * st, const char * beg)
     }
 }
 
+// set of the bytes the root may end with by the first element of the
+// (reversed) condition, 0 if it may end with any byte (or the strip is
+// added back)
+int SfxEntry::condition_bytes(unsigned char * set)
+{
+    if (numconds == 0 || stripl) return 0;
+    char * p = c.conds;
+    memset(set, 0, CONDBYTES_SIZE);
+    if (*p == '.') return 0;
+    if (*p != '[') {
+        set[(unsigned char) *p >> 3] |= 1 << (*p & 7);
+        return 1;
+    }
+    p = nextchar(p);
+    if (!p || *p == '^') return 0;
+    // every byte of the group, so multibyte characters are not decoded
+    for (; p && *p != ']'; p = nextchar(p)) set[(unsigned char) *p >> 3] |= 1 << (*p & 7);
+    return (p != NULL);
+}
+
 // see if this suffix is present in the word
 struct hentry * SfxEntry::checkword(const char * word, int len, int optflags,
     PfxEntry* ppfx, char ** wlst, int maxSug, int * ns, const FLAG cclass, const FLAG needflag,
@@ -616,10 +655,10 @@ struct hentry * SfxEntry::checkword(const char * word, int len, int optflags,
                 if ((he = pmyMgr->lookup(tmpword)) != NULL) {
                     do {
                         // check conditional suffix (enabled by prefix)
-                        if ((TESTAFF(he->astr, aflag, he->alen) || (ep && ep->getCont() &&
+                        if ((TESTAFF(HENTRY_ASTR(he), aflag, he->alen) || (ep && ep->getCont() &&
                                     TESTAFF(ep->getCont(), aflag, ep->getContLen()))) &&
                             (((optflags & aeXPRODUCT) == 0) ||
-                            (ep && TESTAFF(he->astr, ep->getFlag(), he->alen)) ||
+                            (ep && TESTAFF(HENTRY_ASTR(he), ep->getFlag(), he->alen)) ||
                              // enabled by prefix
                             ((contclass) && (ep && TESTAFF(contclass, ep->getFlag(), contclasslen)))
                             ) &&
@@ -628,15 +667,15 @@ struct hentry * SfxEntry::checkword(const char * word, int len, int optflags,
                                 ((contclass) && TESTAFF(contclass, cclass, contclasslen))
                             ) &&
                             // check only in compound homonyms (bad flags)
-                            (!badflag || !TESTAFF(he->astr, badflag, he->alen)
+                            (!badflag || !TESTAFF(HENTRY_ASTR(he), badflag, he->alen)
                             ) &&
                             // handle required flag
                             ((!needflag) ||
-                              (TESTAFF(he->astr, needflag, he->alen) ||
+                              (TESTAFF(HENTRY_ASTR(he), needflag, he->alen) ||
                               ((contclass) && TESTAFF(contclass, needflag, contclasslen)))
                             )
                         ) return he;
-                        he = he->next_homonym; // check homonyms
+                        he = HENTRY_HOMONYM(he); // check homonyms
                     } while (he);
 
                 // obsolote stemming code (used only by the
@@ -662,7 +701,7 @@ struct hentry * SfxEntry::checkword(const char * word, int len, int optflags,
 }
 
 // see if two-level suffix is present in the word
-struct hentry * SfxEntry::check_twosfx(const char * word, int len, int optflags,
+struct hentry * SfxEntry::check_twosfx(affix_ctx & ctx, const char * word, int len, int optflags,
     PfxEntry* ppfx, const FLAG needflag)
 {
     int                 tmpl;            // length of tmpword
@@ -711,11 +750,11 @@ struct hentry * SfxEntry::check_twosfx(const char * word, int len, int optflags,
                 if (ppfx) {
                     // handle conditional suffix
                     if ((contclass) && TESTAFF(contclass, ep->getFlag(), contclasslen))
-                        he = pmyMgr->suffix_check(tmpword, tmpl, 0, NULL, NULL, 0, NULL, (FLAG) aflag, needflag);
+                        he = pmyMgr->suffix_check(ctx, tmpword, tmpl, 0, NULL, NULL, 0, NULL, (FLAG) aflag, needflag);
                     else
-                        he = pmyMgr->suffix_check(tmpword, tmpl, optflags, ppfx, NULL, 0, NULL, (FLAG) aflag, needflag);
+                        he = pmyMgr->suffix_check(ctx, tmpword, tmpl, optflags, ppfx, NULL, 0, NULL, (FLAG) aflag, needflag);
                 } else {
-                    he = pmyMgr->suffix_check(tmpword, tmpl, 0, NULL, NULL, 0, NULL, (FLAG) aflag, needflag);
+                    he = pmyMgr->suffix_check(ctx, tmpword, tmpl, 0, NULL, NULL, 0, NULL, (FLAG) aflag, needflag);
                 }
                 if (he) return he;
             }
@@ -815,11 +854,11 @@ struct hentry * SfxEntry::get_next_homonym(struct hentry * he, int optflags, Pfx
     PfxEntry* ep = ppfx;
     FLAG eFlag = ep ? ep->getFlag() : FLAG_NULL;
 
-    while (he->next_homonym) {
-        he = he->next_homonym;
-        if ((TESTAFF(he->astr, aflag, he->alen) || (ep && ep->getCont() && TESTAFF(ep->getCont(), aflag, ep->getContLen()))) &&
+    while (HENTRY_HOMONYM(he)) {
+        he = HENTRY_HOMONYM(he);
+        if ((TESTAFF(HENTRY_ASTR(he), aflag, he->alen) || (ep && ep->getCont() && TESTAFF(ep->getCont(), aflag, ep->getContLen()))) &&
                             ((optflags & aeXPRODUCT) == 0 ||
-                            TESTAFF(he->astr, eFlag, he->alen) ||
+                            TESTAFF(HENTRY_ASTR(he), eFlag, he->alen) ||
                              // handle conditional suffix
                             ((contclass) && TESTAFF(contclass, eFlag, contclasslen))
                             ) &&
@@ -829,7 +868,7 @@ struct hentry * SfxEntry::get_next_homonym(struct hentry * he, int optflags, Pfx
                             ) &&
                             // handle required flag
                             ((!needflag) ||
-                              (TESTAFF(he->astr, needflag, he->alen) ||
+                              (TESTAFF(HENTRY_ASTR(he), needflag, he->alen) ||
                               ((contclass) && TESTAFF(contclass, needflag, contclasslen)))
                             )
                         ) return he;
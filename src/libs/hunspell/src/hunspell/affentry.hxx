@@ -24,15 +24,15 @@ public:
   ~PfxEntry();
 
   inline bool          allowCross() { return ((opts & aeXPRODUCT) != 0); }
-  struct hentry *      checkword(const char * word, int len, char in_compound, 
+  struct hentry *      checkword(affix_ctx & ctx, const char * word, int len, char in_compound, 
                             const FLAG needflag = FLAG_NULL);
 
-  struct hentry *      check_twosfx(const char * word, int len, char in_compound, const FLAG needflag = NULL);
+  struct hentry *      check_twosfx(affix_ctx & ctx, const char * word, int len, char in_compound, const FLAG needflag = NULL);
 
   char *      check_morph(const char * word, int len, char in_compound,
                             const FLAG needflag = FLAG_NULL);
 
-  char *      check_twosfx_morph(const char * word, int len,
+  char *      check_twosfx_morph(affix_ctx & ctx, const char * word, int len,
                   char in_compound, const FLAG needflag = FLAG_NULL);
 
   inline FLAG getFlag()   { return aflag;   }
@@ -58,6 +58,7 @@ public:
   
   inline char * nextchar(char * p);
   inline int    test_condition(const char * st);
+  int           condition_bytes(unsigned char * set);
 };
 
 
@@ -90,7 +91,7 @@ public:
 //                    const FLAG cclass = FLAG_NULL, const FLAG needflag = FLAG_NULL, char in_compound=IN_CPD_NOT);
                     const FLAG cclass = FLAG_NULL, const FLAG needflag = FLAG_NULL, const FLAG badflag = 0);
 
-  struct hentry *   check_twosfx(const char * word, int len, int optflags, PfxEntry* ppfx, const FLAG needflag = NULL);
+  struct hentry *   check_twosfx(affix_ctx & ctx, const char * word, int len, int optflags, PfxEntry* ppfx, const FLAG needflag = NULL);
 
   char *      check_twosfx_morph(const char * word, int len, int optflags,
                  PfxEntry* ppfx, const FLAG needflag = FLAG_NULL);
@@ -128,6 +129,7 @@ public:
 
   inline char * nextchar(char * p);
   inline int    test_condition(const char * st, const char * begin);
+  int           condition_bytes(unsigned char * set);
 
 };
 
@@ -14,6 +14,13 @@
 
 #include "csutil.hxx"
 
+// check the deadline; once passed, it stays expired for the call
+int affix_ctx::expired()
+{
+  if (!timedout && deadline && monotonic_usec() >= deadline) timedout = 1;
+  return timedout;
+}
+
 AffixMgr::AffixMgr(const char * affpath, HashMgr** ptr, int * md, const char * key) 
 {
   // register hash manager and load affix data from aff file
@@ -60,13 +67,12 @@ AffixMgr::AffixMgr(const char * affpath, HashMgr** ptr, int * md, const char * k
   langnum = 0; // language code (see http://l10n.openoffice.org/languages.html)
   needaffix = FLAG_NULL; // forbidden root, allowed only with suffixes
   cpdwordmax = -1; // default: unlimited wordcount in compound words
+  cpdmaxcheck = MAXCPDCHECK;
   cpdmin = -1;  // undefined
   cpdmaxsyllable = 0; // default: unlimited syllablecount in compound words
   cpdvowels=NULL; // vowels (for calculating of Hungarian compounding limit, O(n) search! XXX)
   cpdvowels_utf16=NULL; // vowels for UTF-8 encoding (bsearch instead of O(n) search)
   cpdvowels_utf16_len=0; // vowels
-  pfxappnd=NULL; // previous prefix for counting the syllables of prefix BUG
-  sfxappnd=NULL; // previous suffix for counting a special syllables BUG
   cpdsyllablenum=NULL; // syllable count incrementing flag
   checknum=0; // checking numbers, and word with numbers
   wordchars=NULL; // letters + spec. word characters
@@ -96,8 +102,6 @@ AffixMgr::AffixMgr(const char * affpath, HashMgr** ptr, int * md, const char * k
   substandard = FLAG_NULL;
   fullstrip = 0;
 
-  sfx = NULL;
-  pfx = NULL;
 
   for (int i=0; i < SETSIZE; i++) {
      pStart[i] = NULL;
@@ -105,6 +109,8 @@ AffixMgr::AffixMgr(const char * affpath, HashMgr** ptr, int * md, const char * k
      pFlag[i] = NULL;
      sFlag[i] = NULL;
   }
+  pfxauto = NULL;
+  sfxauto = NULL;
 
   for (int j=0; j < CONTSIZE; j++) {
     contclasses[j] = 0;
@@ -147,6 +153,8 @@ AffixMgr::~AffixMgr()
        }
        sStart[j] = NULL;
   }
+  free_automaton(pfxauto);
+  free_automaton(sfxauto);
 
   if (keystring) free(keystring);
   keystring=NULL;
@@ -380,6 +388,14 @@ int  AffixMgr::parse_file(const char * affpath, const char * key)
           }
        }
 
+       /* parse in the data used by compound_check() method */
+       if (strncmp(line,"COMPOUNDCHECKMAX",16) == 0) {
+          if (parse_num(line, &cpdmaxcheck, afflst)) {
+             delete afflst;
+             return 1;
+          }
+       }
+
        /* parse in the flag sign compounds in dictionary */
        if (strncmp(line,"COMPOUNDROOT",12) == 0) {
           if (parse_flag(line, &compoundroot, afflst)) {
@@ -736,6 +752,10 @@ int  AffixMgr::parse_file(const char * affpath, const char * key)
     process_pfx_order();
     process_sfx_order();
 
+    // and compile the lists to automatons to find the matching affixes
+    // of a word in one pass
+    build_automatons();
+
     /* get encoding for CHECKCOMPOUNDCASE */
     if (!utf8) {
     char * enc = get_encoding();
@@ -1041,6 +1061,223 @@ int AffixMgr::process_sfx_order()
     return 0;
 }
 
+// compile the sorted affix lists to automatons, see affstate
+int AffixMgr::build_automatons()
+{
+    int n = 0, m = 0;
+    for (int i = 1; i < SETSIZE; i++) {
+        for (PfxEntry * ptr = pStart[i]; ptr; ptr = ptr->getNext()) n++;
+        for (SfxEntry * ptr = sStart[i]; ptr; ptr = ptr->getNext()) m++;
+    }
+    if (m > n) n = m;
+    const char ** keys = (const char **) malloc(n * sizeof(char *) + 1);
+    void ** affixes = (void **) malloc(n * sizeof(void *) + 1);
+    unsigned char * condbytes = (unsigned char *) malloc(n * CONDBYTES_SIZE + 1);
+    char * restricted = (char *) malloc(n + 1);
+    if (!keys || !affixes || !condbytes || !restricted) {
+        free(keys);
+        free(affixes);
+        free(condbytes);
+        free(restricted);
+        return 1;
+    }
+    n = 0;
+    for (int i = 1; i < SETSIZE; i++) {
+        for (PfxEntry * ptr = pStart[i]; ptr; ptr = ptr->getNext(), n++) {
+            keys[n] = ptr->getKey();
+            affixes[n] = ptr;
+            restricted[n] = (char) ptr->condition_bytes(condbytes + n * CONDBYTES_SIZE);
+        }
+    }
+    pfxauto = build_automaton(n, keys, affixes, condbytes, restricted);
+    m = 0;
+    for (int i = 1; i < SETSIZE; i++) {
+        for (SfxEntry * ptr = sStart[i]; ptr; ptr = ptr->getNext(), m++) {
+            keys[m] = ptr->getKey();
+            affixes[m] = ptr;
+            restricted[m] = (char) ptr->condition_bytes(condbytes + m * CONDBYTES_SIZE);
+        }
+    }
+    sfxauto = build_automaton(m, keys, affixes, condbytes, restricted);
+    free(keys);
+    free(affixes);
+    free(condbytes);
+    free(restricted);
+    return 0;
+}
+
+// index of a byte set in a->condbytes, added if it is new
+static int add_condbytes(affautomaton * a, int * nsets, const unsigned char * set)
+{
+    int i;
+    for (i = 1; i < *nsets; i++) {
+        if (memcmp(a->condbytes + i * CONDBYTES_SIZE, set, CONDBYTES_SIZE) == 0) return i;
+    }
+    memcpy(a->condbytes + i * CONDBYTES_SIZE, set, CONDBYTES_SIZE);
+    (*nsets)++;
+    return i;
+}
+
+// NULL if the affix strings contain the '.' wildcard (matched by
+// isSubset()), then the affix lists are walked instead
+affautomaton * AffixMgr::build_automaton(int n, const char ** keys, void ** affixes,
+    unsigned char * condbytes, char * restricted)
+{
+    int nchars = 0;
+    for (int i = 0; i < n; i++) {
+        if (strchr(keys[i], '.')) return NULL;
+        nchars += strlen(keys[i]);
+    }
+    affautomaton * a = (affautomaton *) malloc(sizeof(affautomaton));
+    if (!a) return NULL;
+    a->states = (affstate *) calloc(nchars + 1, sizeof(affstate));
+    a->affixes = (void **) malloc(n * sizeof(void *) + 1);
+    a->conds = (int *) malloc(n * sizeof(int) + 1);
+    // at worst a set for every affix and state
+    a->condbytes = (unsigned char *) malloc((n + nchars + 1) * CONDBYTES_SIZE);
+    if (!a->states || !a->affixes || !a->conds || !a->condbytes) {
+        free_automaton(a);
+        return NULL;
+    }
+    memset(a->start, 0, sizeof(a->start));
+    int nstates = 1; // state 0 is the empty string
+    int nsets = 1;
+    unsigned char set[CONDBYTES_SIZE];
+    for (int i = 0; i < n; i++) {
+        const unsigned char * key = (const unsigned char *) keys[i];
+        int * link = a->start + *key;
+        int state = 0;
+        for (; *key; key++) {
+            // the lists are sorted, so a new child is the greatest one
+            while (*link && a->states[*link].c != *key) link = &(a->states[*link].next);
+            if (!*link) {
+                a->states[nstates].c = *key;
+                *link = nstates++;
+            }
+            state = *link;
+            link = &(a->states[state].child);
+        }
+        affstate * st = a->states + state;
+        if (!st->count) st->first = i;
+        else if (st->first + st->count != i) {
+            // equal strings are not adjacent, the lists are not sorted
+            free_automaton(a);
+            return NULL;
+        }
+        st->count++;
+        a->affixes[i] = affixes[i];
+        a->conds[i] = restricted[i] ? add_condbytes(a, &nsets, condbytes + i * CONDBYTES_SIZE) : 0;
+    }
+    // a state is restricted, if all of its affixes are
+    for (int s = 1; s < nstates; s++) {
+        affstate * st = a->states + s;
+        if (!st->count) continue;
+        memset(set, 0, CONDBYTES_SIZE);
+        int k;
+        for (k = st->first; k < st->first + st->count && a->conds[k]; k++) {
+            for (int j = 0; j < CONDBYTES_SIZE; j++) set[j] |= a->condbytes[a->conds[k] * CONDBYTES_SIZE + j];
+        }
+        if (k == st->first + st->count) st->cond = add_condbytes(a, &nsets, set);
+    }
+    return a;
+}
+
+void AffixMgr::free_automaton(affautomaton * a)
+{
+    if (!a) return;
+    free(a->states);
+    free(a->affixes);
+    free(a->conds);
+    free(a->condbytes);
+    free(a);
+}
+
+#define CONDBYTES_TEST(a, set, c) ((a)->condbytes[(set) * CONDBYTES_SIZE + ((c) >> 3)] & (1 << ((c) & 7)))
+
+// step the enumeration to the next character of the word, 0 if no
+// affix string continues with it
+int AffixMgr::next_state(affautomaton * a, affix_iter & it, unsigned char c)
+{
+    int state = it.depth ? a->states[it.state].child : a->start[c];
+    while (state && a->states[state].c < c) state = a->states[state].next;
+    if (!state || a->states[state].c != c) return 0;
+    it.state = state;
+    it.depth++;
+    it.pos = a->states[state].first;
+    it.end = it.pos + a->states[state].count;
+    return 1;
+}
+
+// enumerate the prefixes whose string begins the word, in list order:
+// for (pptr = first_pfx(it, word, len); pptr; pptr = next_pfx(it, word, len))
+// Prefixes whose condition excludes the first byte of the root are
+// skipped, they can not match.
+inline PfxEntry * AffixMgr::first_pfx(affix_iter & it, const char * word, int len)
+{
+    it.state = it.depth = it.pos = it.end = 0;
+    it.ptr = pStart[*((const unsigned char *)word)];
+    return next_pfx(it, word, len);
+}
+
+inline PfxEntry * AffixMgr::next_pfx(affix_iter & it, const char * word, int len)
+{
+    if (!pfxauto) {
+        PfxEntry * pptr = (PfxEntry *) it.ptr;
+        while (pptr && !isSubset(pptr->getKey(), word)) pptr = pptr->getNextNE();
+        if (pptr) it.ptr = pptr->getNextEQ();
+        return pptr;
+    }
+    for (;;) {
+        while (it.pos == it.end) {
+            unsigned char c = *((const unsigned char *)(word + it.depth));
+            if (!c || !next_state(pfxauto, it, c)) return NULL;
+            int cond = pfxauto->states[it.state].cond;
+            if (cond && (it.depth >= len ||
+                  !CONDBYTES_TEST(pfxauto, cond, *((const unsigned char *)(word + it.depth)))))
+                it.pos = it.end;
+        }
+        int cond = pfxauto->conds[it.pos];
+        if (!cond || (it.depth < len &&
+              CONDBYTES_TEST(pfxauto, cond, *((const unsigned char *)(word + it.depth)))))
+            return (PfxEntry *) pfxauto->affixes[it.pos++];
+        it.pos++;
+    }
+}
+
+// enumerate the suffixes whose (reversed) string ends the word of len > 0,
+// skipping the ones whose condition excludes the last byte of the root
+inline SfxEntry * AffixMgr::first_sfx(affix_iter & it, const char * word, int len)
+{
+    it.state = it.depth = it.pos = it.end = 0;
+    it.ptr = sStart[*((const unsigned char *)(word + len - 1))];
+    return next_sfx(it, word, len);
+}
+
+inline SfxEntry * AffixMgr::next_sfx(affix_iter & it, const char * word, int len)
+{
+    if (!sfxauto) {
+        SfxEntry * sptr = (SfxEntry *) it.ptr;
+        while (sptr && !isRevSubset(sptr->getKey(), word + len - 1, len)) sptr = sptr->getNextNE();
+        if (sptr) it.ptr = sptr->getNextEQ();
+        return sptr;
+    }
+    for (;;) {
+        while (it.pos == it.end) {
+            if (it.depth == len) return NULL;
+            if (!next_state(sfxauto, it, *((const unsigned char *)(word + len - 1 - it.depth)))) return NULL;
+            int cond = sfxauto->states[it.state].cond;
+            if (cond && (it.depth == len ||
+                  !CONDBYTES_TEST(sfxauto, cond, *((const unsigned char *)(word + len - 1 - it.depth)))))
+                it.pos = it.end;
+        }
+        int cond = sfxauto->conds[it.pos];
+        if (!cond || (it.depth < len &&
+              CONDBYTES_TEST(sfxauto, cond, *((const unsigned char *)(word + len - 1 - it.depth)))))
+            return (SfxEntry *) sfxauto->affixes[it.pos++];
+        it.pos++;
+    }
+}
+
 // add flags to the result for dictionary debugging
 void AffixMgr::debugflag(char * result, unsigned short flag) {
     char * st = encode_flag(flag);
@@ -1098,14 +1335,13 @@ inline int AffixMgr::isSubset(const char * s1, const char * s2)
 
 
 // check word for prefixes
-struct hentry * AffixMgr::prefix_check(const char * word, int len, char in_compound,
+struct hentry * AffixMgr::prefix_check(affix_ctx & ctx, const char * word, int len, char in_compound,
     const FLAG needflag)
 {
     struct hentry * rv= NULL;
 
-    pfx = NULL;
-    pfxappnd = NULL;
-    sfxappnd = NULL;
+    ctx.pfx = NULL;
+    ctx.sfxappnd = NULL;
     
     // first handle the special case of 0 length prefixes
     PfxEntry * pe = pStart[0];
@@ -1119,9 +1355,9 @@ struct hentry * AffixMgr::prefix_check(const char * word, int len, char in_compo
                   (TESTAFF(pe->getCont(), compoundpermitflag, pe->getContLen()))))
               ) {
                     // check prefix
-                    rv = pe->checkword(word, len, in_compound, needflag);
+                    rv = pe->checkword(ctx, word, len, in_compound, needflag);
                     if (rv) {
-                        pfx=pe; // BUG: pfx not stateless
+                        ctx.pfx=pe;
                         return rv;
                     }
              }
@@ -1129,67 +1365,55 @@ struct hentry * AffixMgr::prefix_check(const char * word, int len, char in_compo
     }
   
     // now handle the general case
-    unsigned char sp = *((const unsigned char *)word);
-    PfxEntry * pptr = pStart[sp];
-
-    while (pptr) {
-        if (isSubset(pptr->getKey(),word)) {
-             if (
-            // fogemorpheme
-              ((in_compound != IN_CPD_NOT) || !(pptr->getCont() &&
-                  (TESTAFF(pptr->getCont(), onlyincompound, pptr->getContLen())))) &&
-            // permit prefixes in compounds
-              ((in_compound != IN_CPD_END) || (pptr->getCont() &&
-                  (TESTAFF(pptr->getCont(), compoundpermitflag, pptr->getContLen()))))
-              ) {
-            // check prefix
-                  rv = pptr->checkword(word, len, in_compound, needflag);
-                  if (rv) {
-                    pfx=pptr; // BUG: pfx not stateless
-                    return rv;
-                  }
-             }
-             pptr = pptr->getNextEQ();
-        } else {
-             pptr = pptr->getNextNE();
-        }
+    affix_iter it;
+    PfxEntry * pptr;
+    for (pptr = first_pfx(it, word, len); pptr; pptr = next_pfx(it, word, len)) {
+         if (
+        // fogemorpheme
+          ((in_compound != IN_CPD_NOT) || !(pptr->getCont() &&
+              (TESTAFF(pptr->getCont(), onlyincompound, pptr->getContLen())))) &&
+        // permit prefixes in compounds
+          ((in_compound != IN_CPD_END) || (pptr->getCont() &&
+              (TESTAFF(pptr->getCont(), compoundpermitflag, pptr->getContLen()))))
+          ) {
+        // check prefix
+              rv = pptr->checkword(ctx, word, len, in_compound, needflag);
+              if (rv) {
+                ctx.pfx=pptr;
+                return rv;
+              }
+         }
     }
     
     return NULL;
 }
 
 // check word for prefixes
-struct hentry * AffixMgr::prefix_check_twosfx(const char * word, int len,
+struct hentry * AffixMgr::prefix_check_twosfx(affix_ctx & ctx, const char * word, int len,
     char in_compound, const FLAG needflag)
 {
     struct hentry * rv= NULL;
 
-    pfx = NULL;
-    sfxappnd = NULL;
+    ctx.pfx = NULL;
+    ctx.sfxappnd = NULL;
     
     // first handle the special case of 0 length prefixes
     PfxEntry * pe = pStart[0];
     
     while (pe) {
-        rv = pe->check_twosfx(word, len, in_compound, needflag);
+        rv = pe->check_twosfx(ctx, word, len, in_compound, needflag);
         if (rv) return rv;
         pe = pe->getNext();
     }
   
     // now handle the general case
-    unsigned char sp = *((const unsigned char *)word);
-    PfxEntry * pptr = pStart[sp];
-
-    while (pptr) {
-        if (isSubset(pptr->getKey(),word)) {
-            rv = pptr->check_twosfx(word, len, in_compound, needflag);
-            if (rv) {
-                pfx = pptr;
-                return rv;
-            }
-            pptr = pptr->getNextEQ();
-        } else {
-             pptr = pptr->getNextNE();
+    affix_iter it;
+    PfxEntry * pptr;
+    for (pptr = first_pfx(it, word, len); pptr; pptr = next_pfx(it, word, len)) {
+        rv = pptr->check_twosfx(ctx, word, len, in_compound, needflag);
+        if (rv) {
+            ctx.pfx = pptr;
+            return rv;
         }
     }
     
@@ -1197,7 +1421,7 @@ struct hentry * AffixMgr::prefix_check_twosfx(const char * word, int len,
 }
 
 // check word for prefixes
-char * AffixMgr::prefix_check_morph(const char * word, int len, char in_compound,
+char * AffixMgr::prefix_check_morph(affix_ctx & ctx, const char * word, int len, char in_compound,
     const FLAG needflag)
 {
     char * st;
@@ -1205,8 +1429,8 @@ char * AffixMgr::prefix_check_morph(const char * word, int len, char in_compound
     char result[MAXLNLEN];
     result[0] = '\0';
 
-    pfx = NULL;
-    sfxappnd = NULL;
+    ctx.pfx = NULL;
+    ctx.sfxappnd = NULL;
     
     // first handle the special case of 0 length prefixes
     PfxEntry * pe = pStart[0];
@@ -1221,24 +1445,18 @@ char * AffixMgr::prefix_check_morph(const char * word, int len, char in_compound
     }
   
     // now handle the general case
-    unsigned char sp = *((const unsigned char *)word);
-    PfxEntry * pptr = pStart[sp];
-
-    while (pptr) {
-        if (isSubset(pptr->getKey(),word)) {
-            st = pptr->check_morph(word,len,in_compound, needflag);
-            if (st) {
-              // fogemorpheme
-              if ((in_compound != IN_CPD_NOT) || !((pptr->getCont() && 
-                        (TESTAFF(pptr->getCont(), onlyincompound, pptr->getContLen()))))) {
-                    mystrcat(result, st, MAXLNLEN);
-                    pfx = pptr;
-                }
-                free(st);
+    affix_iter it;
+    PfxEntry * pptr;
+    for (pptr = first_pfx(it, word, len); pptr; pptr = next_pfx(it, word, len)) {
+        st = pptr->check_morph(word,len,in_compound, needflag);
+        if (st) {
+          // fogemorpheme
+          if ((in_compound != IN_CPD_NOT) || !((pptr->getCont() && 
+                    (TESTAFF(pptr->getCont(), onlyincompound, pptr->getContLen()))))) {
+                mystrcat(result, st, MAXLNLEN);
+                ctx.pfx = pptr;
             }
-            pptr = pptr->getNextEQ();
-        } else {
-            pptr = pptr->getNextNE();
+            free(st);
         }
     }
     
@@ -1248,7 +1466,7 @@ char * AffixMgr::prefix_check_morph(const char * word, int len, char in_compound
 
 
 // check word for prefixes
-char * AffixMgr::prefix_check_twosfx_morph(const char * word, int len,
+char * AffixMgr::prefix_check_twosfx_morph(affix_ctx & ctx, const char * word, int len,
     char in_compound, const FLAG needflag)
 {
     char * st;
@@ -1256,13 +1474,13 @@ char * AffixMgr::prefix_check_twosfx_morph(const char * word, int len,
     char result[MAXLNLEN];
     result[0] = '\0';
 
-    pfx = NULL;
-    sfxappnd = NULL;
+    ctx.pfx = NULL;
+    ctx.sfxappnd = NULL;
     
     // first handle the special case of 0 length prefixes
     PfxEntry * pe = pStart[0];
     while (pe) {
-        st = pe->check_twosfx_morph(word,len,in_compound, needflag);
+        st = pe->check_twosfx_morph(ctx, word,len,in_compound, needflag);
         if (st) {
             mystrcat(result, st, MAXLNLEN);
             free(st);
@@ -1271,20 +1489,14 @@ char * AffixMgr::prefix_check_twosfx_morph(const char * word, int len,
     }
   
     // now handle the general case
-    unsigned char sp = *((const unsigned char *)word);
-    PfxEntry * pptr = pStart[sp];
-
-    while (pptr) {
-        if (isSubset(pptr->getKey(),word)) {
-            st = pptr->check_twosfx_morph(word, len, in_compound, needflag);
-            if (st) {
-                mystrcat(result, st, MAXLNLEN);
-                free(st);
-                pfx = pptr;
-            }
-            pptr = pptr->getNextEQ();
-        } else {
-            pptr = pptr->getNextNE();
+    affix_iter it;
+    PfxEntry * pptr;
+    for (pptr = first_pfx(it, word, len); pptr; pptr = next_pfx(it, word, len)) {
+        st = pptr->check_twosfx_morph(ctx, word, len, in_compound, needflag);
+        if (st) {
+            mystrcat(result, st, MAXLNLEN);
+            free(st);
+            ctx.pfx = pptr;
         }
     }
     
@@ -1293,7 +1505,7 @@ char * AffixMgr::prefix_check_twosfx_morph(const char * word, int len,
 }
 
 // Is word a non compound with a REP substitution (see checkcompoundrep)?
-int AffixMgr::cpdrep_check(const char * word, int wl)
+int AffixMgr::cpdrep_check(affix_ctx & ctx, const char * word, int wl)
 {
   char candidate[MAXLNLEN];
   const char * r;
@@ -1311,7 +1523,7 @@ int AffixMgr::cpdrep_check(const char * word, int wl)
           if (r-word + lenr + strlen(r+lenp) >= MAXLNLEN) break;
           strcpy(candidate+(r-word),reptable[i].pattern2);
           strcpy(candidate+(r-word)+lenr, r+lenp);
-          if (candidate_check(candidate,strlen(candidate))) return 1;
+          if (candidate_check(ctx, candidate,strlen(candidate))) return 1;
           r++; // search for the next letter
       }
    }
@@ -1325,9 +1537,9 @@ int AffixMgr::cpdpat_check(const char * word, int pos, hentry * r1, hentry * r2,
   for (int i = 0; i < numcheckcpd; i++) {
       if (isSubset(checkcpdtable[i].pattern2, word + pos) &&
         (!r1 || !checkcpdtable[i].cond ||
-          (r1->astr && TESTAFF(r1->astr, checkcpdtable[i].cond, r1->alen))) &&
+          (HENTRY_ASTR(r1) && TESTAFF(HENTRY_ASTR(r1), checkcpdtable[i].cond, r1->alen))) &&
         (!r2 || !checkcpdtable[i].cond2 ||
-          (r2->astr && TESTAFF(r2->astr, checkcpdtable[i].cond2, r2->alen))) &&
+          (HENTRY_ASTR(r2) && TESTAFF(HENTRY_ASTR(r2), checkcpdtable[i].cond2, r2->alen))) &&
         // zero length pattern => only TESTAFF
         // zero pattern (0/flag) => unmodified stem (zero affixes allowed)
         (!*(checkcpdtable[i].pattern) || (
@@ -1393,7 +1605,7 @@ int AffixMgr::defcpd_check(hentry *** words, short wnum, hentry * rv, hentry **
   for (i = 0; i < numdefcpd; i++) {
     for (j = 0; j < defcpdtable[i].len; j++) {
        if (defcpdtable[i].def[j] != '*' && defcpdtable[i].def[j] != '?' &&
-          TESTAFF(rv->astr, defcpdtable[i].def[j], rv->alen)) ok = 1;
+          TESTAFF(HENTRY_ASTR(rv), defcpdtable[i].def[j], rv->alen)) ok = 1;
     }
   }
   if (ok == 0) {
@@ -1419,7 +1631,7 @@ int AffixMgr::defcpd_check(hentry *** words, short wnum, hentry * rv, hentry **
             btwp[bt] = wp;
             while (wp <= wend) {
                 if (!(*words)[wp]->alen || 
-                  !TESTAFF((*words)[wp]->astr, defcpdtable[i].def[pp-2], (*words)[wp]->alen)) {
+                  !TESTAFF(HENTRY_ASTR((*words)[wp]), defcpdtable[i].def[pp-2], (*words)[wp]->alen)) {
                     ok2 = 0;
                     break;
                 }
@@ -1432,7 +1644,7 @@ int AffixMgr::defcpd_check(hentry *** words, short wnum, hentry * rv, hentry **
         } else {
             ok2 = 1;
             if (!(*words)[wp] || !(*words)[wp]->alen || 
-              !TESTAFF((*words)[wp]->astr, defcpdtable[i].def[pp], (*words)[wp]->alen)) {
+              !TESTAFF(HENTRY_ASTR((*words)[wp]), defcpdtable[i].def[pp], (*words)[wp]->alen)) {
                 ok = 0;
                 break;
             }
@@ -1468,7 +1680,7 @@ int AffixMgr::defcpd_check(hentry *** words, short wnum, hentry * rv, hentry **
   return 0;
 }
 
-inline int AffixMgr::candidate_check(const char * word, int len)
+inline int AffixMgr::candidate_check(affix_ctx & ctx, const char * word, int len)
 {
   struct hentry * rv=NULL;
   
@@ -1478,7 +1690,7 @@ inline int AffixMgr::candidate_check(const char * word, int len)
 //  rv = prefix_check(word,len,1);
 //  if (rv) return 1;
   
-  rv = affix_check(word,len);
+  rv = affix_check(ctx, word,len);
   if (rv) return 1;
   return 0;
 }
@@ -1523,9 +1735,62 @@ void AffixMgr::setcminmax(int * cmin, int * cmax, const char * word, int len) {
 
 // check if compound word is correctly spelled
 // hu_mov_rule = spec. Hungarian rule (XXX)
-struct hentry * AffixMgr::compound_check(const char * word, int len, 
+struct hentry * AffixMgr::compound_check(affix_ctx & ctx, const char * word, int len, 
     short wordnum, short numsyllable, short maxwordnum, short wnum, hentry ** words = NULL,
     char hu_mov_rule = 0, char is_sug = 0, int * info = NULL)
+{
+    // failed ends and the budget are kept only for this word
+    if (ctx.cpdnmemo) memset(ctx.cpdmemo, 0, sizeof(ctx.cpdmemo));
+    ctx.cpdnmemo = 0;
+    ctx.cpdword = word;
+    ctx.cpdlen = len;
+    ctx.cpdbudget = cpdmaxcheck;
+    return compound_check_part(ctx, word, len, wordnum, numsyllable, maxwordnum, wnum,
+        words, hu_mov_rule, is_sug, info);
+}
+
+// compound_check_part() of an end of the word in the recursion, NULL
+// without checking, if it has already failed with the same word count
+// and syllable number, or if the word ran out of its COMPOUNDCHECKMAX
+// budget. The same end is reached by every split of the beginning into
+// the same number of words, so this keeps checking polynomial.
+struct hentry * AffixMgr::compound_check_end(affix_ctx & ctx, const char * word, int len,
+    short wordnum, short numsyllable, short maxwordnum, short wnum, hentry ** words,
+    char is_sug, int * info)
+{
+    unsigned long long key = 0;
+    int slot = 0;
+    // the result depends on the defcpd state of words, and on the
+    // CHECKCOMPOUNDPATTERN replacements, which change the end
+    if (!words && len <= ctx.cpdlen &&
+        memcmp(word, ctx.cpdword + ctx.cpdlen - len, len) == 0) {
+        key = ((unsigned long long) (ctx.cpdlen - len + 1) << 48) |
+              ((unsigned long long) (unsigned short) wordnum << 32) |
+              ((unsigned long long) (unsigned short) numsyllable << 16) |
+              (unsigned short) wnum;
+        for (slot = (int) ((key * 0x9E3779B97F4A7C15ULL) >> 56) & (CPDMEMO_SIZE - 1);
+            ctx.cpdmemo[slot]; slot = (slot + 1) & (CPDMEMO_SIZE - 1)) {
+            if (ctx.cpdmemo[slot] == key) return NULL;
+        }
+    }
+    if (ctx.cpdbudget <= 0) return NULL;
+    ctx.cpdbudget--;
+    struct hentry * rv = compound_check_part(ctx, word, len, wordnum, numsyllable,
+        maxwordnum, wnum, words, 0, is_sug, info);
+    // keep a quarter of the table free for the probes
+    if (!rv && key && ctx.cpdnmemo < CPDMEMO_SIZE - CPDMEMO_SIZE / 4) {
+        // the recursion may have filled the slot
+        for (; ctx.cpdmemo[slot]; slot = (slot + 1) & (CPDMEMO_SIZE - 1));
+        ctx.cpdmemo[slot] = key;
+        ctx.cpdnmemo++;
+    }
+    return rv;
+}
+
+// check a word, or an end of it in the recursion, for compounding
+struct hentry * AffixMgr::compound_check_part(affix_ctx & ctx, const char * word, int len,
+    short wordnum, short numsyllable, short maxwordnum, short wnum, hentry ** words,
+    char hu_mov_rule, char is_sug, int * info)
 {
     int i; 
     short oldnumsyllable, oldnumsyllable2, oldwordnum, oldwordnum2;
@@ -1595,8 +1860,8 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
         ch = st[i];
         st[i] = '\0';
 
-        sfx = NULL;
-        pfx = NULL;
+        ctx.sfx = NULL;
+        ctx.pfx = NULL;
 
         // FIRST WORD
 
@@ -1605,19 +1870,19 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
 
         // search homonym with compound flag
         while ((rv) && !hu_mov_rule &&
-            ((needaffix && TESTAFF(rv->astr, needaffix, rv->alen)) ||
-                !((compoundflag && !words && !onlycpdrule && TESTAFF(rv->astr, compoundflag, rv->alen)) ||
+            ((needaffix && TESTAFF(HENTRY_ASTR(rv), needaffix, rv->alen)) ||
+                !((compoundflag && !words && !onlycpdrule && TESTAFF(HENTRY_ASTR(rv), compoundflag, rv->alen)) ||
                   (compoundbegin && !wordnum && !onlycpdrule && 
-                        TESTAFF(rv->astr, compoundbegin, rv->alen)) ||
+                        TESTAFF(HENTRY_ASTR(rv), compoundbegin, rv->alen)) ||
                   (compoundmiddle && wordnum && !words && !onlycpdrule &&
-                    TESTAFF(rv->astr, compoundmiddle, rv->alen)) ||
+                    TESTAFF(HENTRY_ASTR(rv), compoundmiddle, rv->alen)) ||
                   (numdefcpd && onlycpdrule &&
                     ((!words && !wordnum && defcpd_check(&words, wnum, rv, (hentry **) &rwords, 0)) ||
                     (words && defcpd_check(&words, wnum, rv, (hentry **) &rwords, 0))))) ||
                   (scpd != 0 && checkcpdtable[scpd-1].cond != FLAG_NULL &&
-                    !TESTAFF(rv->astr, checkcpdtable[scpd-1].cond, rv->alen)))
+                    !TESTAFF(HENTRY_ASTR(rv), checkcpdtable[scpd-1].cond, rv->alen)))
                   ) {
-            rv = rv->next_homonym;
+            rv = HENTRY_HOMONYM(rv);
         }
 
         if (rv) affixed = 0;
@@ -1625,31 +1890,31 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
         if (!rv) {
             if (onlycpdrule) break;
             if (compoundflag && 
-             !(rv = prefix_check(st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundflag))) {
-                if ((rv = suffix_check(st, i, 0, NULL, NULL, 0, NULL,
+             !(rv = prefix_check(ctx, st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundflag))) {
+                if ((rv = suffix_check(ctx, st, i, 0, NULL, NULL, 0, NULL,
                         FLAG_NULL, compoundflag, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) && !hu_mov_rule &&
-                    sfx->getCont() &&
-                        ((compoundforbidflag && TESTAFF(sfx->getCont(), compoundforbidflag, 
-                            sfx->getContLen())) || (compoundend &&
-                        TESTAFF(sfx->getCont(), compoundend, 
-                            sfx->getContLen())))) {
+                    ctx.sfx->getCont() &&
+                        ((compoundforbidflag && TESTAFF(ctx.sfx->getCont(), compoundforbidflag, 
+                            ctx.sfx->getContLen())) || (compoundend &&
+                        TESTAFF(ctx.sfx->getCont(), compoundend, 
+                            ctx.sfx->getContLen())))) {
                         rv = NULL;
                 }
             }
 
             if (rv ||
               (((wordnum == 0) && compoundbegin &&
-                ((rv = suffix_check(st, i, 0, NULL, NULL, 0, NULL, FLAG_NULL, compoundbegin, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
-                (rv = prefix_check(st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundbegin)))) ||
+                ((rv = suffix_check(ctx, st, i, 0, NULL, NULL, 0, NULL, FLAG_NULL, compoundbegin, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
+                (rv = prefix_check(ctx, st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundbegin)))) ||
               ((wordnum > 0) && compoundmiddle &&
-                ((rv = suffix_check(st, i, 0, NULL, NULL, 0, NULL, FLAG_NULL, compoundmiddle, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
-                (rv = prefix_check(st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundmiddle)))))
+                ((rv = suffix_check(ctx, st, i, 0, NULL, NULL, 0, NULL, FLAG_NULL, compoundmiddle, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
+                (rv = prefix_check(ctx, st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundmiddle)))))
               ) checked_prefix = 1;
         // else check forbiddenwords and needaffix
-        } else if (rv->astr && (TESTAFF(rv->astr, forbiddenword, rv->alen) ||
-            TESTAFF(rv->astr, needaffix, rv->alen) ||
-            TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen) ||
-            (is_sug && nosuggest && TESTAFF(rv->astr, nosuggest, rv->alen))
+        } else if (HENTRY_ASTR(rv) && (TESTAFF(HENTRY_ASTR(rv), forbiddenword, rv->alen) ||
+            TESTAFF(HENTRY_ASTR(rv), needaffix, rv->alen) ||
+            TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen) ||
+            (is_sug && nosuggest && TESTAFF(HENTRY_ASTR(rv), nosuggest, rv->alen))
              )) {
                 st[i] = ch;
                 //continue;
@@ -1658,63 +1923,63 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
 
             // check non_compound flag in suffix and prefix
             if ((rv) && !hu_mov_rule &&
-                ((pfx && pfx->getCont() &&
-                    TESTAFF(pfx->getCont(), compoundforbidflag, 
-                        pfx->getContLen())) ||
-                (sfx && sfx->getCont() &&
-                    TESTAFF(sfx->getCont(), compoundforbidflag, 
-                        sfx->getContLen())))) {
+                ((ctx.pfx && ctx.pfx->getCont() &&
+                    TESTAFF(ctx.pfx->getCont(), compoundforbidflag, 
+                        ctx.pfx->getContLen())) ||
+                (ctx.sfx && ctx.sfx->getCont() &&
+                    TESTAFF(ctx.sfx->getCont(), compoundforbidflag, 
+                        ctx.sfx->getContLen())))) {
                     rv = NULL;
             }
 
             // check compoundend flag in suffix and prefix
             if ((rv) && !checked_prefix && compoundend && !hu_mov_rule &&
-                ((pfx && pfx->getCont() &&
-                    TESTAFF(pfx->getCont(), compoundend, 
-                        pfx->getContLen())) ||
-                (sfx && sfx->getCont() &&
-                    TESTAFF(sfx->getCont(), compoundend, 
-                        sfx->getContLen())))) {
+                ((ctx.pfx && ctx.pfx->getCont() &&
+                    TESTAFF(ctx.pfx->getCont(), compoundend, 
+                        ctx.pfx->getContLen())) ||
+                (ctx.sfx && ctx.sfx->getCont() &&
+                    TESTAFF(ctx.sfx->getCont(), compoundend, 
+                        ctx.sfx->getContLen())))) {
                     rv = NULL;
             }
 
             // check compoundmiddle flag in suffix and prefix
             if ((rv) && !checked_prefix && (wordnum==0) && compoundmiddle && !hu_mov_rule &&
-                ((pfx && pfx->getCont() &&
-                    TESTAFF(pfx->getCont(), compoundmiddle, 
-                        pfx->getContLen())) ||
-                (sfx && sfx->getCont() &&
-                    TESTAFF(sfx->getCont(), compoundmiddle, 
-                        sfx->getContLen())))) {
+                ((ctx.pfx && ctx.pfx->getCont() &&
+                    TESTAFF(ctx.pfx->getCont(), compoundmiddle, 
+                        ctx.pfx->getContLen())) ||
+                (ctx.sfx && ctx.sfx->getCont() &&
+                    TESTAFF(ctx.sfx->getCont(), compoundmiddle, 
+                        ctx.sfx->getContLen())))) {
                     rv = NULL;
             }
 
         // check forbiddenwords
-        if ((rv) && (rv->astr) && (TESTAFF(rv->astr, forbiddenword, rv->alen) ||
-            TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen) ||
-            (is_sug && nosuggest && TESTAFF(rv->astr, nosuggest, rv->alen)))) {
+        if ((rv) && (HENTRY_ASTR(rv)) && (TESTAFF(HENTRY_ASTR(rv), forbiddenword, rv->alen) ||
+            TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen) ||
+            (is_sug && nosuggest && TESTAFF(HENTRY_ASTR(rv), nosuggest, rv->alen)))) {
                 return NULL;
             }
 
         // increment word number, if the second root has a compoundroot flag
         if ((rv) && compoundroot && 
-            (TESTAFF(rv->astr, compoundroot, rv->alen))) {
+            (TESTAFF(HENTRY_ASTR(rv), compoundroot, rv->alen))) {
                 wordnum++;
         }
 
         // first word is acceptable in compound words?
         if (((rv) && 
           ( checked_prefix || (words && words[wnum]) ||
-            (compoundflag && TESTAFF(rv->astr, compoundflag, rv->alen)) ||
-            ((oldwordnum == 0) && compoundbegin && TESTAFF(rv->astr, compoundbegin, rv->alen)) ||
-            ((oldwordnum > 0) && compoundmiddle && TESTAFF(rv->astr, compoundmiddle, rv->alen))// ||
+            (compoundflag && TESTAFF(HENTRY_ASTR(rv), compoundflag, rv->alen)) ||
+            ((oldwordnum == 0) && compoundbegin && TESTAFF(HENTRY_ASTR(rv), compoundbegin, rv->alen)) ||
+            ((oldwordnum > 0) && compoundmiddle && TESTAFF(HENTRY_ASTR(rv), compoundmiddle, rv->alen))// ||
 //            (numdefcpd && )
 
 // LANG_hu section: spec. Hungarian rule
             || ((langnum == LANG_hu) && hu_mov_rule && (
-                    TESTAFF(rv->astr, 'F', rv->alen) || // XXX hardwired Hungarian dictionary codes
-                    TESTAFF(rv->astr, 'G', rv->alen) ||
-                    TESTAFF(rv->astr, 'H', rv->alen)
+                    TESTAFF(HENTRY_ASTR(rv), 'F', rv->alen) || // XXX hardwired Hungarian dictionary codes
+                    TESTAFF(HENTRY_ASTR(rv), 'G', rv->alen) ||
+                    TESTAFF(HENTRY_ASTR(rv), 'H', rv->alen)
                 )
               )
 // END of LANG_hu section
@@ -1722,7 +1987,7 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
           (
              // test CHECKCOMPOUNDPATTERN conditions
              scpd == 0 || checkcpdtable[scpd-1].cond == FLAG_NULL || 
-                TESTAFF(rv->astr, checkcpdtable[scpd-1].cond, rv->alen)
+                TESTAFF(HENTRY_ASTR(rv), checkcpdtable[scpd-1].cond, rv->alen)
           )
           && ! (( checkcompoundtriple && scpd == 0 && !words && // test triple letters
                    (word[i-1]==word[i]) && (
@@ -1735,10 +2000,10 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
                ))
          )
 // LANG_hu section: spec. Hungarian rule
-         || ((!rv) && (langnum == LANG_hu) && hu_mov_rule && (rv = affix_check(st,i)) &&
-              (sfx && sfx->getCont() && ( // XXX hardwired Hungarian dic. codes
-                        TESTAFF(sfx->getCont(), (unsigned short) 'x', sfx->getContLen()) ||
-                        TESTAFF(sfx->getCont(), (unsigned short) '%', sfx->getContLen())
+         || ((!rv) && (langnum == LANG_hu) && hu_mov_rule && (rv = affix_check(ctx, st,i)) &&
+              (ctx.sfx && ctx.sfx->getCont() && ( // XXX hardwired Hungarian dic. codes
+                        TESTAFF(ctx.sfx->getCont(), (unsigned short) 'x', ctx.sfx->getContLen()) ||
+                        TESTAFF(ctx.sfx->getCont(), (unsigned short) '%', ctx.sfx->getContLen())
                     )
                )
              )
@@ -1749,7 +2014,7 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
                 // calculate syllable number of the word
                 numsyllable += get_syllable(st, i);
                 // + 1 word, if syllable number of the prefix > 1 (hungarian convention)
-                if (pfx && (get_syllable(pfx->getKey(),strlen(pfx->getKey())) > 1)) wordnum++;
+                if (ctx.pfx && (get_syllable(ctx.pfx->getKey(),strlen(ctx.pfx->getKey())) > 1)) wordnum++;
             }
 // END of LANG_hu section
 
@@ -1770,19 +2035,19 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
             rv = lookup((st+i)); // perhaps without prefix
 
         // search homonym with compound flag
-        while ((rv) && ((needaffix && TESTAFF(rv->astr, needaffix, rv->alen)) ||
-                        !((compoundflag && !words && TESTAFF(rv->astr, compoundflag, rv->alen)) ||
-                          (compoundend && !words && TESTAFF(rv->astr, compoundend, rv->alen)) ||
+        while ((rv) && ((needaffix && TESTAFF(HENTRY_ASTR(rv), needaffix, rv->alen)) ||
+                        !((compoundflag && !words && TESTAFF(HENTRY_ASTR(rv), compoundflag, rv->alen)) ||
+                          (compoundend && !words && TESTAFF(HENTRY_ASTR(rv), compoundend, rv->alen)) ||
                            (numdefcpd && words && defcpd_check(&words, wnum + 1, rv, NULL,1))) ||
                              (scpd != 0 && checkcpdtable[scpd-1].cond2 != FLAG_NULL &&
-                                !TESTAFF(rv->astr, checkcpdtable[scpd-1].cond2, rv->alen))
+                                !TESTAFF(HENTRY_ASTR(rv), checkcpdtable[scpd-1].cond2, rv->alen))
                            )) {
-            rv = rv->next_homonym;
+            rv = HENTRY_HOMONYM(rv);
         }
 
             // check FORCEUCASE
             if (rv && forceucase && (rv) &&
-                (TESTAFF(rv->astr, forceucase, rv->alen)) && !(info && *info & SPELL_ORIGCAP)) rv = NULL;
+                (TESTAFF(HENTRY_ASTR(rv), forceucase, rv->alen)) && !(info && *info & SPELL_ORIGCAP)) rv = NULL;
 
             if (rv && words && words[wnum + 1]) return rv_first;
 
@@ -1791,21 +2056,21 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
 
 
 // LANG_hu section: spec. Hungarian rule, XXX hardwired dictionary code
-            if ((rv) && (langnum == LANG_hu) && (TESTAFF(rv->astr, 'I', rv->alen)) && !(TESTAFF(rv->astr, 'J', rv->alen))) {
+            if ((rv) && (langnum == LANG_hu) && (TESTAFF(HENTRY_ASTR(rv), 'I', rv->alen)) && !(TESTAFF(HENTRY_ASTR(rv), 'J', rv->alen))) {
                 numsyllable--;
             }
 // END of LANG_hu section
 
             // increment word number, if the second root has a compoundroot flag
             if ((rv) && (compoundroot) && 
-                (TESTAFF(rv->astr, compoundroot, rv->alen))) {
+                (TESTAFF(HENTRY_ASTR(rv), compoundroot, rv->alen))) {
                     wordnum++;
             }
 
             // check forbiddenwords
-            if ((rv) && (rv->astr) && (TESTAFF(rv->astr, forbiddenword, rv->alen) ||
-                TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen) ||
-               (is_sug && nosuggest && TESTAFF(rv->astr, nosuggest, rv->alen)))) return NULL;
+            if ((rv) && (HENTRY_ASTR(rv)) && (TESTAFF(HENTRY_ASTR(rv), forbiddenword, rv->alen) ||
+                TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen) ||
+               (is_sug && nosuggest && TESTAFF(HENTRY_ASTR(rv), nosuggest, rv->alen)))) return NULL;
 
             // second word is acceptable, as a root?
             // hungarian conventions: compounding is acceptable,
@@ -1813,8 +2078,8 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
             // then the syllable number of root words must be 6, or lesser.
 
             if ((rv) && (
-                      (compoundflag && TESTAFF(rv->astr, compoundflag, rv->alen)) ||
-                      (compoundend && TESTAFF(rv->astr, compoundend, rv->alen))
+                      (compoundflag && TESTAFF(HENTRY_ASTR(rv), compoundflag, rv->alen)) ||
+                      (compoundend && TESTAFF(HENTRY_ASTR(rv), compoundend, rv->alen))
                     )
                 && (
                       ((cpdwordmax==-1) || (wordnum+1<cpdwordmax)) || 
@@ -1830,11 +2095,11 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
                    )
             // test CHECKCOMPOUNDPATTERN conditions
                 && (scpd == 0 || checkcpdtable[scpd-1].cond2 == FLAG_NULL ||
-                      TESTAFF(rv->astr, checkcpdtable[scpd-1].cond2, rv->alen))
+                      TESTAFF(HENTRY_ASTR(rv), checkcpdtable[scpd-1].cond2, rv->alen))
                 )
                  {
                       // forbid compound word, if it is a non compound word with typical fault
-                      if (checkcompoundrep && cpdrep_check(word,len)) return NULL;
+                      if (checkcompoundrep && cpdrep_check(ctx, word,len)) return NULL;
                       return rv_first;
             }
 
@@ -1842,47 +2107,47 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
             wordnum = oldwordnum2;
 
             // perhaps second word has prefix or/and suffix
-            sfx = NULL;
-            sfxflag = FLAG_NULL;
-            rv = (compoundflag && !onlycpdrule) ? affix_check((word+i),strlen(word+i), compoundflag, IN_CPD_END) : NULL;
+            ctx.sfx = NULL;
+            ctx.sfxflag = FLAG_NULL;
+            rv = (compoundflag && !onlycpdrule) ? affix_check(ctx, (word+i),strlen(word+i), compoundflag, IN_CPD_END) : NULL;
             if (!rv && compoundend && !onlycpdrule) {
-                sfx = NULL;
-                pfx = NULL;
-                rv = affix_check((word+i),strlen(word+i), compoundend, IN_CPD_END);
+                ctx.sfx = NULL;
+                ctx.pfx = NULL;
+                rv = affix_check(ctx, (word+i),strlen(word+i), compoundend, IN_CPD_END);
             }
 
             if (!rv && numdefcpd && words) {
-                rv = affix_check((word+i),strlen(word+i), 0, IN_CPD_END);
+                rv = affix_check(ctx, (word+i),strlen(word+i), 0, IN_CPD_END);
                 if (rv && defcpd_check(&words, wnum + 1, rv, NULL, 1)) return rv_first;
                 rv = NULL;
             }
 
             // test CHECKCOMPOUNDPATTERN conditions (allowed forms)
             if (rv && !(scpd == 0 || checkcpdtable[scpd-1].cond2 == FLAG_NULL || 
-                TESTAFF(rv->astr, checkcpdtable[scpd-1].cond2, rv->alen))) rv = NULL;
+                TESTAFF(HENTRY_ASTR(rv), checkcpdtable[scpd-1].cond2, rv->alen))) rv = NULL;
 
             // test CHECKCOMPOUNDPATTERN conditions (forbidden compounds)
             if (rv && numcheckcpd && scpd == 0 && cpdpat_check(word, i, rv_first, rv, affixed)) rv = NULL;
 
             // check non_compound flag in suffix and prefix
             if ((rv) && 
-                ((pfx && pfx->getCont() &&
-                    TESTAFF(pfx->getCont(), compoundforbidflag, 
-                        pfx->getContLen())) ||
-                (sfx && sfx->getCont() &&
-                    TESTAFF(sfx->getCont(), compoundforbidflag, 
-                        sfx->getContLen())))) {
+                ((ctx.pfx && ctx.pfx->getCont() &&
+                    TESTAFF(ctx.pfx->getCont(), compoundforbidflag, 
+                        ctx.pfx->getContLen())) ||
+                (ctx.sfx && ctx.sfx->getCont() &&
+                    TESTAFF(ctx.sfx->getCont(), compoundforbidflag, 
+                        ctx.sfx->getContLen())))) {
                     rv = NULL;
             }
 
             // check FORCEUCASE
             if (rv && forceucase && (rv) &&
-                (TESTAFF(rv->astr, forceucase, rv->alen)) && !(info && *info & SPELL_ORIGCAP)) rv = NULL;
+                (TESTAFF(HENTRY_ASTR(rv), forceucase, rv->alen)) && !(info && *info & SPELL_ORIGCAP)) rv = NULL;
 
             // check forbiddenwords
-            if ((rv) && (rv->astr) && (TESTAFF(rv->astr, forbiddenword, rv->alen) ||
-                TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen) ||
-               (is_sug && nosuggest && TESTAFF(rv->astr, nosuggest, rv->alen)))) return NULL;
+            if ((rv) && (HENTRY_ASTR(rv)) && (TESTAFF(HENTRY_ASTR(rv), forbiddenword, rv->alen) ||
+                TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen) ||
+               (is_sug && nosuggest && TESTAFF(HENTRY_ASTR(rv), nosuggest, rv->alen)))) return NULL;
 
             // pfxappnd = prefix of word+i, or NULL
             // calculate syllable number of prefix.
@@ -1895,30 +2160,30 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
 
                 // - affix syllable num.
                 // XXX only second suffix (inflections, not derivations)
-                if (sfxappnd) {
-                    char * tmp = myrevstrdup(sfxappnd);
+                if (ctx.sfxappnd) {
+                    char * tmp = myrevstrdup(ctx.sfxappnd);
                     numsyllable -= get_syllable(tmp, strlen(tmp));
                     free(tmp);
                 }
 
                 // + 1 word, if syllable number of the prefix > 1 (hungarian convention)
-                if (pfx && (get_syllable(pfx->getKey(),strlen(pfx->getKey())) > 1)) wordnum++;
+                if (ctx.pfx && (get_syllable(ctx.pfx->getKey(),strlen(ctx.pfx->getKey())) > 1)) wordnum++;
 
                 // increment syllable num, if last word has a SYLLABLENUM flag
                 // and the suffix is beginning `s'
 
                 if (cpdsyllablenum) {
-                    switch (sfxflag) {
+                    switch (ctx.sfxflag) {
                         case 'c': { numsyllable+=2; break; }
                         case 'J': { numsyllable += 1; break; }
-                        case 'I': { if (rv && TESTAFF(rv->astr, 'J', rv->alen)) numsyllable += 1; break; }
+                        case 'I': { if (rv && TESTAFF(HENTRY_ASTR(rv), 'J', rv->alen)) numsyllable += 1; break; }
                     }
                 }
             }
 
             // increment word number, if the second word has a compoundroot flag
             if ((rv) && (compoundroot) && 
-                (TESTAFF(rv->astr, compoundroot, rv->alen))) {
+                (TESTAFF(HENTRY_ASTR(rv), compoundroot, rv->alen))) {
                     wordnum++;
             }
 
@@ -1936,7 +2201,7 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
                    (!checkcompounddup || (rv != rv_first))
                    )) {
                     // forbid compound word, if it is a non compound word with typical fault
-                    if (checkcompoundrep && cpdrep_check(word, len)) return NULL;
+                    if (checkcompoundrep && cpdrep_check(ctx, word, len)) return NULL;
                     return rv_first;
             }
 
@@ -1945,8 +2210,8 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
 
             // perhaps second word is a compound word (recursive call)
             if (wordnum < maxwordnum) {
-                rv = compound_check((st+i),strlen(st+i), wordnum+1,
-                     numsyllable, maxwordnum, wnum + 1, words, 0, is_sug, info);
+                rv = compound_check_end(ctx, (st+i),strlen(st+i), wordnum+1,
+                     numsyllable, maxwordnum, wnum + 1, words, is_sug, info);
                 
                 if (rv && numcheckcpd && ((scpd == 0 && cpdpat_check(word, i, rv_first, rv, affixed)) ||
                    (scpd != 0 && !cpdpat_check(word, i, rv_first, rv, affixed)))) rv = NULL;
@@ -1958,22 +2223,22 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
                 if (checkcompoundrep || forbiddenword) {
                     struct hentry * rv2 = NULL;
 
-                    if (checkcompoundrep && cpdrep_check(word, len)) return NULL;
+                    if (checkcompoundrep && cpdrep_check(ctx, word, len)) return NULL;
                     
                     // check first part
                     if (strncmp(rv->word, word + i, rv->blen) == 0) {
                         char r = *(st + i + rv->blen);
                         *(st + i + rv->blen) = '\0';
                         
-                        if (checkcompoundrep && cpdrep_check(st, i + rv->blen)) {
+                        if (checkcompoundrep && cpdrep_check(ctx, st, i + rv->blen)) {
                             *(st + i + rv->blen) = r;
                             continue;
                         }
 
                         if (forbiddenword) {
                             rv2 = lookup(word);
-                            if (!rv2) rv2 = affix_check(word, len);
-                            if (rv2 && rv2->astr && TESTAFF(rv2->astr, forbiddenword, rv2->alen) && 
+                            if (!rv2) rv2 = affix_check(ctx, word, len);
+                            if (rv2 && HENTRY_ASTR(rv2) && TESTAFF(HENTRY_ASTR(rv2), forbiddenword, rv2->alen) && 
                                 (strncmp(rv2->word, st, i + rv->blen) == 0)) {
                                     return NULL;
                             }
@@ -2024,7 +2289,7 @@ struct hentry * AffixMgr::compound_check(const char * word, int len,
 
 // check if compound word is correctly spelled
 // hu_mov_rule = spec. Hungarian rule (XXX)
-int AffixMgr::compound_check_morph(const char * word, int len, 
+int AffixMgr::compound_check_morph(affix_ctx & ctx, const char * word, int len, 
     short wordnum, short numsyllable, short maxwordnum, short wnum, hentry ** words,
     char hu_mov_rule = 0, char ** result = NULL, char * partresult = NULL)
 {
@@ -2074,7 +2339,7 @@ int AffixMgr::compound_check_morph(const char * word, int len,
 
         ch = st[i];
         st[i] = '\0';
-        sfx = NULL;
+        ctx.sfx = NULL;
 
         // FIRST WORD
 
@@ -2087,17 +2352,17 @@ int AffixMgr::compound_check_morph(const char * word, int len,
 
         // search homonym with compound flag
         while ((rv) && !hu_mov_rule && 
-            ((needaffix && TESTAFF(rv->astr, needaffix, rv->alen)) ||
-                !((compoundflag && !words && !onlycpdrule && TESTAFF(rv->astr, compoundflag, rv->alen)) ||
+            ((needaffix && TESTAFF(HENTRY_ASTR(rv), needaffix, rv->alen)) ||
+                !((compoundflag && !words && !onlycpdrule && TESTAFF(HENTRY_ASTR(rv), compoundflag, rv->alen)) ||
                 (compoundbegin && !wordnum && !onlycpdrule &&
-                        TESTAFF(rv->astr, compoundbegin, rv->alen)) ||
+                        TESTAFF(HENTRY_ASTR(rv), compoundbegin, rv->alen)) ||
                 (compoundmiddle && wordnum && !words && !onlycpdrule &&
-                    TESTAFF(rv->astr, compoundmiddle, rv->alen)) ||
+                    TESTAFF(HENTRY_ASTR(rv), compoundmiddle, rv->alen)) ||
                   (numdefcpd && onlycpdrule &&
                     ((!words && !wordnum && defcpd_check(&words, wnum, rv, (hentry **) &rwords, 0)) ||
                     (words && defcpd_check(&words, wnum, rv, (hentry **) &rwords, 0))))
                   ))) {
-            rv = rv->next_homonym;
+            rv = HENTRY_HOMONYM(rv);
         }
 
         if (rv) affixed = 0;
@@ -2117,36 +2382,36 @@ int AffixMgr::compound_check_morph(const char * word, int len,
         if (!rv) {
             if (onlycpdrule) break;
             if (compoundflag &&
-             !(rv = prefix_check(st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundflag))) {
-                if ((rv = suffix_check(st, i, 0, NULL, NULL, 0, NULL,
+             !(rv = prefix_check(ctx, st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundflag))) {
+                if ((rv = suffix_check(ctx, st, i, 0, NULL, NULL, 0, NULL,
                         FLAG_NULL, compoundflag, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) && !hu_mov_rule &&
-                    sfx->getCont() &&
-                        ((compoundforbidflag && TESTAFF(sfx->getCont(), compoundforbidflag, 
-                            sfx->getContLen())) || (compoundend &&
-                        TESTAFF(sfx->getCont(), compoundend, 
-                            sfx->getContLen())))) {
+                    ctx.sfx->getCont() &&
+                        ((compoundforbidflag && TESTAFF(ctx.sfx->getCont(), compoundforbidflag, 
+                            ctx.sfx->getContLen())) || (compoundend &&
+                        TESTAFF(ctx.sfx->getCont(), compoundend, 
+                            ctx.sfx->getContLen())))) {
                         rv = NULL;
                 }
             }
 
             if (rv ||
               (((wordnum == 0) && compoundbegin &&
-                ((rv = suffix_check(st, i, 0, NULL, NULL, 0, NULL, FLAG_NULL, compoundbegin, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
-                (rv = prefix_check(st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundbegin)))) ||
+                ((rv = suffix_check(ctx, st, i, 0, NULL, NULL, 0, NULL, FLAG_NULL, compoundbegin, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
+                (rv = prefix_check(ctx, st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundbegin)))) ||
               ((wordnum > 0) && compoundmiddle &&
-                ((rv = suffix_check(st, i, 0, NULL, NULL, 0, NULL, FLAG_NULL, compoundmiddle, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
-                (rv = prefix_check(st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundmiddle)))))
+                ((rv = suffix_check(ctx, st, i, 0, NULL, NULL, 0, NULL, FLAG_NULL, compoundmiddle, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
+                (rv = prefix_check(ctx, st, i, hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN, compoundmiddle)))))
               ) {
-                // char * p = prefix_check_morph(st, i, 0, compound);
+                // char * p = prefix_check_morph(ctx, st, i, 0, compound);
                 char * p = NULL;
-                if (compoundflag) p = affix_check_morph(st, i, compoundflag);
+                if (compoundflag) p = affix_check_morph(ctx, st, i, compoundflag);
                 if (!p || (*p == '\0')) {
                    if (p) free(p);
                    p = NULL;
                    if ((wordnum == 0) && compoundbegin) {
-                     p = affix_check_morph(st, i, compoundbegin);
+                     p = affix_check_morph(ctx, st, i, compoundbegin);
                    } else if ((wordnum > 0) && compoundmiddle) {
-                     p = affix_check_morph(st, i, compoundmiddle);                   
+                     p = affix_check_morph(ctx, st, i, compoundmiddle);                   
                    }
                 }
                 if (p && (*p != '\0')) {
@@ -2157,68 +2422,68 @@ int AffixMgr::compound_check_morph(const char * word, int len,
                 checked_prefix = 1;
             }
         // else check forbiddenwords
-        } else if (rv->astr && (TESTAFF(rv->astr, forbiddenword, rv->alen) ||
-            TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen) ||
-            TESTAFF(rv->astr, needaffix, rv->alen))) {
+        } else if (HENTRY_ASTR(rv) && (TESTAFF(HENTRY_ASTR(rv), forbiddenword, rv->alen) ||
+            TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen) ||
+            TESTAFF(HENTRY_ASTR(rv), needaffix, rv->alen))) {
                 st[i] = ch;
                 continue;
         }
 
             // check non_compound flag in suffix and prefix
             if ((rv) && !hu_mov_rule &&
-                ((pfx && pfx->getCont() &&
-                    TESTAFF(pfx->getCont(), compoundforbidflag, 
-                        pfx->getContLen())) ||
-                (sfx && sfx->getCont() &&
-                    TESTAFF(sfx->getCont(), compoundforbidflag, 
-                        sfx->getContLen())))) {
+                ((ctx.pfx && ctx.pfx->getCont() &&
+                    TESTAFF(ctx.pfx->getCont(), compoundforbidflag, 
+                        ctx.pfx->getContLen())) ||
+                (ctx.sfx && ctx.sfx->getCont() &&
+                    TESTAFF(ctx.sfx->getCont(), compoundforbidflag, 
+                        ctx.sfx->getContLen())))) {
                     continue;
             }
 
             // check compoundend flag in suffix and prefix
             if ((rv) && !checked_prefix && compoundend && !hu_mov_rule &&
-                ((pfx && pfx->getCont() &&
-                    TESTAFF(pfx->getCont(), compoundend, 
-                        pfx->getContLen())) ||
-                (sfx && sfx->getCont() &&
-                    TESTAFF(sfx->getCont(), compoundend, 
-                        sfx->getContLen())))) {
+                ((ctx.pfx && ctx.pfx->getCont() &&
+                    TESTAFF(ctx.pfx->getCont(), compoundend, 
+                        ctx.pfx->getContLen())) ||
+                (ctx.sfx && ctx.sfx->getCont() &&
+                    TESTAFF(ctx.sfx->getCont(), compoundend, 
+                        ctx.sfx->getContLen())))) {
                     continue;
             }
 
             // check compoundmiddle flag in suffix and prefix
             if ((rv) && !checked_prefix && (wordnum==0) && compoundmiddle && !hu_mov_rule &&
-                ((pfx && pfx->getCont() &&
-                    TESTAFF(pfx->getCont(), compoundmiddle, 
-                        pfx->getContLen())) ||
-                (sfx && sfx->getCont() &&
-                    TESTAFF(sfx->getCont(), compoundmiddle, 
-                        sfx->getContLen())))) {
+                ((ctx.pfx && ctx.pfx->getCont() &&
+                    TESTAFF(ctx.pfx->getCont(), compoundmiddle, 
+                        ctx.pfx->getContLen())) ||
+                (ctx.sfx && ctx.sfx->getCont() &&
+                    TESTAFF(ctx.sfx->getCont(), compoundmiddle, 
+                        ctx.sfx->getContLen())))) {
                     rv = NULL;
             }       
 
         // check forbiddenwords
-        if ((rv) && (rv->astr) && (TESTAFF(rv->astr, forbiddenword, rv->alen)
-            || TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen))) continue;
+        if ((rv) && (HENTRY_ASTR(rv)) && (TESTAFF(HENTRY_ASTR(rv), forbiddenword, rv->alen)
+            || TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen))) continue;
 
         // increment word number, if the second root has a compoundroot flag
         if ((rv) && (compoundroot) && 
-            (TESTAFF(rv->astr, compoundroot, rv->alen))) {
+            (TESTAFF(HENTRY_ASTR(rv), compoundroot, rv->alen))) {
                 wordnum++;
         }
 
         // first word is acceptable in compound words?
         if (((rv) && 
           ( checked_prefix || (words && words[wnum]) ||
-            (compoundflag && TESTAFF(rv->astr, compoundflag, rv->alen)) ||
-            ((oldwordnum == 0) && compoundbegin && TESTAFF(rv->astr, compoundbegin, rv->alen)) ||
-            ((oldwordnum > 0) && compoundmiddle && TESTAFF(rv->astr, compoundmiddle, rv->alen)) 
+            (compoundflag && TESTAFF(HENTRY_ASTR(rv), compoundflag, rv->alen)) ||
+            ((oldwordnum == 0) && compoundbegin && TESTAFF(HENTRY_ASTR(rv), compoundbegin, rv->alen)) ||
+            ((oldwordnum > 0) && compoundmiddle && TESTAFF(HENTRY_ASTR(rv), compoundmiddle, rv->alen)) 
 // LANG_hu section: spec. Hungarian rule
             || ((langnum == LANG_hu) && // hu_mov_rule
                 hu_mov_rule && (
-                    TESTAFF(rv->astr, 'F', rv->alen) ||
-                    TESTAFF(rv->astr, 'G', rv->alen) ||
-                    TESTAFF(rv->astr, 'H', rv->alen)
+                    TESTAFF(HENTRY_ASTR(rv), 'F', rv->alen) ||
+                    TESTAFF(HENTRY_ASTR(rv), 'G', rv->alen) ||
+                    TESTAFF(HENTRY_ASTR(rv), 'H', rv->alen)
                 )
               )
 // END of LANG_hu section
@@ -2238,10 +2503,10 @@ int AffixMgr::compound_check_morph(const char * word, int len,
                ))
          )
 // LANG_hu section: spec. Hungarian rule
-         || ((!rv) && (langnum == LANG_hu) && hu_mov_rule && (rv = affix_check(st,i)) &&
-              (sfx && sfx->getCont() && (
-                        TESTAFF(sfx->getCont(), (unsigned short) 'x', sfx->getContLen()) ||
-                        TESTAFF(sfx->getCont(), (unsigned short) '%', sfx->getContLen())
+         || ((!rv) && (langnum == LANG_hu) && hu_mov_rule && (rv = affix_check(ctx, st,i)) &&
+              (ctx.sfx && ctx.sfx->getCont() && (
+                        TESTAFF(ctx.sfx->getCont(), (unsigned short) 'x', ctx.sfx->getContLen()) ||
+                        TESTAFF(ctx.sfx->getCont(), (unsigned short) '%', ctx.sfx->getContLen())
                     )                
                )
              )
@@ -2254,7 +2519,7 @@ int AffixMgr::compound_check_morph(const char * word, int len,
                 numsyllable += get_syllable(st, i);
 
                 // + 1 word, if syllable number of the prefix > 1 (hungarian convention)
-                if (pfx && (get_syllable(pfx->getKey(),strlen(pfx->getKey())) > 1)) wordnum++;
+                if (ctx.pfx && (get_syllable(ctx.pfx->getKey(),strlen(ctx.pfx->getKey())) > 1)) wordnum++;
             }
 // END of LANG_hu section
 
@@ -2263,11 +2528,11 @@ int AffixMgr::compound_check_morph(const char * word, int len,
             rv = lookup((word+i)); // perhaps without prefix
 
         // search homonym with compound flag
-        while ((rv) && ((needaffix && TESTAFF(rv->astr, needaffix, rv->alen)) ||
-                        !((compoundflag && !words && TESTAFF(rv->astr, compoundflag, rv->alen)) ||
-                          (compoundend && !words && TESTAFF(rv->astr, compoundend, rv->alen)) ||
+        while ((rv) && ((needaffix && TESTAFF(HENTRY_ASTR(rv), needaffix, rv->alen)) ||
+                        !((compoundflag && !words && TESTAFF(HENTRY_ASTR(rv), compoundflag, rv->alen)) ||
+                          (compoundend && !words && TESTAFF(HENTRY_ASTR(rv), compoundend, rv->alen)) ||
                            (numdefcpd && words && defcpd_check(&words, wnum + 1, rv, NULL,1))))) {
-            rv = rv->next_homonym;
+            rv = HENTRY_HOMONYM(rv);
         }
 
             if (rv && words && words[wnum + 1]) {
@@ -2296,19 +2561,19 @@ int AffixMgr::compound_check_morph(const char * word, int len,
             oldwordnum2 = wordnum;
 
 // LANG_hu section: spec. Hungarian rule
-            if ((rv) && (langnum == LANG_hu) && (TESTAFF(rv->astr, 'I', rv->alen)) && !(TESTAFF(rv->astr, 'J', rv->alen))) {
+            if ((rv) && (langnum == LANG_hu) && (TESTAFF(HENTRY_ASTR(rv), 'I', rv->alen)) && !(TESTAFF(HENTRY_ASTR(rv), 'J', rv->alen))) {
                 numsyllable--;
             }
 // END of LANG_hu section
             // increment word number, if the second root has a compoundroot flag
             if ((rv) && (compoundroot) && 
-                (TESTAFF(rv->astr, compoundroot, rv->alen))) {
+                (TESTAFF(HENTRY_ASTR(rv), compoundroot, rv->alen))) {
                     wordnum++;
             }
 
             // check forbiddenwords
-            if ((rv) && (rv->astr) && (TESTAFF(rv->astr, forbiddenword, rv->alen) ||
-                TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen))) {
+            if ((rv) && (HENTRY_ASTR(rv)) && (TESTAFF(HENTRY_ASTR(rv), forbiddenword, rv->alen) ||
+                TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen))) {
                 st[i] = ch;
                 continue;
             }
@@ -2318,8 +2583,8 @@ int AffixMgr::compound_check_morph(const char * word, int len,
             // when compound forms consist of 2 words, or if more,
             // then the syllable number of root words must be 6, or lesser.
             if ((rv) && (
-                      (compoundflag && TESTAFF(rv->astr, compoundflag, rv->alen)) ||
-                      (compoundend && TESTAFF(rv->astr, compoundend, rv->alen))
+                      (compoundflag && TESTAFF(HENTRY_ASTR(rv), compoundflag, rv->alen)) ||
+                      (compoundend && TESTAFF(HENTRY_ASTR(rv), compoundend, rv->alen))
                     )
                 && (
                       ((cpdwordmax==-1) || (wordnum+1<cpdwordmax)) || 
@@ -2359,25 +2624,25 @@ int AffixMgr::compound_check_morph(const char * word, int len,
             wordnum = oldwordnum2;
 
             // perhaps second word has prefix or/and suffix
-            sfx = NULL;
-            sfxflag = FLAG_NULL;
+            ctx.sfx = NULL;
+            ctx.sfxflag = FLAG_NULL;
 
-            if (compoundflag && !onlycpdrule) rv = affix_check((word+i),strlen(word+i), compoundflag); else rv = NULL;
+            if (compoundflag && !onlycpdrule) rv = affix_check(ctx, (word+i),strlen(word+i), compoundflag); else rv = NULL;
 
             if (!rv && compoundend && !onlycpdrule) {
-                sfx = NULL;
-                pfx = NULL;
-                rv = affix_check((word+i),strlen(word+i), compoundend);
+                ctx.sfx = NULL;
+                ctx.pfx = NULL;
+                rv = affix_check(ctx, (word+i),strlen(word+i), compoundend);
             }
 
             if (!rv && numdefcpd && words) {
-                rv = affix_check((word+i),strlen(word+i), 0, IN_CPD_END);
+                rv = affix_check(ctx, (word+i),strlen(word+i), 0, IN_CPD_END);
                 if (rv && words && defcpd_check(&words, wnum + 1, rv, NULL, 1)) {
                       char * m = NULL;
-                      if (compoundflag) m = affix_check_morph((word+i),strlen(word+i), compoundflag);
+                      if (compoundflag) m = affix_check_morph(ctx, (word+i),strlen(word+i), compoundflag);
                       if ((!m || *m == '\0') && compoundend) {
                             if (m) free(m);
-                            m = affix_check_morph((word+i),strlen(word+i), compoundend);
+                            m = affix_check_morph(ctx, (word+i),strlen(word+i), compoundend);
                       }
                       mystrcat(*result, presult, MAXLNLEN);
                       if (m || (*m != '\0')) {
@@ -2392,19 +2657,19 @@ int AffixMgr::compound_check_morph(const char * word, int len,
 
             // check non_compound flag in suffix and prefix
             if ((rv) && 
-                ((pfx && pfx->getCont() &&
-                    TESTAFF(pfx->getCont(), compoundforbidflag, 
-                        pfx->getContLen())) ||
-                (sfx && sfx->getCont() &&
-                    TESTAFF(sfx->getCont(), compoundforbidflag, 
-                        sfx->getContLen())))) {
+                ((ctx.pfx && ctx.pfx->getCont() &&
+                    TESTAFF(ctx.pfx->getCont(), compoundforbidflag, 
+                        ctx.pfx->getContLen())) ||
+                (ctx.sfx && ctx.sfx->getCont() &&
+                    TESTAFF(ctx.sfx->getCont(), compoundforbidflag, 
+                        ctx.sfx->getContLen())))) {
                     rv = NULL;
             }
 
             // check forbiddenwords
-            if ((rv) && (rv->astr) && (TESTAFF(rv->astr,forbiddenword,rv->alen) ||
-                    TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen))
-                    && (! TESTAFF(rv->astr, needaffix, rv->alen))) {
+            if ((rv) && (HENTRY_ASTR(rv)) && (TESTAFF(HENTRY_ASTR(rv),forbiddenword,rv->alen) ||
+                    TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen))
+                    && (! TESTAFF(HENTRY_ASTR(rv), needaffix, rv->alen))) {
                         st[i] = ch;
                         continue;
                     }
@@ -2415,30 +2680,30 @@ int AffixMgr::compound_check_morph(const char * word, int len,
 
                 // - affix syllable num.
                 // XXX only second suffix (inflections, not derivations)
-                if (sfxappnd) {
-                    char * tmp = myrevstrdup(sfxappnd);
+                if (ctx.sfxappnd) {
+                    char * tmp = myrevstrdup(ctx.sfxappnd);
                     numsyllable -= get_syllable(tmp, strlen(tmp));
                     free(tmp);
                 }
 
                 // + 1 word, if syllable number of the prefix > 1 (hungarian convention)
-                if (pfx && (get_syllable(pfx->getKey(),strlen(pfx->getKey())) > 1)) wordnum++;
+                if (ctx.pfx && (get_syllable(ctx.pfx->getKey(),strlen(ctx.pfx->getKey())) > 1)) wordnum++;
 
                 // increment syllable num, if last word has a SYLLABLENUM flag
                 // and the suffix is beginning `s'
 
                 if (cpdsyllablenum) {
-                    switch (sfxflag) {
+                    switch (ctx.sfxflag) {
                         case 'c': { numsyllable+=2; break; }
                         case 'J': { numsyllable += 1; break; }
-                        case 'I': { if (rv && TESTAFF(rv->astr, 'J', rv->alen)) numsyllable += 1; break; }
+                        case 'I': { if (rv && TESTAFF(HENTRY_ASTR(rv), 'J', rv->alen)) numsyllable += 1; break; }
                     }
                 }
             }
 
             // increment word number, if the second word has a compoundroot flag
             if ((rv) && (compoundroot) && 
-                (TESTAFF(rv->astr, compoundroot, rv->alen))) {
+                (TESTAFF(HENTRY_ASTR(rv), compoundroot, rv->alen))) {
                     wordnum++;
             }
             // second word is acceptable, as a word with prefix or/and suffix?
@@ -2455,10 +2720,10 @@ int AffixMgr::compound_check_morph(const char * word, int len,
                    (!checkcompounddup || (rv != rv_first))
                    )) {
                       char * m = NULL;
-                      if (compoundflag) m = affix_check_morph((word+i),strlen(word+i), compoundflag);
+                      if (compoundflag) m = affix_check_morph(ctx, (word+i),strlen(word+i), compoundflag);
                       if ((!m || *m == '\0') && compoundend) {
                             if (m) free(m);
-                            m = affix_check_morph((word+i),strlen(word+i), compoundend);
+                            m = affix_check_morph(ctx, (word+i),strlen(word+i), compoundend);
                       }
                       mystrcat(*result, presult, MAXLNLEN);
                       if (m && (*m != '\0')) {
@@ -2475,7 +2740,7 @@ int AffixMgr::compound_check_morph(const char * word, int len,
 
             // perhaps second word is a compound word (recursive call)
             if ((wordnum < maxwordnum) && (ok == 0)) {
-                        compound_check_morph((word+i),strlen(word+i), wordnum+1, 
+                        compound_check_morph(ctx, (word+i),strlen(word+i), wordnum+1, 
                              numsyllable, maxwordnum, wnum + 1, words, 0, result, presult);
             } else {
                 rv=NULL;
@@ -2515,7 +2780,7 @@ inline int AffixMgr::isRevSubset(const char * s1, const char * end_of_s2, int le
 
 // check word for suffixes
 
-struct hentry * AffixMgr::suffix_check (const char * word, int len, 
+struct hentry * AffixMgr::suffix_check(affix_ctx & ctx, const char * word, int len, 
        int sfxopts, PfxEntry * ppfx, char ** wlst, int maxSug, int * ns, 
        const FLAG cclass, const FLAG needflag, char in_compound)
 {
@@ -2553,7 +2818,7 @@ struct hentry * AffixMgr::suffix_check (const char * word, int len,
                 rv = se->checkword(word,len, sfxopts, ppfx, wlst, maxSug, ns, (FLAG) cclass, 
                     needflag, (in_compound ? 0 : onlyincompound));
                 if (rv) {
-                    sfx=se; // BUG: sfx not stateless
+                    ctx.sfx=se;
                     return rv;
                 }
             }
@@ -2563,49 +2828,42 @@ struct hentry * AffixMgr::suffix_check (const char * word, int len,
 
     // now handle the general case
     if (len == 0) return NULL; // FULLSTRIP
-    unsigned char sp= *((const unsigned char *)(word + len - 1));
-    SfxEntry * sptr = sStart[sp];
-
-    while (sptr) {
-        if (isRevSubset(sptr->getKey(), word + len - 1, len)
-        ) {
-            // suffixes are not allowed in beginning of compounds
-            if ((((in_compound != IN_CPD_BEGIN)) || // && !cclass
-             // except when signed with compoundpermitflag flag
-             (sptr->getCont() && compoundpermitflag &&
-                TESTAFF(sptr->getCont(),compoundpermitflag,sptr->getContLen()))) && (!circumfix ||
-              // no circumfix flag in prefix and suffix
-              ((!ppfx || !(ep->getCont()) || !TESTAFF(ep->getCont(),
-                   circumfix, ep->getContLen())) &&
-               (!sptr->getCont() || !(TESTAFF(sptr->getCont(),circumfix,sptr->getContLen())))) ||
-              // circumfix flag in prefix AND suffix
-              ((ppfx && (ep->getCont()) && TESTAFF(ep->getCont(),
-                   circumfix, ep->getContLen())) &&
-               (sptr->getCont() && (TESTAFF(sptr->getCont(),circumfix,sptr->getContLen())))))  &&
-            // fogemorpheme
-              (in_compound || 
-                 !((sptr->getCont() && (TESTAFF(sptr->getCont(), onlyincompound, sptr->getContLen()))))) &&
-            // needaffix on prefix or first suffix
-              (cclass || 
-                  !(sptr->getCont() && TESTAFF(sptr->getCont(), needaffix, sptr->getContLen())) ||
-                  (ppfx && !((ep->getCont()) &&
-                     TESTAFF(ep->getCont(), needaffix,
-                       ep->getContLen())))
-              )
-            ) if (in_compound != IN_CPD_END || ppfx || !(sptr->getCont() && TESTAFF(sptr->getCont(), onlyincompound, sptr->getContLen()))) {
-                rv = sptr->checkword(word,len, sfxopts, ppfx, wlst,
-                    maxSug, ns, cclass, needflag, (in_compound ? 0 : onlyincompound));
-                if (rv) {
-                    sfx=sptr; // BUG: sfx not stateless
-                    sfxflag = sptr->getFlag(); // BUG: sfxflag not stateless
-                    if (!sptr->getCont()) sfxappnd=sptr->getKey(); // BUG: sfxappnd not stateless
-                    return rv;
-                }
-             }
-             sptr = sptr->getNextEQ();
-        } else {
-             sptr = sptr->getNextNE();
-        }
+    affix_iter it;
+    SfxEntry * sptr;
+    for (sptr = first_sfx(it, word, len); sptr; sptr = next_sfx(it, word, len)) {
+        // suffixes are not allowed in beginning of compounds
+        if ((((in_compound != IN_CPD_BEGIN)) || // && !cclass
+         // except when signed with compoundpermitflag flag
+         (sptr->getCont() && compoundpermitflag &&
+            TESTAFF(sptr->getCont(),compoundpermitflag,sptr->getContLen()))) && (!circumfix ||
+          // no circumfix flag in prefix and suffix
+          ((!ppfx || !(ep->getCont()) || !TESTAFF(ep->getCont(),
+               circumfix, ep->getContLen())) &&
+           (!sptr->getCont() || !(TESTAFF(sptr->getCont(),circumfix,sptr->getContLen())))) ||
+          // circumfix flag in prefix AND suffix
+          ((ppfx && (ep->getCont()) && TESTAFF(ep->getCont(),
+               circumfix, ep->getContLen())) &&
+           (sptr->getCont() && (TESTAFF(sptr->getCont(),circumfix,sptr->getContLen())))))  &&
+        // fogemorpheme
+          (in_compound || 
+             !((sptr->getCont() && (TESTAFF(sptr->getCont(), onlyincompound, sptr->getContLen()))))) &&
+        // needaffix on prefix or first suffix
+          (cclass || 
+              !(sptr->getCont() && TESTAFF(sptr->getCont(), needaffix, sptr->getContLen())) ||
+              (ppfx && !((ep->getCont()) &&
+                 TESTAFF(ep->getCont(), needaffix,
+                   ep->getContLen())))
+          )
+        ) if (in_compound != IN_CPD_END || ppfx || !(sptr->getCont() && TESTAFF(sptr->getCont(), onlyincompound, sptr->getContLen()))) {
+            rv = sptr->checkword(word,len, sfxopts, ppfx, wlst,
+                maxSug, ns, cclass, needflag, (in_compound ? 0 : onlyincompound));
+            if (rv) {
+                ctx.sfx=sptr;
+                ctx.sfxflag = sptr->getFlag();
+                if (!sptr->getCont()) ctx.sfxappnd=sptr->getKey();
+                return rv;
+            }
+         }
     }
 
     return NULL;
@@ -2613,7 +2871,7 @@ struct hentry * AffixMgr::suffix_check (const char * word, int len,
 
 // check word for two-level suffixes
 
-struct hentry * AffixMgr::suffix_check_twosfx(const char * word, int len, 
+struct hentry * AffixMgr::suffix_check_twosfx(affix_ctx & ctx, const char * word, int len, 
        int sfxopts, PfxEntry * ppfx, const FLAG needflag)
 {
     struct hentry * rv = NULL;
@@ -2623,7 +2881,7 @@ struct hentry * AffixMgr::suffix_check_twosfx(const char * word, int len,
     while (se) {
         if (contclasses[se->getFlag()])
         {
-            rv = se->check_twosfx(word,len, sfxopts, ppfx, needflag);
+            rv = se->check_twosfx(ctx, word,len, sfxopts, ppfx, needflag);
             if (rv) return rv;
         }
         se = se->getNext();
@@ -2631,30 +2889,24 @@ struct hentry * AffixMgr::suffix_check_twosfx(const char * word, int len,
 
     // now handle the general case
     if (len == 0) return NULL; // FULLSTRIP
-    unsigned char sp = *((const unsigned char *)(word + len - 1));
-    SfxEntry * sptr = sStart[sp];
-
-    while (sptr) {
-        if (isRevSubset(sptr->getKey(), word + len - 1, len)) {
-            if (contclasses[sptr->getFlag()])
-            {
-                rv = sptr->check_twosfx(word,len, sfxopts, ppfx, needflag);
-                if (rv) {
-                    sfxflag = sptr->getFlag(); // BUG: sfxflag not stateless
-                    if (!sptr->getCont()) sfxappnd=sptr->getKey(); // BUG: sfxappnd not stateless
-                    return rv;
-                }
+    affix_iter it;
+    SfxEntry * sptr;
+    for (sptr = first_sfx(it, word, len); sptr; sptr = next_sfx(it, word, len)) {
+        if (contclasses[sptr->getFlag()])
+        {
+            rv = sptr->check_twosfx(ctx, word,len, sfxopts, ppfx, needflag);
+            if (rv) {
+                ctx.sfxflag = sptr->getFlag();
+                if (!sptr->getCont()) ctx.sfxappnd=sptr->getKey();
+                return rv;
             }
-            sptr = sptr->getNextEQ();
-        } else {
-             sptr = sptr->getNextNE();
         }
     }
 
     return NULL;
 }
 
-char * AffixMgr::suffix_check_twosfx_morph(const char * word, int len, 
+char * AffixMgr::suffix_check_twosfx_morph(affix_ctx & ctx, const char * word, int len, 
        int sfxopts, PfxEntry * ppfx, const FLAG needflag)
 {
     char result[MAXLNLEN];
@@ -2694,34 +2946,28 @@ char * AffixMgr::suffix_check_twosfx_morph(const char * word, int len,
 
     // now handle the general case
     if (len == 0) return NULL; // FULLSTRIP
-    unsigned char sp = *((const unsigned char *)(word + len - 1));
-    SfxEntry * sptr = sStart[sp];
-
-    while (sptr) {
-        if (isRevSubset(sptr->getKey(), word + len - 1, len)) {
-            if (contclasses[sptr->getFlag()]) 
-            {
-                st = sptr->check_twosfx_morph(word,len, sfxopts, ppfx, needflag);
-                if (st) {
-                    sfxflag = sptr->getFlag(); // BUG: sfxflag not stateless
-                    if (!sptr->getCont()) sfxappnd=sptr->getKey(); // BUG: sfxappnd not stateless
-                    strcpy(result2, st);
-                    free(st);
-
-                result3[0] = '\0';
-
-                if (sptr->getMorph()) {
-                    mystrcat(result3, " ", MAXLNLEN);
-                    mystrcat(result3, sptr->getMorph(), MAXLNLEN);
-                } else debugflag(result3, sptr->getFlag());
-                strlinecat(result2, result3);
-                mystrcat(result2, "\n", MAXLNLEN);
-                mystrcat(result,  result2, MAXLNLEN);
-                }
+    affix_iter it;
+    SfxEntry * sptr;
+    for (sptr = first_sfx(it, word, len); sptr; sptr = next_sfx(it, word, len)) {
+        if (contclasses[sptr->getFlag()]) 
+        {
+            st = sptr->check_twosfx_morph(word,len, sfxopts, ppfx, needflag);
+            if (st) {
+                ctx.sfxflag = sptr->getFlag();
+                if (!sptr->getCont()) ctx.sfxappnd=sptr->getKey();
+                strcpy(result2, st);
+                free(st);
+
+            result3[0] = '\0';
+
+            if (sptr->getMorph()) {
+                mystrcat(result3, " ", MAXLNLEN);
+                mystrcat(result3, sptr->getMorph(), MAXLNLEN);
+            } else debugflag(result3, sptr->getFlag());
+            strlinecat(result2, result3);
+            mystrcat(result2, "\n", MAXLNLEN);
+            mystrcat(result,  result2, MAXLNLEN);
             }
-            sptr = sptr->getNextEQ();
-        } else {
-             sptr = sptr->getNextNE();
         }
     }
     if (*result) return mystrdup(result);
@@ -2801,63 +3047,56 @@ char * AffixMgr::suffix_check_morph(const char * word, int len,
 
     // now handle the general case
     if (len == 0) return NULL; // FULLSTRIP
-    unsigned char sp = *((const unsigned char *)(word + len - 1));
-    SfxEntry * sptr = sStart[sp];
-
-    while (sptr) {
-        if (isRevSubset(sptr->getKey(), word + len - 1, len)
-        ) {
-            // suffixes are not allowed in beginning of compounds
-            if (((((in_compound != IN_CPD_BEGIN)) || // && !cclass
-             // except when signed with compoundpermitflag flag
-             (sptr->getCont() && compoundpermitflag &&
-                TESTAFF(sptr->getCont(),compoundpermitflag,sptr->getContLen()))) && (!circumfix ||
-              // no circumfix flag in prefix and suffix
-              ((!ppfx || !(ep->getCont()) || !TESTAFF(ep->getCont(),
-                   circumfix, ep->getContLen())) &&
-               (!sptr->getCont() || !(TESTAFF(sptr->getCont(),circumfix,sptr->getContLen())))) ||
-              // circumfix flag in prefix AND suffix
-              ((ppfx && (ep->getCont()) && TESTAFF(ep->getCont(),
-                   circumfix, ep->getContLen())) &&
-               (sptr->getCont() && (TESTAFF(sptr->getCont(),circumfix,sptr->getContLen())))))  &&
-            // fogemorpheme
-              (in_compound || 
-                 !((sptr->getCont() && (TESTAFF(sptr->getCont(), onlyincompound, sptr->getContLen()))))) &&
-            // needaffix on first suffix
-              (cclass || !(sptr->getCont() && 
-                   TESTAFF(sptr->getCont(), needaffix, sptr->getContLen())))
-            )) rv = sptr->checkword(word,len, sfxopts, ppfx, NULL, 0, 0, cclass, needflag);
-            while (rv) {
-                    if (ppfx) {
-                        if (ppfx->getMorph()) {
-                            mystrcat(result, ppfx->getMorph(), MAXLNLEN);
-                            mystrcat(result, " ", MAXLNLEN);
-                        } else debugflag(result, ppfx->getFlag());
-                    }    
-                    if (complexprefixes && HENTRY_DATA(rv)) mystrcat(result, HENTRY_DATA2(rv), MAXLNLEN);
-                    if (! HENTRY_FIND(rv, MORPH_STEM)) {
-                            mystrcat(result, " ", MAXLNLEN);                                
-                            mystrcat(result, MORPH_STEM, MAXLNLEN);
-                            mystrcat(result, HENTRY_WORD(rv), MAXLNLEN);
-                    }
-                    // store the pointer of the hash entry
+    affix_iter it;
+    SfxEntry * sptr;
+    for (sptr = first_sfx(it, word, len); sptr; sptr = next_sfx(it, word, len)) {
+        // suffixes are not allowed in beginning of compounds
+        if (((((in_compound != IN_CPD_BEGIN)) || // && !cclass
+         // except when signed with compoundpermitflag flag
+         (sptr->getCont() && compoundpermitflag &&
+            TESTAFF(sptr->getCont(),compoundpermitflag,sptr->getContLen()))) && (!circumfix ||
+          // no circumfix flag in prefix and suffix
+          ((!ppfx || !(ep->getCont()) || !TESTAFF(ep->getCont(),
+               circumfix, ep->getContLen())) &&
+           (!sptr->getCont() || !(TESTAFF(sptr->getCont(),circumfix,sptr->getContLen())))) ||
+          // circumfix flag in prefix AND suffix
+          ((ppfx && (ep->getCont()) && TESTAFF(ep->getCont(),
+               circumfix, ep->getContLen())) &&
+           (sptr->getCont() && (TESTAFF(sptr->getCont(),circumfix,sptr->getContLen())))))  &&
+        // fogemorpheme
+          (in_compound || 
+             !((sptr->getCont() && (TESTAFF(sptr->getCont(), onlyincompound, sptr->getContLen()))))) &&
+        // needaffix on first suffix
+          (cclass || !(sptr->getCont() && 
+               TESTAFF(sptr->getCont(), needaffix, sptr->getContLen())))
+        )) rv = sptr->checkword(word,len, sfxopts, ppfx, NULL, 0, 0, cclass, needflag);
+        while (rv) {
+                if (ppfx) {
+                    if (ppfx->getMorph()) {
+                        mystrcat(result, ppfx->getMorph(), MAXLNLEN);
+                        mystrcat(result, " ", MAXLNLEN);
+                    } else debugflag(result, ppfx->getFlag());
+                }    
+                if (complexprefixes && HENTRY_DATA(rv)) mystrcat(result, HENTRY_DATA2(rv), MAXLNLEN);
+                if (! HENTRY_FIND(rv, MORPH_STEM)) {
+                        mystrcat(result, " ", MAXLNLEN);                                
+                        mystrcat(result, MORPH_STEM, MAXLNLEN);
+                        mystrcat(result, HENTRY_WORD(rv), MAXLNLEN);
+                }
+                // store the pointer of the hash entry
 //                    sprintf(result + strlen(result), " %s%p", MORPH_HENTRY, rv);
 
-                    if (!complexprefixes && HENTRY_DATA(rv)) {
-                        mystrcat(result, " ", MAXLNLEN);                                
-                        mystrcat(result, HENTRY_DATA2(rv), MAXLNLEN);
-                    }
+                if (!complexprefixes && HENTRY_DATA(rv)) {
+                    mystrcat(result, " ", MAXLNLEN);                                
+                    mystrcat(result, HENTRY_DATA2(rv), MAXLNLEN);
+                }
 
-                if (sptr->getMorph()) {
-                    mystrcat(result, " ", MAXLNLEN);
-                    mystrcat(result, sptr->getMorph(), MAXLNLEN);
-                } else debugflag(result, sptr->getFlag());
-                mystrcat(result, "\n", MAXLNLEN);
-                rv = sptr->get_next_homonym(rv, sfxopts, ppfx, cclass, needflag);
-            }
-             sptr = sptr->getNextEQ();
-        } else {
-             sptr = sptr->getNextNE();
+            if (sptr->getMorph()) {
+                mystrcat(result, " ", MAXLNLEN);
+                mystrcat(result, sptr->getMorph(), MAXLNLEN);
+            } else debugflag(result, sptr->getFlag());
+            mystrcat(result, "\n", MAXLNLEN);
+            rv = sptr->get_next_homonym(rv, sfxopts, ppfx, cclass, needflag);
         }
     }
 
@@ -2866,35 +3105,35 @@ char * AffixMgr::suffix_check_morph(const char * word, int len,
 }
 
 // check if word with affixes is correctly spelled
-struct hentry * AffixMgr::affix_check (const char * word, int len, const FLAG needflag, char in_compound)
+struct hentry * AffixMgr::affix_check(affix_ctx & ctx, const char * word, int len, const FLAG needflag, char in_compound)
 {
     struct hentry * rv= NULL;
 
     // check all prefixes (also crossed with suffixes if allowed) 
-    rv = prefix_check(word, len, in_compound, needflag);
+    rv = prefix_check(ctx, word, len, in_compound, needflag);
     if (rv) return rv;
 
     // if still not found check all suffixes
-    rv = suffix_check(word, len, 0, NULL, NULL, 0, NULL, FLAG_NULL, needflag, in_compound);
+    rv = suffix_check(ctx, word, len, 0, NULL, NULL, 0, NULL, FLAG_NULL, needflag, in_compound);
 
     if (havecontclass) {
-        sfx = NULL;
-        pfx = NULL;
+        ctx.sfx = NULL;
+        ctx.pfx = NULL;
 
         if (rv) return rv;
         // if still not found check all two-level suffixes
-        rv = suffix_check_twosfx(word, len, 0, NULL, needflag);
+        rv = suffix_check_twosfx(ctx, word, len, 0, NULL, needflag);
 
         if (rv) return rv;
         // if still not found check all two-level suffixes
-        rv = prefix_check_twosfx(word, len, IN_CPD_NOT, needflag);
+        rv = prefix_check_twosfx(ctx, word, len, IN_CPD_NOT, needflag);
     }
 
     return rv;
 }
 
 // check if word with affixes is correctly spelled
-char * AffixMgr::affix_check_morph(const char * word, int len, const FLAG needflag, char in_compound)
+char * AffixMgr::affix_check_morph(affix_ctx & ctx, const char * word, int len, const FLAG needflag, char in_compound)
 {
     char result[MAXLNLEN];
     char * st = NULL;
@@ -2902,7 +3141,7 @@ char * AffixMgr::affix_check_morph(const char * word, int len, const FLAG needfl
     *result = '\0';
     
     // check all prefixes (also crossed with suffixes if allowed) 
-    st = prefix_check_morph(word, len, in_compound);
+    st = prefix_check_morph(ctx, word, len, in_compound);
     if (st) {
         mystrcat(result, st, MAXLNLEN);
         free(st);
@@ -2916,17 +3155,17 @@ char * AffixMgr::affix_check_morph(const char * word, int len, const FLAG needfl
     }
 
     if (havecontclass) {
-        sfx = NULL;
-        pfx = NULL;
+        ctx.sfx = NULL;
+        ctx.pfx = NULL;
         // if still not found check all two-level suffixes
-        st = suffix_check_twosfx_morph(word, len, 0, NULL, needflag);
+        st = suffix_check_twosfx_morph(ctx, word, len, 0, NULL, needflag);
         if (st) {
             mystrcat(result, st, MAXLNLEN);
             free(st);
         }
 
         // if still not found check all two-level suffixes
-        st = prefix_check_twosfx_morph(word, len, IN_CPD_NOT, needflag);
+        st = prefix_check_twosfx_morph(ctx, word, len, IN_CPD_NOT, needflag);
         if (st) {
             mystrcat(result, st, MAXLNLEN);
             free(st);
@@ -2981,9 +3220,9 @@ char * AffixMgr::morphgen(char * ts, int wl, const unsigned short * ap,
                     char * newword = sptr->add(ts, wl);
                     if (newword) {
                         hentry * check = pHMgr->lookup(newword); // XXX extra dic
-                        if (!check || !check->astr || 
-                            !(TESTAFF(check->astr, forbiddenword, check->alen) || 
-                              TESTAFF(check->astr, ONLYUPCASEFLAG, check->alen))) {
+                        if (!check || !HENTRY_ASTR(check) || 
+                            !(TESTAFF(HENTRY_ASTR(check), forbiddenword, check->alen) || 
+                              TESTAFF(HENTRY_ASTR(check), ONLYUPCASEFLAG, check->alen))) {
                                 return newword;
                         }
                         free(newword);
@@ -3363,19 +3602,6 @@ int AffixMgr::get_checknum() const
   return checknum;
 }
 
-// return the value of prefix
-const char * AffixMgr::get_prefix() const
-{
-  if (pfx) return pfx->getKey();
-  return NULL;
-}
-
-// return the value of suffix
-const char * AffixMgr::get_suffix() const
-{
-  return sfxappnd;
-}
-
 // return the value of suffix
 const char * AffixMgr::get_version() const
 {
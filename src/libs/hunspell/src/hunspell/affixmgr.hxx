@@ -18,6 +18,61 @@
 class PfxEntry;
 class SfxEntry;
 
+#define CPDMEMO_SIZE 1024 // power of two
+
+// per-call state of affix and compound checking, owned by the caller
+// so that one loaded AffixMgr can be shared between threads
+struct affix_ctx {
+  const char *        sfxappnd; // appendix of the last matched suffix
+  FLAG                sfxflag;  // flag of the last matched suffix
+  SfxEntry *          sfx;      // last matched suffix
+  PfxEntry *          pfx;      // last matched prefix
+  unsigned long long  deadline; // monotonic_usec() limit of suggestion, 0 = none
+  int                 timedout; // the deadline has passed
+  const char *        cpdword;  // word of the running compound_check()
+  int                 cpdlen;
+  int                 cpdbudget; // compound_check_part() calls left for the word
+  int                 cpdnmemo; // used slots of cpdmemo, -1 if not cleared yet
+  unsigned long long  cpdmemo[CPDMEMO_SIZE]; // ends of the word failed as compounds
+
+  affix_ctx() : sfxappnd(NULL), sfxflag(FLAG_NULL), sfx(NULL), pfx(NULL),
+    deadline(0), timedout(0), cpdword(NULL), cpdlen(0), cpdbudget(0), cpdnmemo(-1) {}
+
+  int expired();
+};
+
+#define CONDBYTES_SIZE (SETSIZE / 8) // byte set of the affix conditions
+
+// state of an affix automaton: a trie of the affix strings (reversed
+// for suffixes), so the affixes matching a word are found in one pass
+// over its characters
+struct affstate {
+  int           child;  // first child state, 0 if none
+  int           next;   // next sibling state with a greater character, 0 if none
+  int           first;  // affixes of the string in affautomaton::affixes
+  int           count;
+  int           cond;   // union of their condition byte sets, 0 if unrestricted
+  unsigned char c;      // last character of the string
+};
+
+struct affautomaton {
+  struct affstate * states;
+  void **           affixes;  // PfxEntry or SfxEntry, in the order of the sorted lists
+  int *             conds;    // byte sets of the root next to the affix (see
+                              // condition_bytes()), 0 if unrestricted
+  unsigned char *   condbytes; // distinct byte sets, the 0th is unused
+  int               start[SETSIZE]; // states of the one character strings
+};
+
+// position of the affix enumeration of a word
+struct affix_iter {
+  int    state;
+  int    depth;   // characters matched
+  int    pos;     // next affix of the state
+  int    end;
+  void * ptr;     // next list entry, if there is no automaton
+};
+
 class LIBHUNSPELL_DLL_EXPORTED AffixMgr
 {
 
@@ -25,6 +80,8 @@ class LIBHUNSPELL_DLL_EXPORTED AffixMgr
   SfxEntry *          sStart[SETSIZE];
   PfxEntry *          pFlag[SETSIZE];
   SfxEntry *          sFlag[SETSIZE];
+  affautomaton *      pfxauto;
+  affautomaton *      sfxauto;
   HashMgr *           pHMgr;
   HashMgr **          alldic;
   int *               maxdic;
@@ -72,17 +129,12 @@ class LIBHUNSPELL_DLL_EXPORTED AffixMgr
   int                 nosplitsugs;
   int                 sugswithdots;
   int                 cpdwordmax;
+  int                 cpdmaxcheck;
   int                 cpdmaxsyllable;
   char *              cpdvowels;
   w_char *            cpdvowels_utf16;
   int                 cpdvowels_utf16_len;
   char *              cpdsyllablenum;
-  const char *        pfxappnd; // BUG: not stateless
-  const char *        sfxappnd; // BUG: not stateless
-  FLAG                sfxflag;  // BUG: not stateless
-  char *              derived;  // BUG: not stateless
-  SfxEntry *          sfx;      // BUG: not stateless
-  PfxEntry *          pfx;      // BUG: not stateless
   int                 checknum;
   char *              wordchars;
   unsigned short *    wordchars_utf16;
@@ -112,33 +164,33 @@ public:
   AffixMgr(const char * affpath, HashMgr** ptr, int * md,
     const char * key = NULL);
   ~AffixMgr();
-  struct hentry *     affix_check(const char * word, int len,
+  struct hentry *     affix_check(affix_ctx & ctx, const char * word, int len,
             const unsigned short needflag = (unsigned short) 0,
             char in_compound = IN_CPD_NOT);
-  struct hentry *     prefix_check(const char * word, int len,
+  struct hentry *     prefix_check(affix_ctx & ctx, const char * word, int len,
             char in_compound, const FLAG needflag = FLAG_NULL);
   inline int isSubset(const char * s1, const char * s2);
-  struct hentry *     prefix_check_twosfx(const char * word, int len,
+  struct hentry *     prefix_check_twosfx(affix_ctx & ctx, const char * word, int len,
             char in_compound, const FLAG needflag = FLAG_NULL);
   inline int isRevSubset(const char * s1, const char * end_of_s2, int len);
-  struct hentry *     suffix_check(const char * word, int len, int sfxopts,
+  struct hentry *     suffix_check(affix_ctx & ctx, const char * word, int len, int sfxopts,
             PfxEntry* ppfx, char ** wlst, int maxSug, int * ns,
             const FLAG cclass = FLAG_NULL, const FLAG needflag = FLAG_NULL,
             char in_compound = IN_CPD_NOT);
-  struct hentry *     suffix_check_twosfx(const char * word, int len,
+  struct hentry *     suffix_check_twosfx(affix_ctx & ctx, const char * word, int len,
             int sfxopts, PfxEntry* ppfx, const FLAG needflag = FLAG_NULL);
 
-  char * affix_check_morph(const char * word, int len,
+  char * affix_check_morph(affix_ctx & ctx, const char * word, int len,
             const FLAG needflag = FLAG_NULL, char in_compound = IN_CPD_NOT);
-  char * prefix_check_morph(const char * word, int len,
+  char * prefix_check_morph(affix_ctx & ctx, const char * word, int len,
             char in_compound, const FLAG needflag = FLAG_NULL);
-  char * suffix_check_morph (const char * word, int len, int sfxopts,
+  char * suffix_check_morph(const char * word, int len, int sfxopts,
             PfxEntry * ppfx, const FLAG cclass = FLAG_NULL,
             const FLAG needflag = FLAG_NULL, char in_compound = IN_CPD_NOT);
 
-  char * prefix_check_twosfx_morph(const char * word, int len,
+  char * prefix_check_twosfx_morph(affix_ctx & ctx, const char * word, int len,
             char in_compound, const FLAG needflag = FLAG_NULL);
-  char * suffix_check_twosfx_morph(const char * word, int len,
+  char * suffix_check_twosfx_morph(affix_ctx & ctx, const char * word, int len,
             int sfxopts, PfxEntry * ppfx, const FLAG needflag = FLAG_NULL);
 
   char * morphgen(char * ts, int wl, const unsigned short * ap,
@@ -149,19 +201,19 @@ public:
             int, char *);
 
   short       get_syllable (const char * word, int wlen);
-  int         cpdrep_check(const char * word, int len);
+  int         cpdrep_check(affix_ctx & ctx, const char * word, int len);
   int         cpdpat_check(const char * word, int len, hentry * r1, hentry * r2,
                     const char affixed);
   int         defcpd_check(hentry *** words, short wnum, hentry * rv,
                     hentry ** rwords, char all);
   int         cpdcase_check(const char * word, int len);
-  inline int  candidate_check(const char * word, int len);
+  inline int  candidate_check(affix_ctx & ctx, const char * word, int len);
   void        setcminmax(int * cmin, int * cmax, const char * word, int len);
-  struct hentry * compound_check(const char * word, int len, short wordnum,
+  struct hentry * compound_check(affix_ctx & ctx, const char * word, int len, short wordnum,
             short numsyllable, short maxwordnum, short wnum, hentry ** words,
             char hu_mov_rule, char is_sug, int * info);
 
-  int compound_check_morph(const char * word, int len, short wordnum,
+  int compound_check_morph(affix_ctx & ctx, const char * word, int len, short wordnum,
             short numsyllable, short maxwordnum, short wnum, hentry ** words,
             char hu_mov_rule, char ** result, char * partresult);
 
@@ -194,9 +246,6 @@ public:
   FLAG                get_compoundroot() const;
   FLAG                get_lemma_present() const;
   int                 get_checknum() const;
-  const char *        get_prefix() const;
-  const char *        get_suffix() const;
-  const char *        get_derived() const;
   const char *        get_version() const;
   int                 have_contclass() const;
   int                 get_utf8() const;
@@ -242,6 +291,21 @@ private:
   SfxEntry * process_sfx_in_order(SfxEntry * ptr, SfxEntry * nptr);
   int process_pfx_tree_to_list();
   int process_sfx_tree_to_list();
+  struct hentry * compound_check_part(affix_ctx & ctx, const char * word, int len, short wordnum,
+            short numsyllable, short maxwordnum, short wnum, hentry ** words,
+            char hu_mov_rule, char is_sug, int * info);
+  struct hentry * compound_check_end(affix_ctx & ctx, const char * word, int len, short wordnum,
+            short numsyllable, short maxwordnum, short wnum, hentry ** words,
+            char is_sug, int * info);
+  affautomaton * build_automaton(int n, const char ** keys, void ** affixes,
+      unsigned char * condbytes, char * restricted);
+  void free_automaton(affautomaton * a);
+  int build_automatons();
+  int next_state(affautomaton * a, affix_iter & it, unsigned char c);
+  inline PfxEntry * first_pfx(affix_iter & it, const char * word, int len);
+  inline PfxEntry * next_pfx(affix_iter & it, const char * word, int len);
+  inline SfxEntry * first_sfx(affix_iter & it, const char * word, int len);
+  inline SfxEntry * next_sfx(affix_iter & it, const char * word, int len);
   int redundant_condition(char, char * strip, int stripl,
       const char * cond, int);
 };
@@ -47,6 +47,7 @@ static inline void HUNSPELL_WARNING(FILE *, const char *, ...) {}
 #define MAXLNLEN        8192
 
 #define MINCPDLEN       3
+#define MAXCPDCHECK     10000 // default of COMPOUNDCHECKMAX
 #define MAXCOMPOUND     10
 #define MAXCONDLEN      20
 #define MAXCONDLEN_1    (MAXCONDLEN - sizeof(char *))
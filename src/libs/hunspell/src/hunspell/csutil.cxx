@@ -6,6 +6,12 @@
 #include <stdio.h> 
 #include <ctype.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
 #include "csutil.hxx"
 #include "atypes.hxx"
 #include "langnum.hxx"
@@ -37,15 +43,20 @@ struct unicode_info {
 static NS_DEFINE_CID(kCharsetConverterManagerCID, NS_ICHARSETCONVERTERMANAGER_CID);
 #endif
 
+// case mapping as difference to the character (modulo 0x10000), so the
+// blocks without letters or with the same pattern are stored only once
 struct unicode_info2 {
   char cletter;
   unsigned short cupper;
   unsigned short clower;
 };
 
-static struct unicode_info2 * utf_tbl = NULL;
+static struct unicode_info2 * utf_tbl = NULL; // distinct blocks of 256 characters
+static struct unicode_info2 * utf_blk[256];   // block of the characters by high byte
 static int utf_tbl_count = 0; // utf_tbl can be used by multiple Hunspell instances
 
+#define UTF_INFO(c) (utf_blk[(c) >> 8] + ((c) & 0xff))
+
 /* only UTF-16 (BMP) implementation */
 char * u16_u8(char * dest, int size, const w_char * src, int srclen) {
     signed char * u8 = (signed char *)dest;
@@ -53,6 +64,18 @@ char * u16_u8(char * dest, int size, const w_char * src, int srclen) {
     const w_char * u2 = src;
     const w_char * u2_max = src + srclen;
     while ((u2 < u2_max) && (u8 < u8_max)) {
+        // runs of ASCII and of 2-byte characters (Latin, Greek, Cyrillic etc.)
+        while (!u2->h && !(u2->l & 0x80)) {
+            *u8++ = u2->l;
+            if ((++u2 == u2_max) || (u8 == u8_max)) goto done;
+        }
+        while ((u2->h && u2->h < 0x08) && (u8_max - u8 >= 2)) {
+            u8[0] = 0xc0 + (u2->h << 2) + (u2->l >> 6);
+            u8[1] = 0x80 + (u2->l & 0x3f);
+            u8 += 2;
+            if (++u2 == u2_max) goto done;
+        }
+        if (u8 == u8_max) break;
         if (u2->h) { // > 0xFF
             // XXX 4-byte haven't implemented yet.
             if (u2->h >= 0x08) {   // >= 0x800 (3-byte UTF-8 character)
@@ -89,6 +112,7 @@ char * u16_u8(char * dest, int size, const w_char * src, int srclen) {
         }
         u2++;
     }
+done:
     *u8 = '\0';
     return dest;
 }
@@ -101,6 +125,20 @@ int u8_u16(w_char * dest, int size, const char * src) {
     w_char * u2_max = u2 + size;
     
     while ((u2 < u2_max) && *u8) {
+    // runs of ASCII and of 2-byte characters (Latin, Greek, Cyrillic etc.)
+    while (*u8 > 0) {
+        u2->h = 0;
+        u2->l = *u8;
+        u8++;
+        if (++u2 == u2_max) return (int)(u2 - dest);
+    }
+    while (((*u8 & 0xe0) == 0xc0) && ((*(u8+1) & 0xc0) == 0x80)) {
+        u2->h = (*u8 & 0x1f) >> 2;
+        u2->l = (*u8 << 6) + (*(u8+1) & 0x3f);
+        u8 += 2;
+        if (++u2 == u2_max) return (int)(u2 - dest);
+    }
+    if (!*u8) break;
     switch ((*u8) & 0xf0) {
         case 0x00:
         case 0x10:
@@ -648,9 +686,10 @@ char * mystrrep(char * word, const char * pat, const char * rep) {
 void mkallsmall_utf(w_char * u, int nc, int langnum) {
     for (int i = 0; i < nc; i++) {
         unsigned short idx = (u[i].h << 8) + u[i].l;
-        if (idx != unicodetolower(idx, langnum)) {
-            u[i].h = (unsigned char) (unicodetolower(idx, langnum) >> 8);
-            u[i].l = (unsigned char) (unicodetolower(idx, langnum) & 0x00FF);
+        unsigned short lower = unicodetolower(idx, langnum);
+        if (idx != lower) {
+            u[i].h = (unsigned char) (lower >> 8);
+            u[i].l = (unsigned char) (lower & 0x00FF);
         }
     }
 }
@@ -658,9 +697,10 @@ void mkallsmall_utf(w_char * u, int nc, int langnum) {
 void mkallcap_utf(w_char * u, int nc, int langnum) {
     for (int i = 0; i < nc; i++) {
         unsigned short idx = (u[i].h << 8) + u[i].l;
-        if (idx != unicodetoupper(idx, langnum)) {
-            u[i].h = (unsigned char) (unicodetoupper(idx, langnum) >> 8);
-            u[i].l = (unsigned char) (unicodetoupper(idx, langnum) & 0x00FF);
+        unsigned short upper = unicodetoupper(idx, langnum);
+        if (idx != upper) {
+            u[i].h = (unsigned char) (upper >> 8);
+            u[i].l = (unsigned char) (upper & 0x00FF);
         }
     }
 }
@@ -5618,20 +5658,30 @@ int get_lang_num(const char * lang) {
 int initialize_utf_tbl() {
   utf_tbl_count++;
   if (utf_tbl) return 0;
-  utf_tbl = (unicode_info2 *) malloc(CONTSIZE * sizeof(unicode_info2));
-  if (utf_tbl) {
-    size_t j;
-    for (j = 0; j < CONTSIZE; j++) {
-      utf_tbl[j].cletter = 0;
-      utf_tbl[j].clower = (unsigned short) j;
-      utf_tbl[j].cupper = (unsigned short) j;
-    }
-    for (j = 0; j < UTF_LST_LEN; j++) {
-      utf_tbl[utf_lst[j].c].cletter = 1;
-      utf_tbl[utf_lst[j].c].clower = utf_lst[j].clower;
-      utf_tbl[utf_lst[j].c].cupper = utf_lst[j].cupper;
+  struct unicode_info2 * flat = (unicode_info2 *) calloc(CONTSIZE, sizeof(unicode_info2));
+  if (!flat) return 1;
+  size_t j;
+  for (j = 0; j < UTF_LST_LEN; j++) {
+    flat[utf_lst[j].c].cletter = 1;
+    flat[utf_lst[j].c].clower = (unsigned short) (utf_lst[j].clower - utf_lst[j].c);
+    flat[utf_lst[j].c].cupper = (unsigned short) (utf_lst[j].cupper - utf_lst[j].c);
+  }
+  // keep the distinct blocks at the front of the flat table
+  const size_t blksize = 256 * sizeof(unicode_info2);
+  unsigned char blk[256];
+  int nblk = 0;
+  for (j = 0; j < 256; j++) {
+    int k = 0;
+    while (k < nblk && memcmp(flat + (k << 8), flat + (j << 8), blksize) != 0) k++;
+    if (k == nblk) {
+      if (k != (int) j) memcpy(flat + (k << 8), flat + (j << 8), blksize);
+      nblk++;
     }
-  } else return 1;
+    blk[j] = (unsigned char) k;
+  }
+  unicode_info2 * shrunk = (unicode_info2 *) realloc(flat, nblk * blksize);
+  utf_tbl = shrunk ? shrunk : flat;
+  for (j = 0; j < 256; j++) utf_blk[j] = utf_tbl + (blk[j] << 8);
   return 0;
 }
 #endif
@@ -5658,7 +5708,7 @@ unsigned short unicodetoupper(unsigned short c, int langnum)
 #ifdef MOZILLA_CLIENT
   return ToUpperCase((PRUnichar) c);
 #else
-  return (utf_tbl) ? utf_tbl[c].cupper : c;
+  return (utf_tbl) ? (unsigned short) (c + UTF_INFO(c)->cupper) : c;
 #endif
 #endif
 }
@@ -5676,7 +5726,7 @@ unsigned short unicodetolower(unsigned short c, int langnum)
 #ifdef MOZILLA_CLIENT
   return ToLowerCase((PRUnichar) c);
 #else
-  return (utf_tbl) ? utf_tbl[c].clower : c;
+  return (utf_tbl) ? (unsigned short) (c + UTF_INFO(c)->clower) : c;
 #endif
 #endif
 }
@@ -5686,7 +5736,7 @@ int unicodeisalpha(unsigned short c)
 #ifdef OPENOFFICEORG
   return u_isalpha(c);
 #else
-  return (utf_tbl) ? utf_tbl[c].cletter : 0;
+  return (utf_tbl) ? UTF_INFO(c)->cletter : 0;
 #endif
 }
 
@@ -5730,8 +5780,9 @@ int get_captype_utf8(w_char * word, int nl, int langnum) {
    if (nl == -1) return NOCAP;
    for (int i = 0; i < nl; i++) {
      idx = (word[i].h << 8) + word[i].l;
-     if (idx != unicodetolower(idx, langnum)) ncap++;
-     if (unicodetoupper(idx, langnum) == unicodetolower(idx, langnum)) nneutral++;
+     unsigned short lower = unicodetolower(idx, langnum);
+     if (idx != lower) ncap++;
+     if (unicodetoupper(idx, langnum) == lower) nneutral++;
    }
    if (ncap) {
       idx = (word[0].h << 8) + word[0].l;
@@ -5832,3 +5883,18 @@ int parse_array(char * line, char ** out, unsigned short ** out_utf16,
    }
    return 0;
 }
+
+unsigned long long monotonic_usec()
+{
+#ifdef _WIN32
+   LARGE_INTEGER freq, count;
+   QueryPerformanceFrequency(&freq);
+   QueryPerformanceCounter(&count);
+   return (unsigned long long) (count.QuadPart / freq.QuadPart) * 1000000 +
+       (unsigned long long) (count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (unsigned long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
@@ -178,6 +178,9 @@ LIBHUNSPELL_DLL_EXPORTED int morphcmp(const char * s, const char * t);
 
 LIBHUNSPELL_DLL_EXPORTED int get_sfxcount(const char * morph);
 
+// monotonic time in microseconds (deadline of the suggestion search)
+LIBHUNSPELL_DLL_EXPORTED unsigned long long monotonic_usec();
+
 // conversion function for protected memory
 LIBHUNSPELL_DLL_EXPORTED void store_pointer(char * dest, char * source);
 
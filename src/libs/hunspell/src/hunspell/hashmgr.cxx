@@ -5,11 +5,186 @@
 #include <string.h>
 #include <stdio.h> 
 #include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef CRITICAL_SECTION ngram_lock_t;
+#define LOCK_INIT(l) InitializeCriticalSection(l)
+#define LOCK_DESTROY(l) DeleteCriticalSection(l)
+#define LOCK(l) EnterCriticalSection(l)
+#define UNLOCK(l) LeaveCriticalSection(l)
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+typedef pthread_mutex_t ngram_lock_t;
+#define LOCK_INIT(l) pthread_mutex_init(l, NULL)
+#define LOCK_DESTROY(l) pthread_mutex_destroy(l)
+#define LOCK(l) pthread_mutex_lock(l)
+#define UNLOCK(l) pthread_mutex_unlock(l)
+#endif
 
 #include "hashmgr.hxx"
 #include "csutil.hxx"
 #include "atypes.hxx"
 
+// compiled dictionary image (see HashMgr::write_compiled)
+
+#define HDIC_MAGIC "HUNDIC\0"
+#define HDIC_VERSION 3
+#define ARENA_BLOCK 65536
+#define HDIC_ALIGN 8
+
+struct hdic_header {
+  char magic[8];
+  unsigned int version;
+  unsigned int pointer_size; // images are only valid on machines with the
+  unsigned int byte_order;   // pointer size and byte order they were built on
+  int tablesize;
+  unsigned long long dic_size; // the source files the image was made from
+  unsigned long long dic_mtime;
+  unsigned long long aff_size;
+  unsigned long long aff_mtime;
+  unsigned long long table_offset;
+  unsigned long long index_offset;
+  unsigned long long index_size; // slots, a power of two
+  unsigned long long flags_offset;
+  unsigned long long entries_offset;
+  unsigned long long image_size;
+};
+
+static size_t hdic_align(size_t n)
+{
+    return (n + HDIC_ALIGN - 1) & ~((size_t) HDIC_ALIGN - 1);
+}
+
+// FNV-1a hash of a word for the lookup index; also returns the first bytes
+static unsigned int index_hash(const char * word, unsigned int * prefix)
+{
+    const unsigned char * p = (const unsigned char *) word;
+    unsigned int h = 2166136261U;
+    unsigned int pre = 0;
+    int i = 0;
+    for (; *p && i < 4; p++, i++) {
+        pre |= (unsigned int) *p << (i * 8);
+        h = (h ^ *p) * 16777619U;
+    }
+    for (; *p; p++) h = (h ^ *p) * 16777619U;
+    *prefix = pre;
+    return h;
+}
+
+// the table and the index refer to the entries relative to their own slots,
+// like the entries refer to each other
+static struct hentry * table_entry(const ptrdiff_t * slot)
+{
+    return (struct hentry *) HENTRY_LINK(slot, *slot);
+}
+
+static void set_table_entry(ptrdiff_t * slot, struct hentry * hp)
+{
+    *slot = HENTRY_REL(slot, hp);
+}
+
+static struct hentry * slot_entry(const struct hindex * slot)
+{
+    return (struct hentry *) HENTRY_LINK(slot, slot->entry_rel);
+}
+
+static void set_slot_entry(struct hindex * slot, struct hentry * hp)
+{
+    slot->entry_rel = HENTRY_REL(slot, hp);
+}
+
+// morphological description of an entry, or NULL
+static const char * hdic_entry_desc(const struct hentry * hp)
+{
+    return (hp->var & H_OPT) ? HENTRY_DATA2(hp) : NULL;
+}
+
+static size_t hdic_entry_size(const struct hentry * hp)
+{
+    size_t size = sizeof(struct hentry) + hp->blen;
+    const char * desc = hdic_entry_desc(hp);
+    if (desc) size += strlen(desc) + 1;
+    return hdic_align(size);
+}
+
+// size and modification time of a source file: an image is used only
+// while both are the same as when it was made
+static int hdic_stat(const char * path, unsigned long long * size, unsigned long long * mtime)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) return 1;
+    *size = (unsigned long long) st.st_size;
+    *mtime = (unsigned long long) st.st_mtime;
+    return 0;
+}
+
+// map a file read-only; hdic_writable() turns it copy-on-write later
+static char * hdic_map(const char * path, size_t * size)
+{
+    char * data = NULL;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER len;
+    if (GetFileSizeEx(file, &len) && len.QuadPart > 0 &&
+        (unsigned long long) len.QuadPart <= (size_t) -1) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapping) {
+            data = (char *) MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+            *size = (size_t) len.QuadPart;
+            DWORD old;
+            if (data && !VirtualProtect(data, *size, PAGE_READONLY, &old)) {
+                UnmapViewOfFile(data);
+                data = NULL;
+            }
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void * p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data = (char *) p;
+            *size = (size_t) st.st_size;
+        }
+    }
+    close(fd);
+#endif
+    return data;
+}
+
+// allow writes to a mapped image, the written pages become private copies
+static int hdic_writable(char * data, size_t size)
+{
+#ifdef _WIN32
+    DWORD old;
+    return !VirtualProtect(data, size, PAGE_WRITECOPY, &old);
+#else
+    return mprotect(data, size, PROT_READ | PROT_WRITE) != 0;
+#endif
+}
+
+static void hdic_unmap(char * data, size_t size)
+{
+#ifdef _WIN32
+    (void) size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
 // build a hash table from a munched word list
 
 HashMgr::HashMgr(const char * tpath, const char * apath, const char * key)
@@ -30,8 +205,32 @@ HashMgr::HashMgr(const char * tpath, const char * apath, const char * key)
   aliasf = NULL;
   numaliasm = 0;
   aliasm = NULL;
+  image = NULL;
+  image_size = 0;
+  image_writable = 0;
+  index = NULL;
+  index_mask = 0;
+  index_count = 0;
+  arena = NULL;
+  arena_pos = NULL;
+  arena_left = 0;
+  ngram_words = NULL;
+  ngram_nwords = 0;
+  ngram_table = NULL;
+  ngram_mask = 0;
+  ngram_count = 0;
+  ngram_postings = NULL;
+  ngram_extra = NULL;
+  ngram_nextra = 0;
+  ngram_minwords = NGRAM_INDEX_MINWORDS;
+  ngram_ncandidates = NGRAM_CANDIDATES;
+  ngram_built = 0;
+  ngram_lock = malloc(sizeof(ngram_lock_t));
+  if (ngram_lock) LOCK_INIT((ngram_lock_t *) ngram_lock);
   forbiddenword = FORBIDDENWORD; // forbidden word signing flag
   load_config(apath, key);
+  // prefer an up-to-date compiled image of the dictionary (not for encrypted ones)
+  if (!key && load_compiled(tpath, apath)) return;
   int ec = load_tables(tpath, key);
   if (ec) {
     /* error condition - what should we do here */
@@ -41,6 +240,10 @@ HashMgr::HashMgr(const char * tpath, const char * apath, const char * key)
       tableptr = NULL;
     }
     tablesize = 0;
+    free(index);
+    index = NULL;
+    index_mask = 0;
+    index_count = 0;
   }
 }
 
@@ -51,18 +254,32 @@ HashMgr::~HashMgr()
     // now pass through hash table freeing up everything
     // go through column by column of the table
     for (int i=0; i < tablesize; i++) {
-      struct hentry * pt = tableptr[i];
+      struct hentry * pt = table_entry(&tableptr[i]);
       struct hentry * nt = NULL;
       while(pt) {
-        nt = pt->next;
-        if (pt->astr && (!aliasf || TESTAFF(pt->astr, ONLYUPCASEFLAG, pt->alen))) free(pt->astr);
-        free(pt);
+        nt = HENTRY_NEXT(pt);
+        unsigned short * astr = HENTRY_ASTR(pt);
+        if (astr && !in_image(astr) &&
+            (!aliasf || TESTAFF(astr, ONLYUPCASEFLAG, pt->alen))) free(astr);
         pt = nt;
       }
     }
-    free(tableptr);
+    if (!in_image(tableptr)) free(tableptr);
   }
   tablesize = 0;
+  if (!in_image(index)) free(index);
+  free_ngram_index();
+  if (ngram_lock) {
+    LOCK_DESTROY((ngram_lock_t *) ngram_lock);
+    free(ngram_lock);
+  }
+  // entries live in the arena blocks (or in the image)
+  while (arena) {
+    char * prev = *((char **) arena);
+    free(arena);
+    arena = prev;
+  }
+  if (image) hdic_unmap(image, image_size);
 
   if (aliasf) {
     for (int j = 0; j < (numaliasf); j++) free(aliasf[j]);
@@ -100,26 +317,365 @@ HashMgr::~HashMgr()
 
 struct hentry * HashMgr::lookup(const char *word) const
 {
-    struct hentry * dp;
-    if (tableptr) {
-       dp = tableptr[hash(word)];
-       if (!dp) return NULL;
-       for (  ;  dp != NULL;  dp = dp->next) {
-          if (strcmp(word, dp->word) == 0) return dp;
-       }
+    if (!index) return NULL;
+    unsigned int prefix;
+    unsigned int h = index_hash(word, &prefix);
+    for (unsigned int i = h & index_mask; index[i].entry_rel; i = (i + 1) & index_mask) {
+        if (index[i].hash == h && index[i].prefix == prefix &&
+            strcmp(word, slot_entry(&index[i])->word) == 0) return slot_entry(&index[i]);
+    }
+    return NULL;
+}
+
+// entries are carved out of large blocks instead of being malloc'ed one by one
+struct hentry * HashMgr::alloc_entry(size_t size)
+{
+    size = hdic_align(size);
+    if (size > arena_left) {
+        size_t block = sizeof(char *) + size > ARENA_BLOCK ? sizeof(char *) + size : ARENA_BLOCK;
+        char * p = (char *) malloc(block);
+        if (!p) return NULL;
+        *((char **) p) = arena;
+        arena = p;
+        arena_pos = p + hdic_align(sizeof(char *));
+        arena_left = block - hdic_align(sizeof(char *));
+    }
+    struct hentry * hp = (struct hentry *) arena_pos;
+    arena_pos += size;
+    arena_left -= size;
+    return hp;
+}
+
+// allocate an empty index for about count words
+int HashMgr::init_index(int count)
+{
+    unsigned int size = 16;
+    while (size < (unsigned int) count * 2) size <<= 1;
+    struct hindex * slots = (struct hindex *) calloc(size, sizeof(struct hindex));
+    if (!slots) return 1;
+    if (!in_image(index)) free(index);
+    index = slots;
+    index_mask = size - 1;
+    index_count = 0;
+    return 0;
+}
+
+// add the first entry of a word to the index, homonyms are reached from it
+int HashMgr::index_add(struct hentry * hp)
+{
+    if ((unsigned int) (index_count + 1) * 10 > (index_mask + 1) * 7) {
+        struct hindex * old = index;
+        unsigned int old_size = index_mask + 1;
+        int old_image = in_image(old);
+        index = NULL;
+        if (init_index(old_size)) {
+            index = old;
+            return 1;
+        }
+        for (unsigned int j = 0; j < old_size; j++) {
+            if (!old[j].entry_rel) continue;
+            unsigned int i = old[j].hash & index_mask;
+            while (index[i].entry_rel) i = (i + 1) & index_mask;
+            index[i] = old[j];
+            set_slot_entry(&index[i], slot_entry(&old[j]));
+            index_count++;
+        }
+        if (!old_image) free(old);
+    }
+    unsigned int prefix;
+    unsigned int h = index_hash(hp->word, &prefix);
+    unsigned int i = h & index_mask;
+    for (; index[i].entry_rel; i = (i + 1) & index_mask) {
+        if (index[i].hash == h && index[i].prefix == prefix &&
+            strcmp(hp->word, slot_entry(&index[i])->word) == 0) return 0;
+    }
+    index[i].hash = h;
+    index[i].prefix = prefix;
+    set_slot_entry(&index[i], hp);
+    index_count++;
+    return 0;
+}
+
+static unsigned int ngram_hash(unsigned long long key)
+{
+    return (unsigned int) ((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+// trigrams of a word as keys (optionally lowercased like the dictionary words
+// scored by SuggestMgr::ngram()), -1 if the word has non-BMP characters
+int HashMgr::ngram_keys(const char * word, unsigned long long * keys, int lower) const
+{
+    int n = 0;
+    if (utf8) {
+        w_char w[MAXWORDUTF8LEN];
+        int wl = u8_u16(w, MAXWORDUTF8LEN, word);
+        if (wl == -1) return -1;
+        if (lower) mkallsmall_utf(w, wl, langnum);
+        for (int i = 0; i + 2 < wl; i++) {
+            keys[n++] = (1ULL << 63) |
+                ((unsigned long long) ((w[i].h << 8) | w[i].l) << 32) |
+                ((unsigned long long) ((w[i + 1].h << 8) | w[i + 1].l) << 16) |
+                (unsigned long long) ((w[i + 2].h << 8) | w[i + 2].l);
+        }
+    } else {
+        char t[MAXWORDUTF8LEN];
+        strncpy(t, word, MAXWORDUTF8LEN - 1);
+        t[MAXWORDUTF8LEN - 1] = '\0';
+        if (lower) mkallsmall(t, csconv);
+        const unsigned char * c = (const unsigned char *) t;
+        for (int i = 0; c[i] && c[i + 1] && c[i + 2]; i++) {
+            keys[n++] = (1ULL << 63) | ((unsigned long long) c[i] << 16) |
+                ((unsigned long long) c[i + 1] << 8) | c[i + 2];
+        }
+    }
+    return n;
+}
+
+// trigrams of an entry: of the word and of its special pronunciation
+int HashMgr::ngram_entry_keys(struct hentry * hp, unsigned long long * keys) const
+{
+    int n = ngram_keys(HENTRY_WORD(hp), keys, 1);
+    if (n < 0) n = 0;
+    char ph[MAXWORDUTF8LEN * 2];
+    if ((hp->var & H_OPT_PHON) && strlen(HENTRY_DATA(hp)) < sizeof(ph) &&
+        copy_field(ph, HENTRY_DATA(hp), MORPH_PHON)) {
+        int m = ngram_keys(ph, keys + n, 1);
+        if (m > 0) n += m;
+    }
+    return n;
+}
+
+const struct hngram * HashMgr::ngram_find(unsigned long long key) const
+{
+    for (unsigned int i = ngram_hash(key) & ngram_mask; ngram_table[i].key; i = (i + 1) & ngram_mask) {
+        if (ngram_table[i].key == key) return &ngram_table[i];
     }
     return NULL;
 }
 
+// slot of a trigram, added (growing the table) if insert is set
+struct hngram * HashMgr::ngram_slot(unsigned long long key, int insert)
+{
+    unsigned int i = ngram_hash(key) & ngram_mask;
+    for (; ngram_table[i].key; i = (i + 1) & ngram_mask) {
+        if (ngram_table[i].key == key) return &ngram_table[i];
+    }
+    if (!insert) return NULL;
+    if ((ngram_count + 1) * 10 > (ngram_mask + 1) * 7) {
+        unsigned int old_size = ngram_mask + 1;
+        struct hngram * old = ngram_table;
+        ngram_table = (struct hngram *) calloc(old_size * 2, sizeof(struct hngram));
+        if (!ngram_table) {
+            ngram_table = old;
+            return NULL;
+        }
+        ngram_mask = old_size * 2 - 1;
+        for (unsigned int j = 0; j < old_size; j++) {
+            if (!old[j].key) continue;
+            unsigned int k = ngram_hash(old[j].key) & ngram_mask;
+            while (ngram_table[k].key) k = (k + 1) & ngram_mask;
+            ngram_table[k] = old[j];
+        }
+        free(old);
+        i = ngram_hash(key) & ngram_mask;
+        while (ngram_table[i].key) i = (i + 1) & ngram_mask;
+    }
+    ngram_table[i].key = key;
+    ngram_count++;
+    return &ngram_table[i];
+}
+
+// index the trigrams of the (lowercased) words for the n-gram suggestion,
+// so it scores only the words sharing the most trigrams with the misspelling
+int HashMgr::build_ngram_index()
+{
+    int n = 0;
+    int col = -1;
+    struct hentry * hp = NULL;
+    while ((hp = walk_hashtable(col, hp))) n++;
+    if (n < ngram_minwords) return 0;
+
+    unsigned long long keys[MAXWORDUTF8LEN * 3];
+    ngram_words = (struct hentry **) malloc(n * sizeof(struct hentry *));
+    ngram_table = (struct hngram *) calloc(4096, sizeof(struct hngram));
+    ngram_mask = 4095;
+    if (!ngram_words || !ngram_table) {
+        free_ngram_index();
+        return 1;
+    }
+
+    // count the words of each trigram
+    n = 0;
+    while ((hp = walk_hashtable(col, hp))) {
+        ngram_words[n] = hp;
+        int nk = ngram_entry_keys(hp, keys);
+        for (int k = 0; k < nk; k++) {
+            struct hngram * slot = ngram_slot(keys[k], 1);
+            if (!slot) {
+                free_ngram_index();
+                return 1;
+            }
+            if (slot->last != (unsigned int) n + 1) {
+                slot->count++;
+                slot->last = n + 1;
+            }
+        }
+        n++;
+    }
+    ngram_nwords = n;
+
+    // lay out the postings, then fill them in walk order
+    unsigned int total = 0;
+    for (unsigned int j = 0; j <= ngram_mask; j++) {
+        ngram_table[j].start = total;
+        total += ngram_table[j].count;
+        ngram_table[j].count = 0;
+        ngram_table[j].last = 0;
+    }
+    ngram_postings = (unsigned int *) malloc((total ? total : 1) * sizeof(unsigned int));
+    if (!ngram_postings) {
+        free_ngram_index();
+        return 1;
+    }
+    for (int i = 0; i < ngram_nwords; i++) {
+        int nk = ngram_entry_keys(ngram_words[i], keys);
+        for (int k = 0; k < nk; k++) {
+            struct hngram * slot = ngram_slot(keys[k], 0);
+            if (slot->last != (unsigned int) i + 1) {
+                ngram_postings[slot->start + slot->count++] = i;
+                slot->last = i + 1;
+            }
+        }
+    }
+    return 0;
+}
+
+void HashMgr::free_ngram_index()
+{
+    free(ngram_words);
+    free(ngram_table);
+    free(ngram_postings);
+    free(ngram_extra);
+    ngram_words = NULL;
+    ngram_nwords = 0;
+    ngram_table = NULL;
+    ngram_mask = 0;
+    ngram_count = 0;
+    ngram_postings = NULL;
+    ngram_extra = NULL;
+    ngram_nextra = 0;
+}
+
+// words added at run time are scored for every misspelling
+int HashMgr::ngram_add(struct hentry * hp)
+{
+    if (!ngram_postings) return 0;
+    struct hentry ** extra = (struct hentry **)
+        realloc(ngram_extra, (ngram_nextra + 1) * sizeof(struct hentry *));
+    if (!extra) return 1;
+    ngram_extra = extra;
+    ngram_extra[ngram_nextra++] = hp;
+    return 0;
+}
+
+// dictionaries of at least minwords words get the index, 0 indexes all;
+// an index built with another minimum is dropped
+void HashMgr::set_ngram_minwords(int minwords)
+{
+    if (!ngram_lock || minwords == ngram_minwords) return;
+    LOCK((ngram_lock_t *) ngram_lock);
+    ngram_minwords = minwords;
+    free_ngram_index();
+    ngram_built = 0;
+    UNLOCK((ngram_lock_t *) ngram_lock);
+}
+
+// the index prunes the n-gram suggestion to about candidates words (at
+// least one), the index itself stays the same
+void HashMgr::set_ngram_candidates(int candidates)
+{
+    if (!ngram_lock) return;
+    LOCK((ngram_lock_t *) ngram_lock);
+    ngram_ncandidates = candidates > 0 ? candidates : 1;
+    UNLOCK((ngram_lock_t *) ngram_lock);
+}
+
+// candidates of the n-gram suggestion in walk order: the words sharing the
+// most trigrams with the word (at least ngram_ncandidates of them, if there
+// are so many) and the words added at run time. The list is allocated.
+// Returns -1 without an index, then all entries have to be walked.
+// The index is built here the first time, so loading does not pay for it.
+int HashMgr::ngram_candidates(const char * word, struct hentry *** list)
+{
+    *list = NULL;
+    if (!ngram_lock) return -1;
+    LOCK((ngram_lock_t *) ngram_lock);
+    if (!ngram_built) {
+        build_ngram_index();
+        ngram_built = 1;
+    }
+    const int ncandidates = ngram_ncandidates;
+    UNLOCK((ngram_lock_t *) ngram_lock);
+    if (!ngram_postings) return -1;
+    unsigned long long keys[MAXWORDUTF8LEN];
+    int nk = ngram_keys(word, keys, 0);
+    if (nk < NGRAM_MINKEYS) return -1;
+    unsigned char * hits = (unsigned char *) calloc(ngram_nwords, 1);
+    if (!hits) return -1;
+    for (int k = 0; k < nk; k++) {
+        int j = 0;
+        while (j < k && keys[j] != keys[k]) j++;
+        if (j < k) continue; // repeated trigram
+        const struct hngram * slot = ngram_find(keys[k]);
+        if (!slot) continue;
+        const unsigned int * p = ngram_postings + slot->start;
+        for (unsigned int i = 0; i < slot->count; i++) {
+            if (hits[p[i]] < 255) hits[p[i]]++;
+        }
+    }
+
+    // lowest number of shared trigrams still giving enough candidates;
+    // words sharing none only fill the list up to ncandidates (so a
+    // dictionary with no more words has all of them scored)
+    int hist[256];
+    memset(hist, 0, sizeof(hist));
+    for (int i = 0; i < ngram_nwords; i++) hist[hits[i]]++;
+    int min = 255;
+    int n = hist[min];
+    while (min > 1 && n < ncandidates) n += hist[--min];
+    int fill = 0;
+    if (min == 1 && n < ncandidates) {
+        min = 0;
+        fill = ncandidates - n;
+        if (fill > hist[0]) fill = hist[0];
+        n += fill;
+    }
+
+    struct hentry ** cand = (struct hentry **)
+        malloc((n + ngram_nextra + 1) * sizeof(struct hentry *));
+    if (!cand) {
+        free(hits);
+        return -1;
+    }
+    n = 0;
+    for (int i = 0; i < ngram_nwords; i++) {
+        if (hits[i] >= min && (hits[i] || fill-- > 0)) cand[n++] = ngram_words[i];
+    }
+    for (int i = 0; i < ngram_nextra; i++) cand[n++] = ngram_extra[i];
+    free(hits);
+    *list = cand;
+    return n;
+}
+
 // add a word to the hash table (private)
 int HashMgr::add_word(const char * word, int wbl, int wcl, unsigned short * aff,
     int al, const char * desc, bool onlyupcase)
 {
     bool upcasehomonym = false;
     int descl = desc ? (aliasm ? sizeof(short) : strlen(desc) + 1) : 0;
+    if (make_writable()) return 1;
     // variable-length hash record with word and optional fields
-    struct hentry* hp = 
-	(struct hentry *) malloc (sizeof(struct hentry) + wbl + descl);
+    struct hentry* hp = alloc_entry(sizeof(struct hentry) + wbl + descl);
     if (!hp) return 1;
     char * hpw = hp->word;
     strcpy(hpw, word);
@@ -139,9 +695,9 @@ int HashMgr::add_word(const char * word, int wbl, int wcl, unsigned short * aff,
     hp->blen = (unsigned char) wbl;
     hp->clen = (unsigned char) wcl;
     hp->alen = (short) al;
-    hp->astr = aff;
-    hp->next = NULL;      
-    hp->next_homonym = NULL;
+    HENTRY_SET_ASTR(hp, aff);
+    HENTRY_SET_NEXT(hp, NULL);
+    HENTRY_SET_HOMONYM(hp, NULL);
 
     // store the description string or its pointer
     if (desc) {
@@ -159,52 +715,50 @@ int HashMgr::add_word(const char * word, int wbl, int wcl, unsigned short * aff,
 	if (strstr(HENTRY_DATA(hp), MORPH_PHON)) hp->var += H_OPT_PHON;
     } else hp->var = 0;
 
-       struct hentry * dp = tableptr[i];
+       struct hentry * dp = table_entry(&tableptr[i]);
        if (!dp) {
-         tableptr[i] = hp;
-         return 0;
+         set_table_entry(&tableptr[i], hp);
+         return index_add(hp) || ngram_add(hp);
        }
-       while (dp->next != NULL) {
-         if ((!dp->next_homonym) && (strcmp(hp->word, dp->word) == 0)) {
+       while (HENTRY_NEXT(dp) != NULL) {
+         if ((!HENTRY_HOMONYM(dp)) && (strcmp(hp->word, dp->word) == 0)) {
     	    // remove hidden onlyupcase homonym
             if (!onlyupcase) {
-		if ((dp->astr) && TESTAFF(dp->astr, ONLYUPCASEFLAG, dp->alen)) {
-		    free(dp->astr);
-		    dp->astr = hp->astr;
+		if ((HENTRY_ASTR(dp)) && TESTAFF(HENTRY_ASTR(dp), ONLYUPCASEFLAG, dp->alen)) {
+		    if (!in_image(HENTRY_ASTR(dp))) free(HENTRY_ASTR(dp));
+		    HENTRY_SET_ASTR(dp, aff);
 		    dp->alen = hp->alen;
-		    free(hp);
 		    return 0;
 		} else {
-    		    dp->next_homonym = hp;
+    		    HENTRY_SET_HOMONYM(dp, hp);
     		}
             } else {
         	upcasehomonym = true;
             }
          }
-         dp=dp->next;
+         dp=HENTRY_NEXT(dp);
        }
        if (strcmp(hp->word, dp->word) == 0) {
     	    // remove hidden onlyupcase homonym
             if (!onlyupcase) {
-		if ((dp->astr) && TESTAFF(dp->astr, ONLYUPCASEFLAG, dp->alen)) {
-		    free(dp->astr);
-		    dp->astr = hp->astr;
+		if ((HENTRY_ASTR(dp)) && TESTAFF(HENTRY_ASTR(dp), ONLYUPCASEFLAG, dp->alen)) {
+		    if (!in_image(HENTRY_ASTR(dp))) free(HENTRY_ASTR(dp));
+		    HENTRY_SET_ASTR(dp, aff);
 		    dp->alen = hp->alen;
-		    free(hp);
 		    return 0;
 		} else {
-    		    dp->next_homonym = hp;
+    		    HENTRY_SET_HOMONYM(dp, hp);
     		}
             } else {
         	upcasehomonym = true;
             }
        }
        if (!upcasehomonym) {
-    	    dp->next = hp;
+    	    HENTRY_SET_NEXT(dp, hp);
+    	    return index_add(hp) || ngram_add(hp);
        } else {
     	    // remove hidden onlyupcase homonym
-    	    if (hp->astr) free(hp->astr);
-    	    free(hp);
+    	    if (aff) free(aff);
        }
     return 0;
 }     
@@ -257,18 +811,19 @@ int HashMgr::get_clen_and_captype(const char * word, int wbl, int * captype) {
 int HashMgr::remove(const char * word)
 {
     struct hentry * dp = lookup(word);
+    if (dp && make_writable()) return 1;
     while (dp) {
-        if (dp->alen == 0 || !TESTAFF(dp->astr, forbiddenword, dp->alen)) {
+        if (dp->alen == 0 || !TESTAFF(HENTRY_ASTR(dp), forbiddenword, dp->alen)) {
             unsigned short * flags =
                 (unsigned short *) malloc(sizeof(short) * (dp->alen + 1));
             if (!flags) return 1;
-            for (int i = 0; i < dp->alen; i++) flags[i] = dp->astr[i];
+            for (int i = 0; i < dp->alen; i++) flags[i] = HENTRY_ASTR(dp)[i];
             flags[dp->alen] = forbiddenword;
-            dp->astr = flags;
+            HENTRY_SET_ASTR(dp, flags);
             dp->alen++;
             flag_qsort(flags, 0, dp->alen);
         }
-        dp = dp->next_homonym;
+        dp = HENTRY_HOMONYM(dp);
     }
     return 0;
 }
@@ -277,8 +832,9 @@ int HashMgr::remove(const char * word)
 int HashMgr::remove_forbidden_flag(const char * word) {
     struct hentry * dp = lookup(word);
     if (!dp) return 1;
+    if (make_writable()) return 0;
     while (dp) {
-         if (dp->astr && TESTAFF(dp->astr, forbiddenword, dp->alen)) {
+         if (HENTRY_ASTR(dp) && TESTAFF(HENTRY_ASTR(dp), forbiddenword, dp->alen)) {
             if (dp->alen == 1) dp->alen = 0; // XXX forbidden words of personal dic.
             else {
                 unsigned short * flags2 =
@@ -286,13 +842,13 @@ int HashMgr::remove_forbidden_flag(const char * word) {
                 if (!flags2) return 1;
                 int i, j = 0;
                 for (i = 0; i < dp->alen; i++) {
-                    if (dp->astr[i] != forbiddenword) flags2[j++] = dp->astr[i];
+                    if (HENTRY_ASTR(dp)[i] != forbiddenword) flags2[j++] = HENTRY_ASTR(dp)[i];
                 }
                 dp->alen--;
-                dp->astr = flags2; // XXX allowed forbidden words
+                HENTRY_SET_ASTR(dp, flags2); // XXX allowed forbidden words
             }
          }
-         dp = dp->next_homonym;
+         dp = HENTRY_HOMONYM(dp);
        }
    return 0;
 }
@@ -317,20 +873,20 @@ int HashMgr::add_with_affix(const char * word, const char * example)
     // detect captype and modify word length for UTF-8 encoding
     struct hentry * dp = lookup(example);
     remove_forbidden_flag(word);
-    if (dp && dp->astr) {
+    if (dp && HENTRY_ASTR(dp)) {
         int captype;
         int wbl = strlen(word);
         int wcl = get_clen_and_captype(word, wbl, &captype);
 	if (aliasf) {
-	    add_word(word, wbl, wcl, dp->astr, dp->alen, NULL, false);	
+	    add_word(word, wbl, wcl, HENTRY_ASTR(dp), dp->alen, NULL, false);	
 	} else {
     	    unsigned short * flags = (unsigned short *) malloc (dp->alen * sizeof(short));
 	    if (flags) {
-		memcpy((void *) flags, (void *) dp->astr, dp->alen * sizeof(short));
+		memcpy((void *) flags, (void *) HENTRY_ASTR(dp), dp->alen * sizeof(short));
 		add_word(word, wbl, wcl, flags, dp->alen, NULL, false);
 	    } else return 1;
 	}
-    	return add_hidden_capitalized_word((char *) word, wbl, wcl, dp->astr, dp->alen, NULL, captype);
+    	return add_hidden_capitalized_word((char *) word, wbl, wcl, HENTRY_ASTR(dp), dp->alen, NULL, captype);
     }
     return 1;
 }
@@ -339,15 +895,323 @@ int HashMgr::add_with_affix(const char * word, const char * example)
 // initialize: col=-1; hp = NULL; hp = walk_hashtable(&col, hp);
 struct hentry * HashMgr::walk_hashtable(int &col, struct hentry * hp) const
 {  
-  if (hp && hp->next != NULL) return hp->next;
+  if (hp && HENTRY_NEXT(hp) != NULL) return HENTRY_NEXT(hp);
   for (col++; col < tablesize; col++) {
-    if (tableptr[col]) return tableptr[col];
+    if (tableptr[col]) return table_entry(&tableptr[col]);
   }
   // null at end and reset to start
   col = -1;
   return NULL;
 }
 
+// file name of the compiled image of a dictionary: foo.dic -> foo.hdic
+char * HashMgr::compiled_path(const char * tpath)
+{
+    size_t len = strlen(tpath);
+    if (len >= 4 && strcmp(tpath + len - 4, ".dic") == 0) len -= 4;
+    char * path = (char *) malloc(len + 6);
+    if (!path) return NULL;
+    memcpy(path, tpath, len);
+    strcpy(path + len, ".hdic");
+    return path;
+}
+
+int HashMgr::in_image(const void * p) const
+{
+    return image && (const char *) p >= image && (const char *) p < image + image_size;
+}
+
+// a mapped image is read-only until the first word is added or removed
+int HashMgr::make_writable()
+{
+    if (!image || image_writable) return 0;
+    if (hdic_writable(image, image_size)) {
+        HUNSPELL_WARNING(stderr, "error: can't modify the compiled dictionary\n");
+        return 1;
+    }
+    image_writable = 1;
+    return 0;
+}
+
+// Write the hash table into a compiled image: the table, lookup index, flag
+// vectors and entries laid out in one block. The links are relative (see
+// htypes.hxx), so load_compiled() uses the image read-only as it is mapped,
+// which skips parsing, hashing and allocating every entry of the .dic file.
+int HashMgr::write_compiled(const char * outpath, const char * tpath, const char * apath) const
+{
+    if (!tableptr || !index) return 1;
+
+    struct hdic_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, HDIC_MAGIC, sizeof(hdr.magic));
+    hdr.version = HDIC_VERSION;
+    hdr.pointer_size = sizeof(void *);
+    hdr.byte_order = 0x01020304;
+    hdr.tablesize = tablesize;
+    if (hdic_stat(tpath, &hdr.dic_size, &hdr.dic_mtime) ||
+        hdic_stat(apath, &hdr.aff_size, &hdr.aff_mtime)) {
+        HUNSPELL_WARNING(stderr, "error: can't read %s or %s\n", tpath, apath);
+        return 1;
+    }
+
+    // sizes of the regions: shared alias flag vectors come first in the flags
+    size_t flags_size = 0;
+    size_t entries_size = 0;
+    int i, j;
+    for (j = 0; j < numaliasf; j++) flags_size += aliasflen[j] * sizeof(unsigned short);
+    for (i = 0; i < tablesize; i++) {
+        for (struct hentry * dp = table_entry(&tableptr[i]); dp; dp = HENTRY_NEXT(dp)) {
+            if (HENTRY_ASTR(dp) && dp->alen > 0) {
+                for (j = 0; j < numaliasf && HENTRY_ASTR(dp) != aliasf[j]; j++);
+                if (j == numaliasf) flags_size += dp->alen * sizeof(unsigned short);
+            }
+            entries_size += hdic_entry_size(dp);
+        }
+    }
+    hdr.table_offset = hdic_align(sizeof(hdr));
+    hdr.index_offset = hdr.table_offset + hdic_align(tablesize * sizeof(ptrdiff_t));
+    hdr.index_size = index_mask + 1;
+    hdr.flags_offset = hdr.index_offset + hdic_align((index_mask + 1) * sizeof(struct hindex));
+    hdr.entries_offset = hdr.flags_offset + hdic_align(flags_size);
+    hdr.image_size = hdr.entries_offset + entries_size;
+
+    char * out = (char *) calloc(1, (size_t) hdr.image_size);
+    if (!out) return 1;
+    memcpy(out, &hdr, sizeof(hdr));
+    ptrdiff_t * table = (ptrdiff_t *) (out + hdr.table_offset);
+    struct hindex * slots = (struct hindex *) (out + hdr.index_offset);
+    memcpy(slots, index, (index_mask + 1) * sizeof(struct hindex));
+    for (unsigned int k = 0; k <= index_mask; k++) slots[k].entry_rel = 0;
+
+    size_t * alias_offsets = NULL;
+    if (numaliasf) {
+        alias_offsets = (size_t *) malloc(numaliasf * sizeof(size_t));
+        if (!alias_offsets) {
+            free(out);
+            return 1;
+        }
+    }
+    size_t flags_pos = (size_t) hdr.flags_offset;
+    for (j = 0; j < numaliasf; j++) {
+        alias_offsets[j] = flags_pos;
+        memcpy(out + flags_pos, aliasf[j], aliasflen[j] * sizeof(unsigned short));
+        flags_pos += aliasflen[j] * sizeof(unsigned short);
+    }
+
+    size_t pos = (size_t) hdr.entries_offset;
+    for (i = 0; i < tablesize; i++) {
+        if (!tableptr[i]) continue;
+        table[i] = (ptrdiff_t) (pos - (size_t) hdr.table_offset - i * sizeof(ptrdiff_t));
+        for (struct hentry * dp = table_entry(&tableptr[i]); dp; dp = HENTRY_NEXT(dp)) {
+            struct hentry * hp = (struct hentry *) (out + pos);
+            size_t size = hdic_entry_size(dp);
+            unsigned int prefix;
+            unsigned int k = index_hash(dp->word, &prefix) & index_mask;
+            for (; index[k].entry_rel; k = (k + 1) & index_mask) {
+                if (slot_entry(&index[k]) == dp) {
+                    slots[k].entry_rel = (ptrdiff_t)
+                        (pos - (size_t) hdr.index_offset - k * sizeof(struct hindex));
+                    break;
+                }
+            }
+            memcpy(hp, dp, sizeof(struct hentry) + dp->blen);
+            // descriptions are stored inline, also the ones given by an alias
+            const char * desc = hdic_entry_desc(dp);
+            if (desc) {
+                strcpy(HENTRY_WORD(hp) + hp->blen + 1, desc);
+                hp->var &= ~H_OPT_ALIASM;
+            } else {
+                hp->var = 0;
+            }
+            size_t astr = 0;
+            if (HENTRY_ASTR(dp) && dp->alen > 0) {
+                for (j = 0; j < numaliasf && HENTRY_ASTR(dp) != aliasf[j]; j++);
+                if (j < numaliasf) {
+                    astr = alias_offsets[j];
+                } else {
+                    memcpy(out + flags_pos, HENTRY_ASTR(dp), dp->alen * sizeof(unsigned short));
+                    astr = flags_pos;
+                    flags_pos += dp->alen * sizeof(unsigned short);
+                }
+            }
+            hp->astr_rel = astr ? (ptrdiff_t) astr - (ptrdiff_t) pos : 0;
+            if (!astr) hp->alen = 0;
+            // homonyms are always further down the same chain
+            hp->next_rel = HENTRY_NEXT(dp) ? (ptrdiff_t) size : 0;
+            hp->homonym_rel = 0;
+            if (HENTRY_HOMONYM(dp)) {
+                size_t hpos = pos;
+                for (struct hentry * np = dp; np != HENTRY_HOMONYM(dp); np = HENTRY_NEXT(np)) {
+                    hpos += hdic_entry_size(np);
+                }
+                hp->homonym_rel = (ptrdiff_t) (hpos - pos);
+            }
+            pos += size;
+        }
+    }
+    free(alias_offsets);
+
+    // the image is written next to the old one and renamed over it, so an
+    // image mapped by a running checker is never truncated under it
+    char * tmppath = (char *) malloc(strlen(outpath) + 5);
+    if (!tmppath) {
+        free(out);
+        return 1;
+    }
+    strcpy(tmppath, outpath);
+    strcat(tmppath, ".tmp");
+    FILE * f = fopen(tmppath, "wb");
+    int ec = !f || fwrite(out, 1, (size_t) hdr.image_size, f) != hdr.image_size;
+    if (f && fclose(f)) ec = 1;
+    free(out);
+    if (!ec && ::rename(tmppath, outpath)) {
+        // Windows doesn't rename over an existing file
+        ::remove(outpath);
+        ec = ::rename(tmppath, outpath) != 0;
+    }
+    if (ec) {
+        if (f) ::remove(tmppath);
+        HUNSPELL_WARNING(stderr, "error: can't write %s\n", outpath);
+    }
+    free(tmppath);
+    return ec;
+}
+
+// offset a link at pos of the image refers to, 0 if it is outside
+static size_t hdic_target(size_t pos, ptrdiff_t rel, size_t size)
+{
+    if (rel < -(ptrdiff_t) pos || rel > (ptrdiff_t) (size - pos)) return 0;
+    return pos + rel;
+}
+
+// Check every offset of an image before it is used: the regions are in
+// order, the chains are contiguous runs of well-formed entries as
+// write_compiled() lays them out (an entry ends with the terminating zero
+// of its data field), flag vectors lie in the flags region,
+// homonyms further down the same chain and the index slots refer to
+// entries, leaving a slot free. Returns the number of indexed words, -1 if
+// the image is corrupt.
+static int hdic_check(const char * base, size_t size)
+{
+    const struct hdic_header * hdr = (const struct hdic_header *) base;
+    if (hdr->tablesize <= 0 || hdr->table_offset > size || hdr->index_offset > size ||
+        hdr->index_size > size || hdr->flags_offset > size || hdr->entries_offset > size ||
+        hdr->table_offset < sizeof(struct hdic_header) ||
+        hdr->table_offset % HDIC_ALIGN || hdr->index_offset % HDIC_ALIGN ||
+        hdr->entries_offset % HDIC_ALIGN ||
+        hdr->index_offset < hdr->table_offset + hdr->tablesize * sizeof(ptrdiff_t) ||
+        hdr->index_size == 0 || (hdr->index_size & (hdr->index_size - 1)) != 0 ||
+        hdr->flags_offset < hdr->index_offset + hdr->index_size * sizeof(struct hindex) ||
+        hdr->entries_offset < hdr->flags_offset) return -1;
+
+    const size_t table_offset = (size_t) hdr->table_offset;
+    const size_t flags_offset = (size_t) hdr->flags_offset;
+    const size_t entries_offset = (size_t) hdr->entries_offset;
+    // entry starts, a bit for every HDIC_ALIGN bytes
+    unsigned char * starts = (unsigned char *)
+        calloc((size - entries_offset) / HDIC_ALIGN / 8 + 1, 1);
+    if (!starts) return -1;
+#define HDIC_START(off) (starts[((off) - entries_offset) / HDIC_ALIGN / 8])
+#define HDIC_BIT(off) (1 << (((off) - entries_offset) / HDIC_ALIGN % 8))
+#define HDIC_IS_START(off) ((off) % HDIC_ALIGN == 0 && (HDIC_START(off) & HDIC_BIT(off)))
+
+    const ptrdiff_t * table = (const ptrdiff_t *) (base + table_offset);
+    size_t pos = entries_offset;
+    int ok = 1;
+    for (int i = 0; ok && i < hdr->tablesize; i++) {
+        if (!table[i]) continue;
+        size_t chain = pos;
+        ok = hdic_target(table_offset + i * sizeof(ptrdiff_t), table[i], size) == pos;
+        while (ok) {
+            const struct hentry * hp = (const struct hentry *) (base + pos);
+            size_t word = pos + offsetof(struct hentry, word);
+            // HENTRY_DATA() points after the word whenever var is set, so
+            // there has to be a data field for every option
+            if (pos + sizeof(struct hentry) > size || word + hp->blen >= size ||
+                memchr(hp->word, '\0', hp->blen + 1) != hp->word + hp->blen ||
+                (hp->var & ~(H_OPT | H_OPT_PHON)) || (hp->var && !(hp->var & H_OPT)) ||
+                hp->alen < 0 ||
+                (hp->var && !memchr(hp->word + hp->blen + 1, '\0', size - (word + hp->blen + 1)))) {
+                ok = 0;
+                break;
+            }
+            size_t esize = hdic_entry_size(hp);
+            size_t astr = hp->astr_rel ? hdic_target(pos, hp->astr_rel, size) : 0;
+            if (pos + esize > size || (hp->astr_rel ? astr < flags_offset || astr % 2 ||
+                astr + hp->alen * sizeof(unsigned short) > entries_offset : hp->alen != 0)) {
+                ok = 0;
+                break;
+            }
+            HDIC_START(pos) |= HDIC_BIT(pos);
+            pos += esize;
+            if (!hp->next_rel) break;
+            ok = hp->next_rel == (ptrdiff_t) esize;
+        }
+        for (size_t p = chain; ok && p < pos; p += hdic_entry_size((const struct hentry *) (base + p))) {
+            const struct hentry * hp = (const struct hentry *) (base + p);
+            size_t h = hp->homonym_rel > 0 ? hdic_target(p, hp->homonym_rel, size) : 0;
+            if (hp->homonym_rel && (!h || h >= pos || !HDIC_IS_START(h))) ok = 0;
+        }
+    }
+    if (pos != size) ok = 0;
+
+    const struct hindex * slots = (const struct hindex *) (base + hdr->index_offset);
+    size_t count = 0;
+    for (size_t j = 0; ok && j < hdr->index_size; j++) {
+        if (!slots[j].entry_rel) continue;
+        size_t e = hdic_target((size_t) hdr->index_offset + j * sizeof(struct hindex),
+            slots[j].entry_rel, size);
+        if (e < entries_offset || e >= size || !HDIC_IS_START(e)) ok = 0;
+        count++;
+    }
+    if (count >= hdr->index_size) ok = 0;
+#undef HDIC_START
+#undef HDIC_BIT
+#undef HDIC_IS_START
+    free(starts);
+    return ok ? (int) count : -1;
+}
+
+// map the compiled image of the dictionary, if there is one made from the
+// current .dic and .aff files
+int HashMgr::load_compiled(const char * tpath, const char * apath)
+{
+    char * path = compiled_path(tpath);
+    if (!path) return 0;
+    size_t size = 0;
+    char * base = hdic_map(path, &size);
+    free(path);
+    if (!base) return 0;
+
+    const struct hdic_header * hdr = (const struct hdic_header *) base;
+    unsigned long long dic_size, dic_mtime, aff_size, aff_mtime;
+    if (size < sizeof(struct hdic_header) ||
+        memcmp(hdr->magic, HDIC_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != HDIC_VERSION || hdr->pointer_size != sizeof(void *) ||
+        hdr->byte_order != 0x01020304 || hdr->image_size != size ||
+        hdic_stat(tpath, &dic_size, &dic_mtime) || hdic_stat(apath, &aff_size, &aff_mtime) ||
+        dic_size != hdr->dic_size || dic_mtime != hdr->dic_mtime ||
+        aff_size != hdr->aff_size || aff_mtime != hdr->aff_mtime) {
+        hdic_unmap(base, size);
+        return 0;
+    }
+    int count = hdic_check(base, size);
+    if (count < 0) {
+        HUNSPELL_WARNING(stderr, "error: corrupt compiled dictionary\n");
+        hdic_unmap(base, size);
+        return 0;
+    }
+
+    image = base;
+    image_size = size;
+    tablesize = hdr->tablesize;
+    tableptr = (ptrdiff_t *) (base + hdr->table_offset);
+    index = (struct hindex *) (base + hdr->index_offset);
+    index_mask = (unsigned int) hdr->index_size - 1;
+    index_count = count;
+    return 1;
+}
+
 // load a munched word list and build a hash table on the fly
 int HashMgr::load_tables(const char * tpath, const char * key)
 {
@@ -386,12 +1250,16 @@ int HashMgr::load_tables(const char * tpath, const char * key)
   if ((tablesize %2) == 0) tablesize++;
 
   // allocate the hash table
-  tableptr = (struct hentry **) malloc(tablesize * sizeof(struct hentry *));
+  tableptr = (ptrdiff_t *) malloc(tablesize * sizeof(ptrdiff_t));
   if (! tableptr) {
     delete dict;
     return 3;
   }
-  for (int i=0; i<tablesize; i++) tableptr[i] = NULL;
+  for (int i=0; i<tablesize; i++) tableptr[i] = 0;
+  if (init_index(tablesize)) {
+    delete dict;
+    return 3;
+  }
 
   // loop through all words on much list and add to hash
   // table and create word and affix strings
@@ -4,16 +4,42 @@
 #include "hunvisapi.h"
 
 #include <stdio.h>
+#include <stddef.h>
 
 #include "htypes.hxx"
 #include "filemgr.hxx"
 
 enum flag { FLAG_CHAR, FLAG_LONG, FLAG_NUM, FLAG_UNI };
 
+// trigram index of the n-gram suggestion (see ngram_candidates())
+#define NGRAM_INDEX_MINWORDS 20000 // smaller dictionaries are walked entirely,
+                                   // unless set_ngram_minwords() says otherwise
+#define NGRAM_CANDIDATES 2000      // about so many words are scored for a word,
+                                   // unless set_ngram_candidates() says otherwise
+#define NGRAM_MINKEYS 3            // words with less trigrams are not looked up
+
+// slot of the open addressing index used by lookup(): the hash and the first
+// bytes of the word are compared before the entry itself is touched
+struct hindex {
+  unsigned int      hash;
+  unsigned int      prefix;
+  ptrdiff_t         entry_rel; // first entry (homonym) of the word relative
+                               // to the slot, like the links of hentry; 0 if free
+};
+
+// slot of the trigram index: numbers of the words containing the trigram
+// are postings[start .. start + count)
+struct hngram {
+  unsigned long long key;    // 0 if free
+  unsigned int      start;
+  unsigned int      count;
+  unsigned int      last;    // word counted last, while building
+};
+
 class LIBHUNSPELL_DLL_EXPORTED HashMgr
 {
   int               tablesize;
-  struct hentry **  tableptr;
+  ptrdiff_t *       tableptr;  // first entries of the chains, relative to their slots
   int               userword;
   flag              flag_mode;
   int               complexprefixes;
@@ -31,6 +57,27 @@ class LIBHUNSPELL_DLL_EXPORTED HashMgr
   unsigned short *  aliasflen;
   int               numaliasm; // morphological desciption `compression' with aliases
   char **           aliasm;
+  char *            image;     // compiled dictionary the table was mapped from
+  size_t            image_size;
+  int               image_writable; // see make_writable()
+  struct hindex *   index;     // distinct words of the table, for lookup()
+  unsigned int      index_mask;
+  int               index_count;
+  char *            arena;     // blocks the entries are allocated from
+  char *            arena_pos;
+  size_t            arena_left;
+  struct hentry **  ngram_words;    // indexed entries in walk order
+  int               ngram_nwords;
+  struct hngram *   ngram_table;    // trigram -> words containing it
+  unsigned int      ngram_mask;
+  unsigned int      ngram_count;
+  unsigned int *    ngram_postings;
+  struct hentry **  ngram_extra;    // entries added after the indexing
+  int               ngram_nextra;
+  int               ngram_minwords; // smaller dictionaries get no index
+  int               ngram_ncandidates; // words scored for a word
+  int               ngram_built;    // built at the first ngram_candidates()
+  void *            ngram_lock;     // guards the building
 
 
 public:
@@ -40,6 +87,9 @@ public:
   struct hentry * lookup(const char *) const;
   int hash(const char *) const;
   struct hentry * walk_hashtable(int & col, struct hentry * hp) const;
+  int ngram_candidates(const char * word, struct hentry *** list);
+  void set_ngram_minwords(int minwords);
+  void set_ngram_candidates(int candidates);
 
   int add(const char * word);
   int add_with_affix(const char * word, const char * pattern);
@@ -51,10 +101,25 @@ public:
   int get_aliasf(int index, unsigned short ** fvec, FileMgr * af);
   int is_aliasm();
   char * get_aliasm(int index);
+  int write_compiled(const char * outpath, const char * tpath, const char * apath) const;
+  static char * compiled_path(const char * tpath);
 
 private:
   int get_clen_and_captype(const char * word, int wbl, int * captype);
   int load_tables(const char * tpath, const char * key);
+  int load_compiled(const char * tpath, const char * apath);
+  int in_image(const void * p) const;
+  int make_writable();
+  struct hentry * alloc_entry(size_t size);
+  int init_index(int count);
+  int index_add(struct hentry * hp);
+  int build_ngram_index();
+  void free_ngram_index();
+  int ngram_keys(const char * word, unsigned long long * keys, int lower) const;
+  int ngram_entry_keys(struct hentry * hp, unsigned long long * keys) const;
+  struct hngram * ngram_slot(unsigned long long key, int insert);
+  const struct hngram * ngram_find(unsigned long long key) const;
+  int ngram_add(struct hentry * hp);
   int add_word(const char * word, int wbl, int wcl, unsigned short * ap,
     int al, const char * desc, bool onlyupcase);
   int load_config(const char * affpath, const char * key);
@@ -1,6 +1,8 @@
 #ifndef _HTYPES_HXX_
 #define _HTYPES_HXX_
 
+#include <stddef.h>
+
 #define ROTATE_LEN   5
 
 #define ROTATE(v,q) \
@@ -17,16 +19,30 @@
 // approx. number  of user defined words
 #define USERWORD 1000
 
+// the links of an entry are stored relative to the entry itself (0 = none),
+// so the entries of a compiled image are used in place (see HashMgr)
 struct hentry
 {
   unsigned char blen; // word length in bytes
   unsigned char clen; // word length in characters (different for UTF-8 enc.)
   short    alen;      // length of affix flag vector
-  unsigned short * astr;  // affix flag vector
-  struct   hentry * next; // next word with same hash code
-  struct   hentry * next_homonym; // next homonym word (with same hash code)
+  ptrdiff_t astr_rel;    // affix flag vector
+  ptrdiff_t next_rel;    // next word with same hash code
+  ptrdiff_t homonym_rel; // next homonym word (with same hash code)
   char     var;       // variable fields (only for special pronounciation yet)
   char     word[1];   // variable-length word (8-bit or UTF-8 encoding)
 };
 
+#define HENTRY_LINK(h, rel) ((rel) ? (void *) ((char *) (h) + (rel)) : NULL)
+#define HENTRY_REL(h, p) ((p) ? (char *) (p) - (char *) (h) : 0)
+
+// affix flag vector, next entry of the chain and next homonym
+#define HENTRY_ASTR(h) ((unsigned short *) HENTRY_LINK(h, (h)->astr_rel))
+#define HENTRY_NEXT(h) ((struct hentry *) HENTRY_LINK(h, (h)->next_rel))
+#define HENTRY_HOMONYM(h) ((struct hentry *) HENTRY_LINK(h, (h)->homonym_rel))
+
+#define HENTRY_SET_ASTR(h, p) ((h)->astr_rel = HENTRY_REL(h, p))
+#define HENTRY_SET_NEXT(h, p) ((h)->next_rel = HENTRY_REL(h, p))
+#define HENTRY_SET_HOMONYM(h, p) ((h)->homonym_rel = HENTRY_REL(h, p))
+
 #endif
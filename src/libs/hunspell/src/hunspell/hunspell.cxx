@@ -20,6 +20,10 @@ Hunspell::Hunspell(const char * affpath, const char * dpath, const char * key)
     complexprefixes = 0;
     affixpath = mystrdup(affpath);
     maxdic = 0;
+    cache = new SpellCache();
+    generation = 1;
+    ngram_minwords = NGRAM_INDEX_MINWORDS;
+    ngram_candidates = NGRAM_CANDIDATES;
 
     /* first set up the hash manager */
     pHMgr[0] = new HashMgr(dpath, affpath, key);
@@ -61,13 +65,29 @@ Hunspell::~Hunspell()
     encoding = NULL;
     if (affixpath) free(affixpath);
     affixpath = NULL;
+    delete cache;
+    cache = NULL;
+}
+
+int Hunspell::compile(const char * affpath, const char * dpath)
+{
+    char * out = HashMgr::compiled_path(dpath);
+    if (!out) return 1;
+    HashMgr * h = new HashMgr(dpath, affpath);
+    int ec = h->write_compiled(out, dpath, affpath);
+    delete h;
+    free(out);
+    return ec;
 }
 
 // load extra dictionaries
 int Hunspell::add_dic(const char * dpath, const char * key) {
     if (maxdic == MAXDIC || !affixpath) return 1;
+    generation++;
     pHMgr[maxdic] = new HashMgr(dpath, affixpath, key);
     if (pHMgr[maxdic]) maxdic++; else return 1;
+    pHMgr[maxdic - 1]->set_ngram_minwords(ngram_minwords);
+    pHMgr[maxdic - 1]->set_ngram_candidates(ngram_candidates);
     return 0;
 }
 
@@ -283,28 +303,28 @@ char * Hunspell::sharps_u8_l1(char * dest, char * source) {
 }
 
 // recursive search for right ss - sharp s permutations
-hentry * Hunspell::spellsharps(char * base, char * pos, int n,
+hentry * Hunspell::spellsharps(HunspellContext & ctx, char * base, char * pos, int n,
         int repnum, char * tmp, int * info, char **root) {
     pos = strstr(pos, "ss");
     if (pos && (n < MAXSHARPS)) {
         *pos = '\xC3';
         *(pos + 1) = '\x9F';
-        hentry * h = spellsharps(base, pos + 2, n + 1, repnum + 1, tmp, info, root);
+        hentry * h = spellsharps(ctx, base, pos + 2, n + 1, repnum + 1, tmp, info, root);
         if (h) return h;
         *pos = 's';
         *(pos + 1) = 's';
-        h = spellsharps(base, pos + 2, n + 1, repnum, tmp, info, root);
+        h = spellsharps(ctx, base, pos + 2, n + 1, repnum, tmp, info, root);
         if (h) return h;
     } else if (repnum > 0) {
-        if (utf8) return checkword(base, info, root);
-        return checkword(sharps_u8_l1(tmp, base), info, root);
+        if (utf8) return checkword(ctx, base, info, root);
+        return checkword(ctx, sharps_u8_l1(tmp, base), info, root);
     }
     return NULL;
 }
 
 int Hunspell::is_keepcase(const hentry * rv) {
-    return pAMgr && rv->astr && pAMgr->get_keepcase() &&
-        TESTAFF(rv->astr, pAMgr->get_keepcase(), rv->alen);
+    return pAMgr && HENTRY_ASTR(rv) && pAMgr->get_keepcase() &&
+        TESTAFF(HENTRY_ASTR(rv), pAMgr->get_keepcase(), rv->alen);
 }
 
 /* insert a word to the beginning of the suggestion array and return ns */
@@ -321,6 +341,26 @@ int Hunspell::insert_sug(char ***slst, char * word, int ns) {
 }
 
 int Hunspell::spell(const char * word, int * info, char ** root)
+{
+  HunspellContext ctx;
+  return spell(ctx, word, info, root);
+}
+
+int Hunspell::spell(HunspellContext & ctx, const char * word, int * info, char ** root)
+{
+  // the stems are not cached
+  if (root || !cache) return spell_word(ctx, word, info, root);
+  int result;
+  int flags = 0;
+  if (!cache->lookup(word, generation, &result, &flags)) {
+    result = spell_word(ctx, word, &flags, NULL);
+    cache->store(word, generation, result, flags);
+  }
+  if (info) *info = flags;
+  return result;
+}
+
+int Hunspell::spell_word(HunspellContext & ctx, const char * word, int * info, char ** root)
 {
   struct hentry * rv=NULL;
   // need larger vector. For example, Turkish capital letter I converted a
@@ -371,24 +411,24 @@ int Hunspell::spell(const char * word, int * info, char ** root)
      case HUHINITCAP:
             *info += SPELL_ORIGCAP;
      case NOCAP: {
-            rv = checkword(cw, info, root);
+            rv = checkword(ctx, cw, info, root);
             if ((abbv) && !(rv)) {
                 memcpy(wspace,cw,wl);
                 *(wspace+wl) = '.';
                 *(wspace+wl+1) = '\0';
-                rv = checkword(wspace, info, root);
+                rv = checkword(ctx, wspace, info, root);
             }
             break;
          }
      case ALLCAP: {
             *info += SPELL_ORIGCAP;
-            rv = checkword(cw, info, root);
+            rv = checkword(ctx, cw, info, root);
             if (rv) break;
             if (abbv) {
                 memcpy(wspace,cw,wl);
                 *(wspace+wl) = '.';
                 *(wspace+wl+1) = '\0';
-                rv = checkword(wspace, info, root);
+                rv = checkword(ctx, wspace, info, root);
                 if (rv) break;
             }
             // Spec. prefix handling for Catalan, French, Italian:
@@ -405,37 +445,37 @@ int Hunspell::spell(const char * word, int * info, char ** root)
             	        *apostrophe = '\'';
 		        if (wl2 < nc) {
 		            mkinitcap2(apostrophe + 1, unicw + wl2 + 1, nc - wl2 - 1);
-			    rv = checkword(cw, info, root);
+			    rv = checkword(ctx, cw, info, root);
 			    if (rv) break;
 		        }
                     } else {
 		        mkinitcap2(apostrophe + 1, unicw, nc);
-		        rv = checkword(cw, info, root);
+		        rv = checkword(ctx, cw, info, root);
 		        if (rv) break;
 		    }
 		}
 		mkinitcap2(cw, unicw, nc);
-		rv = checkword(cw, info, root);
+		rv = checkword(ctx, cw, info, root);
 		if (rv) break;
             }
             if (pAMgr && pAMgr->get_checksharps() && strstr(cw, "SS")) {
                 char tmpword[MAXWORDUTF8LEN];
                 wl = mkallsmall2(cw, unicw, nc);
                 memcpy(wspace,cw,(wl+1));
-                rv = spellsharps(wspace, wspace, 0, 0, tmpword, info, root);
+                rv = spellsharps(ctx, wspace, wspace, 0, 0, tmpword, info, root);
                 if (!rv) {
                     wl2 = mkinitcap2(cw, unicw, nc);
-                    rv = spellsharps(cw, cw, 0, 0, tmpword, info, root);
+                    rv = spellsharps(ctx, cw, cw, 0, 0, tmpword, info, root);
                 }
                 if ((abbv) && !(rv)) {
                     *(wspace+wl) = '.';
                     *(wspace+wl+1) = '\0';
-                    rv = spellsharps(wspace, wspace, 0, 0, tmpword, info, root);
+                    rv = spellsharps(ctx, wspace, wspace, 0, 0, tmpword, info, root);
                     if (!rv) {
                         memcpy(wspace, cw, wl2);
                         *(wspace+wl2) = '.';
                         *(wspace+wl2+1) = '\0';
-                        rv = spellsharps(wspace, wspace, 0, 0, tmpword, info, root);
+                        rv = spellsharps(ctx, wspace, wspace, 0, 0, tmpword, info, root);
                     }
                 }
                 if (rv) break;
@@ -447,7 +487,7 @@ int Hunspell::spell(const char * word, int * info, char ** root)
              memcpy(wspace,cw,(wl+1));
              wl2 = mkinitcap2(cw, unicw, nc);
              if (captype == INITCAP) *info += SPELL_INITCAP;
-             rv = checkword(cw, info, root);
+             rv = checkword(ctx, cw, info, root);
              if (captype == INITCAP) *info -= SPELL_INITCAP;
              // forbid bad capitalization
              // (for example, ijs -> Ijs instead of IJs in Dutch)
@@ -459,18 +499,18 @@ int Hunspell::spell(const char * word, int * info, char ** root)
              if (rv && is_keepcase(rv) && (captype == ALLCAP)) rv = NULL;
              if (rv) break;
 
-             rv = checkword(wspace, info, root);
+             rv = checkword(ctx, wspace, info, root);
              if (abbv && !rv) {
 
                  *(wspace+wl) = '.';
                  *(wspace+wl+1) = '\0';
-                 rv = checkword(wspace, info, root);
+                 rv = checkword(ctx, wspace, info, root);
                  if (!rv) {
                     memcpy(wspace, cw, wl2);
                     *(wspace+wl2) = '.';
                     *(wspace+wl2+1) = '\0';
     	    	    if (captype == INITCAP) *info += SPELL_INITCAP;
-                    rv = checkword(wspace, info, root);
+                    rv = checkword(ctx, wspace, info, root);
     	    	    if (captype == INITCAP) *info -= SPELL_INITCAP;
                     if (rv && is_keepcase(rv) && (captype == ALLCAP)) rv = NULL;
                     break;
@@ -488,8 +528,8 @@ int Hunspell::spell(const char * word, int * info, char ** root)
   }
 
   if (rv) {
-      if (pAMgr && pAMgr->get_warn() && rv->astr &&
-          TESTAFF(rv->astr, pAMgr->get_warn(), rv->alen)) {
+      if (pAMgr && pAMgr->get_warn() && HENTRY_ASTR(rv) &&
+          TESTAFF(HENTRY_ASTR(rv), pAMgr->get_warn(), rv->alen)) {
               *info += SPELL_WARN;
 	      if (pAMgr->get_forbidwarn()) return 0;
               return HUNSPELL_OK_WARN;
@@ -523,12 +563,12 @@ int Hunspell::spell(const char * word, int * info, char ** root)
       int plen = strlen(wordbreak[j]);
       if (plen == 1 || plen > wl) continue;
       if (wordbreak[j][0] == '^' && strncmp(cw, wordbreak[j] + 1, plen - 1) == 0
-        && spell(cw + plen - 1)) return 1;
+        && spell(ctx, cw + plen - 1)) return 1;
       if (wordbreak[j][plen - 1] == '$' &&
         strncmp(cw + wl - plen + 1, wordbreak[j], plen - 1) == 0) {
 	    r = cw[wl - plen + 1];
 	    cw[wl - plen + 1] = '\0';
-    	    if (spell(cw)) return 1;
+    	    if (spell(ctx, cw)) return 1;
 	    cw[wl - plen + 1] = r;
 	}
     }
@@ -538,18 +578,18 @@ int Hunspell::spell(const char * word, int * info, char ** root)
       int plen = strlen(wordbreak[j]);
       s=(char *) strstr(cw, wordbreak[j]);
       if (s && (s > cw) && (s < cw + wl - plen)) {
-	if (!spell(s + plen)) continue;
+	if (!spell(ctx, s + plen)) continue;
         r = *s;
         *s = '\0';
         // examine 2 sides of the break point
-        if (spell(cw)) return 1;
+        if (spell(ctx, cw)) return 1;
         *s = r;
 
         // LANG_hu: spec. dash rule
 	if (langnum == LANG_hu && strcmp(wordbreak[j], "-") == 0) {
 	  r = s[1];
 	  s[1] = '\0';
-          if (spell(cw)) return 1; // check the first part with dash
+          if (spell(ctx, cw)) return 1; // check the first part with dash
           s[1] = r;
 	}
         // end of LANG speficic region
@@ -561,7 +601,7 @@ int Hunspell::spell(const char * word, int * info, char ** root)
   return 0;
 }
 
-struct hentry * Hunspell::checkword(const char * w, int * info, char ** root)
+struct hentry * Hunspell::checkword(HunspellContext & ctx, const char * w, int * info, char ** root)
 {
   struct hentry * he = NULL;
   int len, i;
@@ -600,12 +640,12 @@ struct hentry * Hunspell::checkword(const char * w, int * info, char ** root)
   he = (pHMgr[i])->lookup(word);
 
   // check forbidden and onlyincompound words
-  if ((he) && (he->astr) && (pAMgr) && TESTAFF(he->astr, pAMgr->get_forbiddenword(), he->alen)) {
+  if ((he) && (HENTRY_ASTR(he)) && (pAMgr) && TESTAFF(HENTRY_ASTR(he), pAMgr->get_forbiddenword(), he->alen)) {
     if (info) *info += SPELL_FORBIDDEN;
     // LANG_hu section: set dash information for suggestions
     if (langnum == LANG_hu) {
         if (pAMgr->get_compoundflag() &&
-            TESTAFF(he->astr, pAMgr->get_compoundflag(), he->alen)) {
+            TESTAFF(HENTRY_ASTR(he), pAMgr->get_compoundflag(), he->alen)) {
                 if (info) *info += SPELL_COMPOUND;
         }
     }
@@ -613,29 +653,29 @@ struct hentry * Hunspell::checkword(const char * w, int * info, char ** root)
   }
 
   // he = next not needaffix, onlyincompound homonym or onlyupcase word
-  while (he && (he->astr) &&
-    ((pAMgr->get_needaffix() && TESTAFF(he->astr, pAMgr->get_needaffix(), he->alen)) ||
-       (pAMgr->get_onlyincompound() && TESTAFF(he->astr, pAMgr->get_onlyincompound(), he->alen)) ||
-       (info && (*info & SPELL_INITCAP) && TESTAFF(he->astr, ONLYUPCASEFLAG, he->alen))
-    )) he = he->next_homonym;
+  while (he && (HENTRY_ASTR(he)) &&
+    ((pAMgr->get_needaffix() && TESTAFF(HENTRY_ASTR(he), pAMgr->get_needaffix(), he->alen)) ||
+       (pAMgr->get_onlyincompound() && TESTAFF(HENTRY_ASTR(he), pAMgr->get_onlyincompound(), he->alen)) ||
+       (info && (*info & SPELL_INITCAP) && TESTAFF(HENTRY_ASTR(he), ONLYUPCASEFLAG, he->alen))
+    )) he = HENTRY_HOMONYM(he);
   }
 
   // check with affixes
   if (!he && pAMgr) {
      // try stripping off affixes */
-     he = pAMgr->affix_check(word, len, 0);
+     he = pAMgr->affix_check(ctx, word, len, 0);
 
      // check compound restriction and onlyupcase
-     if (he && he->astr && (
+     if (he && HENTRY_ASTR(he) && (
         (pAMgr->get_onlyincompound() &&
-    	    TESTAFF(he->astr, pAMgr->get_onlyincompound(), he->alen)) ||
+    	    TESTAFF(HENTRY_ASTR(he), pAMgr->get_onlyincompound(), he->alen)) ||
         (info && (*info & SPELL_INITCAP) &&
-    	    TESTAFF(he->astr, ONLYUPCASEFLAG, he->alen)))) {
+    	    TESTAFF(HENTRY_ASTR(he), ONLYUPCASEFLAG, he->alen)))) {
     	    he = NULL;
      }
 
      if (he) {
-        if ((he->astr) && (pAMgr) && TESTAFF(he->astr, pAMgr->get_forbiddenword(), he->alen)) {
+        if ((HENTRY_ASTR(he)) && (pAMgr) && TESTAFF(HENTRY_ASTR(he), pAMgr->get_forbiddenword(), he->alen)) {
             if (info) *info += SPELL_FORBIDDEN;
             return NULL;
         }
@@ -647,13 +687,13 @@ struct hentry * Hunspell::checkword(const char * w, int * info, char ** root)
         }
      // try check compound word
      } else if (pAMgr->get_compound()) {
-          he = pAMgr->compound_check(word, len, 0, 0, 100, 0, NULL, 0, 0, info);
+          he = pAMgr->compound_check(ctx, word, len, 0, 0, 100, 0, NULL, 0, 0, info);
           // LANG_hu section: `moving rule' with last dash
           if ((!he) && (langnum == LANG_hu) && (word[len-1] == '-')) {
              char * dup = mystrdup(word);
              if (!dup) return NULL;
              dup[len-1] = '\0';
-             he = pAMgr->compound_check(dup, len-1, -5, 0, 100, 0, NULL, 1, 0, info);
+             he = pAMgr->compound_check(ctx, dup, len-1, -5, 0, 100, 0, NULL, 1, 0, info);
              free(dup);
           }
           // end of LANG speficic region
@@ -674,6 +714,48 @@ struct hentry * Hunspell::checkword(const char * w, int * info, char ** root)
 }
 
 int Hunspell::suggest(char*** slst, const char * word)
+{
+  HunspellContext ctx;
+  return suggest(ctx, slst, word, 0);
+}
+
+int Hunspell::suggest(HunspellContext & ctx, char*** slst, const char * word)
+{
+  return suggest(ctx, slst, word, 0);
+}
+
+int Hunspell::suggest(HunspellContext & ctx, char*** slst, const char * word,
+    int timeout, hunspell_suggest_callback callback, void * data)
+{
+  // only a timed out search of the same word in the same dictionary
+  // resumes, anything else starts a new search
+  if (!ctx.timedout || !ctx.sugword || strcmp(ctx.sugword, word) != 0 ||
+      ctx.sugeneration != generation) {
+    ctx.reset();
+    ctx.sugword = mystrdup(word);
+    ctx.sugeneration = generation;
+  }
+  ctx.begin(timeout > 0 ? monotonic_usec() + (unsigned long long) timeout * 1000 : 0);
+  int ns = suggest_word(ctx, slst, word);
+  ctx.deadline = 0;
+
+  // report the suggestions not reported by the previous calls
+  if (callback) for (int j = 0; j < ns; j++) {
+    int k = 0;
+    while (k < ctx.nreported && strcmp(ctx.reported[k], (*slst)[j]) != 0) k++;
+    if (k < ctx.nreported) continue;
+    char ** r = (char **) realloc(ctx.reported, (ctx.nreported + 1) * sizeof(char *));
+    if (!r) break;
+    ctx.reported = r;
+    ctx.reported[ctx.nreported] = mystrdup((*slst)[j]);
+    if (!ctx.reported[ctx.nreported]) break;
+    ctx.nreported++;
+    callback((*slst)[j], data);
+  }
+  return ns;
+}
+
+int Hunspell::suggest_word(HunspellContext & ctx, char*** slst, const char * word)
 {
   int onlycmpdsug = 0;
   char cw[MAXWORDUTF8LEN];
@@ -683,7 +765,7 @@ int Hunspell::suggest(char*** slst, const char * word)
   *slst = NULL;
   // process XML input of the simplified API (see manual)
   if (strncmp(word, SPELL_XML, sizeof(SPELL_XML) - 3) == 0) {
-     return spellml(slst, word);
+     return spellml(ctx, slst, word);
   }
   int nc = strlen(word);
   if (utf8) {
@@ -708,7 +790,7 @@ int Hunspell::suggest(char*** slst, const char * word)
   if (pAMgr && captype == NOCAP && pAMgr->get_forceucase()) {
     int info = SPELL_ORIGCAP;
     char ** wlst;
-    if (checkword(cw, &info, NULL)) {
+    if (checkword(ctx, cw, &info, NULL)) {
         if (*slst) {
             wlst = *slst;
         } else {
@@ -727,23 +809,23 @@ int Hunspell::suggest(char*** slst, const char * word)
  
   switch(captype) {
      case NOCAP:   {
-                     ns = pSMgr->suggest(slst, cw, ns, &onlycmpdsug);
+                     ns = pSMgr->suggest(ctx, slst, cw, ns, &onlycmpdsug);
                      break;
                    }
 
      case INITCAP: {
                      capwords = 1;
-                     ns = pSMgr->suggest(slst, cw, ns, &onlycmpdsug);
+                     ns = pSMgr->suggest(ctx, slst, cw, ns, &onlycmpdsug);
                      if (ns == -1) break;
                      memcpy(wspace,cw,(wl+1));
                      mkallsmall2(wspace, unicw, nc);
-                     ns = pSMgr->suggest(slst, wspace, ns, &onlycmpdsug);
+                     ns = pSMgr->suggest(ctx, slst, wspace, ns, &onlycmpdsug);
                      break;
                    }
      case HUHINITCAP:
                     capwords = 1;
      case HUHCAP: {
-                     ns = pSMgr->suggest(slst, cw, ns, &onlycmpdsug);
+                     ns = pSMgr->suggest(ctx, slst, cw, ns, &onlycmpdsug);
                      if (ns != -1) {
                         int prevns;
     		        // something.The -> something. The
@@ -770,17 +852,17 @@ int Hunspell::suggest(char*** slst, const char * word)
                             // TheOpenOffice.org -> The OpenOffice.org
                             memcpy(wspace,cw,(wl+1));
                             mkinitsmall2(wspace, unicw, nc);
-                            ns = pSMgr->suggest(slst, wspace, ns, &onlycmpdsug);
+                            ns = pSMgr->suggest(ctx, slst, wspace, ns, &onlycmpdsug);
                         }
                         memcpy(wspace,cw,(wl+1));
                         mkallsmall2(wspace, unicw, nc);
-                        if (spell(wspace)) ns = insert_sug(slst, wspace, ns);
+                        if (spell(ctx, wspace)) ns = insert_sug(slst, wspace, ns);
                         prevns = ns;
-                        ns = pSMgr->suggest(slst, wspace, ns, &onlycmpdsug);
+                        ns = pSMgr->suggest(ctx, slst, wspace, ns, &onlycmpdsug);
                         if (captype == HUHINITCAP) {
                             mkinitcap2(wspace, unicw, nc);
-                            if (spell(wspace)) ns = insert_sug(slst, wspace, ns);
-                            ns = pSMgr->suggest(slst, wspace, ns, &onlycmpdsug);
+                            if (spell(ctx, wspace)) ns = insert_sug(slst, wspace, ns);
+                            ns = pSMgr->suggest(ctx, slst, wspace, ns, &onlycmpdsug);
                         }
                         // aNew -> "a New" (instead of "a new")
                         for (int j = prevns; j < ns; j++) {
@@ -807,12 +889,12 @@ int Hunspell::suggest(char*** slst, const char * word)
      case ALLCAP: {
                      memcpy(wspace, cw, (wl+1));
                      mkallsmall2(wspace, unicw, nc);
-                     ns = pSMgr->suggest(slst, wspace, ns, &onlycmpdsug);
+                     ns = pSMgr->suggest(ctx, slst, wspace, ns, &onlycmpdsug);
                      if (ns == -1) break;
-                     if (pAMgr && pAMgr->get_keepcase() && spell(wspace))
+                     if (pAMgr && pAMgr->get_keepcase() && spell(ctx, wspace))
                         ns = insert_sug(slst, wspace, ns);
                      mkinitcap2(wspace, unicw, nc);
-                     ns = pSMgr->suggest(slst, wspace, ns, &onlycmpdsug);
+                     ns = pSMgr->suggest(ctx, slst, wspace, ns, &onlycmpdsug);
                      for (int j=0; j < ns; j++) {
                         mkallcap((*slst)[j]);
                         if (pAMgr && pAMgr->get_checksharps()) {
@@ -848,7 +930,7 @@ int Hunspell::suggest(char*** slst, const char * word)
               *pos = '\0';
               strcpy(w, (*slst)[j]);
               strcat(w, pos + 1);
-              spell(w, &info, NULL);
+              spell(ctx, w, &info, NULL);
               if ((info & SPELL_COMPOUND) && (info & SPELL_FORBIDDEN)) {
                   *pos = ' ';
               } else *pos = '-';
@@ -861,7 +943,7 @@ int Hunspell::suggest(char*** slst, const char * word)
   if (pAMgr && (ns == 0 || onlycmpdsug) && (pAMgr->get_maxngramsugs() != 0) && (*slst)) {
       switch(captype) {
           case NOCAP: {
-              ns = pSMgr->ngsuggest(*slst, cw, ns, pHMgr, maxdic);
+              ns = pSMgr->ngsuggest(ctx, *slst, cw, ns, pHMgr, maxdic);
               break;
           }
 	  case HUHINITCAP:
@@ -869,21 +951,21 @@ int Hunspell::suggest(char*** slst, const char * word)
           case HUHCAP: {
               memcpy(wspace,cw,(wl+1));
               mkallsmall2(wspace, unicw, nc);
-              ns = pSMgr->ngsuggest(*slst, wspace, ns, pHMgr, maxdic);
+              ns = pSMgr->ngsuggest(ctx, *slst, wspace, ns, pHMgr, maxdic);
 	      break;
           }
          case INITCAP: {
               capwords = 1;
               memcpy(wspace,cw,(wl+1));
               mkallsmall2(wspace, unicw, nc);
-              ns = pSMgr->ngsuggest(*slst, wspace, ns, pHMgr, maxdic);
+              ns = pSMgr->ngsuggest(ctx, *slst, wspace, ns, pHMgr, maxdic);
               break;
           }
           case ALLCAP: {
               memcpy(wspace,cw,(wl+1));
               mkallsmall2(wspace, unicw, nc);
 	      int oldns = ns;
-              ns = pSMgr->ngsuggest(*slst, wspace, ns, pHMgr, maxdic);
+              ns = pSMgr->ngsuggest(ctx, *slst, wspace, ns, pHMgr, maxdic);
               for (int j = oldns; j < ns; j++)
                   mkallcap((*slst)[j]);
               break;
@@ -905,8 +987,8 @@ int Hunspell::suggest(char*** slst, const char * word)
      }
      while (nodashsug && !last) {
 	if (*pos == '\0') last = 1; else *pos = '\0';
-        if (!spell(ppos)) {
-          nn = suggest(&nlst, ppos);
+        if (!spell(ctx, ppos)) {
+          nn = suggest_word(ctx, &nlst, ppos);
           for (int j = nn - 1; j >= 0; j--) {
             strncpy(wspace, cw, ppos - cw);
             strcpy(wspace + (ppos - cw), nlst[j]);
@@ -956,7 +1038,7 @@ int Hunspell::suggest(char*** slst, const char * word)
     case ALLCAP: {
       int l = 0;
       for (int j=0; j < ns; j++) {
-        if (!strchr((*slst)[j],' ') && !spell((*slst)[j])) {
+        if (!strchr((*slst)[j],' ') && !spell(ctx, (*slst)[j])) {
           char s[MAXSWUTF8L];
           w_char w[MAXSWL];
           int len;
@@ -968,12 +1050,12 @@ int Hunspell::suggest(char*** slst, const char * word)
           }
           mkallsmall2(s, w, len);
           free((*slst)[j]);
-          if (spell(s)) {
+          if (spell(ctx, s)) {
             (*slst)[l] = mystrdup(s);
             if ((*slst)[l]) l++;
           } else {
             mkinitcap2(s, w, len);
-            if (spell(s)) {
+            if (spell(ctx, s)) {
               (*slst)[l] = mystrdup(s);
               if ((*slst)[l]) l++;
             }
@@ -1020,6 +1102,28 @@ int Hunspell::suggest(char*** slst, const char * word)
   return l;
 }
 
+HunspellContext::HunspellContext() : sugword(NULL), sugeneration(0), reported(NULL),
+  nreported(0)
+{
+}
+
+HunspellContext::~HunspellContext()
+{
+  reset();
+}
+
+// forget the word, the recorded passes and the reported suggestions
+void HunspellContext::reset()
+{
+  clear();
+  for (int i = 0; i < nreported; i++) free(reported[i]);
+  free(reported);
+  free(sugword);
+  sugword = NULL;
+  reported = NULL;
+  nreported = 0;
+}
+
 void Hunspell::free_list(char *** slst, int n) {
         freelist(slst, n);
 }
@@ -1029,10 +1133,27 @@ char * Hunspell::get_dic_encoding()
   return encoding;
 }
 
+void Hunspell::set_ngram_minwords(int minwords)
+{
+  // an interrupted suggestion search can't resume on another candidate list
+  generation++;
+  ngram_minwords = minwords;
+  for (int i = 0; i < maxdic; i++) pHMgr[i]->set_ngram_minwords(minwords);
+}
+
+void Hunspell::set_ngram_candidates(int candidates)
+{
+  // changes the candidate list as well
+  generation++;
+  ngram_candidates = candidates;
+  for (int i = 0; i < maxdic; i++) pHMgr[i]->set_ngram_candidates(candidates);
+}
+
 #ifdef HUNSPELL_EXPERIMENTAL
 // XXX need UTF-8 support
 int Hunspell::suggest_auto(char*** slst, const char * word)
 {
+  HunspellContext ctx;
   char cw[MAXWORDUTF8LEN];
   char wspace[MAXWORDUTF8LEN];
   if (!pSMgr || maxdic == 0) return 0;
@@ -1051,7 +1172,7 @@ int Hunspell::suggest_auto(char*** slst, const char * word)
 
   switch(captype) {
      case NOCAP:   {
-                     ns = pSMgr->suggest_auto(slst, cw, ns);
+                     ns = pSMgr->suggest_auto(ctx, slst, cw, ns);
                      if (ns>0) break;
                      break;
                    }
@@ -1059,21 +1180,21 @@ int Hunspell::suggest_auto(char*** slst, const char * word)
      case INITCAP: {
                      memcpy(wspace,cw,(wl+1));
                      mkallsmall(wspace);
-                     ns = pSMgr->suggest_auto(slst, wspace, ns);
+                     ns = pSMgr->suggest_auto(ctx, slst, wspace, ns);
                      for (int j=0; j < ns; j++)
                        mkinitcap((*slst)[j]);
-                     ns = pSMgr->suggest_auto(slst, cw, ns);
+                     ns = pSMgr->suggest_auto(ctx, slst, cw, ns);
                      break;
 
                    }
 
      case HUHINITCAP:
      case HUHCAP: {
-                     ns = pSMgr->suggest_auto(slst, cw, ns);
+                     ns = pSMgr->suggest_auto(ctx, slst, cw, ns);
                      if (ns == 0) {
                         memcpy(wspace,cw,(wl+1));
                         mkallsmall(wspace);
-                        ns = pSMgr->suggest_auto(slst, wspace, ns);
+                        ns = pSMgr->suggest_auto(ctx, slst, wspace, ns);
                      }
                      break;
                    }
@@ -1081,10 +1202,10 @@ int Hunspell::suggest_auto(char*** slst, const char * word)
      case ALLCAP: {
                      memcpy(wspace,cw,(wl+1));
                      mkallsmall(wspace);
-                     ns = pSMgr->suggest_auto(slst, wspace, ns);
+                     ns = pSMgr->suggest_auto(ctx, slst, wspace, ns);
 
                      mkinitcap(wspace);
-                     ns = pSMgr->suggest_auto(slst, wspace, ns);
+                     ns = pSMgr->suggest_auto(ctx, slst, wspace, ns);
 
                      for (int j=0; j < ns; j++)
                        mkallcap((*slst)[j]);
@@ -1117,7 +1238,7 @@ int Hunspell::suggest_auto(char*** slst, const char * word)
               *pos = '\0';
               strcpy(w, (*slst)[j]);
               strcat(w, pos + 1);
-              spell(w, &info, NULL);
+              spell(ctx, w, &info, NULL);
               if ((info & SPELL_COMPOUND) && (info & SPELL_FORBIDDEN)) {
                   *pos = ' ';
               } else *pos = '-';
@@ -1193,9 +1314,15 @@ int Hunspell::stem(char*** slst, char ** desc, int n)
 }
 
 int Hunspell::stem(char*** slst, const char * word)
+{
+  HunspellContext ctx;
+  return stem(ctx, slst, word);
+}
+
+int Hunspell::stem(HunspellContext & ctx, char*** slst, const char * word)
 {
   char ** pl;
-  int pln = analyze(&pl, word);
+  int pln = analyze(ctx, &pl, word);
   int pln2 = stem(slst, pl, pln);
   freelist(&pl, pln);
   return pln2;
@@ -1204,6 +1331,7 @@ int Hunspell::stem(char*** slst, const char * word)
 #ifdef HUNSPELL_EXPERIMENTAL
 int Hunspell::suggest_pos_stems(char*** slst, const char * word)
 {
+  HunspellContext ctx;
   char cw[MAXWORDUTF8LEN];
   char wspace[MAXWORDUTF8LEN];
   if (! pSMgr || maxdic == 0) return 0;
@@ -1225,13 +1353,13 @@ int Hunspell::suggest_pos_stems(char*** slst, const char * word)
   switch(captype) {
      case HUHCAP:
      case NOCAP:   {
-                     ns = pSMgr->suggest_pos_stems(slst, cw, ns);
+                     ns = pSMgr->suggest_pos_stems(ctx, slst, cw, ns);
 
                      if ((abbv) && (ns == 0)) {
                          memcpy(wspace,cw,wl);
                          *(wspace+wl) = '.';
                          *(wspace+wl+1) = '\0';
-                         ns = pSMgr->suggest_pos_stems(slst, wspace, ns);
+                         ns = pSMgr->suggest_pos_stems(ctx, slst, wspace, ns);
                      }
 
                      break;
@@ -1239,12 +1367,12 @@ int Hunspell::suggest_pos_stems(char*** slst, const char * word)
 
      case INITCAP: {
 
-                     ns = pSMgr->suggest_pos_stems(slst, cw, ns);
+                     ns = pSMgr->suggest_pos_stems(ctx, slst, cw, ns);
 
                      if (ns == 0 || ((*slst)[0][0] == '#')) {
                         memcpy(wspace,cw,(wl+1));
                         mkallsmall(wspace);
-                        ns = pSMgr->suggest_pos_stems(slst, wspace, ns);
+                        ns = pSMgr->suggest_pos_stems(ctx, slst, wspace, ns);
                      }
 
                      break;
@@ -1252,16 +1380,16 @@ int Hunspell::suggest_pos_stems(char*** slst, const char * word)
                    }
 
      case ALLCAP: {
-                     ns = pSMgr->suggest_pos_stems(slst, cw, ns);
+                     ns = pSMgr->suggest_pos_stems(ctx, slst, cw, ns);
                      if (ns != 0) break;
 
                      memcpy(wspace,cw,(wl+1));
                      mkallsmall(wspace);
-                     ns = pSMgr->suggest_pos_stems(slst, wspace, ns);
+                     ns = pSMgr->suggest_pos_stems(ctx, slst, wspace, ns);
 
                      if (ns == 0) {
                          mkinitcap(wspace);
-                         ns = pSMgr->suggest_pos_stems(slst, wspace, ns);
+                         ns = pSMgr->suggest_pos_stems(ctx, slst, wspace, ns);
                      }
                      break;
                    }
@@ -1326,18 +1454,21 @@ int Hunspell::mkinitsmall2(char * p, w_char * u, int nc)
 
 int Hunspell::add(const char * word)
 {
+    generation++;
     if (pHMgr[0]) return (pHMgr[0])->add(word);
     return 0;
 }
 
 int Hunspell::add_with_affix(const char * word, const char * example)
 {
+    generation++;
     if (pHMgr[0]) return (pHMgr[0])->add_with_affix(word, example);
     return 0;
 }
 
 int Hunspell::remove(const char * word)
 {
+    generation++;
     if (pHMgr[0]) return (pHMgr[0])->remove(word);
     return 0;
 }
@@ -1362,6 +1493,12 @@ void Hunspell::cat_result(char * result, char * st)
 }
 
 int Hunspell::analyze(char*** slst, const char * word)
+{
+  HunspellContext ctx;
+  return analyze(ctx, slst, word);
+}
+
+int Hunspell::analyze(HunspellContext & ctx, char*** slst, const char * word)
 {
   char cw[MAXWORDUTF8LEN];
   char wspace[MAXWORDUTF8LEN];
@@ -1416,17 +1553,17 @@ int Hunspell::analyze(char*** slst, const char * word)
   }
 
   if ((n == wl) && (n3 > 0) && (n - n3 > 3)) return 0;
-  if ((n == wl) || ((n>0) && ((cw[n]=='%') || (cw[n]=='\xB0')) && checkword(cw+n, NULL, NULL))) {
+  if ((n == wl) || ((n>0) && ((cw[n]=='%') || (cw[n]=='\xB0')) && checkword(ctx, cw+n, NULL, NULL))) {
         mystrcat(result, cw, MAXLNLEN);
         result[n - 1] = '\0';
-        if (n == wl) cat_result(result, pSMgr->suggest_morph(cw + n - 1));
+        if (n == wl) cat_result(result, pSMgr->suggest_morph(ctx, cw + n - 1));
         else {
                 char sign = cw[n];
                 cw[n] = '\0';
-                cat_result(result, pSMgr->suggest_morph(cw + n - 1));
+                cat_result(result, pSMgr->suggest_morph(ctx, cw + n - 1));
                 mystrcat(result, "+", MAXLNLEN); // XXX SPEC. MORPHCODE
                 cw[n] = sign;
-                cat_result(result, pSMgr->suggest_morph(cw + n));
+                cat_result(result, pSMgr->suggest_morph(ctx, cw + n));
         }
         return line_tok(result, slst, MSEP_REC);
   }
@@ -1437,12 +1574,12 @@ int Hunspell::analyze(char*** slst, const char * word)
      case HUHCAP:
      case HUHINITCAP:
      case NOCAP:  {
-                    cat_result(result, pSMgr->suggest_morph(cw));
+                    cat_result(result, pSMgr->suggest_morph(ctx, cw));
                     if (abbv) {
                         memcpy(wspace,cw,wl);
                         *(wspace+wl) = '.';
                         *(wspace+wl+1) = '\0';
-                        cat_result(result, pSMgr->suggest_morph(wspace));
+                        cat_result(result, pSMgr->suggest_morph(ctx, wspace));
                     }
                     break;
                 }
@@ -1450,45 +1587,45 @@ int Hunspell::analyze(char*** slst, const char * word)
                      wl = mkallsmall2(cw, unicw, nc);
                      memcpy(wspace,cw,(wl+1));
                      wl2 = mkinitcap2(cw, unicw, nc);
-                     cat_result(result, pSMgr->suggest_morph(wspace));
-                     cat_result(result, pSMgr->suggest_morph(cw));
+                     cat_result(result, pSMgr->suggest_morph(ctx, wspace));
+                     cat_result(result, pSMgr->suggest_morph(ctx, cw));
                      if (abbv) {
                          *(wspace+wl) = '.';
                          *(wspace+wl+1) = '\0';
-                         cat_result(result, pSMgr->suggest_morph(wspace));
+                         cat_result(result, pSMgr->suggest_morph(ctx, wspace));
 
                          memcpy(wspace, cw, wl2);
                          *(wspace+wl2) = '.';
                          *(wspace+wl2+1) = '\0';
 
-                         cat_result(result, pSMgr->suggest_morph(wspace));
+                         cat_result(result, pSMgr->suggest_morph(ctx, wspace));
                      }
                      break;
                    }
      case ALLCAP: {
-                     cat_result(result, pSMgr->suggest_morph(cw));
+                     cat_result(result, pSMgr->suggest_morph(ctx, cw));
                      if (abbv) {
                          memcpy(wspace,cw,wl);
                          *(wspace+wl) = '.';
                          *(wspace+wl+1) = '\0';
-                         cat_result(result, pSMgr->suggest_morph(cw));
+                         cat_result(result, pSMgr->suggest_morph(ctx, cw));
                      }
                      wl = mkallsmall2(cw, unicw, nc);
                      memcpy(wspace,cw,(wl+1));
                      wl2 = mkinitcap2(cw, unicw, nc);
 
-                     cat_result(result, pSMgr->suggest_morph(wspace));
-                     cat_result(result, pSMgr->suggest_morph(cw));
+                     cat_result(result, pSMgr->suggest_morph(ctx, wspace));
+                     cat_result(result, pSMgr->suggest_morph(ctx, cw));
                      if (abbv) {
                          *(wspace+wl) = '.';
                          *(wspace+wl+1) = '\0';
-                         cat_result(result, pSMgr->suggest_morph(wspace));
+                         cat_result(result, pSMgr->suggest_morph(ctx, wspace));
 
                          memcpy(wspace, cw, wl2);
                          *(wspace+wl2) = '.';
                          *(wspace+wl2+1) = '\0';
 
-                         cat_result(result, pSMgr->suggest_morph(wspace));
+                         cat_result(result, pSMgr->suggest_morph(ctx, wspace));
                      }
                      break;
                    }
@@ -1511,8 +1648,8 @@ int Hunspell::analyze(char*** slst, const char * word)
       *dash='\0';
       // examine 2 sides of the dash
       if (dash[1] == '\0') { // base word ending with dash
-        if (spell(cw)) {
-		char * p = pSMgr->suggest_morph(cw);
+        if (spell(ctx, cw)) {
+		char * p = pSMgr->suggest_morph(ctx, cw);
 		if (p) {
 		    int ret = line_tok(p, slst, MSEP_REC);
 		    free(p);
@@ -1521,14 +1658,14 @@ int Hunspell::analyze(char*** slst, const char * word)
 		
 	}
       } else if ((dash[1] == 'e') && (dash[2] == '\0')) { // XXX (HU) -e hat.
-        if (spell(cw) && (spell("-e"))) {
-                        st = pSMgr->suggest_morph(cw);
+        if (spell(ctx, cw) && (spell(ctx, "-e"))) {
+                        st = pSMgr->suggest_morph(ctx, cw);
                         if (st) {
                                 mystrcat(result, st, MAXLNLEN);
                                 free(st);
                         }
                         mystrcat(result,"+", MAXLNLEN); // XXX spec. separator in MORPHCODE
-                        st = pSMgr->suggest_morph("-e");
+                        st = pSMgr->suggest_morph(ctx, "-e");
                         if (st) {
                                 mystrcat(result, st, MAXLNLEN);
                                 free(st);
@@ -1540,18 +1677,18 @@ int Hunspell::analyze(char*** slst, const char * word)
         char r2 = *(dash + 1);
         dash[0]='-';
         dash[1]='\0';
-        nresult = spell(cw);
+        nresult = spell(ctx, cw);
         dash[1] = r2;
         dash[0]='\0';
-        if (nresult && spell(dash+1) && ((strlen(dash+1) > 1) ||
+        if (nresult && spell(ctx, dash+1) && ((strlen(dash+1) > 1) ||
                 ((dash[1] > '0') && (dash[1] < '9')))) {
-                            st = pSMgr->suggest_morph(cw);
+                            st = pSMgr->suggest_morph(ctx, cw);
                             if (st) {
                                 mystrcat(result, st, MAXLNLEN);
                                     free(st);
                                 mystrcat(result,"+", MAXLNLEN); // XXX spec. separator in MORPHCODE
                             }
-                            st = pSMgr->suggest_morph(dash+1);
+                            st = pSMgr->suggest_morph(ctx, dash+1);
                             if (st) {
                                     mystrcat(result, st, MAXLNLEN);
                                     free(st);
@@ -1574,10 +1711,10 @@ int Hunspell::analyze(char*** slst, const char * word)
          // examine 100000-hoz, 10000-hoz 1000-hoz, 10-hoz,
          // 56-hoz, 6-hoz
          for(; n >= 1; n--) {
-            if ((*(dash - n) >= '0') && (*(dash - n) <= '9') && checkword(dash - n, NULL, NULL)) {
+            if ((*(dash - n) >= '0') && (*(dash - n) <= '9') && checkword(ctx, dash - n, NULL, NULL)) {
                     mystrcat(result, cw, MAXLNLEN);
                     result[dash - cw - n] = '\0';
-                        st = pSMgr->suggest_morph(dash - n);
+                        st = pSMgr->suggest_morph(ctx, dash - n);
                         if (st) {
                         mystrcat(result, st, MAXLNLEN);
                                 free(st);
@@ -1591,11 +1728,17 @@ int Hunspell::analyze(char*** slst, const char * word)
 }
 
 int Hunspell::generate(char*** slst, const char * word, char ** pl, int pln)
+{
+  HunspellContext ctx;
+  return generate(ctx, slst, word, pl, pln);
+}
+
+int Hunspell::generate(HunspellContext & ctx, char*** slst, const char * word, char ** pl, int pln)
 {
   *slst = NULL;
   if (!pSMgr || !pln) return 0;
   char **pl2;
-  int pl2n = analyze(&pl2, word);
+  int pl2n = analyze(ctx, &pl2, word);
   int captype = 0;
   int abbv = 0;
   char cw[MAXWORDUTF8LEN];
@@ -1625,7 +1768,7 @@ int Hunspell::generate(char*** slst, const char * word, char ** pl, int pln)
 
     int r = 0;
     for (int j=0; j < linenum; j++) {
-        if (!spell((*slst)[j])) {
+        if (!spell(ctx, (*slst)[j])) {
             free((*slst)[j]);
             (*slst)[j] = NULL;
         } else {
@@ -1641,10 +1784,16 @@ int Hunspell::generate(char*** slst, const char * word, char ** pl, int pln)
 }
 
 int Hunspell::generate(char*** slst, const char * word, const char * pattern)
+{
+  HunspellContext ctx;
+  return generate(ctx, slst, word, pattern);
+}
+
+int Hunspell::generate(HunspellContext & ctx, char*** slst, const char * word, const char * pattern)
 {
   char **pl;
-  int pln = analyze(&pl, pattern);
-  int n = generate(slst, word, pl, pln);
+  int pln = analyze(ctx, &pl, pattern);
+  int n = generate(ctx, slst, word, pl, pln);
   freelist(&pl, pln);
   return uniqlist(*slst, n);
 }
@@ -1710,7 +1859,7 @@ int Hunspell::get_xml_list(char ***slst, char * list, const char * tag) {
     return n;
 }
 
-int Hunspell::spellml(char*** slst, const char * word)
+int Hunspell::spellml(HunspellContext & ctx, char*** slst, const char * word)
 {
   char *q, *q2;
   char cw[MAXWORDUTF8LEN], cw2[MAXWORDUTF8LEN];
@@ -1722,7 +1871,7 @@ int Hunspell::spellml(char*** slst, const char * word)
   if (!q2) return 0; // bad XML input
   if (check_xml_par(q, "type=", "analyze")) {
       int n = 0, s = 0;
-      if (get_xml_par(cw, strchr(q2, '>'), MAXWORDUTF8LEN - 10)) n = analyze(slst, cw);
+      if (get_xml_par(cw, strchr(q2, '>'), MAXWORDUTF8LEN - 10)) n = analyze(ctx, slst, cw);
       if (n == 0) return 0;
       // convert the result to <code><a>ana1</a><a>ana2</a></code> format
       for (int i = 0; i < n; i++) s+= strlen((*slst)[i]);
@@ -1743,20 +1892,20 @@ int Hunspell::spellml(char*** slst, const char * word)
       (*slst)[0] = r;
       return 1;
   } else if (check_xml_par(q, "type=", "stem")) {
-      if (get_xml_par(cw, strchr(q2, '>'), MAXWORDUTF8LEN - 1)) return stem(slst, cw);
+      if (get_xml_par(cw, strchr(q2, '>'), MAXWORDUTF8LEN - 1)) return stem(ctx, slst, cw);
   } else if (check_xml_par(q, "type=", "generate")) {
       int n = get_xml_par(cw, strchr(q2, '>'), MAXWORDUTF8LEN - 1);
       if (n == 0) return 0;
       char * q3 = strstr(q2 + 1, "<word");
       if (q3) {
         if (get_xml_par(cw2, strchr(q3, '>'), MAXWORDUTF8LEN - 1)) {
-            return generate(slst, cw, cw2);
+            return generate(ctx, slst, cw, cw2);
         }
       } else {
         if ((q2 = strstr(q2 + 1, "<code"))) {
           char ** slst2;
           if ((n = get_xml_list(&slst2, strchr(q2, '>'), "<a>"))) {
-            int n2 = generate(slst, cw, slst2, n);
+            int n2 = generate(ctx, slst, cw, slst2, n);
             freelist(&slst2, n);
             return uniqlist(*slst, n2);
           }
@@ -1772,6 +1921,7 @@ int Hunspell::spellml(char*** slst, const char * word)
 // XXX need UTF-8 support
 char * Hunspell::morph_with_correction(const char * word)
 {
+  HunspellContext ctx;
   char cw[MAXWORDUTF8LEN];
   char wspace[MAXWORDUTF8LEN];
   if (! pSMgr || maxdic == 0) return NULL;
@@ -1794,7 +1944,7 @@ char * Hunspell::morph_with_correction(const char * word)
 
   switch(captype) {
      case NOCAP:   {
-                     st = pSMgr->suggest_morph_for_spelling_error(cw);
+                     st = pSMgr->suggest_morph_for_spelling_error(ctx, cw);
                      if (st) {
                         mystrcat(result, st, MAXLNLEN);
                         free(st);
@@ -1803,7 +1953,7 @@ char * Hunspell::morph_with_correction(const char * word)
                          memcpy(wspace,cw,wl);
                          *(wspace+wl) = '.';
                          *(wspace+wl+1) = '\0';
-                         st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                         st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                          if (st) {
                             if (*result) mystrcat(result, "\n", MAXLNLEN);
                             mystrcat(result, st, MAXLNLEN);
@@ -1815,12 +1965,12 @@ char * Hunspell::morph_with_correction(const char * word)
      case INITCAP: {
                      memcpy(wspace,cw,(wl+1));
                      mkallsmall(wspace);
-                     st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                     st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                      if (st) {
                         mystrcat(result, st, MAXLNLEN);
                         free(st);
                      }
-                     st = pSMgr->suggest_morph_for_spelling_error(cw);
+                     st = pSMgr->suggest_morph_for_spelling_error(ctx, cw);
                      if (st) {
                         if (*result) mystrcat(result, "\n", MAXLNLEN);
                         mystrcat(result, st, MAXLNLEN);
@@ -1831,14 +1981,14 @@ char * Hunspell::morph_with_correction(const char * word)
                          *(wspace+wl) = '.';
                          *(wspace+wl+1) = '\0';
                          mkallsmall(wspace);
-                         st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                         st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                          if (st) {
                             if (*result) mystrcat(result, "\n", MAXLNLEN);
                             mystrcat(result, st, MAXLNLEN);
                             free(st);
                          }
                          mkinitcap(wspace);
-                         st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                         st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                          if (st) {
                             if (*result) mystrcat(result, "\n", MAXLNLEN);
                             mystrcat(result, st, MAXLNLEN);
@@ -1848,14 +1998,14 @@ char * Hunspell::morph_with_correction(const char * word)
                      break;
                    }
      case HUHCAP: {
-                     st = pSMgr->suggest_morph_for_spelling_error(cw);
+                     st = pSMgr->suggest_morph_for_spelling_error(ctx, cw);
                      if (st) {
                         mystrcat(result, st, MAXLNLEN);
                         free(st);
                      }
                      memcpy(wspace,cw,(wl+1));
                      mkallsmall(wspace);
-                     st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                     st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                      if (st) {
                         if (*result) mystrcat(result, "\n", MAXLNLEN);
                         mystrcat(result, st, MAXLNLEN);
@@ -1865,20 +2015,20 @@ char * Hunspell::morph_with_correction(const char * word)
                  }
      case ALLCAP: {
                      memcpy(wspace,cw,(wl+1));
-                     st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                     st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                      if (st) {
                         mystrcat(result, st, MAXLNLEN);
                         free(st);
                      }
                      mkallsmall(wspace);
-                     st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                     st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                      if (st) {
                         if (*result) mystrcat(result, "\n", MAXLNLEN);
                         mystrcat(result, st, MAXLNLEN);
                         free(st);
                      }
                      mkinitcap(wspace);
-                     st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                     st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                      if (st) {
                         if (*result) mystrcat(result, "\n", MAXLNLEN);
                         mystrcat(result, st, MAXLNLEN);
@@ -1889,20 +2039,20 @@ char * Hunspell::morph_with_correction(const char * word)
                         *(wspace+wl) = '.';
                         *(wspace+wl+1) = '\0';
                         if (*result) mystrcat(result, "\n", MAXLNLEN);
-                        st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                        st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                         if (st) {
                             mystrcat(result, st, MAXLNLEN);
                             free(st);
                         }
                         mkallsmall(wspace);
-                        st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                        st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                         if (st) {
                           if (*result) mystrcat(result, "\n", MAXLNLEN);
                           mystrcat(result, st, MAXLNLEN);
                           free(st);
                         }
                         mkinitcap(wspace);
-                        st = pSMgr->suggest_morph_for_spelling_error(wspace);
+                        st = pSMgr->suggest_morph_for_spelling_error(ctx, wspace);
                         if (st) {
                           if (*result) mystrcat(result, "\n", MAXLNLEN);
                           mystrcat(result, st, MAXLNLEN);
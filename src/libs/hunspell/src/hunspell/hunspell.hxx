@@ -3,6 +3,7 @@
 #include "hashmgr.hxx"
 #include "affixmgr.hxx"
 #include "suggestmgr.hxx"
+#include "spellcache.hxx"
 #include "langnum.hxx"
 
 #define  SPELL_XML "<?xml?>"
@@ -17,6 +18,36 @@
 #ifndef _MYSPELLMGR_HXX_
 #define _MYSPELLMGR_HXX_
 
+/* HunspellContext - per-call state of checking and suggestion
+ * The loaded dictionaries are not modified by spell(), suggest() and
+ * the morphological functions, so one Hunspell instance can be shared
+ * between threads when each thread passes its own context. The functions
+ * without a context argument use a temporary one. Run-time dictionary
+ * changes (add(), remove() etc.) still need exclusive access.
+ * The context also keeps the finished passes of an interrupted
+ * suggestion search (see the timeout variant of suggest()).
+ */
+
+class LIBHUNSPELL_DLL_EXPORTED HunspellContext : public sug_ctx
+{
+  friend class Hunspell;
+  char *  sugword;   // word of the last suggestion search
+  unsigned int sugeneration; // dictionary generation of the search
+  char ** reported;  // suggestions already passed to the callback
+  int     nreported;
+
+  HunspellContext(const HunspellContext &);
+  HunspellContext & operator = (const HunspellContext &);
+
+public:
+  HunspellContext();
+  ~HunspellContext();
+
+  void reset();
+};
+
+typedef void (*hunspell_suggest_callback)(const char * suggestion, void * data);
+
 class LIBHUNSPELL_DLL_EXPORTED Hunspell
 {
   AffixMgr*       pAMgr;
@@ -30,6 +61,10 @@ class LIBHUNSPELL_DLL_EXPORTED Hunspell
   int             utf8;
   int             complexprefixes;
   char**          wordbreak;
+  SpellCache *    cache;
+  unsigned int    generation;  // bumped by the dictionary changes
+  int             ngram_minwords;
+  int             ngram_candidates;
 
 public:
 
@@ -40,6 +75,15 @@ public:
   Hunspell(const char * affpath, const char * dpath, const char * key = NULL);
   ~Hunspell();
 
+  /* compile(aff, dic) - write the memory-mappable image of the dictionary
+   * next to it (foo.dic -> foo.hdic, see also the hcompile tool). The image
+   * replaces parsing the dictionary file in the next constructors as long
+   * as the affix and dictionary files keep their size and modification time.
+   * output: 0 = image written, 1 = error
+   */
+
+  static int compile(const char * affpath, const char * dpath);
+
   /* load extra dictionaries (only dic files) */
   int add_dic(const char * dpath, const char * key = NULL);
 
@@ -51,9 +95,14 @@ public:
    *     SPELL_COMPOUND  = a compound word 
    *     SPELL_FORBIDDEN = an explicit forbidden word
    *   root: root (stem), when input is a word with affix(es)
+   *
+   * The results (without root) are cached until the next dictionary
+   * change (add_dic(), add(), add_with_affix() or remove()).
    */
    
   int spell(const char * word, int * info = NULL, char ** root = NULL);
+  int spell(HunspellContext & ctx, const char * word, int * info = NULL,
+    char ** root = NULL);
 
   /* suggest(suggestions, word) - search suggestions
    * input: pointer to an array of strings pointer and the (bad) word
@@ -64,6 +113,20 @@ public:
    */
 
   int suggest(char*** slst, const char * word);
+  int suggest(HunspellContext & ctx, char*** slst, const char * word);
+
+  /* suggest(ctx, slst, word, timeout, callback, data) - bounded search
+   * The search stops after timeout milliseconds (0 = no limit) and returns
+   * the suggestions found so far. callback(suggestion, data) is called for
+   * each suggestion not reported by an earlier call. ctx.timedout is set
+   * when the search was interrupted: calling again with the same context
+   * and word resumes it, skipping the passes that had already finished.
+   * A finished search, another word or a dictionary change since the
+   * interrupted call start a new search.
+   */
+
+  int suggest(HunspellContext & ctx, char*** slst, const char * word,
+    int timeout, hunspell_suggest_callback callback = NULL, void * data = NULL);
 
   /* deallocate suggestion lists */
 
@@ -71,15 +134,34 @@ public:
 
   char * get_dic_encoding();
 
+  /* set_ngram_minwords(minwords) - dictionaries of at least minwords words
+   * (NGRAM_INDEX_MINWORDS by default, 0 = all) get a trigram index, so the
+   * n-gram suggestion scores only the words sharing trigrams with the
+   * misspelling; smaller ones are walked entirely. The index is built
+   * at the first suggestion that needs it.
+   */
+
+  void set_ngram_minwords(int minwords);
+
+  /* set_ngram_candidates(candidates) - the trigram index prunes the n-gram
+   * suggestion to about candidates words (NGRAM_CANDIDATES by default)
+   * sharing the most trigrams with the misspelling. Less candidates are
+   * faster, but may miss a suggestion the whole dictionary would give.
+   */
+
+  void set_ngram_candidates(int candidates);
+
  /* morphological functions */
 
  /* analyze(result, word) - morphological analysis of the word */
  
   int analyze(char*** slst, const char * word);
+  int analyze(HunspellContext & ctx, char*** slst, const char * word);
 
  /* stem(result, word) - stemmer function */
   
   int stem(char*** slst, const char * word);
+  int stem(HunspellContext & ctx, char*** slst, const char * word);
   
  /* stem(result, analysis, n) - get stems from a morph. analysis
   * example:
@@ -93,6 +175,8 @@ public:
  /* generate(result, word, word2) - morphological generation by example(s) */
 
   int generate(char*** slst, const char * word, const char * word2);
+  int generate(HunspellContext & ctx, char*** slst, const char * word,
+    const char * word2);
 
  /* generate(result, word, desc, n) - generation by morph. description(s)
   * example:
@@ -103,6 +187,8 @@ public:
   */
 
   int generate(char*** slst, const char * word, char ** desc, int n);
+  int generate(HunspellContext & ctx, char*** slst, const char * word,
+    char ** desc, int n);
 
   /* functions for run-time modification of the dictionary */
 
@@ -154,14 +240,16 @@ private:
    int    mkallcap2(char * p, w_char * u, int nc);
    void   mkallsmall(char *);
    int    mkallsmall2(char * p, w_char * u, int nc);
-   struct hentry * checkword(const char *, int * info, char **root);
+   struct hentry * checkword(HunspellContext &, const char *, int * info, char **root);
    char * sharps_u8_l1(char * dest, char * source);
-   hentry * spellsharps(char * base, char *, int, int, char * tmp, int * info, char **root);
+   hentry * spellsharps(HunspellContext &, char * base, char *, int, int, char * tmp, int * info, char **root);
    int    is_keepcase(const hentry * rv);
    int    insert_sug(char ***slst, char * word, int ns);
    void   cat_result(char * result, char * st);
    char * stem_description(const char * desc);
-   int    spellml(char*** slst, const char * word);
+   int    spellml(HunspellContext &, char*** slst, const char * word);
+   int    spell_word(HunspellContext &, const char * word, int * info, char ** root);
+   int    suggest_word(HunspellContext &, char*** slst, const char * word);
    int    get_xml_par(char * dest, const char * par, int maxl);
    const char * get_xml_pos(const char * s, const char * attr);
    int    get_xml_list(char ***slst, char * list, const char * tag);
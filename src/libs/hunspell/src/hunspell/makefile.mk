@@ -53,6 +53,7 @@ SLOFILES=	\
 		$(SLO)$/hunzip.obj \
 		$(SLO)$/filemgr.obj \
 		$(SLO)$/replist.obj \
+		$(SLO)$/spellcache.obj \
 		$(SLO)$/hunspell.obj
 
 LIB1TARGET= $(SLB)$/lib$(TARGET).lib
@@ -0,0 +1,131 @@
+#include "license.hunspell"
+#include "license.myspell"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef CRITICAL_SECTION cache_lock;
+#define LOCK_INIT(l) InitializeCriticalSection(l)
+#define LOCK_DESTROY(l) DeleteCriticalSection(l)
+#define LOCK(l) EnterCriticalSection(l)
+#define UNLOCK(l) LeaveCriticalSection(l)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t cache_lock;
+#define LOCK_INIT(l) pthread_mutex_init(l, NULL)
+#define LOCK_DESTROY(l) pthread_mutex_destroy(l)
+#define LOCK(l) pthread_mutex_lock(l)
+#define UNLOCK(l) pthread_mutex_unlock(l)
+#endif
+
+#include "spellcache.hxx"
+
+// FNV-1a hash and length of a word, 0 length if it is too long to cache
+static unsigned int cache_hash(const char * word, int * len)
+{
+    const unsigned char * p = (const unsigned char *) word;
+    unsigned int h = 2166136261U;
+    int n = 0;
+    for (; *p; p++, n++) {
+        if (n == SPELLCACHE_WORDLEN) {
+            *len = 0;
+            return 0;
+        }
+        h = (h ^ *p) * 16777619U;
+    }
+    *len = n;
+    return h;
+}
+
+SpellCache::SpellCache()
+{
+    entries = (struct spellcache_entry *)
+        calloc(SPELLCACHE_SETS * SPELLCACHE_WAYS, sizeof(struct spellcache_entry));
+    hands = (unsigned char *) calloc(SPELLCACHE_SETS, 1);
+    locks = malloc(SPELLCACHE_LOCKS * sizeof(cache_lock));
+    if (!entries || !hands || !locks) {
+        free(entries);
+        free(hands);
+        free(locks);
+        entries = NULL;
+        hands = NULL;
+        locks = NULL;
+        return;
+    }
+    for (int i = 0; i < SPELLCACHE_LOCKS; i++) LOCK_INIT((cache_lock *) locks + i);
+}
+
+SpellCache::~SpellCache()
+{
+    if (locks) {
+        for (int i = 0; i < SPELLCACHE_LOCKS; i++) LOCK_DESTROY((cache_lock *) locks + i);
+    }
+    free(entries);
+    free(hands);
+    free(locks);
+}
+
+// result of a word checked in the given generation, 0 if not cached
+int SpellCache::lookup(const char * word, unsigned int generation, int * result, int * info)
+{
+    int len;
+    unsigned int h = cache_hash(word, &len);
+    if (!entries || !len) return 0;
+    unsigned int set = h & (SPELLCACHE_SETS - 1);
+    struct spellcache_entry * e = entries + set * SPELLCACHE_WAYS;
+    cache_lock * lock = (cache_lock *) locks + (set & (SPELLCACHE_LOCKS - 1));
+    int found = 0;
+    LOCK(lock);
+    for (int i = 0; i < SPELLCACHE_WAYS; i++, e++) {
+        if (e->hash == h && e->len == len && e->generation == generation &&
+            memcmp(e->word, word, len) == 0) {
+            e->ref = 1;
+            *result = e->result;
+            *info = e->info;
+            found = 1;
+            break;
+        }
+    }
+    UNLOCK(lock);
+    return found;
+}
+
+void SpellCache::store(const char * word, unsigned int generation, int result, int info)
+{
+    int len;
+    unsigned int h = cache_hash(word, &len);
+    if (!entries || !len) return;
+    unsigned int set = h & (SPELLCACHE_SETS - 1);
+    struct spellcache_entry * e = entries + set * SPELLCACHE_WAYS;
+    cache_lock * lock = (cache_lock *) locks + (set & (SPELLCACHE_LOCKS - 1));
+    LOCK(lock);
+    // the word itself (stored by another thread), a free or an outdated
+    // entry, else the first unreferenced one from the clock hand
+    int way = -1;
+    for (int i = 0; i < SPELLCACHE_WAYS; i++) {
+        if (e[i].hash == h && e[i].len == len && memcmp(e[i].word, word, len) == 0) {
+            way = i;
+            break;
+        }
+        if (way == -1 && (!e[i].len || e[i].generation != generation)) way = i;
+    }
+    if (way == -1) {
+        int hand = hands[set];
+        while (e[hand].ref) {
+            e[hand].ref = 0;
+            hand = (hand + 1) % SPELLCACHE_WAYS;
+        }
+        way = hand;
+        hands[set] = (unsigned char) ((hand + 1) % SPELLCACHE_WAYS);
+    }
+    e[way].hash = h;
+    e[way].generation = generation;
+    e[way].result = result;
+    e[way].info = info;
+    e[way].len = (unsigned char) len;
+    e[way].ref = 0;
+    memcpy(e[way].word, word, len);
+    UNLOCK(lock);
+}
@@ -0,0 +1,43 @@
+/* cache of spell() results */
+#ifndef _SPELLCACHE_HXX_
+#define _SPELLCACHE_HXX_
+
+#include "hunvisapi.h"
+
+#define SPELLCACHE_SETS 1024   // power of two
+#define SPELLCACHE_WAYS 8      // entries of a set, replaced in CLOCK order
+#define SPELLCACHE_LOCKS 16    // power of two, a lock guards every 16th set
+#define SPELLCACHE_WORDLEN 46  // longer words are not cached
+
+struct spellcache_entry {
+  unsigned int  hash;
+  unsigned int  generation; // dictionary generation of the result
+  int           result;
+  int           info;
+  unsigned char len;        // 0 if free
+  unsigned char ref;        // referenced since the clock hand passed
+  char          word[SPELLCACHE_WORDLEN];
+};
+
+/* SpellCache - results of spell() by word
+ * Lookups and stores may come from several threads; a result is valid
+ * only for the dictionary generation it was stored with.
+ */
+
+class LIBHUNSPELL_DLL_EXPORTED SpellCache
+{
+    struct spellcache_entry * entries;
+    unsigned char * hands;
+    void * locks;
+
+    SpellCache(const SpellCache &);
+    SpellCache & operator = (const SpellCache &);
+
+public:
+    SpellCache();
+    ~SpellCache();
+
+    int lookup(const char * word, unsigned int generation, int * result, int * info);
+    void store(const char * word, unsigned int generation, int result, int info);
+};
+#endif
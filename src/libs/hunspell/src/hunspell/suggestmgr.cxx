@@ -12,6 +12,80 @@
 
 const w_char W_VLINE = { '\0', '|' };
 
+sug_ctx::sug_ctx() : pass(0), npasses(0), counts(NULL), results(NULL),
+  nresults(0), cursor(0), scanpass(-1)
+{
+}
+
+sug_ctx::~sug_ctx()
+{
+  clear();
+}
+
+// start (or resume) a search, limited to the monotonic_usec() deadline
+void sug_ctx::begin(unsigned long long limit)
+{
+  pass = 0;
+  cursor = 0;
+  deadline = limit;
+  timedout = 0;
+}
+
+// forget the recorded passes
+void sug_ctx::clear()
+{
+  for (int i = 0; i < nresults; i++) free(results[i]);
+  free(results);
+  free(counts);
+  results = NULL;
+  counts = NULL;
+  nresults = 0;
+  npasses = 0;
+  cursor = 0;
+  scanpass = -1;
+}
+
+// add the suggestions of the next pass when it was recorded by an
+// interrupted search, return 0 when the pass has to run
+int sug_ctx::replay(char ** wlst, int * ns, int maxn)
+{
+  if (pass >= npasses) return 0;
+  for (int i = 0; i < counts[pass]; i++, cursor++) {
+    if (*ns < maxn) {
+      wlst[*ns] = mystrdup(results[cursor]);
+      if (wlst[*ns]) (*ns)++;
+    }
+  }
+  pass++;
+  return 1;
+}
+
+// record the suggestions wlst[from..to) of a pass finished in time,
+// only a search with a deadline can be resumed
+void sug_ctx::record(char ** wlst, int from, int to)
+{
+  if (pass++ != npasses || to < from || !deadline || expired()) return;
+  int * c = (int *) realloc(counts, (npasses + 1) * sizeof(int));
+  if (!c) return;
+  counts = c;
+  if (to > from) {
+    char ** r = (char **) realloc(results, (nresults + to - from) * sizeof(char *));
+    if (!r) return;
+    results = r;
+    for (int i = from; i < to; i++) {
+      results[nresults + i - from] = mystrdup(wlst[i]);
+      if (!results[nresults + i - from]) {
+        // a pass recorded only in part would replay differently
+        for (int j = from; j < i; j++) free(results[nresults + j - from]);
+        return;
+      }
+    }
+  }
+  counts[npasses++] = to - from;
+  nresults += to - from;
+  cursor += to - from;
+}
+
 SuggestMgr::SuggestMgr(const char * tryme, int maxn, 
                        AffixMgr * aptr)
 {
@@ -102,14 +176,14 @@ SuggestMgr::~SuggestMgr()
 #endif
 }
 
-int SuggestMgr::testsug(char** wlst, const char * candidate, int wl, int ns, int cpdsuggest,
+int SuggestMgr::testsug(affix_ctx & ctx, char** wlst, const char * candidate, int wl, int ns, int cpdsuggest,
    int * timer, clock_t * timelimit) {
       int cwrd = 1;
       if (ns == maxSug) return maxSug;
       for (int k=0; k < ns; k++) {
         if (strcmp(candidate,wlst[k]) == 0) cwrd = 0;
       }
-      if ((cwrd) && checkword(candidate, wl, cpdsuggest, timer, timelimit)) {
+      if ((cwrd) && checkword(ctx, candidate, wl, cpdsuggest, timer, timelimit)) {
         wlst[ns] = mystrdup(candidate);
         if (wlst[ns] == NULL) {
             for (int j=0; j<ns; j++) free(wlst[j]);
@@ -124,7 +198,7 @@ int SuggestMgr::testsug(char** wlst, const char * candidate, int wl, int ns, int
 //    pass in address of array of char * pointers
 // onlycompoundsug: probably bad suggestions (need for ngram sugs, too)
 
-int SuggestMgr::suggest(char*** slst, const char * w, int nsug,
+int SuggestMgr::suggest(sug_ctx & ctx, char*** slst, const char * w, int nsug,
     int * onlycompoundsug)
 {
   int nocompoundtwowords = 0;
@@ -167,76 +241,100 @@ int SuggestMgr::suggest(char*** slst, const char * w, int nsug,
     if (cpdsuggest > 0) oldSug = nsug;
 
     // suggestions for an uppercase word (html -> HTML)
-    if ((nsug < maxSug) && (nsug > -1)) {
-        nsug = (utf8) ? capchars_utf(wlst, word_utf, wl, nsug, cpdsuggest) :
-                    capchars(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = (utf8) ? capchars_utf(ctx, wlst, word_utf, wl, nsug, cpdsuggest) :
+                    capchars(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
     // perhaps we made a typical fault of spelling
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-      nsug = replchars(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+      int prevsug = nsug;
+      nsug = replchars(ctx, wlst, word, nsug, cpdsuggest);
+      ctx.record(wlst, prevsug, nsug);
     }
 
     // perhaps we made chose the wrong char from a related set
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-      nsug = mapchars(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+      int prevsug = nsug;
+      nsug = mapchars(ctx, wlst, word, nsug, cpdsuggest);
+      ctx.record(wlst, prevsug, nsug);
     }
 
     // only suggest compound words when no other suggestion
     if ((cpdsuggest == 0) && (nsug > nsugorig)) nocompoundtwowords=1;
 
     // did we swap the order of chars by mistake
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-        nsug = (utf8) ? swapchar_utf(wlst, word_utf, wl, nsug, cpdsuggest) :
-                    swapchar(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = (utf8) ? swapchar_utf(ctx, wlst, word_utf, wl, nsug, cpdsuggest) :
+                    swapchar(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
     // did we swap the order of non adjacent chars by mistake
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-        nsug = (utf8) ? longswapchar_utf(wlst, word_utf, wl, nsug, cpdsuggest) :
-                    longswapchar(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = (utf8) ? longswapchar_utf(ctx, wlst, word_utf, wl, nsug, cpdsuggest) :
+                    longswapchar(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
     // did we just hit the wrong key in place of a good char (case and keyboard)
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-        nsug = (utf8) ? badcharkey_utf(wlst, word_utf, wl, nsug, cpdsuggest) :
-                    badcharkey(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = (utf8) ? badcharkey_utf(ctx, wlst, word_utf, wl, nsug, cpdsuggest) :
+                    badcharkey(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
     // did we add a char that should not be there
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-        nsug = (utf8) ? extrachar_utf(wlst, word_utf, wl, nsug, cpdsuggest) :
-                    extrachar(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = (utf8) ? extrachar_utf(ctx, wlst, word_utf, wl, nsug, cpdsuggest) :
+                    extrachar(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
 
     // did we forgot a char
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-        nsug = (utf8) ? forgotchar_utf(wlst, word_utf, wl, nsug, cpdsuggest) :
-                    forgotchar(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = (utf8) ? forgotchar_utf(ctx, wlst, word_utf, wl, nsug, cpdsuggest) :
+                    forgotchar(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
     // did we move a char
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-        nsug = (utf8) ? movechar_utf(wlst, word_utf, wl, nsug, cpdsuggest) :
-                    movechar(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = (utf8) ? movechar_utf(ctx, wlst, word_utf, wl, nsug, cpdsuggest) :
+                    movechar(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
     // did we just hit the wrong key in place of a good char
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-        nsug = (utf8) ? badchar_utf(wlst, word_utf, wl, nsug, cpdsuggest) :
-                    badchar(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = (utf8) ? badchar_utf(ctx, wlst, word_utf, wl, nsug, cpdsuggest) :
+                    badchar(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
     // did we double two characters
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-        nsug = (utf8) ? doubletwochars_utf(wlst, word_utf, wl, nsug, cpdsuggest) :
-                    doubletwochars(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = (utf8) ? doubletwochars_utf(ctx, wlst, word_utf, wl, nsug, cpdsuggest) :
+                    doubletwochars(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
     // perhaps we forgot to hit space and two words ran together
-    if (!nosplitsugs && (nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs))) {
-        nsug = twowords(wlst, word, nsug, cpdsuggest);
+    if (!nosplitsugs && (nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && !ctx.replay(wlst, &nsug, maxSug)) {
+        int prevsug = nsug;
+        nsug = twowords(ctx, wlst, word, nsug, cpdsuggest);
+        ctx.record(wlst, prevsug, nsug);
     }
 
     } // repeating ``for'' statement compounding support
@@ -258,7 +356,7 @@ int SuggestMgr::suggest(char*** slst, const char * w, int nsug,
 // generate suggestions for a word with typical mistake
 //    pass in address of array of char * pointers
 #ifdef HUNSPELL_EXPERIMENTAL
-int SuggestMgr::suggest_auto(char*** slst, const char * w, int nsug)
+int SuggestMgr::suggest_auto(affix_ctx & ctx, char*** slst, const char * w, int nsug)
 {
     int nocompoundtwowords = 0;
     char ** wlst;
@@ -288,18 +386,18 @@ int SuggestMgr::suggest_auto(char*** slst, const char * w, int nsug)
 
     // perhaps we made a typical fault of spelling
     if ((nsug < maxSug) && (nsug > -1))
-    nsug = replchars(wlst, word, nsug, cpdsuggest);
+    nsug = replchars(ctx, wlst, word, nsug, cpdsuggest);
 
     // perhaps we made chose the wrong char from a related set
     if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)))
-      nsug = mapchars(wlst, word, nsug, cpdsuggest);
+      nsug = mapchars(ctx, wlst, word, nsug, cpdsuggest);
 
     if ((cpdsuggest==0) && (nsug>0)) nocompoundtwowords=1;
 
     // perhaps we forgot to hit space and two words ran together
 
-    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && check_forbidden(word, strlen(word))) {
-                nsug = twowords(wlst, word, nsug, cpdsuggest);
+    if ((nsug < maxSug) && (nsug > -1) && (!cpdsuggest || (nsug < oldSug + maxcpdsugs)) && check_forbidden(ctx, word, strlen(word))) {
+                nsug = twowords(ctx, wlst, word, nsug, cpdsuggest);
         }
     
     } // repeating ``for'' statement compounding support
@@ -317,27 +415,27 @@ int SuggestMgr::suggest_auto(char*** slst, const char * w, int nsug)
 #endif // END OF HUNSPELL_EXPERIMENTAL CODE
 
 // suggestions for an uppercase word (html -> HTML)
-int SuggestMgr::capchars_utf(char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
+int SuggestMgr::capchars_utf(affix_ctx & ctx, char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
 {
   char candidate[MAXSWUTF8L];
   w_char candidate_utf[MAXSWL];
   memcpy(candidate_utf, word, wl * sizeof(w_char));
   mkallcap_utf(candidate_utf, wl, langnum);
   u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-  return testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+  return testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
 }
 
 // suggestions for an uppercase word (html -> HTML)
-int SuggestMgr::capchars(char** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::capchars(affix_ctx & ctx, char** wlst, const char * word, int ns, int cpdsuggest)
 {
   char candidate[MAXSWUTF8L];
   strcpy(candidate, word);
   mkallcap(candidate, csconv);
-  return testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+  return testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
 }
 
 // suggestions for when chose the wrong char out of a related set
-int SuggestMgr::mapchars(char** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::mapchars(affix_ctx & ctx, char** wlst, const char * word, int ns, int cpdsuggest)
 {
   char candidate[MAXSWUTF8L];
   clock_t timelimit;
@@ -353,10 +451,10 @@ int SuggestMgr::mapchars(char** wlst, const char * word, int ns, int cpdsuggest)
 
   timelimit = clock();
   timer = MINTIMER;
-  return map_related(word, (char *) &candidate, 0, 0, wlst, cpdsuggest, ns, maptable, nummap, &timer, &timelimit);
+  return map_related(ctx, word, (char *) &candidate, 0, 0, wlst, cpdsuggest, ns, maptable, nummap, &timer, &timelimit);
 }
 
-int SuggestMgr::map_related(const char * word, char * candidate, int wn, int cn,
+int SuggestMgr::map_related(affix_ctx & ctx, const char * word, char * candidate, int wn, int cn,
     char** wlst, int cpdsuggest,  int ns,
     const mapentry* maptable, int nummap, int * timer, clock_t * timelimit)
 {
@@ -366,7 +464,7 @@ int SuggestMgr::map_related(const char * word, char * candidate, int wn, int cn,
       int wl = strlen(candidate);
       for (int m=0; m < ns; m++)
           if (strcmp(candidate, wlst[m]) == 0) cwrd = 0;
-      if ((cwrd) && checkword(candidate, wl, cpdsuggest, timer, timelimit)) {
+      if ((cwrd) && checkword(ctx, candidate, wl, cpdsuggest, timer, timelimit)) {
           if (ns < maxSug) {
               wlst[ns] = mystrdup(candidate);
               if (wlst[ns] == NULL) return -1;
@@ -383,7 +481,7 @@ int SuggestMgr::map_related(const char * word, char * candidate, int wn, int cn,
         in_map = 1;
         for (int l = 0; l < maptable[j].len; l++) {
 	  strcpy(candidate + cn, maptable[j].set[l]);
-	  ns = map_related(word, candidate, wn + len, strlen(candidate), wlst,
+	  ns = map_related(ctx, word, candidate, wn + len, strlen(candidate), wlst,
 		cpdsuggest, ns, maptable, nummap, timer, timelimit);
     	  if (!(*timer)) return ns;
 	}
@@ -392,7 +490,7 @@ int SuggestMgr::map_related(const char * word, char * candidate, int wn, int cn,
   }
   if (!in_map) {
      *(candidate + cn) = *(word + wn);
-     ns = map_related(word, candidate, wn + 1, cn + 1, wlst, cpdsuggest,
+     ns = map_related(ctx, word, candidate, wn + 1, cn + 1, wlst, cpdsuggest,
         ns, maptable, nummap, timer, timelimit);
   }
   return ns;
@@ -400,7 +498,7 @@ int SuggestMgr::map_related(const char * word, char * candidate, int wn, int cn,
 
 // suggestions for a typical fault of spelling, that
 // differs with more, than 1 letter from the right form.
-int SuggestMgr::replchars(char** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::replchars(affix_ctx & ctx, char** wlst, const char * word, int ns, int cpdsuggest)
 {
   char candidate[MAXSWUTF8L];
   const char * r;
@@ -421,7 +519,7 @@ int SuggestMgr::replchars(char** wlst, const char * word, int ns, int cpdsuggest
           if (r-word + lenr + strlen(r+lenp) >= MAXSWUTF8L) break;
           strcpy(candidate+(r-word),reptable[i].pattern2);
           strcpy(candidate+(r-word)+lenr, r+lenp);
-          ns = testsug(wlst, candidate, wl-lenp+lenr, ns, cpdsuggest, NULL, NULL);
+          ns = testsug(ctx, wlst, candidate, wl-lenp+lenr, ns, cpdsuggest, NULL, NULL);
           if (ns == -1) return -1;
           // check REP suggestions with space
           char * sp = strchr(candidate, ' ');
@@ -429,10 +527,10 @@ int SuggestMgr::replchars(char** wlst, const char * word, int ns, int cpdsuggest
             char * prev = candidate;
             while (sp) {
               *sp = '\0';
-              if (checkword(prev, strlen(prev), 0, NULL, NULL)) {
+              if (checkword(ctx, prev, strlen(prev), 0, NULL, NULL)) {
                 int oldns = ns;
                 *sp = ' ';
-                ns = testsug(wlst, sp + 1, strlen(sp + 1), ns, cpdsuggest, NULL, NULL);
+                ns = testsug(ctx, wlst, sp + 1, strlen(sp + 1), ns, cpdsuggest, NULL, NULL);
                 if (ns == -1) return -1;
                 if (oldns < ns) {
                   free(wlst[ns - 1]);
@@ -452,7 +550,7 @@ int SuggestMgr::replchars(char** wlst, const char * word, int ns, int cpdsuggest
 }
 
 // perhaps we doubled two characters (pattern aba -> ababa, for example vacation -> vacacation)
-int SuggestMgr::doubletwochars(char** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::doubletwochars(affix_ctx & ctx, char** wlst, const char * word, int ns, int cpdsuggest)
 {
   char candidate[MAXSWUTF8L];
   int state=0;
@@ -464,7 +562,7 @@ int SuggestMgr::doubletwochars(char** wlst, const char * word, int ns, int cpdsu
           if (state==3) {
             strcpy(candidate,word);
             strcpy(candidate+i-1,word+i+1);
-            ns = testsug(wlst, candidate, wl-2, ns, cpdsuggest, NULL, NULL);
+            ns = testsug(ctx, wlst, candidate, wl-2, ns, cpdsuggest, NULL, NULL);
             if (ns == -1) return -1;
             state=0;
           }
@@ -476,7 +574,7 @@ int SuggestMgr::doubletwochars(char** wlst, const char * word, int ns, int cpdsu
 }
 
 // perhaps we doubled two characters (pattern aba -> ababa, for example vacation -> vacacation)
-int SuggestMgr::doubletwochars_utf(char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
+int SuggestMgr::doubletwochars_utf(affix_ctx & ctx, char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
 {
   w_char        candidate_utf[MAXSWL];
   char          candidate[MAXSWUTF8L];
@@ -489,7 +587,7 @@ int SuggestMgr::doubletwochars_utf(char ** wlst, const w_char * word, int wl, in
             memcpy(candidate_utf, word, (i - 1) * sizeof(w_char));
             memcpy(candidate_utf+i-1, word+i+1, (wl-i-1) * sizeof(w_char));
             u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl-2);
-            ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+            ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
             if (ns == -1) return -1;
             state=0;
           }
@@ -501,7 +599,7 @@ int SuggestMgr::doubletwochars_utf(char ** wlst, const w_char * word, int wl, in
 }
 
 // error is wrong char in place of correct one (case and keyboard related version)
-int SuggestMgr::badcharkey(char ** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::badcharkey(affix_ctx & ctx, char ** wlst, const char * word, int ns, int cpdsuggest)
 {
   char  tmpc;
   char  candidate[MAXSWUTF8L];
@@ -515,7 +613,7 @@ int SuggestMgr::badcharkey(char ** wlst, const char * word, int ns, int cpdsugge
     // check with uppercase letters
     candidate[i] = csconv[((unsigned char)tmpc)].cupper;
     if (tmpc != candidate[i]) {
-       ns = testsug(wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
+       ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
        if (ns == -1) return -1;
        candidate[i] = tmpc;
     }
@@ -525,12 +623,12 @@ int SuggestMgr::badcharkey(char ** wlst, const char * word, int ns, int cpdsugge
     while (loc) {
        if ((loc > ckey) && (*(loc - 1) != '|')) {
           candidate[i] = *(loc - 1);
-          ns = testsug(wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
+          ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
           if (ns == -1) return -1;
        }
        if ((*(loc + 1) != '|') && (*(loc + 1) != '\0')) {
           candidate[i] = *(loc + 1);
-          ns = testsug(wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
+          ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
           if (ns == -1) return -1;
        }
        loc = strchr(loc + 1, tmpc);
@@ -541,7 +639,7 @@ int SuggestMgr::badcharkey(char ** wlst, const char * word, int ns, int cpdsugge
 }
 
 // error is wrong char in place of correct one (case and keyboard related version)
-int SuggestMgr::badcharkey_utf(char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
+int SuggestMgr::badcharkey_utf(affix_ctx & ctx, char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
 {
   w_char        tmpc;
   w_char        candidate_utf[MAXSWL];
@@ -555,7 +653,7 @@ int SuggestMgr::badcharkey_utf(char ** wlst, const w_char * word, int wl, int ns
     mkallcap_utf(candidate_utf + i, 1, langnum);
     if (!w_char_eq(tmpc, candidate_utf[i])) {
        u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-       ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+       ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
        if (ns == -1) return -1;
        candidate_utf[i] = tmpc;
     }
@@ -567,13 +665,13 @@ int SuggestMgr::badcharkey_utf(char ** wlst, const w_char * word, int wl, int ns
        if ((loc > ckey_utf) && !w_char_eq(*(loc - 1), W_VLINE)) {
           candidate_utf[i] = *(loc - 1);
           u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-          ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+          ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
           if (ns == -1) return -1;
        }
        if (((loc + 1) < (ckey_utf + ckeyl)) && !w_char_eq(*(loc + 1), W_VLINE)) {
           candidate_utf[i] = *(loc + 1);
           u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-          ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+          ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
           if (ns == -1) return -1;
        }
        do { loc++; } while ((loc < (ckey_utf + ckeyl)) && !w_char_eq(*loc, tmpc));
@@ -584,7 +682,7 @@ int SuggestMgr::badcharkey_utf(char ** wlst, const w_char * word, int wl, int ns
 }
 
 // error is wrong char in place of correct one
-int SuggestMgr::badchar(char ** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::badchar(affix_ctx & ctx, char ** wlst, const char * word, int ns, int cpdsuggest)
 {
   char  tmpc;
   char  candidate[MAXSWUTF8L];
@@ -599,7 +697,7 @@ int SuggestMgr::badchar(char ** wlst, const char * word, int ns, int cpdsuggest)
        tmpc = candidate[i];
        if (ctry[j] == tmpc) continue;
        candidate[i] = ctry[j];
-       ns = testsug(wlst, candidate, wl, ns, cpdsuggest, &timer, &timelimit);
+       ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, &timer, &timelimit);
        if (ns == -1) return -1;
        if (!timer) return ns;
        candidate[i] = tmpc;
@@ -609,7 +707,7 @@ int SuggestMgr::badchar(char ** wlst, const char * word, int ns, int cpdsuggest)
 }
 
 // error is wrong char in place of correct one
-int SuggestMgr::badchar_utf(char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
+int SuggestMgr::badchar_utf(affix_ctx & ctx, char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
 {
   w_char        tmpc;
   w_char        candidate_utf[MAXSWL];
@@ -625,7 +723,7 @@ int SuggestMgr::badchar_utf(char ** wlst, const w_char * word, int wl, int ns, i
        if (w_char_eq(tmpc, ctry_utf[j])) continue;
        candidate_utf[i] = ctry_utf[j];
        u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-       ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, &timer, &timelimit);
+       ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, &timer, &timelimit);
        if (ns == -1) return -1;
        if (!timer) return ns;
        candidate_utf[i] = tmpc;
@@ -635,7 +733,7 @@ int SuggestMgr::badchar_utf(char ** wlst, const w_char * word, int wl, int ns, i
 }
 
 // error is word has an extra letter it does not need 
-int SuggestMgr::extrachar_utf(char** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
+int SuggestMgr::extrachar_utf(affix_ctx & ctx, char** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
 {
    char   candidate[MAXSWUTF8L];
    w_char candidate_utf[MAXSWL];
@@ -648,7 +746,7 @@ int SuggestMgr::extrachar_utf(char** wlst, const w_char * word, int wl, int ns,
        w_char tmpc2 = *p;
        if (p < candidate_utf + wl - 1) *p = tmpc;
        u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl - 1);
-       ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+       ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
        if (ns == -1) return -1;
        tmpc = tmpc2;
    }
@@ -656,7 +754,7 @@ int SuggestMgr::extrachar_utf(char** wlst, const w_char * word, int wl, int ns,
 }
 
 // error is word has an extra letter it does not need 
-int SuggestMgr::extrachar(char** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::extrachar(affix_ctx & ctx, char** wlst, const char * word, int ns, int cpdsuggest)
 {
    char    tmpc = '\0';
    char    candidate[MAXSWUTF8L];
@@ -668,7 +766,7 @@ int SuggestMgr::extrachar(char** wlst, const char * word, int ns, int cpdsuggest
    for (p = candidate + wl - 1; p >=candidate; p--) {
       char tmpc2 = *p;
       *p = tmpc;
-      ns = testsug(wlst, candidate, wl-1, ns, cpdsuggest, NULL, NULL);
+      ns = testsug(ctx, wlst, candidate, wl-1, ns, cpdsuggest, NULL, NULL);
       if (ns == -1) return -1;
       tmpc = tmpc2;
    }
@@ -676,7 +774,7 @@ int SuggestMgr::extrachar(char** wlst, const char * word, int ns, int cpdsuggest
 }
 
 // error is missing a letter it needs
-int SuggestMgr::forgotchar(char ** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::forgotchar(affix_ctx & ctx, char ** wlst, const char * word, int ns, int cpdsuggest)
 {
    char candidate[MAXSWUTF8L];
    char * p;
@@ -689,7 +787,7 @@ int SuggestMgr::forgotchar(char ** wlst, const char * word, int ns, int cpdsugge
       for (p = candidate + wl;  p >= candidate; p--)  {
          *(p+1) = *p;
          *p = ctry[i];
-         ns = testsug(wlst, candidate, wl+1, ns, cpdsuggest, &timer, &timelimit);
+         ns = testsug(ctx, wlst, candidate, wl+1, ns, cpdsuggest, &timer, &timelimit);
          if (ns == -1) return -1;
          if (!timer) return ns;
       }
@@ -698,7 +796,7 @@ int SuggestMgr::forgotchar(char ** wlst, const char * word, int ns, int cpdsugge
 }
 
 // error is missing a letter it needs
-int SuggestMgr::forgotchar_utf(char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
+int SuggestMgr::forgotchar_utf(affix_ctx & ctx, char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
 {
    w_char  candidate_utf[MAXSWL];
    char    candidate[MAXSWUTF8L];
@@ -712,7 +810,7 @@ int SuggestMgr::forgotchar_utf(char ** wlst, const w_char * word, int wl, int ns
          *(p + 1) = *p;
          *p = ctry_utf[i];
          u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl + 1);
-         ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, &timer, &timelimit);
+         ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, &timer, &timelimit);
          if (ns == -1) return -1;
          if (!timer) return ns;
       }
@@ -722,7 +820,7 @@ int SuggestMgr::forgotchar_utf(char ** wlst, const w_char * word, int wl, int ns
 
 
 /* error is should have been two words */
-int SuggestMgr::twowords(char ** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::twowords(affix_ctx & ctx, char ** wlst, const char * word, int ns, int cpdsuggest)
 {
     char candidate[MAXSWUTF8L];
     char * p;
@@ -733,7 +831,7 @@ int SuggestMgr::twowords(char ** wlst, const char * word, int ns, int cpdsuggest
     int wl=strlen(word);
     if (wl < 3) return ns;
     
-    if (langnum == LANG_hu) forbidden = check_forbidden(word, wl);
+    if (langnum == LANG_hu) forbidden = check_forbidden(ctx, word, wl);
 
     strcpy(candidate + 1, word);
     // split the string into two pieces after every char
@@ -747,9 +845,9 @@ int SuggestMgr::twowords(char ** wlst, const char * word, int ns, int cpdsuggest
        }
        if (utf8 && p[1] == '\0') break; // last UTF-8 character
        *p = '\0';
-       c1 = checkword(candidate,strlen(candidate), cpdsuggest, NULL, NULL);
+       c1 = checkword(ctx, candidate,strlen(candidate), cpdsuggest, NULL, NULL);
        if (c1) {
-         c2 = checkword((p+1),strlen(p+1), cpdsuggest, NULL, NULL);
+         c2 = checkword(ctx, (p+1),strlen(p+1), cpdsuggest, NULL, NULL);
          if (c2) {
             *p = ' ';
 
@@ -795,7 +893,7 @@ int SuggestMgr::twowords(char ** wlst, const char * word, int ns, int cpdsuggest
 
 
 // error is adjacent letter were swapped
-int SuggestMgr::swapchar(char ** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::swapchar(affix_ctx & ctx, char ** wlst, const char * word, int ns, int cpdsuggest)
 {
    char candidate[MAXSWUTF8L];
    char * p;
@@ -807,7 +905,7 @@ int SuggestMgr::swapchar(char ** wlst, const char * word, int ns, int cpdsuggest
       tmpc = *p;
       *p = p[1];
       p[1] = tmpc;
-      ns = testsug(wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
+      ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
       if (ns == -1) return -1;
       p[1] = *p;
       *p = tmpc;
@@ -820,13 +918,13 @@ int SuggestMgr::swapchar(char ** wlst, const char * word, int ns, int cpdsuggest
      candidate[2] = word[2];
      candidate[wl - 2] = word[wl - 1];
      candidate[wl - 1] = word[wl - 2];
-     ns = testsug(wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
+     ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
      if (ns == -1) return -1;
      if (wl == 5) {
         candidate[0] = word[0];
         candidate[1] = word[2];
         candidate[2] = word[1];
-        ns = testsug(wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
+        ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
         if (ns == -1) return -1;
      }
    }
@@ -834,7 +932,7 @@ int SuggestMgr::swapchar(char ** wlst, const char * word, int ns, int cpdsuggest
 }
 
 // error is adjacent letter were swapped
-int SuggestMgr::swapchar_utf(char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
+int SuggestMgr::swapchar_utf(affix_ctx & ctx, char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
 {
    w_char candidate_utf[MAXSWL];
    char   candidate[MAXSWUTF8L];
@@ -849,7 +947,7 @@ int SuggestMgr::swapchar_utf(char ** wlst, const w_char * word, int wl, int ns,
       p[1] = tmpc;
       u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
       if (len == 0) len = strlen(candidate);
-      ns = testsug(wlst, candidate, len, ns, cpdsuggest, NULL, NULL);
+      ns = testsug(ctx, wlst, candidate, len, ns, cpdsuggest, NULL, NULL);
       if (ns == -1) return -1;
       p[1] = *p;
       *p = tmpc;
@@ -863,14 +961,14 @@ int SuggestMgr::swapchar_utf(char ** wlst, const w_char * word, int wl, int ns,
      candidate_utf[wl - 2] = word[wl - 1];
      candidate_utf[wl - 1] = word[wl - 2];
      u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-     ns = testsug(wlst, candidate, len, ns, cpdsuggest, NULL, NULL);
+     ns = testsug(ctx, wlst, candidate, len, ns, cpdsuggest, NULL, NULL);
      if (ns == -1) return -1;
      if (wl == 5) {
         candidate_utf[0] = word[0];
         candidate_utf[1] = word[2];
         candidate_utf[2] = word[1];
         u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-	ns = testsug(wlst, candidate, len, ns, cpdsuggest, NULL, NULL);
+	ns = testsug(ctx, wlst, candidate, len, ns, cpdsuggest, NULL, NULL);
         if (ns == -1) return -1;
      }
    }
@@ -878,7 +976,7 @@ int SuggestMgr::swapchar_utf(char ** wlst, const w_char * word, int wl, int ns,
 }
 
 // error is not adjacent letter were swapped
-int SuggestMgr::longswapchar(char ** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::longswapchar(affix_ctx & ctx, char ** wlst, const char * word, int ns, int cpdsuggest)
 {
    char candidate[MAXSWUTF8L];
    char * p;
@@ -893,7 +991,7 @@ int SuggestMgr::longswapchar(char ** wlst, const char * word, int ns, int cpdsug
       tmpc = *p;
       *p = *q;
       *q = tmpc;
-      ns = testsug(wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
+      ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
       if (ns == -1) return -1;
       *q = *p;
       *p = tmpc;
@@ -905,7 +1003,7 @@ int SuggestMgr::longswapchar(char ** wlst, const char * word, int ns, int cpdsug
 
 
 // error is adjacent letter were swapped
-int SuggestMgr::longswapchar_utf(char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
+int SuggestMgr::longswapchar_utf(affix_ctx & ctx, char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
 {
    w_char candidate_utf[MAXSWL];
    char   candidate[MAXSWUTF8L];
@@ -921,7 +1019,7 @@ int SuggestMgr::longswapchar_utf(char ** wlst, const w_char * word, int wl, int
          *p = *q;
          *q = tmpc;
          u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-         ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+         ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
          if (ns == -1) return -1;
          *q = *p;
          *p = tmpc;
@@ -932,7 +1030,7 @@ int SuggestMgr::longswapchar_utf(char ** wlst, const w_char * word, int wl, int
 }
 
 // error is a letter was moved
-int SuggestMgr::movechar(char ** wlst, const char * word, int ns, int cpdsuggest)
+int SuggestMgr::movechar(affix_ctx & ctx, char ** wlst, const char * word, int ns, int cpdsuggest)
 {
    char candidate[MAXSWUTF8L];
    char * p;
@@ -948,7 +1046,7 @@ int SuggestMgr::movechar(char ** wlst, const char * word, int ns, int cpdsuggest
       *(q-1) = *q;
       *q = tmpc;
       if ((q-p) < 2) continue; // omit swap char
-      ns = testsug(wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
+      ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
       if (ns == -1) return -1;
     }
     strcpy(candidate, word);
@@ -959,7 +1057,7 @@ int SuggestMgr::movechar(char ** wlst, const char * word, int ns, int cpdsuggest
       *(q+1) = *q;
       *q = tmpc;
       if ((p-q) < 2) continue; // omit swap char
-      ns = testsug(wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
+      ns = testsug(ctx, wlst, candidate, wl, ns, cpdsuggest, NULL, NULL);
       if (ns == -1) return -1;
     }
     strcpy(candidate, word);
@@ -968,7 +1066,7 @@ int SuggestMgr::movechar(char ** wlst, const char * word, int ns, int cpdsuggest
 }
 
 // error is a letter was moved
-int SuggestMgr::movechar_utf(char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
+int SuggestMgr::movechar_utf(affix_ctx & ctx, char ** wlst, const w_char * word, int wl, int ns, int cpdsuggest)
 {
    w_char candidate_utf[MAXSWL];
    char   candidate[MAXSWUTF8L];
@@ -984,7 +1082,7 @@ int SuggestMgr::movechar_utf(char ** wlst, const w_char * word, int wl, int ns,
          *q = tmpc;
          if ((q-p) < 2) continue; // omit swap char
          u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-         ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+         ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
          if (ns == -1) return -1;
      }
      memcpy (candidate_utf, word, wl * sizeof(w_char));
@@ -996,7 +1094,7 @@ int SuggestMgr::movechar_utf(char ** wlst, const w_char * word, int wl, int ns,
          *q = tmpc;
          if ((p-q) < 2) continue; // omit swap char
          u16_u8(candidate, MAXSWUTF8L, candidate_utf, wl);
-         ns = testsug(wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
+         ns = testsug(ctx, wlst, candidate, strlen(candidate), ns, cpdsuggest, NULL, NULL);
          if (ns == -1) return -1;
      }
      memcpy (candidate_utf, word, wl * sizeof(w_char));
@@ -1004,22 +1102,34 @@ int SuggestMgr::movechar_utf(char ** wlst, const w_char * word, int wl, int ns,
    return ns;   
 }
 
+// walk a candidate list like HashMgr::walk_hashtable() (col = -1 at start)
+static struct hentry * next_candidate(struct hentry ** cand, int n, int & col)
+{
+  if (++col < n) return cand[col];
+  col = -1;
+  return NULL;
+}
+
 // generate a set of suggestions for very poorly spelled words
-int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md)
+int SuggestMgr::ngsuggest(sug_ctx & ctx, char** wlst, char * w, int ns, HashMgr** pHMgr, int md)
 {
+  if (ctx.replay(wlst, &ns, maxSug)) return ns;
+  int firstns = ns;
 
   int i, j;
   int lval;
   int sc, scphon;
   int lp, lpphon;
   int nonbmp = 0;
+  int utf = utf8;
 
   // exhaustively search through all root words
   // keeping track of the MAX_ROOTS most similar root words
-  struct hentry * roots[MAX_ROOTS];
-  char * rootsphon[MAX_ROOTS];
-  int scores[MAX_ROOTS];
-  int scoresphon[MAX_ROOTS];
+  struct ngscan scan;
+  struct hentry ** roots = scan.roots;
+  char ** rootsphon = scan.rootsphon;
+  int * scores = scan.scores;
+  int * scoresphon = scan.scoresphon;
   for (i = 0; i < MAX_ROOTS; i++) {
     roots[i] = NULL;
     scores[i] = -100 * i;
@@ -1028,6 +1138,20 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
   }
   lp = MAX_ROOTS - 1;
   lpphon = MAX_ROOTS - 1;
+  int dic = 0;
+  struct hentry* hp = NULL;
+  int col = -1;
+
+  // continue the scan of the interrupted search
+  if (ctx.scanpass == ctx.pass) {
+    scan = ctx.scan;
+    lp = scan.lp;
+    lpphon = scan.lpphon;
+    dic = scan.dic;
+    col = scan.col;
+    hp = scan.hp;
+    ctx.scanpass = -1;
+  }
   scphon = -20000;
   int low = NGRAM_LOWERING;
   
@@ -1038,30 +1162,28 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
   // word reversing wrapper for complex prefixes
   if (complexprefixes) {
     strcpy(w2, w);
-    if (utf8) reverseword_utf(w2); else reverseword(w2);
+    if (utf) reverseword_utf(w2); else reverseword(w2);
     word = w2;
   }
 
   char mw[MAXSWUTF8L];
   w_char u8[MAXSWL];
   int nc = strlen(word);
-  int n = (utf8) ? u8_u16(u8, MAXSWL, word) : nc;
+  int n = (utf) ? u8_u16(u8, MAXSWL, word) : nc;
   
   // set character based ngram suggestion for words with non-BMP Unicode characters
   if (n == -1) {
-    utf8 = 0; // XXX not state-free
+    utf = 0;
     n = nc;
     nonbmp = 1;
     low = 0;
   }
 
-  struct hentry* hp = NULL;
-  int col = -1;
   phonetable * ph = (pAMgr) ? pAMgr->get_phonetable() : NULL;
   char target[MAXSWUTF8L];
   char candidate[MAXSWUTF8L];
   if (ph) {
-    if (utf8) {
+    if (utf) {
       w_char _w[MAXSWL];
       int _wl = u8_u16(_w, MAXSWL, word);
       mkallcap_utf(_w, _wl, langnum);
@@ -1078,29 +1200,34 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
   FLAG nongramsuggest = pAMgr ? pAMgr->get_nongramsuggest() : FLAG_NULL;
   FLAG onlyincompound = pAMgr ? pAMgr->get_onlyincompound() : FLAG_NULL;
 
-  for (i = 0; i < md; i++) {  
-  while (0 != (hp = (pHMgr[i])->walk_hashtable(col, hp))) {
-    if ((hp->astr) && (pAMgr) && 
-       (TESTAFF(hp->astr, forbiddenword, hp->alen) ||
-          TESTAFF(hp->astr, ONLYUPCASEFLAG, hp->alen) ||
-          TESTAFF(hp->astr, nosuggest, hp->alen) ||
-          TESTAFF(hp->astr, nongramsuggest, hp->alen) ||
-          TESTAFF(hp->astr, onlyincompound, hp->alen))) continue;
-
-    sc = ngram(3, word, HENTRY_WORD(hp), NGRAM_LONGER_WORSE + low) +
-	leftcommonsubstring(word, HENTRY_WORD(hp));
+  int timer = MINTIMER;
+  for (; dic < md && !ctx.timedout; dic++) {
+  // score the words sharing trigrams with the word, or all of them
+  struct hentry ** cand = NULL;
+  int ncand = nonbmp ? -1 : pHMgr[dic]->ngram_candidates(word, &cand);
+  while (0 != (hp = (ncand >= 0) ? next_candidate(cand, ncand, col) :
+      pHMgr[dic]->walk_hashtable(col, hp))) {
+    if ((HENTRY_ASTR(hp)) && (pAMgr) && 
+       (TESTAFF(HENTRY_ASTR(hp), forbiddenword, hp->alen) ||
+          TESTAFF(HENTRY_ASTR(hp), ONLYUPCASEFLAG, hp->alen) ||
+          TESTAFF(HENTRY_ASTR(hp), nosuggest, hp->alen) ||
+          TESTAFF(HENTRY_ASTR(hp), nongramsuggest, hp->alen) ||
+          TESTAFF(HENTRY_ASTR(hp), onlyincompound, hp->alen))) continue;
+
+    sc = ngram(3, word, HENTRY_WORD(hp), NGRAM_LONGER_WORSE + low, utf) +
+	leftcommonsubstring(word, HENTRY_WORD(hp), utf);
 
     // check special pronounciation
     if ((hp->var & H_OPT_PHON) && copy_field(f, HENTRY_DATA(hp), MORPH_PHON)) {
-	int sc2 = ngram(3, word, f, NGRAM_LONGER_WORSE + low) +
-		+ leftcommonsubstring(word, f);
+	int sc2 = ngram(3, word, f, NGRAM_LONGER_WORSE + low, utf) +
+		+ leftcommonsubstring(word, f, utf);
 	if (sc2 > sc) sc = sc2;
     }
     
     scphon = -20000;
     if (ph && (sc > 2) && (abs(n - (int) hp->clen) <= 3)) {
       char target2[MAXSWUTF8L];
-      if (utf8) {
+      if (utf) {
         w_char _w[MAXSWL];
         int _wl = u8_u16(_w, MAXSWL, HENTRY_WORD(hp));
         mkallcap_utf(_w, _wl, langnum);
@@ -1110,7 +1237,7 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
         mkallcap(candidate, csconv);
       }
       phonet(candidate, target2, -1, *ph);
-      scphon = 2 * ngram(3, target, target2, NGRAM_LONGER_WORSE);
+      scphon = 2 * ngram(3, target, target2, NGRAM_LONGER_WORSE, utf);
     }
 
     if (sc > scores[lp]) {
@@ -1135,21 +1262,40 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
           lval = scoresphon[j];
         }
     }
-  }}
+
+    // check the deadline, saving the scan for a resumed search
+    if (!--timer) {
+      timer = MAXPLUSTIMER;
+      if (ctx.expired()) {
+        if (ctx.pass == ctx.npasses) {
+          scan.lp = lp;
+          scan.lpphon = lpphon;
+          scan.dic = dic;
+          scan.col = col;
+          scan.hp = hp;
+          ctx.scan = scan;
+          ctx.scanpass = ctx.pass;
+        }
+        break;
+      }
+    }
+  }
+  free(cand);
+  }
 
   // find minimum threshold for a passable suggestion
   // mangle original word three differnt ways
   // and score them to generate a minimum acceptable score
   int thresh = 0;
   for (int sp = 1; sp < 4; sp++) {
-     if (utf8) {
+     if (utf) {
        for (int k=sp; k < n; k+=4) *((unsigned short *) u8 + k) = '*';
        u16_u8(mw, MAXSWUTF8L, u8, n);
-       thresh = thresh + ngram(n, word, mw, NGRAM_ANY_MISMATCH + low);
+       thresh = thresh + ngram(n, word, mw, NGRAM_ANY_MISMATCH + low, utf);
      } else {
        strcpy(mw, word);
        for (int k=sp; k < n; k+=4) *(mw + k) = '*';
-       thresh = thresh + ngram(n, word, mw, NGRAM_ANY_MISMATCH + low);
+       thresh = thresh + ngram(n, word, mw, NGRAM_ANY_MISMATCH + low, utf);
      }
   }
   thresh = thresh / 3;
@@ -1172,20 +1318,20 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
   struct guessword * glst;
   glst = (struct guessword *) calloc(MAX_WORDS,sizeof(struct guessword));
   if (! glst) {
-    if (nonbmp) utf8 = 1;
+    ctx.record(wlst, firstns, ns);
     return ns;
   }
 
   for (i = 0; i < MAX_ROOTS; i++) {
-      if (roots[i]) {
+      if (roots[i] && !ctx.expired()) {
         struct hentry * rp = roots[i];
         int nw = pAMgr->expand_rootword(glst, MAX_WORDS, HENTRY_WORD(rp), rp->blen,
-            	    rp->astr, rp->alen, word, nc, 
+            	    HENTRY_ASTR(rp), rp->alen, word, nc, 
                     ((rp->var & H_OPT_PHON) ? copy_field(f, HENTRY_DATA(rp), MORPH_PHON) : NULL));
 
         for (int k = 0; k < nw ; k++) {
-           sc = ngram(n, word, glst[k].word, NGRAM_ANY_MISMATCH + low) +
-               leftcommonsubstring(word, glst[k].word);
+           sc = ngram(n, word, glst[k].word, NGRAM_ANY_MISMATCH + low, utf) +
+               leftcommonsubstring(word, glst[k].word, utf);
 
            if (sc > thresh) {
               if (sc > gscore[lp]) {
@@ -1218,6 +1364,13 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
   }
   free(glst);
 
+  // the scan is complete, a resumed search starts with the expansion
+  if (ctx.timedout && ctx.scanpass == -1 && ctx.pass == ctx.npasses) {
+    scan.dic = md;
+    ctx.scan = scan;
+    ctx.scanpass = ctx.pass;
+  }
+
   // now we are done generating guesses
   // sort in order of decreasing score
   
@@ -1241,7 +1394,7 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
         // lowering guess[i]
         char gl[MAXSWUTF8L];
         int len;
-        if (utf8) {
+        if (utf) {
           w_char _w[MAXSWL];
           len = u8_u16(_w, MAXSWL, guess[i]);
           mkallsmall_utf(_w, len, langnum);
@@ -1252,7 +1405,7 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
           len = strlen(guess[i]);
         }
 
-        int _lcs = lcslen(word, gl);
+        int _lcs = lcslen(word, gl, utf);
 
         // same characters with different casing
         if ((n == len) && (n == _lcs)) {
@@ -1261,20 +1414,20 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
         }
         // using 2-gram instead of 3, and other weightening
 
-        re = ngram(2, word, gl, NGRAM_ANY_MISMATCH + low + NGRAM_WEIGHTED) +
-             ngram(2, gl, word, NGRAM_ANY_MISMATCH + low + NGRAM_WEIGHTED);
+        re = ngram(2, word, gl, NGRAM_ANY_MISMATCH + low + NGRAM_WEIGHTED, utf) +
+             ngram(2, gl, word, NGRAM_ANY_MISMATCH + low + NGRAM_WEIGHTED, utf);
  
         gscore[i] =
           // length of longest common subsequent minus length difference
           2 * _lcs - abs((int) (n - len)) +
           // weight length of the left common substring
-          leftcommonsubstring(word, gl) +
+          leftcommonsubstring(word, gl, utf) +
           // weight equal character positions
           (!nonbmp && commoncharacterpositions(word, gl, &is_swap) ? 1: 0) +
           // swap character (not neighboring)
           ((is_swap) ? 10 : 0) +
           // ngram
-          ngram(4, word, gl, NGRAM_ANY_MISMATCH + low) +
+          ngram(4, word, gl, NGRAM_ANY_MISMATCH + low, utf) +
           // weighted ngrams
 	  re +
          // different limit for dictionaries with PHONE rules
@@ -1290,7 +1443,7 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
         // lowering rootphon[i]
         char gl[MAXSWUTF8L];
         int len;
-        if (utf8) {
+        if (utf) {
           w_char _w[MAXSWL];
           len = u8_u16(_w, MAXSWL, rootsphon[i]);
           mkallsmall_utf(_w, len, langnum);
@@ -1302,9 +1455,9 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
         }
 
         // heuristic weigthing of ngram scores
-        scoresphon[i] += 2 * lcslen(word, gl) - abs((int) (n - len)) +
+        scoresphon[i] += 2 * lcslen(word, gl, utf) - abs((int) (n - len)) +
           // weight length of the left common substring
-          leftcommonsubstring(word, gl);
+          leftcommonsubstring(word, gl, utf);
       }
   }
 
@@ -1333,7 +1486,7 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
           if ((!guessorig[i] && strstr(guess[i], wlst[j])) ||
 	     (guessorig[i] && strstr(guessorig[i], wlst[j])) ||
             // check forbidden words
-            !checkword(guess[i], strlen(guess[i]), 0, NULL, NULL)) unique = 0;
+            !checkword(ctx, guess[i], strlen(guess[i]), 0, NULL, NULL)) unique = 0;
         }
         if (unique) {
     	    wlst[ns++] = guess[i];
@@ -1361,34 +1514,37 @@ int SuggestMgr::ngsuggest(char** wlst, char * w, int ns, HashMgr** pHMgr, int md
           // don't suggest previous suggestions or a previous suggestion with prefixes or affixes
           if (strstr(rootsphon[i], wlst[j]) || 
             // check forbidden words
-            !checkword(rootsphon[i], strlen(rootsphon[i]), 0, NULL, NULL)) unique = 0;
+            !checkword(ctx, rootsphon[i], strlen(rootsphon[i]), 0, NULL, NULL)) unique = 0;
         }
         if (unique) {
             wlst[ns++] = mystrdup(rootsphon[i]);
-            if (!wlst[ns - 1]) return ns - 1;
+            if (!wlst[ns - 1]) {
+              ctx.record(wlst, firstns, ns - 1);
+              return ns - 1;
+            }
         }
       }
     }
   }
 
-  if (nonbmp) utf8 = 1;
+  ctx.record(wlst, firstns, ns);
   return ns;
 }
 
-
 // see if a candidate suggestion is spelled correctly
 // needs to check both root words and words with affixes
 
 // obsolote MySpell-HU modifications:
 // return value 2 and 3 marks compounding with hyphen (-)
 // `3' marks roots without suffix
-int SuggestMgr::checkword(const char * word, int len, int cpdsuggest, int * timer, clock_t * timelimit)
+int SuggestMgr::checkword(affix_ctx & ctx, const char * word, int len, int cpdsuggest, int * timer, clock_t * timelimit)
 {
   struct hentry * rv=NULL;
   struct hentry * rv2=NULL;
   int nosuffix = 0;
 
   // check time limit
+  if (ctx.expired()) return 0;
   if (timer) {
     (*timer)--;
     if (!(*timer) && timelimit) {
@@ -1400,10 +1556,10 @@ int SuggestMgr::checkword(const char * word, int len, int cpdsuggest, int * time
   if (pAMgr) { 
     if (cpdsuggest==1) {
       if (pAMgr->get_compound()) {
-        rv = pAMgr->compound_check(word, len, 0, 0, 100, 0, NULL, 0, 1, 0); //EXT
-        if (rv && (!(rv2 = pAMgr->lookup(word)) || !rv2->astr || 
-            !(TESTAFF(rv2->astr,pAMgr->get_forbiddenword(),rv2->alen) ||
-            TESTAFF(rv2->astr,pAMgr->get_nosuggest(),rv2->alen)))) return 3; // XXX obsolote categorisation + only ICONV needs affix flag check?
+        rv = pAMgr->compound_check(ctx, word, len, 0, 0, 100, 0, NULL, 0, 1, 0); //EXT
+        if (rv && (!(rv2 = pAMgr->lookup(word)) || !HENTRY_ASTR(rv2) || 
+            !(TESTAFF(HENTRY_ASTR(rv2),pAMgr->get_forbiddenword(),rv2->alen) ||
+            TESTAFF(HENTRY_ASTR(rv2),pAMgr->get_nosuggest(),rv2->alen)))) return 3; // XXX obsolote categorisation + only ICONV needs affix flag check?
         }
         return 0;
     }
@@ -1411,62 +1567,62 @@ int SuggestMgr::checkword(const char * word, int len, int cpdsuggest, int * time
     rv = pAMgr->lookup(word);
 
     if (rv) {
-        if ((rv->astr) && (TESTAFF(rv->astr,pAMgr->get_forbiddenword(),rv->alen)
-               || TESTAFF(rv->astr,pAMgr->get_nosuggest(),rv->alen))) return 0;
+        if ((HENTRY_ASTR(rv)) && (TESTAFF(HENTRY_ASTR(rv),pAMgr->get_forbiddenword(),rv->alen)
+               || TESTAFF(HENTRY_ASTR(rv),pAMgr->get_nosuggest(),rv->alen))) return 0;
         while (rv) {
-            if (rv->astr && (TESTAFF(rv->astr,pAMgr->get_needaffix(),rv->alen) ||
-                TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen) ||
-            TESTAFF(rv->astr,pAMgr->get_onlyincompound(),rv->alen))) {
-                rv = rv->next_homonym;
+            if (HENTRY_ASTR(rv) && (TESTAFF(HENTRY_ASTR(rv),pAMgr->get_needaffix(),rv->alen) ||
+                TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen) ||
+            TESTAFF(HENTRY_ASTR(rv),pAMgr->get_onlyincompound(),rv->alen))) {
+                rv = HENTRY_HOMONYM(rv);
             } else break;
         }
-    } else rv = pAMgr->prefix_check(word, len, 0); // only prefix, and prefix + suffix XXX
+    } else rv = pAMgr->prefix_check(ctx, word, len, 0); // only prefix, and prefix + suffix XXX
 
     if (rv) {
         nosuffix=1;
     } else {
-        rv = pAMgr->suffix_check(word, len, 0, NULL, NULL, 0, NULL); // only suffix
+        rv = pAMgr->suffix_check(ctx, word, len, 0, NULL, NULL, 0, NULL); // only suffix
     }
 
     if (!rv && pAMgr->have_contclass()) {
-        rv = pAMgr->suffix_check_twosfx(word, len, 0, NULL, FLAG_NULL);
-        if (!rv) rv = pAMgr->prefix_check_twosfx(word, len, 1, FLAG_NULL);
+        rv = pAMgr->suffix_check_twosfx(ctx, word, len, 0, NULL, FLAG_NULL);
+        if (!rv) rv = pAMgr->prefix_check_twosfx(ctx, word, len, 1, FLAG_NULL);
     }
 
     // check forbidden words
-    if ((rv) && (rv->astr) && (TESTAFF(rv->astr,pAMgr->get_forbiddenword(),rv->alen) ||
-      TESTAFF(rv->astr, ONLYUPCASEFLAG, rv->alen) ||
-      TESTAFF(rv->astr,pAMgr->get_nosuggest(),rv->alen) ||
-      TESTAFF(rv->astr,pAMgr->get_onlyincompound(),rv->alen))) return 0;
+    if ((rv) && (HENTRY_ASTR(rv)) && (TESTAFF(HENTRY_ASTR(rv),pAMgr->get_forbiddenword(),rv->alen) ||
+      TESTAFF(HENTRY_ASTR(rv), ONLYUPCASEFLAG, rv->alen) ||
+      TESTAFF(HENTRY_ASTR(rv),pAMgr->get_nosuggest(),rv->alen) ||
+      TESTAFF(HENTRY_ASTR(rv),pAMgr->get_onlyincompound(),rv->alen))) return 0;
 
     if (rv) { // XXX obsolote    
       if ((pAMgr->get_compoundflag()) && 
-          TESTAFF(rv->astr, pAMgr->get_compoundflag(), rv->alen)) return 2 + nosuffix; 
+          TESTAFF(HENTRY_ASTR(rv), pAMgr->get_compoundflag(), rv->alen)) return 2 + nosuffix; 
       return 1;
     }
   }
   return 0;
 }
 
-int SuggestMgr::check_forbidden(const char * word, int len)
+int SuggestMgr::check_forbidden(affix_ctx & ctx, const char * word, int len)
 {
   struct hentry * rv = NULL;
 
   if (pAMgr) { 
     rv = pAMgr->lookup(word);
-    if (rv && rv->astr && (TESTAFF(rv->astr,pAMgr->get_needaffix(),rv->alen) ||
-        TESTAFF(rv->astr,pAMgr->get_onlyincompound(),rv->alen))) rv = NULL;
-    if (!(pAMgr->prefix_check(word,len,1)))
-        rv = pAMgr->suffix_check(word,len, 0, NULL, NULL, 0, NULL); // prefix+suffix, suffix
+    if (rv && HENTRY_ASTR(rv) && (TESTAFF(HENTRY_ASTR(rv),pAMgr->get_needaffix(),rv->alen) ||
+        TESTAFF(HENTRY_ASTR(rv),pAMgr->get_onlyincompound(),rv->alen))) rv = NULL;
+    if (!(pAMgr->prefix_check(ctx, word,len,1)))
+        rv = pAMgr->suffix_check(ctx, word,len, 0, NULL, NULL, 0, NULL); // prefix+suffix, suffix
     // check forbidden words
-    if ((rv) && (rv->astr) && TESTAFF(rv->astr,pAMgr->get_forbiddenword(),rv->alen)) return 1;
+    if ((rv) && (HENTRY_ASTR(rv)) && TESTAFF(HENTRY_ASTR(rv),pAMgr->get_forbiddenword(),rv->alen)) return 1;
    }
     return 0;
 }
 
 #ifdef HUNSPELL_EXPERIMENTAL
 // suggest possible stems
-int SuggestMgr::suggest_pos_stems(char*** slst, const char * w, int nsug)
+int SuggestMgr::suggest_pos_stems(affix_ctx & ctx, char*** slst, const char * w, int nsug)
 {
     char ** wlst;    
 
@@ -1492,7 +1648,7 @@ int SuggestMgr::suggest_pos_stems(char*** slst, const char * w, int nsug)
         if (wlst == NULL) return -1;
     }
 
-    rv = pAMgr->suffix_check(word, wl, 0, NULL, wlst, maxSug, &nsug);
+    rv = pAMgr->suffix_check(ctx, word, wl, 0, NULL, wlst, maxSug, &nsug);
 
     // delete dash from end of word
     if (nsug > 0) {
@@ -1507,7 +1663,7 @@ int SuggestMgr::suggest_pos_stems(char*** slst, const char * w, int nsug)
 #endif // END OF HUNSPELL_EXPERIMENTAL CODE
 
 
-char * SuggestMgr::suggest_morph(const char * w)
+char * SuggestMgr::suggest_morph(affix_ctx & ctx, const char * w)
 {
     char result[MAXLNLEN];
     char * r = (char *) result;
@@ -1532,9 +1688,9 @@ char * SuggestMgr::suggest_morph(const char * w)
     rv = pAMgr->lookup(word);
     
     while (rv) {
-        if ((!rv->astr) || !(TESTAFF(rv->astr, pAMgr->get_forbiddenword(), rv->alen) ||
-            TESTAFF(rv->astr, pAMgr->get_needaffix(), rv->alen) ||
-            TESTAFF(rv->astr,pAMgr->get_onlyincompound(),rv->alen))) {
+        if ((!HENTRY_ASTR(rv)) || !(TESTAFF(HENTRY_ASTR(rv), pAMgr->get_forbiddenword(), rv->alen) ||
+            TESTAFF(HENTRY_ASTR(rv), pAMgr->get_needaffix(), rv->alen) ||
+            TESTAFF(HENTRY_ASTR(rv),pAMgr->get_onlyincompound(),rv->alen))) {
                 if (!HENTRY_FIND(rv, MORPH_STEM)) {
                     mystrcat(result, " ", MAXLNLEN);                                
                     mystrcat(result, MORPH_STEM, MAXLNLEN);
@@ -1546,33 +1702,33 @@ char * SuggestMgr::suggest_morph(const char * w)
                 }
                 mystrcat(result, "\n", MAXLNLEN);
         }
-        rv = rv->next_homonym;
+        rv = HENTRY_HOMONYM(rv);
     }
     
-    st = pAMgr->affix_check_morph(word,strlen(word));
+    st = pAMgr->affix_check_morph(ctx, word,strlen(word));
     if (st) {
         mystrcat(result, st, MAXLNLEN);
         free(st);
     }
 
     if (pAMgr->get_compound() && (*result == '\0'))
-        pAMgr->compound_check_morph(word, strlen(word),
+        pAMgr->compound_check_morph(ctx, word, strlen(word),
                      0, 0, 100, 0,NULL, 0, &r, NULL);
     
     return (*result) ? mystrdup(line_uniq(result, MSEP_REC)) : NULL;
 }
 
 #ifdef HUNSPELL_EXPERIMENTAL
-char * SuggestMgr::suggest_morph_for_spelling_error(const char * word)
+char * SuggestMgr::suggest_morph_for_spelling_error(sug_ctx & ctx, const char * word)
 {
     char * p = NULL;
     char ** wlst = (char **) calloc(maxSug, sizeof(char *));
     if (!**wlst) return NULL;
     // we will use only the first suggestion
     for (int i = 0; i < maxSug - 1; i++) wlst[i] = "";
-    int ns = suggest(&wlst, word, maxSug - 1, NULL);
+    int ns = suggest(ctx, &wlst, word, maxSug - 1, NULL);
     if (ns == maxSug) {
-        p = suggest_morph(wlst[maxSug - 1]);
+        p = suggest_morph(ctx, wlst[maxSug - 1]);
         free(wlst[maxSug - 1]);
     }
     if (wlst) free(wlst);
@@ -1590,7 +1746,7 @@ char * SuggestMgr::suggest_hentry_gen(hentry * rv, char * pattern)
     if (get_sfxcount(HENTRY_DATA(rv)) > sfxcount) return NULL;
 
     if (HENTRY_DATA(rv)) {
-        char * aff = pAMgr->morphgen(HENTRY_WORD(rv), rv->blen, rv->astr, rv->alen,
+        char * aff = pAMgr->morphgen(HENTRY_WORD(rv), rv->blen, HENTRY_ASTR(rv), rv->alen,
             HENTRY_DATA(rv), pattern, 0);
         if (aff) {
             mystrcat(result, aff, MAXLNLEN);
@@ -1616,7 +1772,7 @@ char * SuggestMgr::suggest_hentry_gen(hentry * rv, char * pattern)
                 char * st = (char *) strstr(HENTRY_DATA2(rv2), MORPH_STEM);
                 if (st && (strncmp(st + MORPH_TAG_LEN, 
                    HENTRY_WORD(rv), fieldlen(st + MORPH_TAG_LEN)) == 0)) {
-                    char * aff = pAMgr->morphgen(HENTRY_WORD(rv2), rv2->blen, rv2->astr, rv2->alen,
+                    char * aff = pAMgr->morphgen(HENTRY_WORD(rv2), rv2->blen, HENTRY_ASTR(rv2), rv2->alen,
                         HENTRY_DATA(rv2), pattern, 0);
                     if (aff) {
                         mystrcat(result, aff, MAXLNLEN);
@@ -1625,7 +1781,7 @@ char * SuggestMgr::suggest_hentry_gen(hentry * rv, char * pattern)
                     }    
                 }
             }
-            rv2 = rv2->next_homonym;
+            rv2 = HENTRY_HOMONYM(rv2);
         }
         p = strstr(p + plen, MORPH_ALLOMORPH);
     }
@@ -1708,7 +1864,7 @@ char * SuggestMgr::suggest_gen(char ** desc, int n, char * pattern) {
                         }
                         freelist(&gen, genl);
                     }
-                    rv = rv->next_homonym;
+                    rv = HENTRY_HOMONYM(rv);
                 }
             }
     }
@@ -1729,7 +1885,7 @@ char * SuggestMgr::suggest_gen(char ** desc, int n, char * pattern) {
 
 
 // generate an n-gram score comparing s1 and s2
-int SuggestMgr::ngram(int n, char * s1, const char * s2, int opt)
+int SuggestMgr::ngram(int n, char * s1, const char * s2, int opt, int utf)
 {
   int nscore = 0;
   int ns;
@@ -1737,7 +1893,7 @@ int SuggestMgr::ngram(int n, char * s1, const char * s2, int opt)
   int l2;
   int test = 0;
 
-  if (utf8) {
+  if (utf) {
     w_char su1[MAXSWL];
     w_char su2[MAXSWL];
     l1 = u8_u16(su1, MAXSWL, s1);
@@ -1803,8 +1959,8 @@ test++;
 }
 
 // length of the left common substring of s1 and (decapitalised) s2
-int SuggestMgr::leftcommonsubstring(char * s1, const char * s2) {
-  if (utf8) {
+int SuggestMgr::leftcommonsubstring(char * s1, const char * s2, int utf) {
+  if (utf) {
     w_char su1[MAXSWL];
     w_char su2[MAXSWL];
     su1[0].l = su2[0].l = su1[0].h = su2[0].h = 0;
@@ -1933,7 +2089,7 @@ void SuggestMgr::bubblesort(char** rword, char** rword2, int* rsc, int n )
 }
 
 // longest common subsequence
-void SuggestMgr::lcs(const char * s, const char * s2, int * l1, int * l2, char ** result) {
+void SuggestMgr::lcs(const char * s, const char * s2, int * l1, int * l2, char ** result, int utf) {
   int n, m;
   w_char su[MAXSWL];
   w_char su2[MAXSWL];
@@ -1941,7 +2097,7 @@ void SuggestMgr::lcs(const char * s, const char * s2, int * l1, int * l2, char *
   char * c;
   int i;
   int j;
-  if (utf8) {
+  if (utf) {
     m = u8_u16(su, MAXSWL, s);
     n = u8_u16(su2, MAXSWL, s2);
   } else {
@@ -1960,8 +2116,8 @@ void SuggestMgr::lcs(const char * s, const char * s2, int * l1, int * l2, char *
   for (j = 0; j <= n; j++) c[j] = 0;
   for (i = 1; i <= m; i++) {
     for (j = 1; j <= n; j++) {
-      if ( ((utf8) && (*((short *) su+i-1) == *((short *)su2+j-1)))
-          || ((!utf8) && ((*(s+i-1)) == (*(s2+j-1))))) {
+      if ( ((utf) && (*((short *) su+i-1) == *((short *)su2+j-1)))
+          || ((!utf) && ((*(s+i-1)) == (*(s2+j-1))))) {
         c[i*(n+1) + j] = c[(i-1)*(n+1) + j-1]+1;
         b[i*(n+1) + j] = LCS_UPLEFT;
       } else if (c[(i-1)*(n+1) + j] >= c[i*(n+1) + j-1]) {
@@ -1979,14 +2135,14 @@ void SuggestMgr::lcs(const char * s, const char * s2, int * l1, int * l2, char *
   *l2 = n;
 }
 
-int SuggestMgr::lcslen(const char * s, const char* s2) {
+int SuggestMgr::lcslen(const char * s, const char* s2, int utf) {
   int m;
   int n;
   int i;
   int j;
   char * result;
   int len = 0;
-  lcs(s, s2, &m, &n, &result);
+  lcs(s, s2, &m, &n, &result, utf);
   if (!result) return 0;
   i = m;
   j = n;
@@ -30,6 +30,46 @@
 
 enum { LCS_UP, LCS_LEFT, LCS_UPLEFT };
 
+// root word scan of ngsuggest(), saved when the deadline stops it
+struct ngscan {
+  int     dic;       // position of the scan in the dictionaries
+  int     col;
+  struct hentry * hp;
+  int     lp;
+  int     lpphon;
+  struct hentry * roots[MAX_ROOTS];
+  char *  rootsphon[MAX_ROOTS];
+  int     scores[MAX_ROOTS];
+  int     scoresphon[MAX_ROOTS];
+};
+
+// state of a suggestion search that can stop at its deadline: the
+// suggestions of the passes finished before it are recorded, and a
+// resumed search of the same word replays them instead of running
+// the passes again
+struct LIBHUNSPELL_DLL_EXPORTED sug_ctx : public affix_ctx {
+  int     pass;      // index of the next pass of the current search
+  int     npasses;   // number of recorded passes
+  int *   counts;    // number of suggestions added by each recorded pass
+  char ** results;   // the suggestions of the recorded passes, in order
+  int     nresults;
+  int     cursor;    // next recorded suggestion to replay
+  int     scanpass;  // pass of the saved root word scan, -1 = none
+  struct ngscan scan;
+
+  sug_ctx();
+  ~sug_ctx();
+
+  void begin(unsigned long long limit);
+  void clear();
+  int  replay(char ** wlst, int * ns, int maxn);
+  void record(char ** wlst, int from, int to);
+
+private:
+  sug_ctx(const sug_ctx &);
+  sug_ctx & operator=(const sug_ctx &);
+};
+
 class LIBHUNSPELL_DLL_EXPORTED SuggestMgr
 {
   char *          ckey;
@@ -55,54 +95,54 @@ public:
   SuggestMgr(const char * tryme, int maxn, AffixMgr *aptr);
   ~SuggestMgr();
 
-  int suggest(char*** slst, const char * word, int nsug, int * onlycmpdsug);
-  int ngsuggest(char ** wlst, char * word, int ns, HashMgr** pHMgr, int md);
-  int suggest_auto(char*** slst, const char * word, int nsug);
+  int suggest(sug_ctx & ctx, char*** slst, const char * word, int nsug, int * onlycmpdsug);
+  int ngsuggest(sug_ctx & ctx, char ** wlst, char * word, int ns, HashMgr** pHMgr, int md);
+  int suggest_auto(affix_ctx & ctx, char*** slst, const char * word, int nsug);
   int suggest_stems(char*** slst, const char * word, int nsug);
-  int suggest_pos_stems(char*** slst, const char * word, int nsug);
+  int suggest_pos_stems(affix_ctx & ctx, char*** slst, const char * word, int nsug);
 
-  char * suggest_morph(const char * word);
+  char * suggest_morph(affix_ctx & ctx, const char * word);
   char * suggest_gen(char ** pl, int pln, char * pattern);
-  char * suggest_morph_for_spelling_error(const char * word);
+  char * suggest_morph_for_spelling_error(sug_ctx & ctx, const char * word);
 
 private:
-   int testsug(char** wlst, const char * candidate, int wl, int ns, int cpdsuggest,
+   int testsug(affix_ctx & ctx, char** wlst, const char * candidate, int wl, int ns, int cpdsuggest,
      int * timer, clock_t * timelimit);
-   int checkword(const char *, int, int, int *, clock_t *);
-   int check_forbidden(const char *, int);
-
-   int capchars(char **, const char *, int, int);
-   int replchars(char**, const char *, int, int);
-   int doubletwochars(char**, const char *, int, int);
-   int forgotchar(char **, const char *, int, int);
-   int swapchar(char **, const char *, int, int);
-   int longswapchar(char **, const char *, int, int);
-   int movechar(char **, const char *, int, int);
-   int extrachar(char **, const char *, int, int);
-   int badcharkey(char **, const char *, int, int);
-   int badchar(char **, const char *, int, int);
-   int twowords(char **, const char *, int, int);
+   int checkword(affix_ctx &, const char *, int, int, int *, clock_t *);
+   int check_forbidden(affix_ctx &, const char *, int);
+
+   int capchars(affix_ctx &, char **, const char *, int, int);
+   int replchars(affix_ctx &, char**, const char *, int, int);
+   int doubletwochars(affix_ctx &, char**, const char *, int, int);
+   int forgotchar(affix_ctx &, char **, const char *, int, int);
+   int swapchar(affix_ctx &, char **, const char *, int, int);
+   int longswapchar(affix_ctx &, char **, const char *, int, int);
+   int movechar(affix_ctx &, char **, const char *, int, int);
+   int extrachar(affix_ctx &, char **, const char *, int, int);
+   int badcharkey(affix_ctx &, char **, const char *, int, int);
+   int badchar(affix_ctx &, char **, const char *, int, int);
+   int twowords(affix_ctx &, char **, const char *, int, int);
    int fixstems(char **, const char *, int);
 
-   int capchars_utf(char **, const w_char *, int wl, int, int);
-   int doubletwochars_utf(char**, const w_char *, int wl, int, int);
-   int forgotchar_utf(char**, const w_char *, int wl, int, int);
-   int extrachar_utf(char**, const w_char *, int wl, int, int);
-   int badcharkey_utf(char **, const w_char *, int wl, int, int);
-   int badchar_utf(char **, const w_char *, int wl, int, int);
-   int swapchar_utf(char **, const w_char *, int wl, int, int);
-   int longswapchar_utf(char **, const w_char *, int, int, int);
-   int movechar_utf(char **, const w_char *, int, int, int);
-
-   int mapchars(char**, const char *, int, int);
-   int map_related(const char *, char *, int, int, char ** wlst, int, int, const mapentry*, int, int *, clock_t *);
-   int ngram(int n, char * s1, const char * s2, int opt);
+   int capchars_utf(affix_ctx &, char **, const w_char *, int wl, int, int);
+   int doubletwochars_utf(affix_ctx &, char**, const w_char *, int wl, int, int);
+   int forgotchar_utf(affix_ctx &, char**, const w_char *, int wl, int, int);
+   int extrachar_utf(affix_ctx &, char**, const w_char *, int wl, int, int);
+   int badcharkey_utf(affix_ctx &, char **, const w_char *, int wl, int, int);
+   int badchar_utf(affix_ctx &, char **, const w_char *, int wl, int, int);
+   int swapchar_utf(affix_ctx &, char **, const w_char *, int wl, int, int);
+   int longswapchar_utf(affix_ctx &, char **, const w_char *, int, int, int);
+   int movechar_utf(affix_ctx &, char **, const w_char *, int, int, int);
+
+   int mapchars(affix_ctx &, char**, const char *, int, int);
+   int map_related(affix_ctx &, const char *, char *, int, int, char ** wlst, int, int, const mapentry*, int, int *, clock_t *);
+   int ngram(int n, char * s1, const char * s2, int opt, int utf);
    int mystrlen(const char * word);
-   int leftcommonsubstring(char * s1, const char * s2);
+   int leftcommonsubstring(char * s1, const char * s2, int utf);
    int commoncharacterpositions(char * s1, const char * s2, int * is_swap);
    void bubblesort( char ** rwd, char ** rwd2, int * rsc, int n);
-   void lcs(const char * s, const char * s2, int * l1, int * l2, char ** result);
-   int lcslen(const char * s, const char* s2);
+   void lcs(const char * s, const char * s2, int * l1, int * l2, char ** result, int utf);
+   int lcslen(const char * s, const char* s2, int utf);
    char * suggest_hentry_gen(hentry * rv, char * pattern);
 
 };
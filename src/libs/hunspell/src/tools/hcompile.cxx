@@ -0,0 +1,28 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashmgr.hxx"
+
+#define DESC "hcompile - compile a dictionary into a memory-mappable image\n" \
+"Usage: hcompile file.aff file.dic [file.hdic]\n" \
+"The image is used instead of parsing file.dic as long as file.aff and\n" \
+"file.dic keep their size and modification time; it is only valid on the\n" \
+"platform it was made on.\n"
+
+int fail(const char * err, const char * par) {
+    fprintf(stderr, err, par);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || strcmp(argv[1], "-h") == 0) return fail(DESC, NULL);
+    char * out = (argc > 3) ? strdup(argv[3]) : HashMgr::compiled_path(argv[2]);
+    if (!out) return fail("hcompile: out of memory\n", NULL);
+    HashMgr * h = new HashMgr(argv[2], argv[1]);
+    int ec = h->write_compiled(out, argv[2], argv[1]);
+    if (ec) fail("hcompile: can't compile %s\n", argv[2]);
+    delete h;
+    free(out);
+    return ec;
+}
@@ -0,0 +1,677 @@
+/*
+ * hunspell-tests: runs the regression suite of tests/ through the library
+ *
+ *     hunspell-tests [-v] [-c hcompile] [tests_dir] [test...]
+ *
+ * The suite is the TESTS list of tests/Makefile.am. As tests/test.sh does
+ * with the command line tools, every test checks that
+ *   - the words of name.good are accepted,
+ *   - the words of name.wrong are rejected,
+ *   - name.sug holds the suggestions of the rejected words that have any,
+ *   - name.morph holds the output of the analyze tool for name.good.
+ * The suggestions are also searched in steps of SUGGEST_STEP milliseconds,
+ * resuming until the search finishes: the result has to be the same and
+ * every suggestion has to reach the callback once.
+ * Every test is run again with the trigram index of the n-gram suggestion,
+ * which the small test dictionaries would not get otherwise. With -c (or a
+ * runner built with HUNSPELL_HCOMPILE) it is also run on the compiled
+ * image of its dictionary: the .aff and .dic files are copied into the
+ * current directory and compiled there by hcompile.
+ * The suite is followed by the tests of a generated dictionary, large
+ * enough for the steps to time out (see run_generated_tests()).
+ * A PASS or FAIL line is printed for every run, -v also prints the lines
+ * of a failed comparison. The exit status is 1 if any run failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hunspell.hxx"
+
+#define DESC "Usage: hunspell-tests [-v] [-c hcompile] [tests_dir] [test...]\n"
+
+#ifndef HUNSPELL_TESTS_DIR
+#define HUNSPELL_TESTS_DIR "tests"
+#endif
+
+#ifndef HUNSPELL_HCOMPILE
+#define HUNSPELL_HCOMPILE NULL
+#endif
+
+// timeout of the resumed suggestion search, in milliseconds
+#define SUGGEST_STEP 1
+// resumed calls after which a search is taken for stuck
+#define SUGGEST_MAXSTEPS 100000
+
+// growing output buffer
+struct textbuf {
+    char * s;
+    int len;
+    int size;
+};
+
+static void buf_add(struct textbuf * b, const char * s)
+{
+    int n = strlen(s);
+    if (b->len + n + 1 > b->size) {
+        b->size = (b->len + n + 1) * 2;
+        b->s = (char *) realloc(b->s, b->size);
+        if (!b->s) {
+            fprintf(stderr, "hunspell-tests: out of memory\n");
+            exit(2);
+        }
+    }
+    memcpy(b->s + b->len, s, n + 1);
+    b->len += n;
+}
+
+static void buf_printf(struct textbuf * b, const char * fmt, const char * a,
+    const char * c = NULL, const char * d = NULL)
+{
+    char * line = (char *) malloc(strlen(fmt) + strlen(a) +
+        (c ? strlen(c) : 0) + (d ? strlen(d) : 0) + 1);
+    if (!line) return;
+    sprintf(line, fmt, a, c, d);
+    buf_add(b, line);
+    free(line);
+}
+
+// whole content of a file without carriage returns, NULL if it is missing
+static char * read_file(const char * dir, const char * name, const char * ext)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s%s", dir, name, ext);
+    FILE * f = fopen(path, "rb");
+    if (!f) return NULL;
+    struct textbuf b = { NULL, 0, 0 };
+    char line[8192];
+    buf_add(&b, "");
+    while (fgets(line, sizeof(line), f)) {
+        char * cr = strchr(line, '\r');
+        if (cr) memmove(cr, cr + 1, strlen(cr + 1) + 1);
+        buf_add(&b, line);
+    }
+    fclose(f);
+    return b.s;
+}
+
+// next line of the text, the text pointer moves after it
+static char * next_line(char ** text)
+{
+    if (!**text) return NULL;
+    char * line = *text;
+    char * nl = strchr(line, '\n');
+    if (nl) {
+        *nl = '\0';
+        *text = nl + 1;
+    } else {
+        *text = line + strlen(line);
+    }
+    return line;
+}
+
+// print the first differing line (or all lines with -v)
+static void print_diff(const char * name, const char * ext,
+    const char * expected, const char * got, int verbose)
+{
+    printf("  %s%s differs\n", name, ext);
+    if (verbose) {
+        printf("  expected:\n%s  got:\n%s", expected, got);
+        return;
+    }
+    int line = 1;
+    int i = 0;
+    int start = 0;
+    while (expected[i] && expected[i] == got[i]) {
+        if (expected[i++] == '\n') {
+            line++;
+            start = i;
+        }
+    }
+    const char * e = expected + start;
+    const char * g = got + start;
+    const char * ee = strchr(e, '\n');
+    const char * ge = strchr(g, '\n');
+    printf("  line %d: expected \"%.*s\", got \"%.*s\"\n", line,
+        (int) (ee ? ee - e : strlen(e)), e, (int) (ge ? ge - g : strlen(g)), g);
+}
+
+// compare texts, ignoring a missing newline at the end
+static int same_text(const char * a, const char * b)
+{
+    int la = strlen(a);
+    int lb = strlen(b);
+    if (la && a[la - 1] == '\n') la--;
+    if (lb && b[lb - 1] == '\n') lb--;
+    return la == lb && strncmp(a, b, la) == 0;
+}
+
+// suggestions passed to the callback of the resumed search
+struct reported {
+    char ** list;
+    int n;
+    int twice;
+};
+
+static void report(const char * suggestion, void * data)
+{
+    struct reported * r = (struct reported *) data;
+    for (int i = 0; i < r->n; i++) {
+        if (strcmp(r->list[i], suggestion) == 0) {
+            r->twice++;
+            return;
+        }
+    }
+    char ** grown = (char **) realloc(r->list, (r->n + 1) * sizeof(char *));
+    if (!grown) {
+        fprintf(stderr, "hunspell-tests: out of memory\n");
+        exit(2);
+    }
+    r->list = grown;
+    r->list[r->n++] = strdup(suggestion);
+}
+
+// search the suggestions of word in SUGGEST_STEP steps, resuming with
+// ctx until the search finishes, and compare them with the slst found
+// without a timeout; the number of interrupted steps is added to timeouts
+static int check_resumed(Hunspell * pMS, HunspellContext & ctx, const char * name,
+    const char * word, char ** slst, int ns, int * timeouts)
+{
+    struct reported r = { NULL, 0, 0 };
+    char ** rlst = NULL;
+    int rn = 0;
+    int steps = 0;
+    do {
+        if (rlst) pMS->free_list(&rlst, rn);
+        rn = pMS->suggest(ctx, &rlst, word, SUGGEST_STEP, report, &r);
+        if (ctx.timedout) (*timeouts)++;
+    } while (ctx.timedout && ++steps < SUGGEST_MAXSTEPS);
+
+    int fails = 0;
+    int same = (rn == ns);
+    for (int i = 0; same && i < ns; i++) same = strcmp(rlst[i], slst[i]) == 0;
+    if (ctx.timedout) {
+        printf("  %s: resumed search of \"%s\" does not finish\n", name, word);
+        fails++;
+    } else if (!same) {
+        printf("  %s: resumed search of \"%s\" found %d suggestions instead of %d%s%s\n",
+            name, word, rn, ns, rn > 0 ? ", the first is " : "", rn > 0 ? rlst[0] : "");
+        fails++;
+    }
+    // every suggestion of the result is reported once, and nothing else
+    int once = (r.twice == 0 && r.n == rn);
+    for (int i = 0; once && i < rn; i++) {
+        int k = 0;
+        while (k < r.n && strcmp(r.list[k], rlst[i]) != 0) k++;
+        once = k < r.n;
+    }
+    if (!once) {
+        printf("  %s: the callback got %d suggestions of \"%s\" (%d twice) for %d found\n",
+            name, r.n, word, r.twice, rn);
+        fails++;
+    }
+    pMS->free_list(&rlst, rn);
+    for (int i = 0; i < r.n; i++) free(r.list[i]);
+    free(r.list);
+    return fails;
+}
+
+// check the words of name.good or name.wrong, collecting the suggestions
+// of the rejected words like "hunspell -a" does
+static int check_words(Hunspell * pMS, const char * dir, const char * name,
+    const char * ext, int good, struct textbuf * sug)
+{
+    char * text = read_file(dir, name, ext);
+    if (!text) return 0;
+    int fails = 0;
+    char * p = text;
+    char * line;
+    while ((line = next_line(&p))) {
+        char * w = line;
+        for (;;) {
+            w += strspn(w, " \t");
+            if (!*w) break;
+            int n = strcspn(w, " \t");
+            char end = w[n];
+            w[n] = '\0';
+            int ok = pMS->spell(w);
+            if (good && !ok) {
+                printf("  %s%s: rejected \"%s\"\n", name, ext, w);
+                fails++;
+            } else if (!good && ok) {
+                printf("  %s%s: accepted \"%s\"\n", name, ext, w);
+                fails++;
+            } else if (!ok && sug) {
+                char ** slst;
+                int ns = pMS->suggest(&slst, w);
+                for (int i = 0; i < ns; i++) {
+                    buf_add(sug, slst[i]);
+                    buf_add(sug, (i < ns - 1) ? ", " : "\n");
+                }
+                HunspellContext ctx;
+                int timeouts = 0;
+                fails += check_resumed(pMS, ctx, name, w, slst, ns, &timeouts);
+                pMS->free_list(&slst, ns);
+            }
+            w[n] = end;
+            w += n;
+        }
+    }
+    free(text);
+    return fails;
+}
+
+// output of src/tools/analyze for name.good
+static int check_morph(Hunspell * pMS, const char * dir, const char * name,
+    const char * expected, int verbose)
+{
+    char * text = read_file(dir, name, ".good");
+    if (!text) return 0;
+    struct textbuf out = { NULL, 0, 0 };
+    buf_add(&out, "");
+    char * p = text;
+    char * line;
+    while ((line = next_line(&p))) {
+        int n = strlen(line);
+        if (n && line[n - 1] == '\t') line[--n] = '\0';
+        if (!n) continue;
+        char ** result;
+        char * s = strchr(line, ' ');
+        if (s) {
+            *s = '\0';
+            n = pMS->generate(&result, line, s + 1);
+            for (int i = 0; i < n; i++)
+                buf_printf(&out, "generate(%s, %s) = %s\n", line, s + 1, result[i]);
+            pMS->free_list(&result, n);
+            if (n == 0) buf_printf(&out, "generate(%s, %s) = NO DATA\n", line, s + 1);
+            continue;
+        }
+        buf_printf(&out, "> %s\n", line);
+        if (!pMS->spell(line)) {
+            buf_add(&out, "Unknown word.\n");
+            continue;
+        }
+        n = pMS->analyze(&result, line);
+        for (int i = 0; i < n; i++)
+            buf_printf(&out, "analyze(%s) = %s\n", line, result[i]);
+        pMS->free_list(&result, n);
+        n = pMS->stem(&result, line);
+        for (int i = 0; i < n; i++)
+            buf_printf(&out, "stem(%s) = %s\n", line, result[i]);
+        pMS->free_list(&result, n);
+    }
+    free(text);
+    int fails = 0;
+    if (!same_text(expected, out.s)) {
+        print_diff(name, ".morph", expected, out.s, verbose);
+        fails++;
+    }
+    free(out.s);
+    return fails;
+}
+
+// the dictionary is read from dicdir, the other files of the test from dir;
+// ngram_minwords is passed to Hunspell::set_ngram_minwords() unless -1
+static int run_test(const char * dir, const char * dicdir, const char * name,
+    int ngram_minwords, int verbose)
+{
+    char aff[1024];
+    char dic[1024];
+    snprintf(aff, sizeof(aff), "%s/%s.aff", dicdir, name);
+    snprintf(dic, sizeof(dic), "%s/%s.dic", dicdir, name);
+    FILE * f = fopen(aff, "r");
+    if (!f) {
+        printf("  missing %s\n", aff);
+        return 1;
+    }
+    fclose(f);
+
+    Hunspell * pMS = new Hunspell(aff, dic);
+    if (ngram_minwords != -1) pMS->set_ngram_minwords(ngram_minwords);
+    int fails = check_words(pMS, dir, name, ".good", 1, NULL);
+
+    char * expected = read_file(dir, name, ".sug");
+    struct textbuf sug = { NULL, 0, 0 };
+    buf_add(&sug, "");
+    fails += check_words(pMS, dir, name, ".wrong", 0, expected ? &sug : NULL);
+    if (expected && !same_text(expected, sug.s)) {
+        print_diff(name, ".sug", expected, sug.s, verbose);
+        fails++;
+    }
+    free(expected);
+    free(sug.s);
+
+    expected = read_file(dir, name, ".morph");
+    if (expected) fails += check_morph(pMS, dir, name, expected, verbose);
+    free(expected);
+
+    delete pMS;
+    return fails;
+}
+
+// copy a file of the suite into the current directory
+static int copy_file(const char * dir, const char * name, const char * ext)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s%s", dir, name, ext);
+    FILE * in = fopen(path, "rb");
+    if (!in) return 1;
+    snprintf(path, sizeof(path), "%s%s", name, ext);
+    FILE * out = fopen(path, "wb");
+    if (!out) {
+        fclose(in);
+        return 1;
+    }
+    char buf[8192];
+    size_t n;
+    int ec = 0;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        if (fwrite(buf, 1, n, out) != n) ec = 1;
+    }
+    fclose(in);
+    if (fclose(out)) ec = 1;
+    return ec;
+}
+
+// run a test on the image hcompile makes of its dictionary
+static int run_image_test(const char * dir, const char * name, const char * hcompile,
+    int verbose)
+{
+    char hdic[1024];
+    snprintf(hdic, sizeof(hdic), "%s.hdic", name);
+    remove(hdic);
+    if (copy_file(dir, name, ".aff") || copy_file(dir, name, ".dic")) {
+        printf("  can't copy %s.aff and %s.dic into the current directory\n", name, name);
+        return 1;
+    }
+    char cmd[4096];
+    snprintf(cmd, sizeof(cmd), "\"%s\" %s.aff %s.dic", hcompile, name, name);
+    int fails = 0;
+    FILE * f = NULL;
+    if (system(cmd) != 0 || !(f = fopen(hdic, "rb"))) {
+        printf("  %s made no image of %s.dic\n", hcompile, name);
+        fails++;
+    } else {
+        fclose(f);
+        fails = run_test(dir, ".", name, -1, verbose);
+    }
+    char path[1024];
+    snprintf(path, sizeof(path), "%s.aff", name);
+    remove(path);
+    snprintf(path, sizeof(path), "%s.dic", name);
+    remove(path);
+    remove(hdic);
+    return fails;
+}
+
+// size of the generated dictionary: searching it without the n-gram
+// index takes a multiple of SUGGEST_STEP, with the index the candidates
+// are pruned
+#define GENERATED_WORDS 30000
+#if GENERATED_WORDS <= NGRAM_CANDIDATES
+#error the generated dictionary is too small to prune the n-gram candidates
+#endif
+// candidates of the pruned search with set_ngram_candidates()
+#define GENERATED_CANDIDATES 50
+// word of the generated dictionary and its misspelling, which only the
+// n-gram suggestion finds
+#define GENERATED_WORD "abracadabra"
+#define GENERATED_MISSPELLING "abrakadabro"
+// the misspelling split in two words: the second is in the dictionary,
+// the first is added during a search. Only the pass splitting the word
+// suggests them, the n-gram suggestion does not make up for that pass.
+#define GENERATED_ADDED "abraka"
+#define GENERATED_TAIL "dabro"
+#define GENERATED_SPLIT GENERATED_ADDED " " GENERATED_TAIL
+
+// write generated.aff and generated.dic into the current directory, the
+// dictionary holds GENERATED_WORD, GENERATED_TAIL and pseudo-random words
+// of 5 to 10 letters
+static int write_generated()
+{
+    FILE * f = fopen("generated.aff", "w");
+    if (!f) return 1;
+    fprintf(f, "SET ISO8859-1\nTRY esianrtolcdugmphbyfvkwz\n");
+    if (fclose(f)) return 1;
+    f = fopen("generated.dic", "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n%s\n%s\n", GENERATED_WORDS, GENERATED_WORD, GENERATED_TAIL);
+    unsigned int seed = 1;
+    for (int i = 2; i < GENERATED_WORDS; i++) {
+        char w[16];
+        int len = 5 + i % 6;
+        for (int j = 0; j < len; j++) {
+            seed = seed * 1103515245 + 12345;
+            w[j] = 'a' + (seed >> 16) % 26;
+        }
+        w[len] = '\0';
+        fprintf(f, "%s\n", w);
+    }
+    return fclose(f) != 0;
+}
+
+// index of word in the suggestions, -1 if it is missing
+static int find_suggestion(char ** slst, int ns, const char * word)
+{
+    for (int i = 0; i < ns; i++) {
+        if (strcmp(slst[i], word) == 0) return i;
+    }
+    return -1;
+}
+
+// resumed searches which time out for real: the suite dictionaries are
+// mostly searched within the first step
+static int run_resume_test(const char * name)
+{
+    Hunspell * pMS = new Hunspell("generated.aff", "generated.dic");
+    // the full scan of the n-gram suggestion is the slow part
+    pMS->set_ngram_minwords(GENERATED_WORDS + 1);
+    char ** slst;
+    int ns = pMS->suggest(&slst, GENERATED_MISSPELLING);
+    int fails = 0;
+    if (find_suggestion(slst, ns, GENERATED_WORD) < 0) {
+        printf("  %s: no suggestion %s for %s\n", name, GENERATED_WORD, GENERATED_MISSPELLING);
+        fails++;
+    }
+    HunspellContext ctx;
+    int timeouts = 0;
+    fails += check_resumed(pMS, ctx, name, GENERATED_MISSPELLING, slst, ns, &timeouts);
+    pMS->free_list(&slst, ns);
+    if (!timeouts) {
+        printf("  %s: no step of %d ms timed out\n", name, SUGGEST_STEP);
+        fails++;
+    }
+    delete pMS;
+    return fails;
+}
+
+// a dictionary change between the steps starts the search again, so the
+// passes recorded before it are not replayed
+static int run_resume_add_test(const char * name)
+{
+    Hunspell * pMS = new Hunspell("generated.aff", "generated.dic");
+    pMS->set_ngram_minwords(GENERATED_WORDS + 1);
+    HunspellContext ctx;
+    char ** slst;
+    int ns = pMS->suggest(ctx, &slst, GENERATED_MISSPELLING, SUGGEST_STEP);
+    pMS->free_list(&slst, ns);
+    int fails = 0;
+    if (!ctx.timedout) {
+        printf("  %s: the first step of %d ms did not time out\n", name, SUGGEST_STEP);
+        fails++;
+    }
+    pMS->add(GENERATED_ADDED);
+
+    HunspellContext fresh;
+    ns = pMS->suggest(fresh, &slst, GENERATED_MISSPELLING);
+    if (find_suggestion(slst, ns, GENERATED_SPLIT) < 0) {
+        printf("  %s: no suggestion \"%s\" after adding %s\n", name, GENERATED_SPLIT, GENERATED_ADDED);
+        fails++;
+    }
+    int timeouts = 0;
+    fails += check_resumed(pMS, ctx, name, GENERATED_MISSPELLING, slst, ns, &timeouts);
+    pMS->free_list(&slst, ns);
+    delete pMS;
+    return fails;
+}
+
+// the trigram index scores only some of the words, the best suggestion
+// has to be among them, also with less candidates than by default
+static int run_pruned_test(const char * name)
+{
+    Hunspell * pMS = new Hunspell("generated.aff", "generated.dic");
+    pMS->set_ngram_minwords(0);
+    int fails = 0;
+    for (int k = 0; k < 2; k++) {
+        if (k) pMS->set_ngram_candidates(GENERATED_CANDIDATES);
+        char ** slst;
+        int ns = pMS->suggest(&slst, GENERATED_MISSPELLING);
+        if (find_suggestion(slst, ns, GENERATED_WORD) != 0) {
+            printf("  %s: %s is not the first suggestion for %s of %d candidates\n", name,
+                GENERATED_WORD, GENERATED_MISSPELLING, k ? GENERATED_CANDIDATES : NGRAM_CANDIDATES);
+            fails++;
+        }
+        pMS->free_list(&slst, ns);
+    }
+    delete pMS;
+    return fails;
+}
+
+// tests of the generated dictionary, counted like the suite runs
+static void run_generated_tests(int * runs, int * failed)
+{
+    static const struct {
+        const char * name;
+        int (*run)(const char * name);
+    } tests[] = {
+        { "resume (generated)", run_resume_test },
+        { "resume after add (generated)", run_resume_add_test },
+        { "pruned (generated)", run_pruned_test }
+    };
+    int ntests = sizeof(tests) / sizeof(tests[0]);
+    if (write_generated()) {
+        printf("  can't write generated.aff and generated.dic into the current directory\n");
+        printf("FAIL: generated\n");
+        (*runs)++;
+        (*failed)++;
+        return;
+    }
+    for (int k = 0; k < ntests; k++) {
+        int fails = tests[k].run(tests[k].name);
+        printf("%s: %s\n", fails ? "FAIL" : "PASS", tests[k].name);
+        if (fails) (*failed)++;
+        (*runs)++;
+    }
+    remove("generated.aff");
+    remove("generated.dic");
+}
+
+// names of the TESTS list of Makefile.am, without the .test extension
+static int read_suite(const char * dir, char *** names)
+{
+    char * text = read_file(dir, "Makefile", ".am");
+    *names = NULL;
+    if (!text) return 0;
+    int n = 0;
+    int intests = 0;
+    char * p = text;
+    char * line;
+    while ((line = next_line(&p))) {
+        if (!intests) {
+            if (strncmp(line, "TESTS", 5) != 0 || !strchr(line, '=')) continue;
+            intests = 1;
+            line = strchr(line, '=') + 1;
+        }
+        int len = strlen(line);
+        int more = (len && line[len - 1] == '\\');
+        for (char * tok = line; *(tok += strspn(tok, " \t\\")); ) {
+            int tlen = strcspn(tok, " \t\\");
+            if (tlen > 5 && strncmp(tok + tlen - 5, ".test", 5) == 0) {
+                char ** grown = (char **) realloc(*names, (n + 1) * sizeof(char *));
+                char * name = (char *) malloc(tlen - 4);
+                if (grown) *names = grown;
+                if (!grown || !name) {
+                    free(name);
+                    free(text);
+                    return n;
+                }
+                (*names)[n] = name;
+                strncpy((*names)[n], tok, tlen - 5);
+                (*names)[n++][tlen - 5] = '\0';
+            }
+            tok += tlen;
+        }
+        if (!more) break;
+    }
+    free(text);
+    return n;
+}
+
+int main(int argc, char ** argv)
+{
+    int verbose = 0;
+    int i = 1;
+    if (i < argc && strcmp(argv[i], "-h") == 0) {
+        fprintf(stderr, DESC);
+        return 2;
+    }
+    if (i < argc && strcmp(argv[i], "-v") == 0) {
+        verbose = 1;
+        i++;
+    }
+    const char * hcompile = HUNSPELL_HCOMPILE;
+    if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+        hcompile = argv[i + 1];
+        i += 2;
+    }
+    const char * dir = HUNSPELL_TESTS_DIR;
+    if (i < argc) dir = argv[i++];
+
+    char ** names;
+    int n;
+    if (i < argc) {
+        names = argv + i;
+        n = argc - i;
+    } else {
+        n = read_suite(dir, &names);
+        if (!n) {
+            free(names);
+            fprintf(stderr, "hunspell-tests: no TESTS in %s/Makefile.am\n", dir);
+            return 2;
+        }
+    }
+
+    int failed = 0;
+    int runs = 0;
+    for (int k = 0; k < n; k++) {
+        // the PASS/FAIL line follows the details
+        int fails = run_test(dir, dir, names[k], -1, verbose);
+        printf("%s: %s\n", fails ? "FAIL" : "PASS", names[k]);
+        if (fails) failed++;
+        // the test dictionaries are too small for the n-gram index by default
+        fails = run_test(dir, dir, names[k], 0, verbose);
+        printf("%s: %s (indexed)\n", fails ? "FAIL" : "PASS", names[k]);
+        if (fails) failed++;
+        runs += 2;
+        // dictionaries without a .dic file (hzip encrypted) have no image
+        char dic[1024];
+        snprintf(dic, sizeof(dic), "%s/%s.dic", dir, names[k]);
+        FILE * f = hcompile ? fopen(dic, "rb") : NULL;
+        if (!f) continue;
+        fclose(f);
+        fails = run_image_test(dir, names[k], hcompile, verbose);
+        printf("%s: %s (compiled)\n", fails ? "FAIL" : "PASS", names[k]);
+        if (fails) failed++;
+        runs++;
+    }
+    // only the whole suite, not the tests named on the command line
+    if (names != argv + i) run_generated_tests(&runs, &failed);
+    printf("%d of %d tests failed\n", failed, runs);
+
+    if (names != argv + i) {
+        for (int k = 0; k < n; k++) free(names[k]);
+        free(names);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,42 @@
+TARGET   = hunspell-tests
+TEMPLATE = app
+
+#
+# Build configuration, testcase adds "make check" that runs the suite
+#
+CONFIG += console thread warn_on testcase
+CONFIG -= app_bundle qt
+
+#
+# The library sources are built into the runner, so nothing is imported
+#
+DEFINES += HUNSPELL_STATIC
+DEFINES += HUNSPELL_TESTS_DIR=\\\"$$PWD/../tests\\\"
+win32: DEFINES += _CRT_SECURE_NO_WARNINGS
+
+QMAKE_MAC_SDK = macosx10.12
+
+#
+# Конфигурируем расположение файлов сборки
+#
+CONFIG(debug, debug|release) {
+    DESTDIR = $$PWD/../../../../build/Debug/libs/hunspell/tests
+} else {
+    DESTDIR = $$PWD/../../../../build/Release/libs/hunspell/tests
+}
+
+OBJECTS_DIR = $$DESTDIR/.obj
+MOC_DIR = $$DESTDIR/.moc
+RCC_DIR = $$DESTDIR/.qrc
+UI_DIR = $$DESTDIR/.ui
+#
+
+#
+# Every test is run again on the image hcompile (../hcompile) makes of its dictionary
+#
+DEFINES += HUNSPELL_HCOMPILE=\\\"$$DESTDIR/../hcompile/hcompile\\\"
+
+include(../hunspell.pri)
+
+SOURCES += \
+    main.cxx
@@ -17,3 +17,24 @@ SUBDIRS = \
     mythes
 
 win32: SUBDIRS += qBreakpad
+
+#
+# Замеры производительности форматов собираются по запросу: qmake CONFIG+=fileformats_bench
+#
+fileformats_bench: SUBDIRS += fileformats/bench
+
+#
+# Регрессионные тесты и замеры hunspell тоже собираются по запросу:
+# qmake CONFIG+=hunspell_tests (запуск - make check), qmake CONFIG+=hunspell_bench.
+# Тесты проверяют и образы словарей, которые делает hcompile, поэтому собирают его первым
+#
+hunspell_tests|hunspell_bench {
+    SUBDIRS += hcompile
+    hcompile.subdir = hunspell/hcompile
+}
+hunspell_tests {
+    SUBDIRS += testrunner
+    testrunner.subdir = hunspell/testrunner
+    testrunner.depends = hcompile
+}
+hunspell_bench: SUBDIRS += hunspell/bench